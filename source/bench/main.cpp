@@ -0,0 +1,284 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+// Stage benchmarks of eyeStalker() on synthetic eye frames, reproducible without recorded data
+
+#include "../eyestalker.h"
+#include "../preprocessedframe.h"
+#include "../stageprofiler.h"
+#include "../syntheticeye.h"
+#include "../trialtracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct benchmarkSettings
+{
+    double minTime;  // s per benchmark
+    int frameTotal;  // frames cycled through by each benchmark
+    int warmUpTotal; // frames tracked before first benchmark frame, so that predictions have converged
+    std::string filter;
+    detectionParameters mDetectionParameters;
+};
+
+void printUsage()
+{
+    std::cout << "Usage: eyestalker-bench [options]\n"
+              << "\n"
+              << "  -s <file>         settings file saved by EyeStalker (default: built-in parameters)\n"
+              << "  --filter <text>   only run benchmarks whose name contains <text>\n"
+              << "  --frames <n>      synthetic frames per benchmark (default: 100)\n"
+              << "  --min-time <s>    minimum run time per benchmark (default: 0.5)\n"
+              << "\n"
+              << "Every stage is timed on a matrix of image sizes and pupil sizes. Output: name, ns per iteration, iterations.\n";
+}
+
+// Runs 'function' until 'minTime' has passed, cycling through the frames. 'setup' is not timed.
+
+void runBenchmark(const std::string& name, const benchmarkSettings& mSettings, int frameTotal, std::function<void(int)> setup, std::function<void(int)> function)
+{
+    if (frameTotal == 0) { return; }
+    if (!mSettings.filter.empty() && name.find(mSettings.filter) == std::string::npos) { return; }
+
+    long long iterationTotal = 0;
+    double timeTotal = 0;
+
+    for (int iFrame = 0; iFrame < std::min(frameTotal, 3); iFrame++) { setup(iFrame); function(iFrame); } // warm caches
+
+    while (timeTotal < mSettings.minTime)
+    {
+        int iFrame = iterationTotal % frameTotal;
+
+        setup(iFrame);
+
+        auto t1 = std::chrono::steady_clock::now();
+        function(iFrame);
+        auto t2 = std::chrono::steady_clock::now();
+
+        timeTotal += std::chrono::duration<double>(t2 - t1).count();
+        iterationTotal++;
+    }
+
+    std::cout << std::left  << std::setw(44) << name
+              << std::right << std::setw(14) << std::fixed << std::setprecision(0) << 1e9 * timeTotal / iterationTotal
+              << std::setw(12) << iterationTotal << std::endl;
+}
+
+void runBenchmarks(const benchmarkSettings& mSettings, const syntheticEyeParameters& mEyeParameters)
+{
+    std::stringstream suffix;
+    suffix << "/" << mEyeParameters.imageWdth << "x" << mEyeParameters.imageHght << "/r" << mEyeParameters.pupilRadius;
+
+    const detectionParameters& mDetectionParameters = mSettings.mDetectionParameters;
+
+    // Frames and the tracker state of each frame
+
+    SyntheticEye mSyntheticEye(mEyeParameters);
+
+    AOIProperties imageAOI;
+    imageAOI.xPos = 0;
+    imageAOI.yPos = 0;
+    imageAOI.wdth = mEyeParameters.imageWdth;
+    imageAOI.hght = mEyeParameters.imageHght;
+
+    detectionVariables mDetectionVariables;
+    resetVariablesHard(mDetectionVariables, mDetectionParameters, imageAOI);
+
+    std::vector<cv::Mat> vImages;
+    std::vector<detectionVariables> vDetectionVariables; // as passed to eyeStalker()
+    std::vector<stageInputs> vInputs;
+
+    for (int iFrame = 0; iFrame < mSettings.warmUpTotal + mSettings.frameTotal; iFrame++)
+    {
+        cv::Mat imageRaw = mSyntheticEye.getFrame(iFrame);
+
+        dataVariables mDataVariables;
+        drawVariables mDrawVariables;
+
+        if (iFrame < mSettings.warmUpTotal)
+        {
+            mDetectionVariables = eyeStalker(imageRaw, imageAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables);
+            continue;
+        }
+
+        detectionVariables mDetectionVariablesInput = mDetectionVariables;
+
+        stageInputs mInputs; // filled by eyeStalker() itself, so that stages see the same inputs as during tracking
+        mDetectionVariables = eyeStalker(imageRaw, imageAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables, developmentOptions{}, NULL, &mInputs);
+
+        if (mInputs.PROCESSED) // blinks do not reach the edge stages
+        {
+            vImages.push_back(imageRaw);
+            vDetectionVariables.push_back(mDetectionVariablesInput);
+            vInputs.push_back(mInputs);
+        }
+    }
+
+    int frameTotal = vInputs.size();
+
+    std::function<void(int)> noSetup = [](int) {};
+
+    // Stages
+
+    std::unique_ptr<PreprocessedFrame> mPreprocessedFrame;
+
+    runBenchmark(std::string(getStageName(STAGE_RESIZE)) + suffix.str(), mSettings, frameTotal,
+                 [&](int i) { mPreprocessedFrame.reset(new PreprocessedFrame(vImages[i])); },
+                 [&](int)   { mPreprocessedFrame->getResized(); });
+
+    runBenchmark(std::string(getStageName(STAGE_INTEGRAL)) + suffix.str(), mSettings, frameTotal,
+                 [&](int i) { mPreprocessedFrame.reset(new PreprocessedFrame(vImages[i])); mPreprocessedFrame->getResized(); },
+                 [&](int)   { mPreprocessedFrame->getIntegralImage(); });
+
+    runBenchmark(std::string(getStageName(STAGE_GLINT)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        AOIProperties glintAOI;
+        glintAOI.wdth = PreprocessedFrame::sizeFactorDown * mDetectionParameters.glintWdth;
+        glintAOI.hght = glintAOI.wdth;
+        detectGlint(vInputs[i].imageResized, vInputs[i].searchAOIResized, glintAOI);
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_HAAR)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        AOIProperties haarAOI = vInputs[i].haarAOIResized;
+        detectPupilApprox(vInputs[i].integralImage, vInputs[i].integralAOI, vInputs[i].searchAOIResized, haarAOI, vInputs[i].glintAOIResized);
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_CANNY)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        cv::Mat imageCannyEdges;
+        cv::Canny(vInputs[i].imageAOIGrayBlurred, imageCannyEdges, vInputs[i].mDetectionParameters.cannyThresholdHigh, vInputs[i].mDetectionParameters.cannyThresholdLow, 5);
+        cannyConversion(imageCannyEdges, vInputs[i].cannyAOI);
+    });
+
+    std::vector<int> cannyEdges;
+    std::vector<int> edgePoints;
+
+    runBenchmark(std::string(getStageName(STAGE_SHARPENING)) + suffix.str(), mSettings, frameTotal,
+                 [&](int i) { cannyEdges = vInputs[i].cannyEdgesOriginal; edgePoints = vInputs[i].edgePointsOriginal; },
+                 [&](int i)
+    {
+        std::vector<int> edgePointsSharpened = sharpenEdges_1(cannyEdges, edgePoints, vInputs[i].cannyAOI);
+        sharpenEdges_2(cannyEdges, edgePointsSharpened, vInputs[i].cannyAOI);
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_EDGE_SELECTION)) + suffix.str(), mSettings, frameTotal,
+                 [&](int i) { cannyEdges = vInputs[i].cannyEdgesSharpened; }, // edge map is changed by edge selection
+                 [&](int i) { edgeSelection(vInputs[i].mDetectionVariables, cannyEdges, vInputs[i].cannyAOI); });
+
+    runBenchmark(std::string(getStageName(STAGE_SEGMENTATION_CURVATURE)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        for (int iEdge = 0; iEdge < (int) vInputs[i].vEdgesSelected.size(); iEdge++)
+        {   edgeSegmentationCurvature(vInputs[i].mDetectionVariables, vInputs[i].vEdgesSelected[iEdge], vInputs[i].curvatureUpperLimit, vInputs[i].curvatureLowerLimit); }
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_SEGMENTATION_LENGTH)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        for (int iEdge = 0; iEdge < (int) vInputs[i].vEdgesCurvature.size(); iEdge++)
+        {   edgeSegmentationLength(vInputs[i].mDetectionVariables, vInputs[i].vEdgesCurvature[iEdge], vInputs[i].cannyAOI); }
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_SEGMENTATION_SCORE)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        for (int iEdge = 0; iEdge < (int) vInputs[i].vEdgesLength.size(); iEdge++)
+        {   edgeSegmentationScore(vInputs[i].mDetectionVariables, vInputs[i].mDetectionParameters, vInputs[i].vEdgesLength[iEdge], vInputs[i].cannyAOI); }
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_SUBSETS)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        edgeCollectionFilter(vInputs[i].mDetectionVariables, vInputs[i].mDetectionParameters, vInputs[i].vEdgesClassified, vInputs[i].cannyAOI);
+    });
+
+    runBenchmark(std::string(getStageName(STAGE_FITTING)) + suffix.str(), mSettings, frameTotal, noSetup, [&](int i)
+    {
+        ellipseFitting(vInputs[i].mDetectionVariables, vInputs[i].mDetectionParameters, vInputs[i].vEdgeCollections, vInputs[i].cannyAOI, NULL, vInputs[i].scaleFactor);
+    });
+
+    // Whole frame
+
+    detectionVariables mDetectionVariablesFrame;
+
+    runBenchmark("eyestalker" + suffix.str(), mSettings, frameTotal,
+                 [&](int i) { mDetectionVariablesFrame = vDetectionVariables[i]; },
+                 [&](int i)
+    {
+        dataVariables mDataVariables;
+        drawVariables mDrawVariables;
+        eyeStalker(vImages[i], imageAOI, mDetectionVariablesFrame, mDetectionParameters, mDataVariables, mDrawVariables);
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    benchmarkSettings mSettings;
+    mSettings.minTime     = 0.5;
+    mSettings.frameTotal  = 100;
+    mSettings.warmUpTotal = 50;
+
+    std::string settingsFilename;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        std::string arg = argv[iArg];
+
+        if      (arg == "-s"         && iArg + 1 < argc) { settingsFilename    = argv[++iArg]; }
+        else if (arg == "--filter"   && iArg + 1 < argc) { mSettings.filter    = argv[++iArg]; }
+        else if (arg == "--frames"   && iArg + 1 < argc) { mSettings.frameTotal = std::max(1, std::atoi(argv[++iArg])); }
+        else if (arg == "--min-time" && iArg + 1 < argc) { mSettings.minTime   = std::atof(argv[++iArg]); }
+        else { printUsage(); return 1; }
+    }
+
+    trialTrackerSettings mTrackerSettings;
+    loadTrialTrackerSettings(settingsFilename, mTrackerSettings); // built-in defaults if no file is given
+    mSettings.mDetectionParameters = mTrackerSettings.mDetectionParameters;
+    mSettings.mDetectionParameters.cameraFrameRate = mTrackerSettings.cameraFrameRate;
+
+    std::cout << std::left  << std::setw(44) << "benchmark"
+              << std::right << std::setw(14) << "ns/iteration"
+              << std::setw(12) << "iterations" << std::endl;
+
+    const int imageSizes[3][2] = {{320, 240}, {640, 480}, {1280, 960}};
+    const double pupilRadii[2] = {15, 30};
+
+    for (int iSize = 0; iSize < 3; iSize++)
+    {
+        for (int iRadius = 0; iRadius < 2; iRadius++)
+        {
+            syntheticEyeParameters mEyeParameters;
+            mEyeParameters.imageWdth       = imageSizes[iSize][0];
+            mEyeParameters.imageHght       = imageSizes[iSize][1];
+            mEyeParameters.frameRate       = mTrackerSettings.cameraFrameRate;
+            mEyeParameters.pupilRadius     = pupilRadii[iRadius];
+            mEyeParameters.irisRadius      = 2.8 * pupilRadii[iRadius];
+            mEyeParameters.trajectory      = TRAJECTORY_PURSUIT;
+            mEyeParameters.motionAmplitude = 0.1 * imageSizes[iSize][0];
+            mEyeParameters.eyelashTotal    = 8;
+
+            runBenchmarks(mSettings, mEyeParameters);
+        }
+    }
+
+    return 0;
+}
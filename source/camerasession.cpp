@@ -0,0 +1,64 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "camerasession.h"
+
+CameraSession::CameraSession()
+{
+    CAMERA_READY   = false;
+    CAMERA_RUNNING = false;
+
+    cameraIndex = 0;
+    cameraXResolution = 0;
+    cameraYResolution = 0;
+
+    camAOI     = {};
+    eyeAOI     = {};
+    eyeAOIRght = {};
+    beadAOI    = {};
+
+    eyeAOIRatio     = {};
+    eyeAOIRatioRght = {};
+    beadAOIRatio    = {};
+}
+
+bool setThreadAffinity(int cpuCore)
+{
+    if (cpuCore < 0) { return false; }
+
+#ifdef __linux__
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpuCore, &cpuSet);
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0);
+
+#elif _WIN32
+
+    return (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << cpuCore) != 0);
+
+#else
+
+    return false;
+
+#endif
+}
+
+unsigned long long getHostTime()
+{
+    auto timeNow = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timeNow).count() / 100;
+}
@@ -0,0 +1,78 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef CAMERASESSION_H
+#define CAMERASESSION_H
+
+// Files
+
+#include "livetelemetry.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>              // std::mutex, std::unique_lock
+
+#ifdef __linux__
+    #include <pthread.h>
+#elif _WIN32
+    #include <windows.h>
+#endif
+
+// State that belongs to a single camera: its areas of interest, capture status and synchronization.
+// Each camera in the process owns one session, so that several cameras can be tracked side by side.
+
+class CameraSession
+{
+
+public:
+
+    CameraSession();
+
+    std::atomic<bool> CAMERA_READY;   // read by capture and tracking threads while GUI starts and stops camera
+    std::atomic<bool> CAMERA_RUNNING;
+
+    int cameraIndex;  // device ID of camera (0 = first available camera)
+    int cameraXResolution;
+    int cameraYResolution;
+
+    AOIProperties camAOI;
+    AOIProperties eyeAOI;
+    AOIProperties eyeAOIRght; // second eye in binocular mode
+    AOIProperties beadAOI;
+
+    AOIPropertiesDouble eyeAOIRatio;
+    AOIPropertiesDouble eyeAOIRatioRght;
+    AOIPropertiesDouble beadAOIRatio;
+
+    std::condition_variable frameCaptureCV;
+
+    std::mutex frameCaptureMutex;
+    std::mutex AOICamMutex;
+    std::mutex AOIEyeMutex; // also guards second eye AOI
+    std::mutex AOIBeadMutex;
+
+    LiveTelemetry mTelemetry; // latency and lost frames of live tracking
+};
+
+bool setThreadAffinity(int cpuCore); // pins calling thread to CPU core, negative value leaves thread unpinned
+
+unsigned long long getHostTime(); // steady clock in units of 0.1 microseconds (same as camera time stamps)
+
+#endif // CAMERASESSION_H
@@ -0,0 +1,234 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "catchuptracker.h"
+
+CatchUpTracker::CatchUpTracker()
+{
+    BEHIND         = false;
+    TRACKER_ACTIVE = false;
+    TRIAL_ACTIVE   = false;
+
+    backlogHigh       = 0;
+    backlogLow        = 0;
+    capacity          = 0;
+    detectionInterval = 1;
+
+    frameCounter   = 0;
+    framesSkipped  = 0;
+    framesStored   = 0;
+    frameIndexLast = -1;
+    trialNumber    = 0;
+}
+
+CatchUpTracker::~CatchUpTracker()
+{
+    {
+        std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+        TRACKER_ACTIVE = false;
+    }
+
+    catchUpCV.notify_one();
+    resultsCV.notify_all();
+
+    if (catchUpThread.joinable()) { catchUpThread.join(); }
+}
+
+void CatchUpTracker::startTrial(int capacityNew, int detectionIntervalNew, int backlogHighNew, int backlogLowNew)
+{
+    std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+
+    TRIAL_ACTIVE      = true;
+    capacity          = capacityNew;
+    detectionInterval = std::max(detectionIntervalNew, 2); // at least every other frame is skipped
+    backlogHigh       = backlogHighNew;
+    backlogLow        = std::min(backlogLowNew, backlogHighNew);
+    frameCounter      = 0;
+    framesSkipped     = 0;
+    trialNumber++;
+
+    if (!TRACKER_ACTIVE)
+    {
+        TRACKER_ACTIVE = true;
+        catchUpThread  = std::thread(&CatchUpTracker::threadCatchUp, this);
+    }
+}
+
+int CatchUpTracker::stopTrial(int& trialNumberStopped)
+{
+    std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+
+    trialNumberStopped = trialNumber;
+
+    if (!TRIAL_ACTIVE) { return 0; }
+
+    TRIAL_ACTIVE = false;
+    BEHIND       = false; // until next trial falls behind
+    catchUpCV.notify_one();
+
+    return framesSkipped;
+}
+
+bool CatchUpTracker::skipFrame(int backlog)
+{
+    std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+
+    if (!TRIAL_ACTIVE) { return false; }
+
+    if (!BEHIND && backlog >= backlogHigh)
+    {
+        BEHIND = true;
+        frameCounter = 0;
+    }
+    else if (BEHIND && backlog <= backlogLow)
+    {
+        BEHIND = false;
+        catchUpCV.notify_one(); // load has dropped
+    }
+
+    if (!BEHIND || framesStored >= capacity) { return false; } // frame is detected live
+
+    frameCounter++;
+    return (frameCounter % detectionInterval != 0); // tracker state is kept up to date by detecting every n-th frame
+}
+
+bool CatchUpTracker::addFrame(int frameIndex, double timestamp, const cv::Mat& imageGray, const catchUpCheckpoint& mCheckpoint)
+{
+    std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+
+    if (framesStored >= capacity) { return false; }
+
+    if (qRuns.empty() || qRuns.back().trialNumber != trialNumber || frameIndex != frameIndexLast + 1) // frame before was detected live
+    {
+        catchUpRun mRun;
+        mRun.trialNumber = trialNumber;
+        mRun.mCheckpoint = mCheckpoint;
+        mRun.mCheckpoint.mDetectionParametersEye .timeBudget = 0; // not live, no need to hurry
+        mRun.mCheckpoint.mDetectionParametersBead.timeBudget = 0;
+        qRuns.push_back(mRun);
+    }
+
+    catchUpFrame mFrame;
+    mFrame.frameIndex = frameIndex;
+    mFrame.timestamp  = timestamp;
+    mFrame.imageGray  = imageGray; // shares image data of frame, no copy
+
+    qRuns.back().vFrames.push_back(mFrame);
+
+    frameIndexLast = frameIndex;
+    framesSkipped++;
+    framesStored++;
+    mFramesPending[trialNumber]++;
+
+    return true;
+}
+
+std::vector<resultRecord> CatchUpTracker::getResults(int trialNumberResults)
+{
+    std::vector<resultRecord> vResults;
+
+    {
+        std::unique_lock<std::mutex> catchUpLock(catchUpMutex);
+        while (TRACKER_ACTIVE && mFramesPending[trialNumberResults] > 0) { resultsCV.wait(catchUpLock); }
+
+        vResults.swap(mResults[trialNumberResults]);
+        mResults      .erase(trialNumberResults);
+        mFramesPending.erase(trialNumberResults);
+    }
+
+    std::sort(vResults.begin(), vResults.end(), [](const resultRecord& a, const resultRecord& b) { return a.frameIndex < b.frameIndex; });
+
+    return vResults;
+}
+
+void CatchUpTracker::threadCatchUp()
+{
+    EventTracer::setThreadName("catch-up");
+
+    while (true)
+    {
+        catchUpRun mRun;
+
+        {
+            std::unique_lock<std::mutex> catchUpLock(catchUpMutex);
+
+            while (TRACKER_ACTIVE && (BEHIND || qRuns.empty())) { catchUpCV.wait(catchUpLock); }
+
+            if (!TRACKER_ACTIVE) { break; }
+
+            mRun = qRuns.front();
+            qRuns.pop_front();
+        }
+
+        TraceSpan mRunSpan("catch-up run");
+
+        const catchUpCheckpoint& c = mRun.mCheckpoint;
+
+        detectionVariables mDetectionVariablesEye     = c.mDetectionVariablesEye;
+        detectionVariables mDetectionVariablesEyeRght = c.mDetectionVariablesEyeRght;
+        detectionVariables mDetectionVariablesBead    = c.mDetectionVariablesBead;
+
+        for (int iFrame = 0, frameTotal = mRun.vFrames.size(); iFrame < frameTotal; iFrame++)
+        {
+            { // wait while live tracking is behind, also when run is left over from an earlier trial
+                std::unique_lock<std::mutex> catchUpLock(catchUpMutex);
+                while (TRACKER_ACTIVE && BEHIND) { catchUpCV.wait(catchUpLock); }
+                if (!TRACKER_ACTIVE) { return; }
+            }
+
+            catchUpFrame& mFrame = mRun.vFrames[iFrame];
+
+            PreprocessedFrame mPreprocessedFrame(mFrame.imageGray);
+
+            dataVariables mDataVariablesEye;
+            dataVariables mDataVariablesEyeRght;
+            dataVariables mDataVariablesBead;
+            drawVariables mDrawVariables;
+
+            mDetectionVariablesEye         = eyeStalker(mPreprocessedFrame, c.eyeAOI, mDetectionVariablesEye, c.mDetectionParametersEye, mDataVariablesEye, mDrawVariables);
+            mDataVariablesEye.absoluteXPos = mDataVariablesEye.exactXPos + c.eyeAOI.xPos + c.cameraAOI.xPos;
+            mDataVariablesEye.absoluteYPos = mDataVariablesEye.exactYPos + c.eyeAOI.yPos + c.cameraAOI.yPos;
+            mDataVariablesEye.timestamp    = mFrame.timestamp;
+
+            if (c.BINOCULAR_MODE)
+            {
+                mDetectionVariablesEyeRght         = eyeStalker(mPreprocessedFrame, c.eyeAOIRght, mDetectionVariablesEyeRght, c.mDetectionParametersEye, mDataVariablesEyeRght, mDrawVariables);
+                mDataVariablesEyeRght.absoluteXPos = mDataVariablesEyeRght.exactXPos + c.eyeAOIRght.xPos + c.cameraAOI.xPos;
+                mDataVariablesEyeRght.absoluteYPos = mDataVariablesEyeRght.exactYPos + c.eyeAOIRght.yPos + c.cameraAOI.yPos;
+            }
+
+            if (c.BEAD_DETECTION)
+            {
+                mDetectionVariablesBead         = eyeStalker(mPreprocessedFrame, c.beadAOI, mDetectionVariablesBead, c.mDetectionParametersBead, mDataVariablesBead, mDrawVariables);
+                mDataVariablesBead.absoluteXPos = mDataVariablesBead.exactXPos + c.beadAOI.xPos + c.cameraAOI.xPos;
+                mDataVariablesBead.absoluteYPos = mDataVariablesBead.exactYPos + c.beadAOI.yPos + c.cameraAOI.yPos;
+            }
+
+            resultRecord mResultRecord;
+            setResultRecord(mResultRecord, mFrame.frameIndex, mFrame.timestamp, &mDataVariablesEye,
+                            c.BINOCULAR_MODE ? &mDataVariablesEyeRght : NULL,
+                            c.BEAD_DETECTION ? &mDataVariablesBead    : NULL);
+
+            mFrame.imageGray = cv::Mat(); // memory is released as soon as frame is done
+
+            std::lock_guard<std::mutex> catchUpLock(catchUpMutex);
+            mResults[mRun.trialNumber].push_back(mResultRecord);
+            mFramesPending[mRun.trialNumber]--;
+            framesStored--;
+            resultsCV.notify_all();
+        }
+    }
+}
@@ -0,0 +1,123 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef CATCHUPTRACKER_H
+#define CATCHUPTRACKER_H
+
+// Files
+
+#include "eventtracer.h"
+#include "eyestalker.h"
+#include "preprocessedframe.h"
+#include "resultstream.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+
+// Backpressure for live tracking. When the tracking thread falls behind the camera (frames pile up in the frame ring),
+// only every n-th frame is detected live, so that the ring drains before the capture thread has to wait for a free slot.
+// The skipped frames are kept in memory and detected by a background thread once the tracking thread has caught up,
+// or at the latest when the trial has ended. Consecutive skipped frames form a run, which starts from the tracker state
+// (checkpoint) of the last frame detected live before it, as if the frames had been detected in order. The tracker is
+// kept for the whole session, so that frames left over from one trial give way to the next trial when it falls behind.
+
+struct catchUpCheckpoint // tracker state before first frame of a run
+{
+    bool BINOCULAR_MODE;
+    bool BEAD_DETECTION;
+
+    AOIProperties cameraAOI;
+    AOIProperties eyeAOI;
+    AOIProperties eyeAOIRght;
+    AOIProperties beadAOI;
+
+    detectionParameters mDetectionParametersEye;
+    detectionParameters mDetectionParametersBead;
+
+    detectionVariables mDetectionVariablesEye;
+    detectionVariables mDetectionVariablesEyeRght;
+    detectionVariables mDetectionVariablesBead;
+};
+
+class CatchUpTracker
+{
+
+public:
+
+    CatchUpTracker();
+    ~CatchUpTracker();
+
+    bool addFrame(int frameIndex, double timestamp, const cv::Mat& imageGray, const catchUpCheckpoint&); // checkpoint is only kept for first frame of a run, false if memory is full
+    bool skipFrame(int backlog); // whether next frame should be skipped, 'backlog' is number of frames waiting in frame ring
+    int stopTrial(int& trialNumber); // returns frames skipped during trial, which are then detected whenever live tracking is not behind
+    std::vector<resultRecord> getResults(int trialNumber); // waits until skipped frames of trial are detected, results are ordered by frame index
+    void startTrial(int capacity, int detectionInterval, int backlogHigh, int backlogLow); // thread is started with first trial
+
+private:
+
+    struct catchUpFrame
+    {
+        int frameIndex;
+        double timestamp;
+        cv::Mat imageGray;
+    };
+
+    struct catchUpRun
+    {
+        int trialNumber;
+        catchUpCheckpoint mCheckpoint;
+        std::vector<catchUpFrame> vFrames;
+    };
+
+    bool BEHIND;         // tracking thread has fallen behind, frames are being skipped
+    bool TRACKER_ACTIVE; // cleared when tracker is destroyed, frames that are left are dropped
+    bool TRIAL_ACTIVE;   // frames may be skipped
+
+    int backlogHigh; // frames waiting in ring before frames are skipped
+    int backlogLow;  // frames waiting in ring before all frames are detected live again, and catch-up may run
+    int capacity;    // frames kept in memory, of all trials
+    int detectionInterval;
+
+    int frameCounter;   // frames since tracking thread fell behind
+    int framesSkipped;  // of current trial
+    int framesStored;
+    int frameIndexLast; // last skipped frame
+    int trialNumber;    // counts trials of session, identifies results of a trial
+
+    std::condition_variable catchUpCV;
+    std::condition_variable resultsCV;
+    std::deque<catchUpRun> qRuns;
+    std::map<int, int> mFramesPending; // per trial, skipped frames that have not been detected yet
+    std::map<int, std::vector<resultRecord>> mResults; // per trial
+    std::mutex catchUpMutex;
+    std::thread catchUpThread;
+
+    void threadCatchUp();
+};
+
+#endif // CATCHUPTRACKER_H
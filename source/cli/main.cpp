@@ -0,0 +1,204 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+// Command-line batch tracker, tracks recorded sessions without display and without Qt
+
+#include "../trialpool.h"
+#include "../trialtracker.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>     // for console output
+#include <string>       // for std::string
+#include <vector>
+
+struct trialSelection
+{
+    std::string sessionDirectory;
+    std::vector<int> trialIndices; // empty for all trials of session
+};
+
+void printUsage()
+{
+    std::cout << "Usage: eyestalker-cli [options] <path>\n"
+              << "\n"
+              << "  <path>         session directory (containing images/), trial directory (images/trial_N) or raw.esv file\n"
+              << "  -s <file>      settings file saved by EyeStalker (default: config_user.ini)\n"
+              << "  -e             <path> contains one session per subdirectory\n"
+              << "  -c <chunks>    split each trial in chunks that are tracked in parallel\n"
+              << "  -j <threads>   number of trials tracked at once (default: all cores)\n"
+              << "  --overlap <n>  warm-up frames before each chunk (default: 500)\n"
+              << "  --edge         also save edge_data.dat\n"
+              << "  --fit          also save fit_data.dat\n"
+              << "  --extra        also save predicted values and processing time\n"
+              << "  --no-ascii     only save binary tracking_data.esd, not the ASCII files\n";
+}
+
+bool selectTrials(const std::string& path, bool EXPERIMENTS, std::vector<trialSelection>& vSelections)
+{
+    boost::filesystem::path inputPath(path);
+
+    if (EXPERIMENTS)
+    {
+        if (!boost::filesystem::is_directory(inputPath)) { return false; }
+
+        std::vector<std::string> vSessions;
+
+        for (auto& entry : boost::make_iterator_range(boost::filesystem::directory_iterator(inputPath), {}))
+        {
+            if (boost::filesystem::is_directory(entry.path())) { vSessions.push_back(entry.path().string()); }
+        }
+
+        std::sort(vSessions.begin(), vSessions.end());
+
+        for (int iSession = 0; iSession < (int) vSessions.size(); iSession++) { vSelections.push_back({vSessions[iSession], {}}); }
+
+        return true;
+    }
+
+    if (boost::filesystem::is_regular_file(inputPath)) { inputPath = inputPath.parent_path(); } // container of a trial
+
+    if (boost::filesystem::is_directory(inputPath / "images"))
+    {
+        vSelections.push_back({inputPath.string(), {}});
+        return true;
+    }
+
+    std::string trialName = inputPath.filename().string();
+
+    if (trialName.compare(0, 6, "trial_") == 0 && trialName.size() > 6)
+    {
+        std::string sessionDirectory = inputPath.parent_path().parent_path().string(); // session/images/trial_N
+        vSelections.push_back({sessionDirectory, {std::atoi(trialName.c_str() + 6)}});
+        return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    bool EXPERIMENTS = false;
+
+    int chunkOverlap    = -1; // from settings file
+    int chunkTotal      = 0;
+    int numberOfThreads = 0;
+
+    std::string path;
+    std::string settingsFilename = "config_user.ini";
+
+    trialTrackerSettings mSettings;
+    bool SAVE_DATA_ASCII = true;
+    bool SAVE_DATA_EDGE  = false;
+    bool SAVE_DATA_EXTRA = false;
+    bool SAVE_DATA_FIT   = false;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if      (std::strcmp(argv[iArg], "-s")        == 0 && iArg + 1 < argc) { settingsFilename = argv[++iArg]; }
+        else if (std::strcmp(argv[iArg], "-c")        == 0 && iArg + 1 < argc) { chunkTotal       = std::atoi(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "-j")        == 0 && iArg + 1 < argc) { numberOfThreads  = std::atoi(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--overlap") == 0 && iArg + 1 < argc) { chunkOverlap     = std::atoi(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "-e")         == 0) { EXPERIMENTS     = true; }
+        else if (std::strcmp(argv[iArg], "--edge")     == 0) { SAVE_DATA_EDGE  = true; }
+        else if (std::strcmp(argv[iArg], "--extra")    == 0) { SAVE_DATA_EXTRA = true; }
+        else if (std::strcmp(argv[iArg], "--fit")      == 0) { SAVE_DATA_FIT   = true; }
+        else if (std::strcmp(argv[iArg], "--no-ascii") == 0) { SAVE_DATA_ASCII = false; }
+        else if (argv[iArg][0] != '-' && path.empty())       { path = argv[iArg]; }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (path.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!loadTrialTrackerSettings(settingsFilename, mSettings))
+    {   std::cout << "Settings file " << settingsFilename << " not found, using default parameters" << std::endl; }
+
+    mSettings.SAVE_DATA_ASCII = mSettings.SAVE_DATA_ASCII && SAVE_DATA_ASCII;
+    mSettings.SAVE_DATA_EDGE  = SAVE_DATA_EDGE;
+    mSettings.SAVE_DATA_EXTRA = SAVE_DATA_EXTRA;
+    mSettings.SAVE_DATA_FIT   = SAVE_DATA_FIT;
+
+    if (chunkTotal   >  0) { mSettings.chunkTotal   = chunkTotal; }
+    if (chunkOverlap >= 0) { mSettings.chunkOverlap = chunkOverlap; }
+
+    std::vector<trialSelection> vSelections;
+
+    if (!selectTrials(path, EXPERIMENTS, vSelections))
+    {
+        std::cout << "No session or trial found at " << path << std::endl;
+        return 1;
+    }
+
+    TrialPool mTrialPool;
+
+    for (int iSelection = 0; iSelection < (int) vSelections.size(); iSelection++)
+    {
+        const trialSelection& mSelection = vSelections[iSelection];
+
+        std::vector<int> trialIndices = mSelection.trialIndices;
+
+        if (trialIndices.empty())
+        {
+            int trialTotal = countTrials(mSelection.sessionDirectory);
+            for (int iTrial = 0; iTrial < trialTotal; iTrial++) { trialIndices.push_back(iTrial); }
+        }
+
+        for (int iTrial = 0; iTrial < (int) trialIndices.size(); iTrial++) { mTrialPool.addTrial(mSelection.sessionDirectory, trialIndices[iTrial]); }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    mTrialPool.start(mSettings, numberOfThreads);
+    mTrialPool.wait();
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::vector<trialPoolResult> vResults = mTrialPool.getResults();
+
+    int trialsTracked = 0;
+
+    for (int iResult = 0; iResult < (int) vResults.size(); iResult++)
+    {
+        const trialPoolResult& mResult = vResults[iResult];
+
+        std::cout << mResult.sessionDirectory << " trial " << mResult.trialIndex << ": ";
+
+        if      (mResult.imageTotal == 0) { std::cout << "no frames" << std::endl; }
+        else if (!mResult.SUCCESS)        { std::cout << "unable to save data" << std::endl; }
+        else
+        {
+            std::cout << mResult.imageTotal << " frames in " << mResult.duration << " s ("
+                      << mResult.imageTotal / mResult.duration << " frames/s)" << std::endl;
+
+            trialsTracked++;
+        }
+    }
+
+    std::cout << trialsTracked << " trials tracked in " << std::chrono::duration<double>(t2 - t1).count() << " s" << std::endl;
+
+    return (trialsTracked > 0) ? 0 : 1;
+}
@@ -55,7 +55,9 @@ static const std::vector<double> parametersEye  = {0.005,   //  0. Gain average
                                                    0.60,    // 24. Score difference threshold edge
                                                    0.10,    // 25. Score difference threshold fit
                                                    7,       // 26. Edge window length
-                                                   6};      // 27. Maximum number of fits
+                                                   6,       // 27. Maximum number of fits
+                                                   0,       // 28. Blink contrast threshold (0 = off)
+                                                   0};      // 29. Reduced-scale circumference
 
 const double initialAspectRatio  = 0.9;
 const double initialCurvature    =  30;
@@ -83,4 +85,6 @@ const double certaintyOffset    = 0.10;
 const double certaintyThreshold = 0.75;
 const double certaintyLatency   = 10.0; // turn into adjustable parameter.
 
+const int blinkLengthMax = 100; // frames that tracker state is kept while eye is closed, before pupil is reported lost
+
 #endif
@@ -0,0 +1,132 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "diagnosticsarena.h"
+
+namespace
+{
+
+const size_t blockSizeMin = 1 << 20; // bytes
+
+}
+
+DiagnosticsArena::DiagnosticsArena()
+{
+    blockUsed = 0;
+}
+
+void DiagnosticsArena::clear()
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    vFrames.clear();
+    vBlocks.clear();
+    vBlockSizes.clear();
+
+    blockUsed = 0;
+}
+
+void DiagnosticsArena::resize(int frameTotal)
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    frameEntry mEntry = {NULL, NULL, 0, 0};
+    vFrames.resize(frameTotal, mEntry);
+}
+
+void* DiagnosticsArena::allocate(size_t bytes)
+{
+    bytes = (bytes + 7) & ~((size_t) 7); // keep values aligned
+
+    if (vBlocks.empty() || blockUsed + bytes > vBlockSizes.back())
+    {
+        size_t blockSize = std::max(bytes, blockSizeMin);
+        vBlocks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]));
+        vBlockSizes.push_back(blockSize);
+        blockUsed = 0;
+    }
+
+    void* data = vBlocks.back().get() + blockUsed;
+    blockUsed += bytes;
+
+    return data;
+}
+
+void DiagnosticsArena::store(int frameIndex, const diagnosticVariables& mDiagnosticVariables)
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    if (frameIndex < 0) { return; }
+
+    if (frameIndex >= (int) vFrames.size())
+    {
+        frameEntry mEntry = {NULL, NULL, 0, 0};
+        vFrames.resize(frameIndex + 1, mEntry);
+    }
+
+    frameEntry& mEntry = vFrames[frameIndex];
+
+    mEntry.edgeTotal    = mDiagnosticVariables.edgeData.size();
+    mEntry.ellipseTotal = mDiagnosticVariables.ellipseData.size();
+    mEntry.edgeData     = NULL;
+    mEntry.ellipseData  = NULL;
+
+    if (mEntry.edgeTotal > 0)
+    {
+        edgeSummary* edgeData = (edgeSummary*) allocate(mEntry.edgeTotal * sizeof(edgeSummary));
+        std::memcpy(edgeData, mDiagnosticVariables.edgeData.data(), mEntry.edgeTotal * sizeof(edgeSummary));
+        mEntry.edgeData = edgeData;
+    }
+
+    if (mEntry.ellipseTotal > 0)
+    {
+        ellipseSummary* ellipseData = (ellipseSummary*) allocate(mEntry.ellipseTotal * sizeof(ellipseSummary));
+        std::memcpy(ellipseData, mDiagnosticVariables.ellipseData.data(), mEntry.ellipseTotal * sizeof(ellipseSummary));
+        mEntry.ellipseData = ellipseData;
+    }
+}
+
+const edgeSummary* DiagnosticsArena::getEdgeData(int frameIndex, int& edgeTotal) const
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    edgeTotal = 0;
+    if (frameIndex < 0 || frameIndex >= (int) vFrames.size()) { return NULL; }
+
+    edgeTotal = vFrames[frameIndex].edgeTotal;
+    return vFrames[frameIndex].edgeData;
+}
+
+const ellipseSummary* DiagnosticsArena::getEllipseData(int frameIndex, int& ellipseTotal) const
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    ellipseTotal = 0;
+    if (frameIndex < 0 || frameIndex >= (int) vFrames.size()) { return NULL; }
+
+    ellipseTotal = vFrames[frameIndex].ellipseTotal;
+    return vFrames[frameIndex].ellipseData;
+}
+
+size_t DiagnosticsArena::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> arenaLock(arenaMutex);
+
+    size_t bytes = vFrames.size() * sizeof(frameEntry);
+    for (int iBlock = 0; iBlock < (int) vBlockSizes.size(); iBlock++) { bytes += vBlockSizes[iBlock]; }
+
+    return bytes;
+}
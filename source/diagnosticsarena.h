@@ -0,0 +1,73 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef DIAGNOSTICSARENA_H
+#define DIAGNOSTICSARENA_H
+
+// Files
+
+#include "structures.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Per-edge and per-fit values of every frame of a trial, only kept when they are exported.
+//
+// Values are copied into large blocks that are released together when the trial changes, instead of
+// two vectors per frame. A frame that is detected again gets new space; the old space is re-used only after clear().
+// Frames may be stored from several threads (e.g. chunks of one trial).
+
+class DiagnosticsArena
+{
+
+public:
+
+    DiagnosticsArena();
+
+    const edgeSummary*    getEdgeData   (int frameIndex, int& edgeTotal)    const; // NULL if frame has no data
+    const ellipseSummary* getEllipseData(int frameIndex, int& ellipseTotal) const;
+    size_t getMemoryUsage() const; // bytes
+    void clear(); // new trial
+    void resize(int frameTotal);
+    void store(int frameIndex, const diagnosticVariables&);
+
+private:
+
+    struct frameEntry
+    {
+        const edgeSummary*    edgeData;
+        const ellipseSummary* ellipseData;
+        int edgeTotal;
+        int ellipseTotal;
+    };
+
+    mutable std::mutex arenaMutex;
+
+    size_t blockUsed; // bytes of last block
+
+    std::vector<frameEntry> vFrames;
+    std::vector<std::unique_ptr<unsigned char[]>> vBlocks; // never moved, so entries stay valid
+    std::vector<size_t> vBlockSizes;
+
+    void* allocate(size_t bytes);
+};
+
+#endif // DIAGNOSTICSARENA_H
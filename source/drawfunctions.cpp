@@ -185,3 +185,8 @@ void drawAll(cv::Mat &I, const drawVariables &mDrawVariables)
         }
     }
 }
+
+void drawAll(cv::Mat &I, const std::vector<drawVariables> &vDrawVariables)
+{
+    for (int i = 0; i < (int) vDrawVariables.size(); i++) { drawAll(I, vDrawVariables[i]); }
+}
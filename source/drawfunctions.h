@@ -25,4 +25,5 @@ void drawOutline(cv::Mat&, const AOIProperties&, const cv::Vec3b&, const std::ve
 void drawEllipse(cv::Mat&, const AOIProperties&, const cv::Vec3b&, const cv::Vec3b&, const cv::Vec3b&, const std::vector<double>&);
 void drawAOI    (cv::Mat&, const AOIProperties&, const cv::Vec3b&);
 void drawAll    (cv::Mat&, const drawVariables&);
+void drawAll    (cv::Mat&, const std::vector<drawVariables>&);
 void drawCross  (cv::Mat&, double, double, const cv::Vec3b&);
@@ -0,0 +1,251 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "eventtracer.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> EventTracer::TRACING_ENABLED(false);
+
+namespace
+{
+
+const int traceBufferCapacity = 65536; // events per thread (2 MB, allocated on first event)
+
+struct traceEvent
+{
+    const char* name;
+    const char* category;
+    long long startTime; // ns
+    long long duration;
+};
+
+struct traceBuffer
+{
+    bool RELEASED;   // thread has ended, buffer can be taken over by a new thread
+    int threadIndex; // tid in trace
+    std::string threadName;
+    unsigned long long eventCount; // events ever added, next event goes to eventCount % capacity
+    std::mutex bufferMutex;        // only contended while trace is saved
+    std::vector<traceEvent> vEvents;
+};
+
+const std::chrono::steady_clock::time_point traceStartTime = std::chrono::steady_clock::now();
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<traceBuffer>> vTraceBuffers;
+
+struct threadBufferHandle // releases buffer of thread when thread ends
+{
+    threadBufferHandle() : mBuffer(NULL) {}
+
+    ~threadBufferHandle()
+    {
+        if (mBuffer == NULL) { return; }
+        std::lock_guard<std::mutex> registryLock(registryMutex);
+        mBuffer->RELEASED = true;
+    }
+
+    traceBuffer* mBuffer;
+};
+
+thread_local threadBufferHandle mThreadBuffer;
+
+traceBuffer* getThreadBuffer()
+{
+    if (mThreadBuffer.mBuffer != NULL) { return mThreadBuffer.mBuffer; }
+
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+
+    for (int iBuffer = 0; iBuffer < (int) vTraceBuffers.size(); iBuffer++)
+    {
+        if (vTraceBuffers[iBuffer]->RELEASED)
+        {
+            vTraceBuffers[iBuffer]->RELEASED = false;
+            mThreadBuffer.mBuffer = vTraceBuffers[iBuffer].get();
+            return mThreadBuffer.mBuffer;
+        }
+    }
+
+    std::unique_ptr<traceBuffer> mBuffer(new traceBuffer());
+    mBuffer->RELEASED    = false;
+    mBuffer->threadIndex = vTraceBuffers.size() + 1;
+    mBuffer->eventCount  = 0;
+
+    mThreadBuffer.mBuffer = mBuffer.get();
+    vTraceBuffers.push_back(std::move(mBuffer));
+
+    return mThreadBuffer.mBuffer;
+}
+
+void writeString(std::ofstream& file, const char* text)
+{
+    file << '"';
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\') { file << '\\'; }
+        file << *c;
+    }
+    file << '"';
+}
+
+void writeTime(std::ofstream& file, long long nanoseconds) // trace time unit is us
+{
+    file << nanoseconds / 1000 << "." << std::setw(3) << std::setfill('0') << nanoseconds % 1000 << std::setfill(' ');
+}
+
+struct lockStatistics
+{
+    int waitTotal;
+    long long waitDuration;
+    long long waitMaximum;
+    long long holdDuration;
+};
+
+}
+
+long long EventTracer::getTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceStartTime).count();
+}
+
+void EventTracer::setEnabled(bool ENABLED) { TRACING_ENABLED.store(ENABLED); }
+
+void EventTracer::setThreadName(const std::string& threadName)
+{
+    traceBuffer* mBuffer = getThreadBuffer();
+    std::lock_guard<std::mutex> bufferLock(mBuffer->bufferMutex);
+    mBuffer->threadName = threadName;
+}
+
+void EventTracer::addSpan(const char* name, const char* category, long long startTime, long long endTime)
+{
+    traceBuffer* mBuffer = getThreadBuffer();
+    std::lock_guard<std::mutex> bufferLock(mBuffer->bufferMutex);
+
+    if (mBuffer->vEvents.empty()) { mBuffer->vEvents.resize(traceBufferCapacity); } // only threads that record spans need memory
+
+    traceEvent& mEvent = mBuffer->vEvents[mBuffer->eventCount % traceBufferCapacity];
+    mEvent.name      = name;
+    mEvent.category  = category;
+    mEvent.startTime = startTime;
+    mEvent.duration  = endTime - startTime;
+
+    mBuffer->eventCount++;
+}
+
+void EventTracer::clear()
+{
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+
+    for (int iBuffer = 0; iBuffer < (int) vTraceBuffers.size(); iBuffer++)
+    {
+        std::lock_guard<std::mutex> bufferLock(vTraceBuffers[iBuffer]->bufferMutex);
+        vTraceBuffers[iBuffer]->eventCount = 0;
+    }
+}
+
+bool EventTracer::save(const std::string& filename)
+{
+    std::ofstream file;
+    file.open(filename, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    std::map<std::string, lockStatistics> mLockStatistics;
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    file << "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"EyeStalker\"}}";
+
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+
+    for (int iBuffer = 0; iBuffer < (int) vTraceBuffers.size(); iBuffer++)
+    {
+        traceBuffer& mBuffer = *vTraceBuffers[iBuffer];
+
+        std::vector<traceEvent> vEvents;
+        std::string threadName;
+
+        { std::lock_guard<std::mutex> bufferLock(mBuffer.bufferMutex); // copy, so that thread is not held up while writing
+            unsigned long long eventTotal = std::min(mBuffer.eventCount, (unsigned long long) traceBufferCapacity);
+            for (unsigned long long iEvent = mBuffer.eventCount - eventTotal; iEvent < mBuffer.eventCount; iEvent++)
+            {   vEvents.push_back(mBuffer.vEvents[iEvent % traceBufferCapacity]); }
+            threadName = mBuffer.threadName;
+        }
+
+        if (!threadName.empty())
+        {
+            file << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << mBuffer.threadIndex << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            writeString(file, threadName.c_str());
+            file << "}}";
+        }
+
+        for (int iEvent = 0; iEvent < (int) vEvents.size(); iEvent++)
+        {
+            const traceEvent& mEvent = vEvents[iEvent];
+
+            bool LOCK_WAIT = (std::string(mEvent.category) == "lock_wait");
+            bool LOCK_HOLD = (std::string(mEvent.category) == "lock_hold");
+
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << mBuffer.threadIndex << ",\"name\":";
+            if      (LOCK_WAIT) { writeString(file, (std::string("wait ") + mEvent.name).c_str()); }
+            else if (LOCK_HOLD) { writeString(file, (std::string("hold ") + mEvent.name).c_str()); }
+            else                { writeString(file, mEvent.name); }
+            file << ",\"cat\":";
+            writeString(file, mEvent.category);
+            file << ",\"ts\":";
+            writeTime(file, mEvent.startTime);
+            file << ",\"dur\":";
+            writeTime(file, mEvent.duration);
+            file << "}";
+
+            if (LOCK_WAIT || LOCK_HOLD)
+            {
+                lockStatistics& mStatistics = mLockStatistics[mEvent.name];
+                if (LOCK_WAIT)
+                {
+                    mStatistics.waitTotal++;
+                    mStatistics.waitDuration += mEvent.duration;
+                    mStatistics.waitMaximum   = std::max(mStatistics.waitMaximum, mEvent.duration);
+                }
+                else { mStatistics.holdDuration += mEvent.duration; }
+            }
+        }
+    }
+
+    file << "\n],\"otherData\":{";
+
+    for (auto it = mLockStatistics.begin(); it != mLockStatistics.end(); it++) // per mutex, over all threads
+    {
+        const lockStatistics& mStatistics = it->second;
+
+        if (it != mLockStatistics.begin()) { file << ","; }
+        writeString(file, it->first.c_str());
+        file << ":\"locked " << mStatistics.waitTotal
+             << " times, wait " << mStatistics.waitDuration / 1000 << " us (max " << mStatistics.waitMaximum / 1000
+             << " us), held " << mStatistics.holdDuration / 1000 << " us\"";
+    }
+
+    file << "}}\n";
+
+    return file.good();
+}
@@ -0,0 +1,127 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef EVENTTRACER_H
+#define EVENTTRACER_H
+
+// Standard Template
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+// Timeline of what each thread was doing (waiting for a frame, detecting, drawing, writing, waiting for or holding a lock),
+// saved in the Chrome trace event format, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// Every thread writes to its own ring buffer, so threads do not contend with each other while tracing; when a buffer is
+// full the oldest events are overwritten. Buffers of threads that have ended are kept until the trace is cleared, and are
+// re-used by new threads. While tracing is disabled (default) a span costs one atomic load.
+//
+// Span names and categories are stored as pointers and must be string literals.
+
+const std::string traceFilename = "trace.json"; // in trial directory
+
+class EventTracer
+{
+
+public:
+
+    static bool isEnabled() { return TRACING_ENABLED.load(std::memory_order_relaxed); }
+    static bool save(const std::string& filename); // events are kept, also holds lock wait totals per mutex
+    static long long getTime(); // ns since start of program
+    static void addSpan(const char* name, const char* category, long long startTime, long long endTime);
+    static void clear();
+    static void setEnabled(bool);
+    static void setThreadName(const std::string&); // shown as track name, e.g. "capture"
+
+private:
+
+    static std::atomic<bool> TRACING_ENABLED;
+};
+
+// Span from construction until end() or destruction
+
+class TraceSpan
+{
+
+public:
+
+    TraceSpan(const char* name, const char* category = "tracking") : ACTIVE(EventTracer::isEnabled()), category(category), name(name)
+    {
+        if (ACTIVE) { startTime = EventTracer::getTime(); }
+    }
+
+    ~TraceSpan() { end(); }
+
+    void end()
+    {
+        if (ACTIVE)
+        {
+            EventTracer::addSpan(name, category, startTime, EventTracer::getTime());
+            ACTIVE = false;
+        }
+    }
+
+private:
+
+    bool ACTIVE;
+    const char* category;
+    const char* name;
+    long long startTime;
+};
+
+// Replacement for std::lock_guard that records the time spent waiting for the mutex and the time it was held,
+// under the given mutex name. Lock waits are summed per mutex name when the trace is saved.
+
+class TracedLock
+{
+
+public:
+
+    TracedLock(std::mutex& mutex, const char* mutexName) : ACTIVE(EventTracer::isEnabled()), mutexName(mutexName), lock(mutex, std::defer_lock)
+    {
+        if (!ACTIVE)
+        {
+            lock.lock();
+            return;
+        }
+
+        long long waitTime = EventTracer::getTime();
+        lock.lock();
+        holdTime = EventTracer::getTime();
+
+        EventTracer::addSpan(mutexName, "lock_wait", waitTime, holdTime);
+    }
+
+    ~TracedLock()
+    {
+        lock.unlock();
+        if (ACTIVE) { EventTracer::addSpan(mutexName, "lock_hold", holdTime, EventTracer::getTime()); }
+    }
+
+private:
+
+    bool ACTIVE;
+    const char* mutexName;
+    long long holdTime;
+    std::unique_lock<std::mutex> lock;
+
+    TracedLock(const TracedLock&);
+    TracedLock& operator=(const TracedLock&);
+};
+
+#endif // EVENTTRACER_H
@@ -16,6 +16,8 @@
 
 #include "eyestalker.h"
 
+static_assert(sizeof(dataVariables) == 64 + (profilingEnabled ? sizeof(stageDurations) : 0), "per-frame sample must stay 64 bytes");
+
 // General
 
 double calculateMean(const std::vector<double>& v)
@@ -45,6 +47,24 @@ double calculateVariance(const std::vector<double>& v)
     return (temp / size);
 }
 
+DetectionDeadline::DetectionDeadline(double timeBudget)
+{
+    EXPIRED   = false;
+    UNLIMITED = (timeBudget <= 0);
+
+    if (!UNLIMITED)
+    {
+        std::chrono::microseconds timeBudgetMicro(static_cast<long long>(1000 * timeBudget));
+        timeDeadline = std::chrono::steady_clock::now() + timeBudgetMicro;
+    }
+}
+
+bool DetectionDeadline::isExpired()
+{
+    if (!EXPIRED && !UNLIMITED) { EXPIRED = (std::chrono::steady_clock::now() >= timeDeadline); }
+    return EXPIRED;
+}
+
 int find2(std::vector<std::vector<int>>& v, int target)
 {
     int size = v.size();
@@ -164,38 +184,6 @@ double calculateScoreTotal(const detectionVariables& mDetectionVariables, std::v
 
 // Detection
 
-std::vector<unsigned int> calculateIntImg(const cv::Mat& img, AOIProperties searchAOI)
-{
-    int imgWidth = img.cols;
-    
-    int startX = searchAOI.xPos;
-    int startY = searchAOI.yPos;
-    int width  = searchAOI.wdth;
-    int height = searchAOI.hght;
-    
-    uchar *ptr = img.data;
-    
-    std::vector<unsigned int> integralImage(width * height); // unsigned due to large positive values
-    
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            int i = width * y + x; // integral image coordinates
-            int j = imgWidth * (y + startY) + (x + startX); // image coordinates
-            
-            double val = ptr[j];
-            
-            if (x == 0 && y == 0) { integralImage[i] = val; }                            // first point
-            else if (y == 0)      { integralImage[i] = val + integralImage[i - 1]; }     // first row
-            else if (x == 0)      { integralImage[i] = val + integralImage[i - width]; } // first column
-            else                  { integralImage[i] = val + integralImage[i - 1] + integralImage[i - width] - integralImage[i - width - 1]; }
-        }
-    }
-    
-    return integralImage;
-}
-
 AOIProperties detectGlint(const cv::Mat& img, AOIProperties searchAOI, AOIProperties glintAOI)
 {
     int imgWidth = img.cols;
@@ -250,8 +238,13 @@ AOIProperties detectGlint(const cv::Mat& img, AOIProperties searchAOI, AOIProper
     return glintAOI;
 }
 
-inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>& I, const  AOIProperties& searchAOI, const AOIProperties& haarAOI, const AOIProperties& glintAOI)
+inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>& I, const AOIProperties& integralAOI, const AOIProperties& searchAOI, const AOIProperties& haarAOI, const AOIProperties& glintAOI)
 {
+    // integral image may cover a larger area than search AOI
+
+    int xOffset = searchAOI.xPos - integralAOI.xPos;
+    int yOffset = searchAOI.yPos - integralAOI.yPos;
+
     // vertices of inner square
 
     int xTopLeft = x;
@@ -265,10 +258,10 @@ inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>&
     if (xBtmRght >= searchAOI.wdth) { xBtmRght = searchAOI.wdth - 1; }
     if (yBtmRght >= searchAOI.hght) { yBtmRght = searchAOI.hght - 1; }
 
-    int iTopLeft = searchAOI.wdth * yTopLeft + xTopLeft;
-    int iTopRght = searchAOI.wdth * yTopLeft + xBtmRght;
-    int iBtmLeft = searchAOI.wdth * yBtmRght + xTopLeft;
-    int iBtmRght = searchAOI.wdth * yBtmRght + xBtmRght;
+    int iTopLeft = integralAOI.wdth * (yTopLeft + yOffset) + (xTopLeft + xOffset);
+    int iTopRght = integralAOI.wdth * (yTopLeft + yOffset) + (xBtmRght + xOffset);
+    int iBtmLeft = integralAOI.wdth * (yBtmRght + yOffset) + (xTopLeft + xOffset);
+    int iBtmRght = integralAOI.wdth * (yBtmRght + yOffset) + (xBtmRght + xOffset);
 
     // calculate glint intensity
 
@@ -312,10 +305,10 @@ inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>&
 
         // coordinates of corners of glint square
 
-        int iTopLeftGlint = searchAOI.wdth * yTopLeftGlint + xTopLeftGlint;
-        int iTopRghtGlint = searchAOI.wdth * yTopLeftGlint + xBtmRghtGlint;
-        int iBtmLeftGlint = searchAOI.wdth * yBtmRghtGlint + xTopLeftGlint;
-        int iBtmRghtGlint = searchAOI.wdth * yBtmRghtGlint + xBtmRghtGlint;
+        int iTopLeftGlint = integralAOI.wdth * (yTopLeftGlint + yOffset) + (xTopLeftGlint + xOffset);
+        int iTopRghtGlint = integralAOI.wdth * (yTopLeftGlint + yOffset) + (xBtmRghtGlint + xOffset);
+        int iBtmLeftGlint = integralAOI.wdth * (yBtmRghtGlint + yOffset) + (xTopLeftGlint + xOffset);
+        int iBtmRghtGlint = integralAOI.wdth * (yBtmRghtGlint + yOffset) + (xBtmRghtGlint + xOffset);
 
         // calculate area and intensity of glint
 
@@ -337,10 +330,10 @@ inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>&
     if (xTopLeftOuter <               0) { xTopLeftOuter =                  0; }
     if (xBtmRghtOuter >= searchAOI.wdth) { xBtmRghtOuter = searchAOI.wdth - 1; }
 
-    int iTopLeftOuter = searchAOI.wdth * yTopLeft + xTopLeftOuter;
-    int iTopRghtOuter = searchAOI.wdth * yTopLeft + xBtmRghtOuter;
-    int iBtmLeftOuter = searchAOI.wdth * yBtmRght + xTopLeftOuter;
-    int iBtmRghtOuter = searchAOI.wdth * yBtmRght + xBtmRghtOuter;
+    int iTopLeftOuter = integralAOI.wdth * (yTopLeft + yOffset) + (xTopLeftOuter + xOffset);
+    int iTopRghtOuter = integralAOI.wdth * (yTopLeft + yOffset) + (xBtmRghtOuter + xOffset);
+    int iBtmLeftOuter = integralAOI.wdth * (yBtmRght + yOffset) + (xTopLeftOuter + xOffset);
+    int iBtmRghtOuter = integralAOI.wdth * (yBtmRght + yOffset) + (xBtmRghtOuter + xOffset);
 
     double intensityOuterLeft = I[iBtmLeft]      - I[iBtmLeftOuter] - I[iTopLeft]      + I[iTopLeftOuter];
     double intensityOuterRght = I[iBtmRghtOuter] - I[iBtmRght]      - I[iTopRghtOuter] + I[iTopRght];
@@ -372,7 +365,7 @@ inline double haarFeatureResponse(int x, int y, const std::vector<unsigned int>&
     return response;
 }
 
-AOIProperties detectPupilApprox(const std::vector<unsigned int>& I, const  AOIProperties& searchAOI, AOIProperties& haarAOI, const AOIProperties& glintAOI)
+AOIProperties detectPupilApprox(const std::vector<unsigned int>& I, const AOIProperties& integralAOI, const AOIProperties& searchAOI, AOIProperties& haarAOI, const AOIProperties& glintAOI)
 {
     double responseMax = -std::numeric_limits<double>::max(); // set to minimum double value;
     
@@ -386,7 +379,7 @@ AOIProperties detectPupilApprox(const std::vector<unsigned int>& I, const  AOIPr
     {
         for (int x = 0; x < wdth; x++)
         {
-            double response = haarFeatureResponse(x, y, I, searchAOI, haarAOI, glintAOI);
+            double response = haarFeatureResponse(x, y, I, integralAOI, searchAOI, haarAOI, glintAOI);
 
             if (response > responseMax)
             {
@@ -400,6 +393,74 @@ AOIProperties detectPupilApprox(const std::vector<unsigned int>& I, const  AOIPr
     return haarAOI;
 }
 
+inline double integralSum(const std::vector<unsigned int>& I, const AOIProperties& integralAOI, int xTopLeft, int yTopLeft, int xBtmRght, int yBtmRght)
+{
+    // sum of all pixels of rectangle, corners included
+
+    double sum = I[integralAOI.wdth * yBtmRght + xBtmRght];
+    if (xTopLeft > 0)                 { sum -= I[integralAOI.wdth * yBtmRght + xTopLeft - 1]; }
+    if (yTopLeft > 0)                 { sum -= I[integralAOI.wdth * (yTopLeft - 1) + xBtmRght]; }
+    if (xTopLeft > 0 && yTopLeft > 0) { sum += I[integralAOI.wdth * (yTopLeft - 1) + xTopLeft - 1]; }
+    return sum;
+}
+
+inline double integralSumClipped(const std::vector<unsigned int>& I, const AOIProperties& integralAOI, int xTopLeft, int yTopLeft, int xBtmRght, int yBtmRght, int& area)
+{
+    xTopLeft = std::max(xTopLeft, 0);
+    yTopLeft = std::max(yTopLeft, 0);
+    xBtmRght = std::min(xBtmRght, integralAOI.wdth - 1);
+    yBtmRght = std::min(yBtmRght, integralAOI.hght - 1);
+
+    if (xTopLeft > xBtmRght || yTopLeft > yBtmRght) { area = 0; return 0; }
+
+    area = (xBtmRght - xTopLeft + 1) * (yBtmRght - yTopLeft + 1);
+    return integralSum(I, integralAOI, xTopLeft, yTopLeft, xBtmRght, yBtmRght);
+}
+
+double haarContrast(const std::vector<unsigned int>& I, const AOIProperties& integralAOI, const AOIProperties& haarAOI, const AOIProperties& glintAOI)
+{
+    // Mean intensity of surroundings (detector enlarged by half its size on each side) minus mean intensity of detector.
+    // Glint is left out of both. A closed eye gives a low value, since the eyelid has no dark pupil.
+
+    int xTopLeft = haarAOI.xPos;
+    int yTopLeft = haarAOI.yPos;
+    int xBtmRght = haarAOI.xPos + haarAOI.wdth - 1;
+    int yBtmRght = haarAOI.yPos + haarAOI.hght - 1;
+
+    int xTopLeftOuter = round(xTopLeft - 0.5 * haarAOI.wdth);
+    int yTopLeftOuter = round(yTopLeft - 0.5 * haarAOI.hght);
+    int xBtmRghtOuter = round(xBtmRght + 0.5 * haarAOI.wdth);
+    int yBtmRghtOuter = round(yBtmRght + 0.5 * haarAOI.hght);
+
+    int areaInner;
+    int areaOuter;
+    int areaGlintInner;
+    int areaGlintOuter;
+
+    double intensityInner = integralSumClipped(I, integralAOI, xTopLeft,      yTopLeft,      xBtmRght,      yBtmRght,      areaInner);
+    double intensityOuter = integralSumClipped(I, integralAOI, xTopLeftOuter, yTopLeftOuter, xBtmRghtOuter, yBtmRghtOuter, areaOuter);
+
+    int xTopLeftGlint = glintAOI.xPos;
+    int yTopLeftGlint = glintAOI.yPos;
+    int xBtmRghtGlint = glintAOI.xPos + glintAOI.wdth - 1;
+    int yBtmRghtGlint = glintAOI.yPos + glintAOI.hght - 1;
+
+    double intensityGlintInner = integralSumClipped(I, integralAOI, std::max(xTopLeftGlint, xTopLeft),      std::max(yTopLeftGlint, yTopLeft),      std::min(xBtmRghtGlint, xBtmRght),      std::min(yBtmRghtGlint, yBtmRght),      areaGlintInner);
+    double intensityGlintOuter = integralSumClipped(I, integralAOI, std::max(xTopLeftGlint, xTopLeftOuter), std::max(yTopLeftGlint, yTopLeftOuter), std::min(xBtmRghtGlint, xBtmRghtOuter), std::min(yBtmRghtGlint, yBtmRghtOuter), areaGlintOuter);
+
+    // Surroundings are outer rectangle without inner rectangle
+
+    intensityOuter = intensityOuter - intensityGlintOuter - (intensityInner - intensityGlintInner);
+    areaOuter      = areaOuter      - areaGlintOuter      - (areaInner      - areaGlintInner);
+
+    intensityInner = intensityInner - intensityGlintInner;
+    areaInner      = areaInner      - areaGlintInner;
+
+    if (areaInner <= 0 || areaOuter <= 0) { return std::numeric_limits<double>::max(); } // cannot tell, assume eye is open
+
+    return (intensityOuter / areaOuter - intensityInner / areaInner);
+}
+
 std::vector<int> getEdgeIndices(const std::vector<int>& binaryImageVector, int tag)
 {
     int AOIArea = binaryImageVector.size();
@@ -1187,7 +1248,7 @@ std::vector<arcProperties> findGraphArcs(const detectionVariables& mDetectionVar
     return arcsAll;
 }
 
-std::vector<std::vector<int>> depthFirstSearch(std::vector<vertexProperties>& vVertexPropertiesAll, std::vector<arcProperties>& vArcPropertiesAll, std::vector<int>& pathArcsRoot, std::vector<int>& verticesCheckedAll, std::vector<int>& verticesChecked, std::vector<int>& arcsChecked, int vertexIndex)
+std::vector<std::vector<int>> depthFirstSearch(std::vector<vertexProperties>& vVertexPropertiesAll, std::vector<arcProperties>& vArcPropertiesAll, std::vector<int>& pathArcsRoot, std::vector<int>& verticesCheckedAll, std::vector<int>& verticesChecked, std::vector<int>& arcsChecked, int vertexIndex, DetectionDeadline* mDeadline = NULL)
 {
     // Depth-first search
     std::vector<std::vector<int>> pathArcsAll;
@@ -1197,6 +1258,8 @@ std::vector<std::vector<int>> depthFirstSearch(std::vector<vertexProperties>& vV
     
     for (int iArc = 0; iArc < numArcs; iArc++)
     {
+        if (mDeadline != NULL && mDeadline->isExpired()) { break; } // keep paths found so far
+
         int arcIndexNew = mVertex.connectedArcs[iArc];
         
         if (arcsChecked[arcIndexNew] == 0)
@@ -1224,7 +1287,7 @@ std::vector<std::vector<int>> depthFirstSearch(std::vector<vertexProperties>& vV
             {
                 if (verticesCheckedNew[vertexIndexNew] == 0) // add arc but stop at vertex
                 {
-                    std::vector<std::vector<int>> pathArcsNew = depthFirstSearch(vVertexPropertiesAll, vArcPropertiesAll, pathArcsRootNew, verticesCheckedAll, verticesCheckedNew, arcsCheckedNew, vertexIndexNew);
+                    std::vector<std::vector<int>> pathArcsNew = depthFirstSearch(vVertexPropertiesAll, vArcPropertiesAll, pathArcsRootNew, verticesCheckedAll, verticesCheckedNew, arcsCheckedNew, vertexIndexNew, mDeadline);
                     if (pathArcsNew.size() > 0) { pathArcsAll.insert(std::end(pathArcsAll), std::begin(pathArcsNew), std::end(pathArcsNew)); }
                 }
                 
@@ -1283,7 +1346,7 @@ std::vector<int> findPreferredPath(const detectionVariables& mDetectionVariables
     else { return pathLengths; } // return empty vector
 }
 
-std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables, std::vector<vertexProperties>& vVertexPropertiesAll, std::vector<arcProperties>& vArcPropertiesAll, const AOIProperties& mAOI)
+std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables, std::vector<vertexProperties>& vVertexPropertiesAll, std::vector<arcProperties>& vArcPropertiesAll, const AOIProperties& mAOI, DetectionDeadline* mDeadline = NULL)
 {
     int numArcsAll = vArcPropertiesAll.size();
     int numVerticesAll = vVertexPropertiesAll.size();
@@ -1304,13 +1367,15 @@ std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables,
     
     for (int iVertex = 0; iVertex < numTerminals; iVertex++) // loop through all (starting) vertices
     {
+        if (mDeadline != NULL && mDeadline->isExpired()) { break; }
+
         int jVertex = terminalVertices[iVertex];
         if (vVertexPropertiesAll[jVertex].connectedArcs.size() > 0) // ignore isolated nodes
         {
             std::vector<int> arcsChecked(numArcsAll, 0); // no arcs checked
             std::vector<int> verticesChecked(numVerticesAll, 0); // no arcs checked
             std::vector<int> pathArcsRoot; // start with no arcs
-            std::vector<std::vector<int>> pathArcsAll = depthFirstSearch(vVertexPropertiesAll, vArcPropertiesAll, pathArcsRoot, verticesCheckedAll, verticesChecked, arcsChecked, jVertex);
+            std::vector<std::vector<int>> pathArcsAll = depthFirstSearch(vVertexPropertiesAll, vArcPropertiesAll, pathArcsRoot, verticesCheckedAll, verticesChecked, arcsChecked, jVertex, mDeadline);
             pathsAll.insert(std::end(pathsAll), std::begin(pathArcsAll), std::end(pathArcsAll));
         }
         
@@ -1321,6 +1386,8 @@ std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables,
     
     for (int iVertex = 0; iVertex < numVerticesAll; iVertex++) // loop through all (starting) vertices
     {
+        if (mDeadline != NULL && mDeadline->isExpired()) { break; }
+
         if (verticesCheckedAll[iVertex] == 0)
         {
             if (vVertexPropertiesAll[iVertex].connectedArcs.size() > 0) // ignore isolated nodes
@@ -1334,7 +1401,8 @@ std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables,
                                                                              verticesCheckedAll,
                                                                              verticesChecked,
                                                                              arcsChecked,
-                                                                             iVertex);
+                                                                             iVertex,
+                                                                             mDeadline);
 
                 // Check for cyclic path
                 if (vVertexPropertiesAll[iVertex].tag == 2) // only internal vertices can have cyclic path
@@ -1515,7 +1583,7 @@ std::vector<int> processGraphTree(const detectionVariables& mDetectionVariables,
     return pathPoints;
 }
 
-std::vector<edgeProperties> edgeSelection(const detectionVariables& mDetectionVariables, std::vector<int>& cannyEdgeVector, AOIProperties mAOI)
+std::vector<edgeProperties> edgeSelection(const detectionVariables& mDetectionVariables, std::vector<int>& cannyEdgeVector, AOIProperties mAOI, DetectionDeadline* mDeadline)
 {
     std::vector<edgeProperties> vEdgePropertiesAll; // new structure containing length and indices of all selected edges
     
@@ -1563,7 +1631,7 @@ std::vector<edgeProperties> edgeSelection(const detectionVariables& mDetectionVa
 
                 if (numArcs > 0 && numVertices > 0)
                 {
-                    pathIndices = processGraphTree(mDetectionVariables, vVertexProperties, vArcProperties, mAOI);
+                    pathIndices = processGraphTree(mDetectionVariables, vVertexProperties, vArcProperties, mAOI, mDeadline);
 
                     edgeProperties mEdgeProperties;
                     mEdgeProperties.pointIndices = pathIndices;
@@ -2470,7 +2538,7 @@ ellipseProperties fitEllipse(std::vector<int> edgePointIndices, const AOIPropert
     return mEllipseProperties;
 }
 
-std::vector<edgeProperties> edgeCollectionFilter(const detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const std::vector<edgeProperties>& vEdgePropertiesAll, const AOIProperties& mAOI)
+std::vector<edgeProperties> edgeCollectionFilter(const detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const std::vector<edgeProperties>& vEdgePropertiesAll, const AOIProperties& mAOI, DetectionDeadline* mDeadline)
 {
     std::vector<edgeProperties> vEdgeProperties; // properties of edge collections
     
@@ -2480,13 +2548,21 @@ std::vector<edgeProperties> edgeCollectionFilter(const detectionVariables& mDete
 
     // First collect all ellipse fits
     
-    for (int combiNumEdges = numEdgesTotal; combiNumEdges >= 1; combiNumEdges--) // loop through all possible edge set sizes
+    bool DEADLINE_EXCEEDED = false; // collections found so far are kept, largest sets come first
+
+    for (int combiNumEdges = numEdgesTotal; combiNumEdges >= 1 && !DEADLINE_EXCEEDED; combiNumEdges--) // loop through all possible edge set sizes
     {
         std::vector<bool> edgeCombination(numEdgesTotal);
         std::fill(edgeCombination.begin() + numEdgesTotal - combiNumEdges, edgeCombination.end(), true);
         
         do // loop through all possible edge combinations for the current set size
         {
+            if (mDeadline != NULL && mDeadline->isExpired())
+            {
+                DEADLINE_EXCEEDED = true;
+                break;
+            }
+
             std::vector<double> combiEdgeScores(combiNumEdges);
             std::vector<int> combiEdgeIndices (combiNumEdges);
             std::vector<int> combiEdgeLengths (combiNumEdges);
@@ -2589,14 +2665,21 @@ std::vector<edgeProperties> edgeCollectionFilter(const detectionVariables& mDete
     return vEdgeProperties;
 }
 
-std::vector<ellipseProperties> ellipseFitting(const detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const std::vector<edgeProperties>& vEdgePropertiesAll, AOIProperties mAOI)
+std::vector<ellipseProperties> ellipseFitting(const detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const std::vector<edgeProperties>& vEdgePropertiesAll, AOIProperties mAOI, DetectionDeadline* mDeadline, int scaleFactor)
 {
     std::vector<ellipseProperties> vEllipsePropertiesAll; // vector to record information for each accepted ellipse fit
+
+    // Constants below are in full-resolution pixels
+
+    double aspectRatioSlopeScaled = aspectRatioSlope / scaleFactor;
+    double fitErrorOffset         = 0.5588 / scaleFactor;
     
     int numEdgesTotal = vEdgePropertiesAll.size();
     
     for (int iEdge = 0; iEdge < numEdgesTotal; iEdge++)
     {
+        if (mDeadline != NULL && mDeadline->isExpired()) { break; } // best fit is chosen from accepted fits so far
+
         std::vector<int> pointIndices = vEdgePropertiesAll[iEdge].pointIndices;
         double edgeSetLength          = vEdgePropertiesAll[iEdge].length;
 
@@ -2615,7 +2698,7 @@ std::vector<ellipseProperties> ellipseFitting(const detectionVariables& mDetecti
 
         // Size and shape absolute filter
         
-        double circumferenceUpperLimit = aspectRatioSlope * (mEllipseProperties.aspectRatio - 1) + mDetectionParameters.thresholdCircumferenceMax;
+        double circumferenceUpperLimit = aspectRatioSlopeScaled * (mEllipseProperties.aspectRatio - 1) + mDetectionParameters.thresholdCircumferenceMax;
         if (mEllipseProperties.circumference > circumferenceUpperLimit)                      { continue; } // no large ellipse
         if (mEllipseProperties.aspectRatio   < mDetectionParameters.thresholdAspectRatioMin) { continue; } // no large deviations from circular shape
 
@@ -2646,7 +2729,7 @@ std::vector<ellipseProperties> ellipseFitting(const detectionVariables& mDetecti
         std::reverse(fitErrorsSorted.begin(), fitErrorsSorted.end());
         std::vector<double> fitErrorsMax(fitErrorsSorted.begin(), fitErrorsSorted.begin() + round(mDetectionParameters.fitEdgeFraction * mEllipseProperties.circumference));
         double fitErrorAbsolute = calculateMean(fitErrorsMax); // absolute error
-        double fitErrorRelative = (fitErrorAbsolute + 0.5588) / mEllipseProperties.circumference; // relative error
+        double fitErrorRelative = (fitErrorAbsolute + fitErrorOffset) / mEllipseProperties.circumference; // relative error
         
         if (fitErrorRelative > mDetectionParameters.thresholdFitError) { continue; } // no large fit errors
         
@@ -2845,19 +2928,193 @@ void checkVariableLimits(detectionVariables& mDetectionVariables, const detectio
     }
 }
 
+double scaleDetection(detectionVariables& mDetectionVariables, detectionParameters& mDetectionParameters, AOIProperties& cannyAOI, int scaleFactor)
+{
+    // Edge stages at reduced scale. A pixel of the scaled image is the mean of a block of scaleFactor x scaleFactor pixels,
+    // starting at the Canny AOI, which becomes the origin. Returns ratio of curvatures at reduced and full scale.
+
+    double scaleOffset = 0.5 * (scaleFactor - 1); // centre of block
+
+    double curvatureFull = 0.5 * (getCurvatureUpperLimit(mDetectionVariables.predictedCircumference, mDetectionVariables.predictedAspectRatio, mDetectionVariables.windowLengthEdge) +
+                                  getCurvatureLowerLimit(mDetectionVariables.predictedCircumference, mDetectionVariables.predictedAspectRatio, mDetectionVariables.windowLengthEdge));
+
+    mDetectionVariables.predictedXPos                = (mDetectionVariables.predictedXPos - cannyAOI.xPos - scaleOffset) / scaleFactor;
+    mDetectionVariables.predictedYPos                = (mDetectionVariables.predictedYPos - cannyAOI.yPos - scaleOffset) / scaleFactor;
+    mDetectionVariables.predictedCircumference      /= scaleFactor;
+    mDetectionVariables.predictedWidth              /= scaleFactor;
+    mDetectionVariables.predictedHeight             /= scaleFactor;
+    mDetectionVariables.thresholdChangePositionUpper /= scaleFactor;
+
+    mDetectionParameters.thresholdCircumferenceMax    /= scaleFactor;
+    mDetectionParameters.thresholdCircumferenceMin    /= scaleFactor;
+    mDetectionParameters.thresholdChangePositionUpper /= scaleFactor;
+    mDetectionParameters.thresholdChangePositionLower /= scaleFactor;
+    mDetectionParameters.glintWdth                    /= scaleFactor;
+    mDetectionParameters.cannyBlurLevel = (mDetectionParameters.cannyBlurLevel + scaleFactor - 1) / scaleFactor; // stays on if it was on
+
+    cannyAOI.xPos = 0;
+    cannyAOI.yPos = 0;
+    cannyAOI.wdth = cannyAOI.wdth / scaleFactor;
+    cannyAOI.hght = cannyAOI.hght / scaleFactor;
+
+    checkVariableLimits(mDetectionVariables, mDetectionParameters); // circumference limits and edge window length at reduced scale
+
+    // Curvature depends on circumference and window length. Convert prediction with curvature limits at both scales
+
+    double curvatureScaled = 0.5 * (getCurvatureUpperLimit(mDetectionVariables.predictedCircumference, mDetectionVariables.predictedAspectRatio, mDetectionVariables.windowLengthEdge) +
+                                    getCurvatureLowerLimit(mDetectionVariables.predictedCircumference, mDetectionVariables.predictedAspectRatio, mDetectionVariables.windowLengthEdge));
+
+    double curvatureFactor = 1;
+    if (curvatureFull > 0 && curvatureScaled > 0) { curvatureFactor = curvatureScaled / curvatureFull; }
+
+    mDetectionVariables.predictedCurvature *= curvatureFactor;
+
+    return curvatureFactor;
+}
+
+std::vector<int> upscaleEdgeIndices(const std::vector<int>& edgeIndices, const AOIProperties& cannyAOIScaled, const AOIProperties& cannyAOI, int scaleFactor)
+{
+    // Point indices of reduced scale to centre of their block at full scale
+
+    int scaleOffset = (scaleFactor - 1) / 2;
+
+    std::vector<int> edgeIndicesNew(edgeIndices.size());
+
+    for (int iPoint = 0, numPoints = edgeIndices.size(); iPoint < numPoints; iPoint++)
+    {
+        int xPos = scaleFactor * (edgeIndices[iPoint] % cannyAOIScaled.wdth) + scaleOffset;
+        int yPos = scaleFactor * (edgeIndices[iPoint] / cannyAOIScaled.wdth) + scaleOffset;
+        edgeIndicesNew[iPoint] = yPos * cannyAOI.wdth + xPos;
+    }
+
+    return edgeIndicesNew;
+}
+
+void upscaleEllipse(ellipseProperties& mEllipseProperties, const AOIProperties& cannyAOI, int scaleFactor)
+{
+    double h = 0.5 * (scaleFactor - 1); // centre of block
+    double n = scaleFactor;
+
+    mEllipseProperties.xPos           = n * mEllipseProperties.xPos + h + cannyAOI.xPos;
+    mEllipseProperties.yPos           = n * mEllipseProperties.yPos + h + cannyAOI.yPos;
+    mEllipseProperties.width         *= n;
+    mEllipseProperties.height        *= n;
+    mEllipseProperties.circumference *= n;
+    mEllipseProperties.edgeLength    *= n;
+
+    if (mEllipseProperties.coefficients.size() != 6) { return; }
+
+    // Substitute x = (u - h) / n and y = (v - h) / n, with (u, v) relative to full-scale Canny AOI
+
+    std::vector<double> c = mEllipseProperties.coefficients;
+
+    mEllipseProperties.coefficients[0] = c[0] / (n * n);
+    mEllipseProperties.coefficients[1] = c[1] / (n * n);
+    mEllipseProperties.coefficients[2] = c[2] / (n * n);
+    mEllipseProperties.coefficients[3] = c[3] / n - (2 * c[0] + c[1]) * h / (n * n);
+    mEllipseProperties.coefficients[4] = c[4] / n - (2 * c[2] + c[1]) * h / (n * n);
+    mEllipseProperties.coefficients[5] = c[5] - (c[3] + c[4]) * h / n + (c[0] + c[1] + c[2]) * h * h / (n * n);
+}
+
+ellipseProperties refineEllipse(const cv::Mat& imageAOIGray, const detectionParameters& mDetectionParameters, const std::vector<int>& edgeIndices, const AOIProperties& cannyAOI, int bandWidth)
+{
+    // Ellipse fit through full-resolution Canny edge points close to the given edge points
+
+    ellipseProperties mEllipseProperties;
+    mEllipseProperties.DETECTED = false;
+
+    std::vector<char> band(cannyAOI.wdth * cannyAOI.hght, 0);
+
+    int xMin = cannyAOI.wdth;
+    int yMin = cannyAOI.hght;
+    int xMax = -1;
+    int yMax = -1;
+
+    for (int iPoint = 0, numPoints = edgeIndices.size(); iPoint < numPoints; iPoint++)
+    {
+        int xPos = edgeIndices[iPoint] % cannyAOI.wdth;
+        int yPos = edgeIndices[iPoint] / cannyAOI.wdth;
+
+        int xStart = std::max(xPos - bandWidth, 0);
+        int yStart = std::max(yPos - bandWidth, 0);
+        int xEnd   = std::min(xPos + bandWidth, cannyAOI.wdth - 1);
+        int yEnd   = std::min(yPos + bandWidth, cannyAOI.hght - 1);
+
+        for (int y = yStart; y <= yEnd; y++)
+        {
+            for (int x = xStart; x <= xEnd; x++) { band[y * cannyAOI.wdth + x] = 1; }
+        }
+
+        if (xStart < xMin) { xMin = xStart; }
+        if (yStart < yMin) { yMin = yStart; }
+        if (xEnd   > xMax) { xMax = xEnd; }
+        if (yEnd   > yMax) { yMax = yEnd; }
+    }
+
+    if (xMax < xMin || yMax < yMin) { return mEllipseProperties; }
+
+    // Canny edge detection in bounding box of band only
+
+    cv::Rect bandRect(xMin, yMin, xMax - xMin + 1, yMax - yMin + 1);
+
+    cv::Mat imageBand = imageAOIGray(bandRect);
+    cv::Mat imageBandBlurred;
+    int cannyBlurLevel = 2 * mDetectionParameters.cannyBlurLevel - 1; // should be odd
+    if (cannyBlurLevel > 0) { cv::GaussianBlur(imageBand, imageBandBlurred, cv::Size(cannyBlurLevel, cannyBlurLevel), 0, 0);
+    } else                  { imageBandBlurred = imageBand; }
+
+    cv::Mat imageCannyEdges;
+    cv::Canny(imageBandBlurred, imageCannyEdges, mDetectionParameters.cannyThresholdHigh, mDetectionParameters.cannyThresholdLow, 5);
+
+    std::vector<int> edgePointIndices;
+
+    for (int y = 0; y < bandRect.height; y++)
+    {
+        const uchar* rowEdges = imageCannyEdges.ptr<uchar>(y);
+
+        for (int x = 0; x < bandRect.width; x++)
+        {
+            int edgePointIndex = (y + yMin) * cannyAOI.wdth + (x + xMin);
+            if (rowEdges[x] > 0 && band[edgePointIndex]) { edgePointIndices.push_back(edgePointIndex); }
+        }
+    }
+
+    if (edgePointIndices.size() < edgeIndices.size()) { return mEllipseProperties; } // should have more points than at reduced scale
+
+    return fitEllipse(edgePointIndices, cannyAOI);
+}
+
 detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
                               const AOIProperties& imageAOI,
                               detectionVariables& mDetectionVariables,
                               const detectionParameters& mDetectionParameters,
                               dataVariables& mDataVariables,
                               drawVariables& mDrawVariables,
-                              const developmentOptions& mAdvancedOptions)
+                              const developmentOptions& mAdvancedOptions,
+                              diagnosticVariables* mDiagnosticVariables,
+                              stageInputs* mStageInputs)
 {
-    mDataVariables.DETECTED  = false;
-    mDrawVariables.PROCESSED = false;
+    PreprocessedFrame mPreprocessedFrame(imageOriginalBGR);
+    return eyeStalker(mPreprocessedFrame, imageAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables, mAdvancedOptions, mDiagnosticVariables, mStageInputs);
+}
 
-    int imageWdth = imageOriginalBGR.cols;
-    int imageHght = imageOriginalBGR.rows;
+detectionVariables eyeStalker(PreprocessedFrame& mPreprocessedFrame,
+                              const AOIProperties& imageAOI,
+                              detectionVariables& mDetectionVariables,
+                              const detectionParameters& mDetectionParameters,
+                              dataVariables& mDataVariables,
+                              drawVariables& mDrawVariables,
+                              const developmentOptions& mAdvancedOptions,
+                              diagnosticVariables* mDiagnosticVariables,
+                              stageInputs* mStageInputs)
+{
+    mDataVariables.DETECTED          = false;
+    mDataVariables.DEADLINE_EXCEEDED = false;
+    mDataVariables.BLINK             = false;
+    mDrawVariables.PROCESSED         = false;
+
+    StageTimer mStageTimer(mDataVariables); // empty without profiling
+    DetectionDeadline mDeadline(mDetectionParameters.timeBudget);
     
     checkVariableLimits(mDetectionVariables, mDetectionParameters); // keep variables within limits
     
@@ -2909,28 +3166,24 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     if (haarAOI.wdth > searchAOI.wdth) { haarAOI.wdth = searchAOI.wdth; }
     if (haarAOI.hght > searchAOI.hght) { haarAOI.hght = searchAOI.hght; }
     
-    // Convert to grayscale
-    
-    cv::Mat imageOriginalGray;
-    cv::cvtColor(imageOriginalBGR, imageOriginalGray, cv::COLOR_BGR2GRAY);
-    
     ////////////////////////////////////////////////////////////////////
     ///////////////////// APPROXIMATE DETECTION  ///////////////////////
     ////////////////////////////////////////////////////////////////////
 
     AOIProperties glintAOI;
     
-    double sizeFactorUp   = 2;
-    double sizeFactorDown = 1 / sizeFactorUp;
+    double sizeFactorUp   = PreprocessedFrame::sizeFactorUp;
+    double sizeFactorDown = PreprocessedFrame::sizeFactorDown;
 
-    // Down sample image
+    // Down sampled grayscale image (shared with other trackers on same frame)
 
-    int imgWdthResized = round(imageWdth * sizeFactorDown);
-    int imgHghtResized = round(imageHght * sizeFactorDown);
+    const cv::Mat& imageResized = mPreprocessedFrame.getResized();
 
-    cv::Size size(imgWdthResized, imgHghtResized);
-    cv::Mat imageResized;
-    cv::resize(imageOriginalGray, imageResized, size);
+    AOIProperties integralAOI;
+    integralAOI.xPos = 0;
+    integralAOI.yPos = 0;
+    integralAOI.wdth = imageResized.cols;
+    integralAOI.hght = imageResized.rows;
 
     AOIProperties searchAOIResized;
     searchAOIResized.xPos = sizeFactorDown * searchAOI.xPos;
@@ -2950,13 +3203,59 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
 
     // Haar-like feature detection
 
-    std::vector<unsigned int> integralImage = calculateIntImg(imageResized, searchAOIResized);
+    const std::vector<unsigned int>& integralImage = mPreprocessedFrame.getIntegralImage();
+
+    mStageTimer.restart(); // preprocessing is timed by the frame, since another tracker may have done it
+    mStageTimer.add(STAGE_GRAYSCALE, mPreprocessedFrame.getDuration(STAGE_GRAYSCALE));
+    mStageTimer.add(STAGE_RESIZE,    mPreprocessedFrame.getDuration(STAGE_RESIZE));
+    mStageTimer.add(STAGE_INTEGRAL,  mPreprocessedFrame.getDuration(STAGE_INTEGRAL));
 
     glintAOIResized = detectGlint(imageResized, searchAOIResized, glintAOIResized);
     glintAOIResized.xPos = searchAOIResized.xPos + glintAOIResized.xPos;
     glintAOIResized.yPos = searchAOIResized.yPos + glintAOIResized.yPos;
 
-    haarAOIResized = detectPupilApprox(integralImage, searchAOIResized, haarAOIResized, glintAOIResized);
+    mStageTimer.mark(STAGE_GLINT);
+
+    if (mStageInputs != NULL) // inputs of Haar-like feature detector
+    {
+        mStageInputs->PROCESSED        = false;
+        mStageInputs->imageResized     = imageResized.clone(); // frame may be re-used by caller
+        mStageInputs->integralImage    = integralImage;
+        mStageInputs->integralAOI      = integralAOI;
+        mStageInputs->searchAOIResized = searchAOIResized;
+        mStageInputs->haarAOIResized   = haarAOIResized;
+        mStageInputs->glintAOIResized  = glintAOIResized;
+    }
+
+    haarAOIResized = detectPupilApprox(integralImage, integralAOI, searchAOIResized, haarAOIResized, glintAOIResized);
+
+    // Blink detection. Without a dark pupil at the best Haar-like detector position, the eye is closed and the remaining
+    // stages are skipped. Tracker state is kept as it was before the blink, instead of losing certainty. An eye that stays
+    // closed for more than 'blinkLengthMax' frames is reported as lost, so that certainty decays as usual.
+
+    bool EYE_CLOSED = false;
+
+    if (mDetectionParameters.thresholdBlinkContrast > 0 && !mAdvancedOptions.CURVATURE_MEASUREMENT)
+    {
+        AOIProperties haarAOIIntegral = haarAOIResized;
+        haarAOIIntegral.xPos = searchAOIResized.xPos + haarAOIResized.xPos;
+        haarAOIIntegral.yPos = searchAOIResized.yPos + haarAOIResized.yPos;
+
+        EYE_CLOSED = (haarContrast(integralImage, integralAOI, haarAOIIntegral, glintAOIResized) < mDetectionParameters.thresholdBlinkContrast);
+    }
+
+    if (EYE_CLOSED) { mDetectionVariablesTemp.blinkLength++;  }
+    else            { mDetectionVariablesTemp.blinkLength = 0; } // contrast has recovered
+
+    if (EYE_CLOSED && mDetectionVariablesTemp.blinkLength <= blinkLengthMax)
+    {
+        mStageTimer.mark(STAGE_HAAR);
+
+        mDataVariables.BLINK = true;
+        return mDetectionVariablesTemp;
+    }
+
+    mStageTimer.mark(STAGE_HAAR);
 
     // Upsample to original size
 
@@ -2987,7 +3286,7 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
 //        if (predictionXPos < 0) { predictionXPos = 0; }
 //        if (predictionYPos < 0) { predictionYPos = 0; }
 
-//        double responsePrediction = haarFeatureResponse(     predictionXPos,      predictionYPos, integralImage, searchAOIResized, haarAOIResized, glintAOIResized);
+//        double responsePrediction = haarFeatureResponse(     predictionXPos,      predictionYPos, integralImage, integralAOI, searchAOIResized, haarAOIResized, glintAOIResized);
 
 //        double responseDeltaPrediction = mDetectionVariables.predictedHaarResponse - std::abs(mDetectionVariables.predictedHaarResponse - responsePrediction);
 
@@ -3035,32 +3334,55 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     // Crop image to new AOI
     
     cv::Rect outerRect(cannyAOI.xPos, cannyAOI.yPos, cannyAOI.wdth, cannyAOI.hght);
-    cv::Mat imageAOIBGR = imageOriginalBGR(outerRect);
-    
-    // Convert back to grayscale
-    
-    cv::Mat imageAOIGray;
-    cv::cvtColor(imageAOIBGR, imageAOIGray, cv::COLOR_BGR2GRAY);
+    cv::Mat imageAOIGray = mPreprocessedFrame.getGray()(outerRect).clone(); // continuous copy, since pixels are accessed through data pointer
+
+    // Multi-resolution detection. For large pupils, the edge stages run on a down-scaled copy of the Canny AOI, in which the
+    // pupil circumference is one to two times circumferenceScaled. The accepted fit is refined at full resolution afterwards.
+
+    int scaleFactor = 1;
+    if (mDetectionParameters.circumferenceScaled > 0 && !mAdvancedOptions.CURVATURE_MEASUREMENT)
+    {   scaleFactor = std::max(1, (int) floor(mDetectionVariables.predictedCircumference / mDetectionParameters.circumferenceScaled)); }
+    if (cannyAOI.wdth < scaleFactor || cannyAOI.hght < scaleFactor) { scaleFactor = 1; }
+
+    detectionParameters mDetectionParametersEdge = mDetectionParameters; // used by edge stages
+    AOIProperties cannyAOIFull     = cannyAOI;
+    cv::Mat       imageAOIGrayFull = imageAOIGray;
+    double curvatureFactor = 1;
+
+    if (scaleFactor > 1)
+    {
+        curvatureFactor = scaleDetection(mDetectionVariables, mDetectionParametersEdge, cannyAOI, scaleFactor);
+
+        cv::Rect scaledRect(0, 0, scaleFactor * cannyAOI.wdth, scaleFactor * cannyAOI.hght); // whole blocks of pixels only
+        cv::resize(imageAOIGrayFull(scaledRect), imageAOIGray, cv::Size(cannyAOI.wdth, cannyAOI.hght), 0, 0, cv::INTER_AREA);
+    }
 
     ///////////////////////////////////////////////////////////////////////
     /////////////////////// CANNY EDGE DETECTION  /////////////////////////
     ///////////////////////////////////////////////////////////////////////
 
     cv::Mat imageAOIGrayBlurred;
-    int cannyBlurLevel = 2 * mDetectionParameters.cannyBlurLevel - 1; // should be odd
+    int cannyBlurLevel = 2 * mDetectionParametersEdge.cannyBlurLevel - 1; // should be odd
     if (cannyBlurLevel > 0) { cv::GaussianBlur(imageAOIGray, imageAOIGrayBlurred, cv::Size(cannyBlurLevel, cannyBlurLevel), 0, 0);
     } else                  { imageAOIGrayBlurred = imageAOIGray; }
+
+    mStageTimer.mark(STAGE_BLUR); // includes cropping
     
     cv::Mat imageCannyEdges;
-    cv::Canny(imageAOIGrayBlurred, imageCannyEdges, mDetectionParameters.cannyThresholdHigh, mDetectionParameters.cannyThresholdLow, 5);
+    cv::Canny(imageAOIGrayBlurred, imageCannyEdges, mDetectionParametersEdge.cannyThresholdHigh, mDetectionParametersEdge.cannyThresholdLow, 5);
 
     std::vector<int> cannyEdgesOriginal  = cannyConversion(imageCannyEdges, cannyAOI); // convert to binary vector
+
+    mStageTimer.mark(STAGE_CANNY);
+
     std::vector<int> cannyEdgesSharpened = cannyEdgesOriginal;
     std::vector<int> edgePointsOriginal  = getEdgeIndices(cannyEdgesOriginal, 1);
     std::vector<int> edgePointsSharpened;
     edgePointsSharpened = sharpenEdges_1(cannyEdgesSharpened, edgePointsOriginal,  cannyAOI);
     edgePointsSharpened = sharpenEdges_2(cannyEdgesSharpened, edgePointsSharpened, cannyAOI);
 
+    mStageTimer.mark(STAGE_SHARPENING);
+
     /////////////////////////////////////////////////////////////////////////////
     //////////////////////////// EDGE SELECTION   ///////////////////////////////
     /////////////////////////////////////////////////////////////////////////////
@@ -3069,8 +3391,33 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     mDetectionVariables.predictedXPosRelative = mDetectionVariables.predictedXPos - cannyAOI.xPos;
     mDetectionVariables.predictedYPosRelative = mDetectionVariables.predictedYPos - cannyAOI.yPos;
 
-    std::vector<edgeProperties> vEdgePropertiesAll = edgeSelection(mDetectionVariables, cannyEdgesSharpened, cannyAOI);
-    vEdgePropertiesAll = removeShortEdges(mDetectionVariables, vEdgePropertiesAll);
+    if (mStageInputs != NULL) // inputs of Canny edge detection, sharpening and edge selection
+    {
+        mStageInputs->PROCESSED            = true;
+        mStageInputs->scaleFactor          = scaleFactor;
+        mStageInputs->cannyAOI             = cannyAOI;
+        mStageInputs->imageAOIGray         = imageAOIGray;
+        mStageInputs->imageAOIGrayBlurred  = imageAOIGrayBlurred;
+        mStageInputs->cannyEdgesOriginal   = cannyEdgesOriginal;
+        mStageInputs->cannyEdgesSharpened  = cannyEdgesSharpened;
+        mStageInputs->edgePointsOriginal   = edgePointsOriginal;
+        mStageInputs->mDetectionParameters = mDetectionParametersEdge;
+        mStageInputs->mDetectionVariables  = mDetectionVariables;
+    }
+
+    // Out of time, or eye closed for too long: remaining stages get no edges and frame is not detected
+
+    std::vector<edgeProperties> vEdgePropertiesAll;
+
+    if (!EYE_CLOSED && !mDeadline.isExpired())
+    {
+        vEdgePropertiesAll = edgeSelection(mDetectionVariables, cannyEdgesSharpened, cannyAOI, &mDeadline);
+        vEdgePropertiesAll = removeShortEdges(mDetectionVariables, vEdgePropertiesAll);
+    }
+
+    if (mDeadline.isExpired()) { vEdgePropertiesAll.clear(); }
+
+    mStageTimer.mark(STAGE_EDGE_SELECTION);
 
     /////////////////////////////////////////////////////////////////////////////
     //////////////////////////// EDGE SEGMENTATION   ////////////////////////////
@@ -3104,7 +3451,14 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     double curvatureUpperLimit;
     double curvatureLowerLimit;
     
-    calculateCurvatureLimits(mDetectionVariables, mDetectionParameters, curvatureUpperLimit, curvatureLowerLimit);
+    calculateCurvatureLimits(mDetectionVariables, mDetectionParametersEdge, curvatureUpperLimit, curvatureLowerLimit);
+
+    if (mStageInputs != NULL)
+    {
+        mStageInputs->curvatureUpperLimit = curvatureUpperLimit;
+        mStageInputs->curvatureLowerLimit = curvatureLowerLimit;
+        mStageInputs->vEdgesSelected      = vEdgePropertiesAll;
+    }
     
     // Curvature segmentation
     
@@ -3121,6 +3475,10 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     
     vEdgePropertiesAll = removeShortEdges(mDetectionVariables, vEdgePropertiesAll);
 
+    mStageTimer.mark(STAGE_SEGMENTATION_CURVATURE);
+
+    if (mDeadline.isExpired()) { vEdgePropertiesAll.clear(); }
+
     // Calculate additional edge properties
     
     for (int iEdge = 0, numEdges = vEdgePropertiesAll.size(); iEdge < numEdges; iEdge++)
@@ -3129,12 +3487,16 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
         
         mEdgeProperties.length      = calculateEdgeLength(mEdgeProperties.pointIndices, cannyAOI);
         mEdgeProperties.radii       = calculateEdgeRadii(mEdgeProperties, cannyAOI, mDetectionVariables.predictedXPosRelative, mDetectionVariables.predictedYPosRelative);
-        mEdgeProperties.gradients   = calculateRadialGradients(mDetectionVariables, mDetectionParameters, imageAOIGray, mEdgeProperties.pointIndices);
-        mEdgeProperties.intensities = findEdgeIntensities(imageAOIGray, mDetectionParameters, mEdgeProperties, cannyAOI);
+        mEdgeProperties.gradients   = calculateRadialGradients(mDetectionVariables, mDetectionParametersEdge, imageAOIGray, mEdgeProperties.pointIndices);
+        mEdgeProperties.intensities = findEdgeIntensities(imageAOIGray, mDetectionParametersEdge, mEdgeProperties, cannyAOI);
         
         vEdgePropertiesAll[iEdge] = mEdgeProperties;
     }
 
+    mStageTimer.mark(STAGE_CLASSIFICATION); // edge features
+
+    if (mStageInputs != NULL) { mStageInputs->vEdgesCurvature = vEdgePropertiesAll; }
+
     // Length segmentation
     
     if (!(mAdvancedOptions.CURVATURE_MEASUREMENT))
@@ -3152,6 +3514,10 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     
     vEdgePropertiesAll = removeShortEdges(mDetectionVariables, vEdgePropertiesAll);
 
+    mStageTimer.mark(STAGE_SEGMENTATION_LENGTH);
+
+    if (mStageInputs != NULL) { mStageInputs->vEdgesLength = vEdgePropertiesAll; }
+
     // Score segmentation
     
     if (mDetectionVariables.certaintyPosition > certaintyThreshold || mDetectionVariables.certaintyFeatures > certaintyThreshold)
@@ -3162,7 +3528,7 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
         {
             edgeProperties mEdgeProperties    = vEdgePropertiesAll[iEdge];
             
-            std::vector<edgeProperties> vEdgePropertiesTemp = edgeSegmentationScore(mDetectionVariables, mDetectionParameters, mEdgeProperties, cannyAOI);
+            std::vector<edgeProperties> vEdgePropertiesTemp = edgeSegmentationScore(mDetectionVariables, mDetectionParametersEdge, mEdgeProperties, cannyAOI);
             vEdgePropertiesNew.insert(vEdgePropertiesNew.end(), vEdgePropertiesTemp.begin(), vEdgePropertiesTemp.end());
         }
         
@@ -3171,6 +3537,10 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     
     vEdgePropertiesAll = removeShortEdges(mDetectionVariables, vEdgePropertiesAll);
 
+    mStageTimer.mark(STAGE_SEGMENTATION_SCORE);
+
+    if (mDeadline.isExpired()) { vEdgePropertiesAll.clear(); }
+
     ///////////////////////////////////////////////////////////////////////////
     ////////////////////////// EDGE CLASSIFICATION  ///////////////////////////
     ///////////////////////////////////////////////////////////////////////////
@@ -3210,7 +3580,7 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     
     // Do edge classification
     
-    std::vector<int> acceptedEdges = edgeClassification(mDetectionVariables, mDetectionParameters, vEdgePropertiesAll);
+    std::vector<int> acceptedEdges = edgeClassification(mDetectionVariables, mDetectionParametersEdge, vEdgePropertiesAll);
     
     std::vector<edgeProperties> vEdgePropertiesNew;
     
@@ -3225,10 +3595,21 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     /////////////////////// ELLIPSE FITTING  /////////////////////////
     //////////////////////////////////////////////////////////////////
 
-    std::vector<edgeProperties> vEdgeCollectionProperties = edgeCollectionFilter(mDetectionVariables, mDetectionParameters, vEdgePropertiesNew, cannyAOI);
-    std::vector<ellipseProperties> vEllipsePropertiesAll  = ellipseFitting(mDetectionVariables, mDetectionParameters, vEdgeCollectionProperties, cannyAOI); // ellipse fitting
+    mStageTimer.mark(STAGE_CLASSIFICATION);
+
+    std::vector<edgeProperties> vEdgeCollectionProperties = edgeCollectionFilter(mDetectionVariables, mDetectionParametersEdge, vEdgePropertiesNew, cannyAOI, &mDeadline);
+
+    if (mStageInputs != NULL)
+    {
+        mStageInputs->vEdgesClassified = vEdgePropertiesNew;
+        mStageInputs->vEdgeCollections = vEdgeCollectionProperties;
+    }
+
+    mStageTimer.mark(STAGE_SUBSETS);
+
+    std::vector<ellipseProperties> vEllipsePropertiesAll  = ellipseFitting(mDetectionVariables, mDetectionParametersEdge, vEdgeCollectionProperties, cannyAOI, &mDeadline, scaleFactor); // ellipse fitting
     ellipseProperties mEllipseProperties; // properties of accepted fit
-    std::vector<int> acceptedFitIndices = ellipseFitFilter(mDetectionVariables, mDetectionParameters, vEllipsePropertiesAll); // grab best fit
+    std::vector<int> acceptedFitIndices = ellipseFitFilter(mDetectionVariables, mDetectionParametersEdge, vEllipsePropertiesAll); // grab best fit
     int numFits = acceptedFitIndices.size();
 
     if (numFits > 0)
@@ -3332,7 +3713,69 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
         mEllipseProperties.DETECTED = false;
         vEllipsePropertiesAll.push_back(mEllipseProperties);
     }
-    
+
+    // Back to full resolution. Fitted edges mark a band, in which full-resolution Canny edges give the final fit
+
+    if (scaleFactor > 1)
+    {
+        AOIProperties cannyAOIScaled = cannyAOI;
+        cannyAOI     = cannyAOIFull;
+        imageAOIGray = imageAOIGrayFull;
+
+        edgePointsSharpened = upscaleEdgeIndices(edgePointsSharpened, cannyAOIScaled, cannyAOI, scaleFactor);
+
+        std::vector<int> edgeIndicesFitted;
+
+        for (int iEdge = 0, numEdges = vEdgePropertiesAll.size(); iEdge < numEdges; iEdge++)
+        {
+            edgeProperties& mEdgeProperties = vEdgePropertiesAll[iEdge];
+
+            mEdgeProperties.pointIndices  = upscaleEdgeIndices(mEdgeProperties.pointIndices, cannyAOIScaled, cannyAOI, scaleFactor);
+            mEdgeProperties.length       *= scaleFactor;
+            mEdgeProperties.radius       *= scaleFactor;
+            mEdgeProperties.radiusVar    *= scaleFactor;
+            mEdgeProperties.curvature    /= curvatureFactor;
+            mEdgeProperties.curvatureMax /= curvatureFactor;
+            mEdgeProperties.curvatureMin /= curvatureFactor;
+
+            if (mEdgeProperties.tag == 2)
+            {   edgeIndicesFitted.insert(edgeIndicesFitted.end(), mEdgeProperties.pointIndices.begin(), mEdgeProperties.pointIndices.end()); }
+        }
+
+        for (int iFit = 0, numFits = vEllipsePropertiesAll.size(); iFit < numFits; iFit++)
+        {
+            if (vEllipsePropertiesAll[iFit].tag >= 0) { upscaleEllipse(vEllipsePropertiesAll[iFit], cannyAOI, scaleFactor); }
+        }
+
+        if (mEllipseProperties.DETECTED)
+        {
+            upscaleEllipse(mEllipseProperties, cannyAOI, scaleFactor);
+            mEllipseProperties.curvature /= curvatureFactor;
+
+            ellipseProperties mEllipsePropertiesRefined = refineEllipse(imageAOIGray, mDetectionParameters, edgeIndicesFitted, cannyAOI, scaleFactor);
+
+            // Refined fit should stay within band
+
+            double bandWidth = scaleFactor;
+
+            if (mEllipsePropertiesRefined.DETECTED &&
+                    std::abs(mEllipsePropertiesRefined.xPos          - mEllipseProperties.xPos)          <= bandWidth &&
+                    std::abs(mEllipsePropertiesRefined.yPos          - mEllipseProperties.yPos)          <= bandWidth &&
+                    std::abs(mEllipsePropertiesRefined.circumference - mEllipseProperties.circumference) <= 2 * M_PI * bandWidth)
+            {
+                mEllipseProperties.angle         = mEllipsePropertiesRefined.angle;
+                mEllipseProperties.aspectRatio   = mEllipsePropertiesRefined.aspectRatio;
+                mEllipseProperties.circumference = mEllipsePropertiesRefined.circumference;
+                mEllipseProperties.xPos          = mEllipsePropertiesRefined.xPos;
+                mEllipseProperties.yPos          = mEllipsePropertiesRefined.yPos;
+                mEllipseProperties.width         = mEllipsePropertiesRefined.width;
+                mEllipseProperties.height        = mEllipsePropertiesRefined.height;
+                mEllipseProperties.coefficients  = mEllipsePropertiesRefined.coefficients;
+            }
+        }
+    }
+
+    mStageTimer.mark(STAGE_FITTING);
     
     /////////////////////////////////////////////////////////////////
     /////////////////////// SAVING DATA  ////////////////////////////
@@ -3341,12 +3784,51 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     mDetectionVariables = mDetectionVariablesTemp;
     detectionVariables mDetectionVariablesNew = mDetectionVariables; // properties for next frame
     
-    mDataVariables.edgeData    = vEdgePropertiesAll;     // edge data
-    mDataVariables.ellipseData = vEllipsePropertiesAll;  // ellipse data
+    if (mDiagnosticVariables != NULL) // edge and ellipse data
+    {
+        int numEdges = vEdgePropertiesAll.size();
+        int numFits  = vEllipsePropertiesAll.size();
+
+        mDiagnosticVariables->edgeData   .resize(numEdges);
+        mDiagnosticVariables->ellipseData.resize(numFits);
+
+        for (int iEdge = 0; iEdge < numEdges; iEdge++)
+        {
+            const edgeProperties& mEdgeProperties = vEdgePropertiesAll[iEdge];
+            edgeSummary& mEdgeSummary = mDiagnosticVariables->edgeData[iEdge];
+
+            mEdgeSummary.curvature    = mEdgeProperties.curvature;
+            mEdgeSummary.curvatureMax = mEdgeProperties.curvatureMax;
+            mEdgeSummary.curvatureMin = mEdgeProperties.curvatureMin;
+            mEdgeSummary.gradient     = mEdgeProperties.gradient;
+            mEdgeSummary.intensity    = mEdgeProperties.intensity;
+            mEdgeSummary.length       = mEdgeProperties.length;
+            mEdgeSummary.radius       = mEdgeProperties.radius;
+            mEdgeSummary.radiusVar    = mEdgeProperties.radiusVar;
+            mEdgeSummary.tag          = mEdgeProperties.tag;
+        }
+
+        for (int iFit = 0; iFit < numFits; iFit++)
+        {
+            const ellipseProperties& mEllipsePropertiesFit = vEllipsePropertiesAll[iFit];
+            ellipseSummary& mEllipseSummary = mDiagnosticVariables->ellipseData[iFit];
+
+            mEllipseSummary.angle         = mEllipsePropertiesFit.angle;
+            mEllipseSummary.aspectRatio   = mEllipsePropertiesFit.aspectRatio;
+            mEllipseSummary.circumference = mEllipsePropertiesFit.circumference;
+            mEllipseSummary.edgeLength    = mEllipsePropertiesFit.edgeLength;
+            mEllipseSummary.edgeScore     = mEllipsePropertiesFit.edgeScore;
+            mEllipseSummary.fitError      = mEllipsePropertiesFit.fitError;
+            mEllipseSummary.xPos          = mEllipsePropertiesFit.xPos;
+            mEllipseSummary.yPos          = mEllipsePropertiesFit.yPos;
+            mEllipseSummary.tag           = mEllipsePropertiesFit.tag;
+        }
+    }
     
     // Save parameters
     
-    mDataVariables.DETECTED = mEllipseProperties.DETECTED;
+    mDataVariables.DETECTED          = mEllipseProperties.DETECTED;
+    mDataVariables.DEADLINE_EXCEEDED = mDeadline.hasExpired();
     
     // Calculate new threshold limits. Thresholds are harsher with higher certainties (= lower certainty factors)
 
@@ -3504,7 +3986,7 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
         int predictionYPos = round(sizeFactorDown * (mDetectionVariables.predictedYPos - 0.5 * (haarAOI.hght - 1) - searchAOI.yPos));
         if (predictionXPos < 0) { predictionXPos = 0; }
         if (predictionYPos < 0) { predictionYPos = 0; }
-        double haarResponse      = haarFeatureResponse(predictionXPos, predictionYPos, integralImage, searchAOIResized, haarAOIResized, glintAOIResized);
+        double haarResponse      = haarFeatureResponse(predictionXPos, predictionYPos, integralImage, integralAOI, searchAOIResized, haarAOIResized, glintAOIResized);
         double errorHaarResponse = haarResponse - mDetectionVariables.predictedHaarResponse;
         mDetectionVariablesNew.momentumHaarResponse  = mDetectionVariables.momentumHaarResponse  + mDetectionParameters.gainAppearance * (errorHaarResponse - mDetectionVariables.momentumHaarResponse);
         mDetectionVariablesNew.predictedHaarResponse = mDetectionVariables.predictedHaarResponse + mDetectionParameters.gainAppearance *  errorHaarResponse + mDetectionVariables.certaintyFeatures * mDetectionVariables.momentumHaarResponse;
@@ -3550,12 +4032,97 @@ detectionVariables eyeStalker(const cv::Mat& imageOriginalBGR,
     mDrawVariables.predictedYPos = round(mDetectionVariables.predictedYPos);
     
     mDrawVariables.cannyEdgeIndices    = edgePointsSharpened;
-    mDrawVariables.edgeData            = vEdgePropertiesAll;
     mDrawVariables.ellipseCoefficients = mEllipseProperties.coefficients;
 
+    mDrawVariables.edgeData.assign(vEdgePropertiesAll.size(), edgeProperties()); // outline only, other per-edge vectors are not drawn
+    for (int iEdge = 0; iEdge < (int) vEdgePropertiesAll.size(); iEdge++)
+    {
+        mDrawVariables.edgeData[iEdge].tag          = vEdgePropertiesAll[iEdge].tag;
+        mDrawVariables.edgeData[iEdge].pointIndices = vEdgePropertiesAll[iEdge].pointIndices;
+    }
+
+    mStageTimer.mark(STAGE_UPDATE);
+
     return mDetectionVariablesNew; // use these variables for next frame
 }
 
+// Detection variables
+
+void resetVariablesHard(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
+{
+    // Reset all variables
+
+    mDetectionVariables.averageAspectRatio   = initialAspectRatio; // close to perfect circle
+    mDetectionVariables.averageCircumference = 0.5 * (mDetectionParameters.thresholdCircumferenceMax + mDetectionParameters.thresholdCircumferenceMin); // calculate first
+    mDetectionVariables.averageCurvature     = initialCurvature;
+    mDetectionVariables.averageGradient      = 0;
+    mDetectionVariables.averageHeight        = mDetectionVariables.averageCircumference / M_PI;
+    mDetectionVariables.averageIntensity     = initialIntensity;
+    mDetectionVariables.averageHaarResponse  = 0;
+    mDetectionVariables.averageWidth         = mDetectionVariables.averageCircumference / M_PI;
+
+    mDetectionVariables.certaintyAverages      = 0;
+    mDetectionVariables.certaintyAveragesPrime = 0;
+
+    resetVariablesSoft(mDetectionVariables, mDetectionParameters, mAOI);
+}
+
+void resetVariablesSoft(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
+{
+    // Reset everything but averages
+
+    mDetectionVariables.predictedAngle         = 0;
+    mDetectionVariables.predictedAspectRatio   = mDetectionVariables.averageAspectRatio;
+    mDetectionVariables.predictedCircumference = mDetectionVariables.averageCircumference;
+    mDetectionVariables.predictedCurvature     = mDetectionVariables.averageCurvature;
+    mDetectionVariables.predictedGradient      = mDetectionVariables.averageGradient;
+    mDetectionVariables.predictedHaarResponse  = mDetectionVariables.averageHaarResponse;
+    mDetectionVariables.predictedHeight        = mDetectionVariables.averageHeight;
+    mDetectionVariables.predictedIntensity     = mDetectionVariables.averageIntensity;
+    mDetectionVariables.predictedWidth         = mDetectionVariables.averageWidth;
+    mDetectionVariables.predictedXPos          = 0.5 * (mAOI.wdth - 1); // centre of image
+    mDetectionVariables.predictedYPos          = 0.5 * (mAOI.hght - 1);
+
+    mDetectionVariables.momentumAspectRatio   = 0;
+    mDetectionVariables.momentumCircumference = 0;
+    mDetectionVariables.momentumCurvature     = 0;
+    mDetectionVariables.momentumGradient      = 0;
+    mDetectionVariables.momentumHaarResponse  = 0;
+    mDetectionVariables.momentumHeight        = 0;
+    mDetectionVariables.momentumIntensity     = 0;
+    mDetectionVariables.momentumWidth         = 0;
+    mDetectionVariables.momentumXPos          = 0;
+    mDetectionVariables.momentumYPos          = 0;
+
+    mDetectionVariables.blinkLength = 0;
+
+    double maxChangeThresholdAspectRatio_1 = mDetectionVariables.predictedAspectRatio - mDetectionParameters.thresholdAspectRatioMin;
+    double maxChangeThresholdAspectRatio_2 = 1.0 - mDetectionVariables.predictedAspectRatio;
+    double maxChangeThresholdAspectRatio   = std::max(maxChangeThresholdAspectRatio_1, maxChangeThresholdAspectRatio_2);
+    double rangeChangeThresholdAspectRatio = maxChangeThresholdAspectRatio   - mDetectionParameters.thresholdChangeAspectRatioUpper;
+    mDetectionVariables.thresholdChangeAspectRatioUpper   = rangeChangeThresholdAspectRatio   + mDetectionParameters.thresholdChangeAspectRatioUpper;
+
+    double maxChangeThresholdCircumference_1 = (mDetectionParameters.thresholdCircumferenceMax - mDetectionVariables.predictedCircumference) / mDetectionParameters.thresholdCircumferenceMax;
+    double maxChangeThresholdCircumference_2 = (mDetectionVariables.predictedCircumference - mDetectionParameters.thresholdCircumferenceMin) / mDetectionVariables.predictedCircumference;
+    double maxChangeThresholdCircumference   = std::max(maxChangeThresholdCircumference_1, maxChangeThresholdCircumference_2);
+    double rangeChangeThresholdCircumference = maxChangeThresholdCircumference - mDetectionParameters.thresholdChangeCircumferenceUpper;
+    mDetectionVariables.thresholdChangeCircumferenceUpper = rangeChangeThresholdCircumference + mDetectionParameters.thresholdChangeCircumferenceUpper;
+
+    double maxChangeThresholdPositionX = mAOI.wdth - mDetectionVariables.predictedWidth;
+    double maxChangeThresholdPositionY = mAOI.hght - mDetectionVariables.predictedHeight;
+    double maxChangeThresholdPosition  = std::max(maxChangeThresholdPositionX, maxChangeThresholdPositionY);
+    double rangeChangeThresholdPosition = maxChangeThresholdPosition - mDetectionParameters.thresholdChangePositionUpper;
+    mDetectionVariables.thresholdChangePositionUpper = rangeChangeThresholdPosition + mDetectionParameters.thresholdChangePositionUpper;
+
+    mDetectionVariables.thresholdScoreEdge = 0;
+    mDetectionVariables.thresholdScoreFit  = 0;
+
+    mDetectionVariables.certaintyFeatures      = 0;
+    mDetectionVariables.certaintyPosition      = 0;
+    mDetectionVariables.certaintyFeaturesPrime = 0;
+    mDetectionVariables.certaintyPositionPrime = 0;
+}
+
 // Look-up tables
 
 double getCurvatureUpperLimit(double circumference, double aspectRatio, int windowLength)
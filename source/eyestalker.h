@@ -20,6 +20,7 @@
 // Files
 
 #include "constants.h"
+#include "preprocessedframe.h"
 #include "structures.h"
 
 // Libraries
@@ -54,11 +55,96 @@ detectionVariables eyeStalker(const cv::Mat&,
                               const detectionParameters&,
                               dataVariables&,
                               drawVariables&,
-                              const developmentOptions& = developmentOptions{});
+                              const developmentOptions& = developmentOptions{},
+                              diagnosticVariables* = NULL,  // per-edge and per-fit values, if not NULL
+                              stageInputs* = NULL);         // inputs of the individual stages, if not NULL
+
+// Same as above, but re-uses preprocessed image data of a frame that is shared between trackers
+
+detectionVariables eyeStalker(PreprocessedFrame&,
+                              const AOIProperties&,
+                              detectionVariables&,
+                              const detectionParameters&,
+                              dataVariables&,
+                              drawVariables&,
+                              const developmentOptions& = developmentOptions{},
+                              diagnosticVariables* = NULL,  // per-edge and per-fit values, if not NULL
+                              stageInputs* = NULL);         // inputs of the individual stages, if not NULL
+
+// Initial detection variables for a new trial (hard) or after tracking was lost (soft, keeps running averages)
+
+void resetVariablesHard(detectionVariables&, const detectionParameters&, const AOIProperties&);
+void resetVariablesSoft(detectionVariables&, const detectionParameters&, const AOIProperties&);
 
 double getCurvatureUpperLimit(double, double, int);
 double getCurvatureLowerLimit(double, double, int);
 
+// Time budget of one eyeStalker() call (detectionParameters::timeBudget). It is checked between stages and inside the
+// combinatorial loops (graph search, edge subsets, ellipse fits), which then stop and keep what they have found so far.
+
+class DetectionDeadline
+{
+
+public:
+
+    DetectionDeadline(double timeBudget); // ms, no limit if 0
+
+    bool isExpired(); // reads clock, stays expired once budget has run out
+    bool hasExpired() const { return EXPIRED; } // without reading clock
+
+private:
+
+    bool EXPIRED;
+    bool UNLIMITED;
+    std::chrono::steady_clock::time_point timeDeadline;
+};
+
+// Stages of eyeStalker(), declared for the stage benchmarks (bench/main.cpp)
+
+double calculateMean   (const std::vector<double>&);
+double calculateMeanInt(const std::vector<int>&);
+double calculateVariance(const std::vector<double>&);
+void checkVariableLimits(detectionVariables&, const detectionParameters&);
+
+AOIProperties detectGlint      (const cv::Mat&, AOIProperties searchAOI, AOIProperties glintAOI);
+AOIProperties detectPupilApprox(const std::vector<unsigned int>&, const AOIProperties& integralAOI, const AOIProperties& searchAOI, AOIProperties& haarAOI, const AOIProperties& glintAOI);
+double        haarContrast     (const std::vector<unsigned int>&, const AOIProperties& integralAOI, const AOIProperties& haarAOI, const AOIProperties& glintAOI); // AOIs relative to integral image
+
+std::vector<int> cannyConversion(const cv::Mat&, AOIProperties);
+std::vector<int> getEdgeIndices (const std::vector<int>&, int tag);
+std::vector<int> sharpenEdges_1 (std::vector<int>& binaryImageVector, std::vector<int>& edgePointIndicesOld, AOIProperties);
+std::vector<int> sharpenEdges_2 (std::vector<int>& binaryImageVector, std::vector<int>& edgePointIndicesOld, AOIProperties);
+
+std::vector<edgeProperties> edgeSelection   (const detectionVariables&, std::vector<int>& cannyEdgeVector, AOIProperties, DetectionDeadline* = NULL);
+std::vector<edgeProperties> removeShortEdges(const detectionVariables&, const std::vector<edgeProperties>&);
+
+void calculateEdgeDirections (const std::vector<int>& edgeIndices, std::vector<double>& edgeXTangents, std::vector<double>& edgeYTangents, AOIProperties);
+void calculateCurvatureLimits(const detectionVariables&, const detectionParameters&, double& curvatureUpperLimit, double& curvatureLowerLimit);
+void calculateCurvatureStats (const detectionVariables&, edgeProperties&);
+void restoreEdgePoints       (edgeProperties&, std::vector<int>& cannyEdgeVector, AOIProperties);
+
+double              calculateEdgeLength     (const std::vector<int>& edgePoints, const AOIProperties&);
+std::vector<double> calculateCurvatures     (const detectionVariables&, std::vector<double>& xNormals, std::vector<double>& yNormals, const std::vector<double>& xTangentsAll, const std::vector<double>& yTangentsAll);
+std::vector<double> calculateEdgeRadii      (const edgeProperties&, AOIProperties, double xCentre, double yCentre);
+std::vector<int>    calculateRadialGradients(const detectionVariables&, const detectionParameters&, const cv::Mat&, const std::vector<int> edgeIndices);
+std::vector<int>    findEdgeIntensities     (const cv::Mat&, const detectionParameters&, const edgeProperties&, AOIProperties);
+
+std::vector<edgeProperties> edgeSegmentationCurvature(const detectionVariables&, const edgeProperties&, const double curvatureUpperLimit, const double curvatureLowerLimit);
+std::vector<edgeProperties> edgeSegmentationLength   (const detectionVariables&, const edgeProperties&, const AOIProperties&);
+std::vector<edgeProperties> edgeSegmentationScore    (const detectionVariables&, const detectionParameters&, const edgeProperties&, const AOIProperties&);
+
+std::vector<int>               edgeClassification  (const detectionVariables&, const detectionParameters&, std::vector<edgeProperties>&);
+std::vector<edgeProperties>    edgeCollectionFilter(const detectionVariables&, const detectionParameters&, const std::vector<edgeProperties>&, const AOIProperties&, DetectionDeadline* = NULL);
+std::vector<ellipseProperties> ellipseFitting      (const detectionVariables&, const detectionParameters&, const std::vector<edgeProperties>&, AOIProperties, DetectionDeadline* = NULL, int scaleFactor = 1); // edges at reduced scale if scaleFactor > 1
+ellipseProperties              fitEllipse          (std::vector<int> edgePointIndices, const AOIProperties&);
+
+// Multi-resolution detection (detectionParameters::circumferenceScaled)
+
+double            scaleDetection    (detectionVariables&, detectionParameters&, AOIProperties& cannyAOI, int scaleFactor); // returns curvature ratio
+std::vector<int>  upscaleEdgeIndices(const std::vector<int>&, const AOIProperties& cannyAOIScaled, const AOIProperties& cannyAOI, int scaleFactor);
+void              upscaleEllipse    (ellipseProperties&, const AOIProperties& cannyAOI, int scaleFactor);
+ellipseProperties refineEllipse     (const cv::Mat&, const detectionParameters&, const std::vector<int>& edgeIndices, const AOIProperties& cannyAOI, int bandWidth);
+
 
 #endif // EYESTALKER
 
@@ -0,0 +1,385 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "framecodec.h"
+
+namespace
+{
+
+const int codecBlockLength = 16; // residuals per block sharing one Rice parameter
+const int codecRiceLimit   = 24; // unary part longer than this is replaced by escape code and raw value
+
+inline int countLeadingZeros(uint64_t value) // value must not be 0
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    while (!(value & (1ULL << 63))) { value <<= 1; count++; }
+    return count;
+#endif
+}
+
+class BitWriter // bits are written most significant first into preallocated memory
+{
+
+public:
+
+    BitWriter(unsigned char* data) : data(data), dataStart(data), bitBuffer(0), bitCount(0) {}
+
+    inline void put(uint32_t value, int numberOfBits) // at most 32 bits
+    {
+        bitBuffer |= (uint64_t) value << (64 - bitCount - numberOfBits);
+        bitCount  += numberOfBits;
+
+        if (bitCount >= 32)
+        {
+            data[0] = (unsigned char) (bitBuffer >> 56);
+            data[1] = (unsigned char) (bitBuffer >> 48);
+            data[2] = (unsigned char) (bitBuffer >> 40);
+            data[3] = (unsigned char) (bitBuffer >> 32);
+            data += 4;
+            bitBuffer <<= 32;
+            bitCount   -= 32;
+        }
+    }
+
+    size_t flush() // returns number of bytes written
+    {
+        while (bitCount > 0)
+        {
+            *data++ = (unsigned char) (bitBuffer >> 56);
+            bitBuffer <<= 8;
+            bitCount   -= 8;
+        }
+
+        bitCount = 0;
+        return data - dataStart;
+    }
+
+private:
+
+    unsigned char* data;
+    unsigned char* dataStart;
+    uint64_t bitBuffer;
+    int bitCount;
+};
+
+class BitReader
+{
+
+public:
+
+    BitReader(const unsigned char* data, size_t dataSize) : data(data), dataEnd(data + dataSize), bitBuffer(0), bitCount(0), bitsRead(0), bitsTotal((uint64_t) dataSize * 8) { fill(); }
+
+    inline uint32_t get(int numberOfBits) // at most 32 bits
+    {
+        if (numberOfBits == 0) { return 0; }
+        if (bitCount < 32) { fill(); }
+
+        uint32_t value = (uint32_t) (bitBuffer >> (64 - numberOfBits));
+        bitBuffer <<= numberOfBits;
+        bitCount   -= numberOfBits;
+        bitsRead   += numberOfBits;
+        return value;
+    }
+
+    inline int getUnary(int limit) // number of one bits before next zero bit, at most 'limit'
+    {
+        if (bitCount < 32) { fill(); }
+
+        uint64_t inverted = ~bitBuffer;
+        int count = (inverted == 0) ? 64 : countLeadingZeros(inverted);
+        if (count > limit) { count = limit; }
+
+        bitBuffer <<= (count + 1); // including terminating zero
+        bitCount   -= (count + 1);
+        bitsRead   += (count + 1);
+        return count;
+    }
+
+    bool isValid() const { return (bitsRead <= bitsTotal); } // false if zeros past end of data were read
+
+private:
+
+    const unsigned char* data;
+    const unsigned char* dataEnd;
+    uint64_t bitBuffer;
+    int bitCount;
+    uint64_t bitsRead;
+    uint64_t bitsTotal;
+
+    inline void fill()
+    {
+        while (bitCount <= 56 && data < dataEnd)
+        {
+            bitBuffer |= (uint64_t) *data++ << (56 - bitCount);
+            bitCount  += 8;
+        }
+
+        if (data >= dataEnd && bitCount < 32) { bitCount = 64; } // past end of data, reads zeros
+    }
+};
+
+inline int predictPixel(int a, int b, int c) // left, up, up-left
+{
+    // Median edge detector, written as median of a, b and a + b - c so that it compiles without branches
+
+    return std::max(std::min(a, b), std::min(std::max(a, b), a + b - c));
+}
+
+inline int mapResidual  (int residual) { return (residual << 1) ^ (residual >> 31); } // 0, -1, 1, -2, 2, ... to 0, 1, 2, 3, 4, ...
+inline int unmapResidual(int value)    { return (value >> 1) ^ -(value & 1); }
+
+inline int getRiceParameter(int sum, int count)
+{
+    int k = 0;
+    while ((count << (k + 1)) <= sum && k < 7) { k++; }
+    return k;
+}
+
+struct codecHeader
+{
+    uint16_t wdth;
+    uint16_t hght;
+    uint8_t  channels;
+    uint8_t  version;
+    uint16_t reserved;
+};
+
+}
+
+bool encodeFrame(const cv::Mat& image, std::vector<unsigned char>& buffer)
+{
+    if (image.empty() || (image.channels() != 1 && image.channels() != 3) || image.elemSize1() != 1) { return false; }
+
+    int channels  = image.channels();
+    int imageWdth = image.cols;
+    int imageHght = image.rows;
+    int rowLength = imageWdth * channels;
+
+    codecHeader mHeader;
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    mHeader.wdth     = imageWdth;
+    mHeader.hght     = imageHght;
+    mHeader.channels = channels;
+    mHeader.version  = 1;
+
+    // Worst case: every residual escaped, plus Rice parameter per block
+
+    int numberOfBlocks = (rowLength + codecBlockLength - 1) / codecBlockLength;
+    size_t bufferSizeMax = sizeof(mHeader) + ((size_t) imageHght * (rowLength * (codecRiceLimit + 9) + numberOfBlocks * 3)) / 8 + 8;
+
+    buffer.resize(bufferSizeMax);
+    std::memcpy(buffer.data(), &mHeader, sizeof(mHeader));
+
+    BitWriter mBitWriter(buffer.data() + sizeof(mHeader));
+
+    std::vector<int> residuals(rowLength);
+
+    for (int y = 0; y < imageHght; y++)
+    {
+        const unsigned char* rowCurrent  = image.ptr(y);
+        const unsigned char* rowPrevious = (y > 0) ? image.ptr(y - 1) : NULL;
+
+        // Prediction residuals of whole row (modulo 256). First row is predicted from the left, first column from above.
+
+        for (int x = 0; x < channels; x++)
+        {
+            int prediction = (y == 0) ? 128 : rowPrevious[x];
+            residuals[x] = mapResidual((signed char) (rowCurrent[x] - prediction));
+        }
+
+        if (y == 0)
+        {
+            for (int x = channels; x < rowLength; x++) { residuals[x] = mapResidual((signed char) (rowCurrent[x] - rowCurrent[x - channels])); }
+        }
+        else
+        {
+            for (int x = channels; x < rowLength; x++)
+            {
+                int prediction = predictPixel(rowCurrent[x - channels], rowPrevious[x], rowPrevious[x - channels]);
+                residuals[x] = mapResidual((signed char) (rowCurrent[x] - prediction));
+            }
+        }
+
+        // Rice code per block
+
+        for (int xStart = 0; xStart < rowLength; xStart += codecBlockLength)
+        {
+            int xEnd = std::min(xStart + codecBlockLength, rowLength);
+
+            int sum = 0;
+            for (int x = xStart; x < xEnd; x++) { sum += residuals[x]; }
+
+            int k = getRiceParameter(sum, xEnd - xStart);
+            mBitWriter.put(k, 3);
+
+            for (int x = xStart; x < xEnd; x++)
+            {
+                int value = residuals[x];
+                int q = value >> k;
+
+                if (q < codecRiceLimit) { mBitWriter.put((((1u << (q + 1)) - 2) << k) | (value & ((1 << k) - 1)), q + 1 + k); } // q ones, zero, k bits
+                else
+                {
+                    mBitWriter.put((1u << (codecRiceLimit + 1)) - 2, codecRiceLimit + 1); // escape
+                    mBitWriter.put(value, 8);
+                }
+            }
+        }
+    }
+
+    buffer.resize(sizeof(mHeader) + mBitWriter.flush());
+
+    return true;
+}
+
+bool decodeFrame(const unsigned char* data, size_t dataSize, cv::Mat& image)
+{
+    codecHeader mHeader;
+    if (dataSize < sizeof(mHeader)) { return false; }
+    std::memcpy(&mHeader, data, sizeof(mHeader));
+
+    if (mHeader.version != 1) { return false; }
+    if (image.cols != mHeader.wdth || image.rows != mHeader.hght || image.channels() != mHeader.channels) { return false; }
+
+    int channels  = mHeader.channels;
+    int rowLength = mHeader.wdth * channels;
+
+    BitReader mBitReader(data + sizeof(mHeader), dataSize - sizeof(mHeader));
+
+    std::vector<int> residuals(rowLength);
+
+    for (int y = 0; y < mHeader.hght; y++)
+    {
+        unsigned char* rowCurrent = image.ptr(y);
+        const unsigned char* rowPrevious = (y > 0) ? image.ptr(y - 1) : NULL;
+
+        for (int xStart = 0; xStart < rowLength; xStart += codecBlockLength)
+        {
+            int xEnd = std::min(xStart + codecBlockLength, rowLength);
+            int k = mBitReader.get(3);
+
+            for (int x = xStart; x < xEnd; x++)
+            {
+                int q = mBitReader.getUnary(codecRiceLimit);
+
+                if (q < codecRiceLimit) { residuals[x] = (q << k) | mBitReader.get(k); }
+                else                    { residuals[x] = mBitReader.get(8); }
+            }
+        }
+
+        for (int x = 0; x < channels; x++)
+        {
+            int prediction = (y == 0) ? 128 : rowPrevious[x];
+            rowCurrent[x] = (unsigned char) (prediction + unmapResidual(residuals[x]));
+        }
+
+        if (y == 0)
+        {
+            for (int x = channels; x < rowLength; x++) { rowCurrent[x] = (unsigned char) (rowCurrent[x - channels] + unmapResidual(residuals[x])); }
+        }
+        else
+        {
+            for (int x = channels; x < rowLength; x++)
+            {
+                int prediction = predictPixel(rowCurrent[x - channels], rowPrevious[x], rowPrevious[x - channels]);
+                rowCurrent[x] = (unsigned char) (prediction + unmapResidual(residuals[x]));
+            }
+        }
+    }
+
+    return mBitReader.isValid();
+}
+
+void benchmarkFrameCodec(const std::vector<cv::Mat>& vImages, std::ostream& output)
+{
+    if (vImages.empty()) { return; }
+
+    double megabytesRaw = 0;
+    for (int iImage = 0; iImage < (int) vImages.size(); iImage++) { megabytesRaw += vImages[iImage].total() * vImages[iImage].elemSize() / (double) (1024 * 1024); }
+
+    output << "method ratio encode_MB/s decode_MB/s\n";
+
+    // Built-in codec
+
+    {
+        std::vector<std::vector<unsigned char>> vBuffers(vImages.size());
+        double bytesEncoded = 0;
+
+        auto t1 = std::chrono::steady_clock::now();
+        for (int iImage = 0; iImage < (int) vImages.size(); iImage++) { encodeFrame(vImages[iImage], vBuffers[iImage]); bytesEncoded += vBuffers[iImage].size(); }
+        auto t2 = std::chrono::steady_clock::now();
+
+        std::vector<cv::Mat> vImagesDecoded(vImages.size());
+
+        for (int iImage = 0; iImage < (int) vImages.size(); iImage++)
+        {
+            vImagesDecoded[iImage].create(vImages[iImage].rows, vImages[iImage].cols, vImages[iImage].type());
+            decodeFrame(vBuffers[iImage].data(), vBuffers[iImage].size(), vImagesDecoded[iImage]);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+
+        bool LOSSLESS = true;
+
+        for (int iImage = 0; iImage < (int) vImages.size() && LOSSLESS; iImage++)
+        {
+            int rowLength = vImages[iImage].cols * vImages[iImage].elemSize();
+            for (int y = 0; y < vImages[iImage].rows; y++)
+            {
+                if (std::memcmp(vImagesDecoded[iImage].ptr(y), vImages[iImage].ptr(y), rowLength) != 0) { LOSSLESS = false; break; }
+            }
+        }
+
+        double timeEncode = std::chrono::duration<double>(t2 - t1).count();
+        double timeDecode = std::chrono::duration<double>(t3 - t2).count();
+
+        output << "codec "
+               << megabytesRaw / (bytesEncoded / (1024 * 1024)) << " "
+               << megabytesRaw / timeEncode << " "
+               << megabytesRaw / timeDecode;
+
+        if (!LOSSLESS) { output << " (decoding mismatch)"; }
+        output << "\n";
+    }
+
+    // PNG
+
+    for (int compressionLevel = 0; compressionLevel <= 9; compressionLevel++)
+    {
+        std::vector<int> compressionParameters;
+        compressionParameters.push_back(CV_IMWRITE_PNG_COMPRESSION);
+        compressionParameters.push_back(compressionLevel);
+
+        std::vector<std::vector<unsigned char>> vBuffers(vImages.size());
+        double bytesEncoded = 0;
+
+        auto t1 = std::chrono::steady_clock::now();
+        for (int iImage = 0; iImage < (int) vImages.size(); iImage++) { cv::imencode(".png", vImages[iImage], vBuffers[iImage], compressionParameters); bytesEncoded += vBuffers[iImage].size(); }
+        auto t2 = std::chrono::steady_clock::now();
+        for (int iImage = 0; iImage < (int) vImages.size(); iImage++) { cv::imdecode(vBuffers[iImage], CV_LOAD_IMAGE_UNCHANGED); }
+        auto t3 = std::chrono::steady_clock::now();
+
+        double timeEncode = std::chrono::duration<double>(t2 - t1).count();
+        double timeDecode = std::chrono::duration<double>(t3 - t2).count();
+
+        output << "png" << compressionLevel << " "
+               << megabytesRaw / (bytesEncoded / (1024 * 1024)) << " "
+               << megabytesRaw / timeEncode << " "
+               << megabytesRaw / timeDecode << "\n";
+    }
+}
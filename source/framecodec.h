@@ -0,0 +1,48 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+// Standard Template
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// Lossless codec for 8-bit camera frames.
+//
+// Every pixel is predicted from its left, upper and upper-left neighbour (median edge detector, as in JPEG-LS)
+// and the prediction residual is written with an adaptive Golomb-Rice code. Eye images are smooth apart from
+// the pupil and glint edges, so most residuals are small. Frames are coded independently of each other,
+// so that any frame in a recording can be decoded on its own.
+
+bool encodeFrame(const cv::Mat& image, std::vector<unsigned char>& buffer); // 8-bit, 1 or 3 channels
+bool decodeFrame(const unsigned char* data, size_t dataSize, cv::Mat& image); // image must be allocated with correct size and type
+
+// Compression ratio and encode/decode speed of codec compared to PNG compression levels 0-9
+
+void benchmarkFrameCodec(const std::vector<cv::Mat>& vImages, std::ostream& output);
+
+#endif // FRAMECODEC_H
@@ -0,0 +1,358 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "framecontainer.h"
+
+static_assert(sizeof(frameContainerHeader) == 64, "container header must be 64 bytes");
+static_assert(sizeof(frameChunkHeader)     == 24, "chunk header must be 24 bytes");
+static_assert(sizeof(frameIndexEntry)      == 16, "index entry must be 16 bytes");
+
+// Writer
+
+FrameContainerWriter::FrameContainerWriter()
+{
+    fileOffset = 0;
+}
+
+FrameContainerWriter::~FrameContainerWriter()
+{
+    close();
+}
+
+bool FrameContainerWriter::open(const std::string& filename)
+{
+    close();
+
+    file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    frameContainerHeader mHeader;
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    std::memcpy(mHeader.magic, frameContainerMagic, sizeof(mHeader.magic));
+    mHeader.version = 1;
+
+    file.write((const char*) &mHeader, sizeof(mHeader));
+
+    fileOffset = sizeof(mHeader);
+    vIndex.clear();
+
+    return file.good();
+}
+
+bool FrameContainerWriter::appendFrame(int frameIndex, double timestamp, const cv::Mat& image)
+{
+    if (image.empty()) { return false; }
+
+    cv::Mat imageContinuous = image;
+    if (!image.isContinuous()) { imageContinuous = image.clone(); }
+
+    return appendChunk(frameIndex, timestamp, imageContinuous, FRAME_CODEC_RAW, imageContinuous.ptr(), imageContinuous.total() * imageContinuous.elemSize());
+}
+
+bool FrameContainerWriter::appendEncodedFrame(int frameIndex, double timestamp, const cv::Mat& image, const std::vector<unsigned char>& imageEncoded)
+{
+    return appendChunk(frameIndex, timestamp, image, FRAME_CODEC_PREDICTIVE, imageEncoded.data(), imageEncoded.size());
+}
+
+bool FrameContainerWriter::appendChunk(int frameIndex, double timestamp, const cv::Mat& image, int codec, const unsigned char* payload, size_t payloadSize)
+{
+    if (!file.is_open() || image.empty()) { return false; }
+
+    frameChunkHeader mChunkHeader;
+    std::memset(&mChunkHeader, 0, sizeof(mChunkHeader));
+    mChunkHeader.frameIndex  = frameIndex;
+    mChunkHeader.wdth        = image.cols;
+    mChunkHeader.hght        = image.rows;
+    mChunkHeader.channels    = image.channels();
+    mChunkHeader.codec       = codec;
+    mChunkHeader.payloadSize = payloadSize;
+    mChunkHeader.timestamp   = timestamp;
+
+    file.write((const char*) &mChunkHeader, sizeof(mChunkHeader));
+    file.write((const char*) payload, payloadSize);
+
+    if ((int) vIndex.size() <= frameIndex) { vIndex.resize(frameIndex + 1, frameIndexEntry{0, 0}); }
+    vIndex[frameIndex].offset    = fileOffset;
+    vIndex[frameIndex].timestamp = timestamp;
+
+    fileOffset += sizeof(mChunkHeader) + payloadSize;
+
+    return file.good();
+}
+
+void FrameContainerWriter::close()
+{
+    if (!file.is_open()) { return; }
+
+    // Index is appended after last frame, then header is updated to point to it
+
+    frameContainerHeader mHeader;
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    std::memcpy(mHeader.magic, frameContainerMagic, sizeof(mHeader.magic));
+    mHeader.version     = 1;
+    mHeader.frameCount  = vIndex.size();
+    mHeader.indexOffset = fileOffset;
+
+    if (!vIndex.empty()) { file.write((const char*) vIndex.data(), vIndex.size() * sizeof(frameIndexEntry)); }
+
+    file.seekp(0);
+    file.write((const char*) &mHeader, sizeof(mHeader));
+    file.close();
+
+    vIndex.clear();
+    fileOffset = 0;
+}
+
+// Reader
+
+namespace
+{
+
+bool isValidChunk(const frameChunkHeader& mChunkHeader, uint64_t offset, size_t dataSize)
+{
+    if (offset < sizeof(frameContainerHeader) || offset > dataSize || dataSize - offset < sizeof(frameChunkHeader)) { return false; }
+    if (mChunkHeader.payloadSize > dataSize - offset - sizeof(frameChunkHeader)) { return false; } // beyond end of file
+    if (mChunkHeader.wdth == 0 || mChunkHeader.hght == 0) { return false; }
+    if (mChunkHeader.channels != 1 && mChunkHeader.channels != 3) { return false; }
+
+    uint64_t imageSize = (uint64_t) mChunkHeader.wdth * mChunkHeader.hght * mChunkHeader.channels;
+
+    if      (mChunkHeader.codec == FRAME_CODEC_RAW)        { return (mChunkHeader.payloadSize == imageSize); }
+    else if (mChunkHeader.codec == FRAME_CODEC_PREDICTIVE) { return (mChunkHeader.payloadSize > 0); } // decoder checks for overruns
+
+    return false; // unknown codec
+}
+
+}
+
+FrameContainerReader::FrameContainerReader()
+{
+    data     = NULL;
+    dataSize = 0;
+
+#ifdef _WIN32
+    hFile    = INVALID_HANDLE_VALUE;
+    hMapping = NULL;
+#else
+    fileDescriptor = -1;
+#endif
+}
+
+FrameContainerReader::~FrameContainerReader()
+{
+    close();
+}
+
+bool FrameContainerReader::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+
+    hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(hFile, &fileSize);
+    dataSize = fileSize.QuadPart;
+
+    hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL) { close(); return false; }
+
+    data = (const unsigned char*) MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+#else
+
+    fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) { return false; }
+
+    struct stat fileStatus;
+    fstat(fileDescriptor, &fileStatus);
+    dataSize = fileStatus.st_size;
+
+    void* mapping = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) { close(); return false; }
+
+    data = (const unsigned char*) mapping;
+
+#endif
+
+    if (data == NULL || !readIndex()) { close(); return false; }
+
+    return true;
+}
+
+bool FrameContainerReader::readIndex()
+{
+    if (dataSize < sizeof(frameContainerHeader)) { return false; }
+
+    frameContainerHeader mHeader;
+    std::memcpy(&mHeader, data, sizeof(mHeader));
+
+    if (std::memcmp(mHeader.magic, frameContainerMagic, sizeof(mHeader.magic)) != 0) { return false; }
+
+    vIndex.clear();
+
+    uint64_t frameCountMax = (dataSize - sizeof(frameContainerHeader)) / sizeof(frameChunkHeader); // every frame takes at least a chunk header
+
+    if (mHeader.indexOffset >= sizeof(frameContainerHeader) && mHeader.indexOffset <= dataSize && mHeader.frameCount <= frameCountMax &&
+        mHeader.frameCount <= (dataSize - mHeader.indexOffset) / sizeof(frameIndexEntry))
+    {
+        vIndex.resize(mHeader.frameCount);
+        if (mHeader.frameCount > 0) { std::memcpy(vIndex.data(), data + mHeader.indexOffset, mHeader.frameCount * sizeof(frameIndexEntry)); }
+        return true; // entries are checked when frame is read
+    }
+
+    // Index missing (recording was interrupted), walk through chunks instead
+
+    uint64_t offset = sizeof(frameContainerHeader);
+
+    while (offset + sizeof(frameChunkHeader) <= dataSize)
+    {
+        frameChunkHeader mChunkHeader;
+        std::memcpy(&mChunkHeader, data + offset, sizeof(mChunkHeader));
+
+        if (!isValidChunk(mChunkHeader, offset, dataSize)) { break; } // incomplete or corrupt last frame
+        if (mChunkHeader.frameIndex >= frameCountMax)      { break; } // corrupt frame index
+
+        if (vIndex.size() <= mChunkHeader.frameIndex) { vIndex.resize(mChunkHeader.frameIndex + 1, frameIndexEntry{0, 0}); }
+        vIndex[mChunkHeader.frameIndex].offset    = offset;
+        vIndex[mChunkHeader.frameIndex].timestamp = mChunkHeader.timestamp;
+
+        offset += sizeof(frameChunkHeader) + mChunkHeader.payloadSize;
+    }
+
+    return true;
+}
+
+void FrameContainerReader::close()
+{
+#ifdef _WIN32
+    if (data != NULL)                  { UnmapViewOfFile(data); }
+    if (hMapping != NULL)              { CloseHandle(hMapping); }
+    if (hFile != INVALID_HANDLE_VALUE) { CloseHandle(hFile); }
+    hMapping = NULL;
+    hFile    = INVALID_HANDLE_VALUE;
+#else
+    if (data != NULL)        { munmap((void*) data, dataSize); }
+    if (fileDescriptor >= 0) { ::close(fileDescriptor); }
+    fileDescriptor = -1;
+#endif
+
+    data     = NULL;
+    dataSize = 0;
+    vIndex.clear();
+}
+
+bool FrameContainerReader::isOpen() const { return (data != NULL); }
+
+int FrameContainerReader::getFrameCount() const { return vIndex.size(); }
+
+double FrameContainerReader::getTimestamp(int frameIndex) const
+{
+    if (frameIndex < 0 || frameIndex >= (int) vIndex.size()) { return 0; }
+    return vIndex[frameIndex].timestamp;
+}
+
+cv::Mat FrameContainerReader::getFrame(int frameIndex) const
+{
+    if (!isOpen() || frameIndex < 0 || frameIndex >= (int) vIndex.size()) { return cv::Mat(); }
+
+    uint64_t offset = vIndex[frameIndex].offset;
+    if (offset == 0) { return cv::Mat(); } // frame was never written
+    if (offset < sizeof(frameContainerHeader) || offset > dataSize || dataSize - offset < sizeof(frameChunkHeader)) { return cv::Mat(); } // corrupt index
+
+    frameChunkHeader mChunkHeader;
+    std::memcpy(&mChunkHeader, data + offset, sizeof(mChunkHeader));
+
+    if (!isValidChunk(mChunkHeader, offset, dataSize)) { return cv::Mat(); }
+
+    int imageType = CV_8UC1;
+    if (mChunkHeader.channels == 3) { imageType = CV_8UC3; }
+
+    const unsigned char* payload = data + offset + sizeof(frameChunkHeader);
+
+    if (mChunkHeader.codec == FRAME_CODEC_RAW) { return cv::Mat(mChunkHeader.hght, mChunkHeader.wdth, imageType, (void*) payload); }
+
+    if (mChunkHeader.codec == FRAME_CODEC_PREDICTIVE)
+    {
+        cv::Mat image(mChunkHeader.hght, mChunkHeader.wdth, imageType);
+        if (decodeFrame(payload, mChunkHeader.payloadSize, image)) { return image; }
+    }
+
+    return cv::Mat(); // unknown codec or corrupt frame
+}
+
+// Conversion
+
+bool convertContainerToPNG(const std::string& trialDirectory)
+{
+    FrameContainerReader mReader;
+    if (!mReader.open(trialDirectory + "/" + frameContainerFilename)) { return false; }
+
+    std::string directoryRaw = trialDirectory + "/raw";
+    if (!boost::filesystem::exists(directoryRaw)) { boost::filesystem::create_directory(directoryRaw); }
+
+    std::vector<int> compressionParameters;
+    compressionParameters.push_back(CV_IMWRITE_PNG_COMPRESSION);
+    compressionParameters.push_back(0);
+
+    for (int iFrame = 0; iFrame < mReader.getFrameCount(); iFrame++)
+    {
+        cv::Mat image = mReader.getFrame(iFrame);
+        if (image.empty()) { continue; }
+
+        std::stringstream filename;
+        filename << directoryRaw << "/" << iFrame << ".png";
+
+        if (!cv::imwrite(filename.str(), image, compressionParameters)) { return false; }
+    }
+
+    return true;
+}
+
+bool convertPNGToContainer(const std::string& trialDirectory, const std::vector<double>& timestamps)
+{
+    if (!boost::filesystem::exists(trialDirectory + "/raw/0.png")) { return false; } // keep existing container
+
+    FrameContainerWriter mWriter;
+    if (!mWriter.open(trialDirectory + "/" + frameContainerFilename)) { return false; }
+
+    for (int iFrame = 0; ; iFrame++)
+    {
+        std::stringstream filename;
+        filename << trialDirectory << "/raw/" << iFrame << ".png";
+
+        if (!boost::filesystem::exists(filename.str())) { break; }
+
+        cv::Mat image = cv::imread(filename.str(), CV_LOAD_IMAGE_GRAYSCALE); // recordings are saved in grayscale
+
+        double timestamp = 0;
+        if (iFrame < (int) timestamps.size()) { timestamp = timestamps[iFrame]; }
+
+        std::vector<unsigned char> imageEncoded;
+
+        if (encodeFrame(image, imageEncoded) && imageEncoded.size() < image.total() * image.elemSize())
+        {
+            if (!mWriter.appendEncodedFrame(iFrame, timestamp, image, imageEncoded)) { return false; }
+        }
+        else if (!mWriter.appendFrame(iFrame, timestamp, image)) { return false; }
+    }
+
+    mWriter.close();
+
+    return true;
+}
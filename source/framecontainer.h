@@ -0,0 +1,155 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef FRAMECONTAINER_H
+#define FRAMECONTAINER_H
+
+// Files
+
+#include "framecodec.h"
+
+// Standard Template
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Boost
+
+#include <boost/filesystem.hpp>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// Memory mapping
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Single-file container for the raw frames of one trial (trial_N/raw.esv), replacing one PNG file per frame.
+//
+// Layout: file header, followed by one chunk per frame (chunk header + pixel data), followed by an index
+// with the file offset and time stamp of every frame. Frames are only ever appended. The index is written
+// when the container is closed; if a recording was interrupted the reader rebuilds it from the chunk headers.
+
+const char frameContainerMagic[8] = {'E', 'S', 'T', 'K', 'R', 'A', 'W', '1'};
+const std::string frameContainerFilename = "raw.esv";
+
+enum frameCodec
+{
+    FRAME_CODEC_RAW        = 0, // uncompressed pixel data
+    FRAME_CODEC_PREDICTIVE = 1  // lossless, see framecodec.h
+};
+
+struct frameContainerHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t frameCount;
+    uint64_t indexOffset; // 0 if container was not closed properly
+    uint8_t  padding[32];
+};
+
+struct frameChunkHeader
+{
+    uint32_t frameIndex;
+    uint16_t wdth;
+    uint16_t hght;
+    uint8_t  channels;
+    uint8_t  codec;
+    uint16_t reserved;
+    uint32_t payloadSize; // in bytes, following this header
+    double   timestamp;   // in ms
+};
+
+struct frameIndexEntry
+{
+    uint64_t offset; // of chunk header
+    double   timestamp;
+};
+
+class FrameContainerWriter
+{
+
+public:
+
+    FrameContainerWriter();
+    ~FrameContainerWriter();
+
+    bool appendEncodedFrame(int frameIndex, double timestamp, const cv::Mat& image, const std::vector<unsigned char>& imageEncoded); // encoded with 'encodeFrame'
+    bool appendFrame(int frameIndex, double timestamp, const cv::Mat& image);
+    bool open(const std::string& filename);
+    void close(); // writes index
+
+private:
+
+    bool appendChunk(int frameIndex, double timestamp, const cv::Mat& image, int codec, const unsigned char* payload, size_t payloadSize);
+
+    std::ofstream file;
+    std::vector<frameIndexEntry> vIndex;
+    uint64_t fileOffset;
+};
+
+class FrameContainerReader
+{
+
+public:
+
+    FrameContainerReader();
+    ~FrameContainerReader();
+
+    bool open(const std::string& filename);
+    bool isOpen() const;
+    cv::Mat getFrame(int frameIndex) const; // uncompressed frames are a view into mapped file, valid until reader is closed
+    double getTimestamp(int frameIndex) const;
+    int getFrameCount() const;
+    void close();
+
+private:
+
+    const unsigned char* data;
+    size_t dataSize;
+
+#ifdef _WIN32
+    HANDLE hFile;
+    HANDLE hMapping;
+#else
+    int fileDescriptor;
+#endif
+
+    std::vector<frameIndexEntry> vIndex;
+
+    bool readIndex();
+};
+
+// Conversion between container and PNG layout (trial_N/raw/0.png, 1.png, ...)
+
+bool convertContainerToPNG(const std::string& trialDirectory);
+bool convertPNGToContainer(const std::string& trialDirectory, const std::vector<double>& timestamps); // frames are compressed
+
+#endif // FRAMECONTAINER_H
@@ -0,0 +1,121 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "frameprefetcher.h"
+
+FramePrefetcher::FramePrefetcher()
+{
+    PREFETCH_ACTIVE = false;
+
+    frameIndexConsumed = 0;
+    frameIndexEnd      = 0;
+    frameIndexNext     = 0;
+    queueCapacity      = 1;
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    stop();
+}
+
+void FramePrefetcher::start(std::function<cv::Mat(int)> loadFrameNew, int frameIndexStart, int frameIndexEndNew, int numberOfThreads, int queueCapacityNew)
+{
+    stop(); // previous trial
+
+    if (numberOfThreads  < 1) { numberOfThreads  = 1; }
+    if (queueCapacityNew < 1) { queueCapacityNew = 1; }
+
+    loadFrame          = loadFrameNew;
+    frameIndexConsumed = frameIndexStart;
+    frameIndexNext     = frameIndexStart;
+    frameIndexEnd      = frameIndexEndNew;
+    queueCapacity      = queueCapacityNew;
+
+    PREFETCH_ACTIVE = true;
+
+    for (int iThread = 0; iThread < numberOfThreads; iThread++) { vThreads.push_back(std::thread(&FramePrefetcher::threadDecoder, this)); }
+}
+
+void FramePrefetcher::threadDecoder()
+{
+    while (true)
+    {
+        int frameIndex;
+
+        {
+            std::unique_lock<std::mutex> queueLock(queueMutex);
+            while (PREFETCH_ACTIVE && frameIndexNext < frameIndexEnd && frameIndexNext >= frameIndexConsumed + queueCapacity) { queueNotFullCV.wait(queueLock); }
+            if (!PREFETCH_ACTIVE || frameIndexNext >= frameIndexEnd) { break; }
+
+            frameIndex = frameIndexNext;
+            frameIndexNext++;
+        }
+
+        cv::Mat image = loadFrame(frameIndex); // decoded outside lock, in parallel with other threads
+
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex);
+            if (frameIndex >= frameIndexConsumed) { mFrames[frameIndex] = image; }
+        }
+
+        frameReadyCV.notify_all();
+    }
+}
+
+cv::Mat FramePrefetcher::getFrame(int frameIndex)
+{
+    {
+        std::unique_lock<std::mutex> queueLock(queueMutex);
+
+        int frameIndexWindow = std::min(frameIndexEnd, frameIndexConsumed + queueCapacity);
+
+        if (PREFETCH_ACTIVE && frameIndex >= frameIndexConsumed && frameIndex < frameIndexWindow) // claimed by a thread now or soon
+        {
+            while (PREFETCH_ACTIVE && mFrames.find(frameIndex) == mFrames.end()) { frameReadyCV.wait(queueLock); }
+
+            auto it = mFrames.find(frameIndex);
+
+            if (it != mFrames.end())
+            {
+                cv::Mat image = it->second;
+
+                mFrames.erase(mFrames.begin(), ++it); // frames that were skipped are not needed anymore
+                frameIndexConsumed = frameIndex + 1;
+                queueNotFullCV.notify_all();
+
+                return image;
+            }
+        }
+    }
+
+    return loadFrame(frameIndex); // outside window
+}
+
+void FramePrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        PREFETCH_ACTIVE = false;
+    }
+
+    frameReadyCV.notify_all();
+    queueNotFullCV.notify_all();
+
+    for (int iThread = 0; iThread < (int) vThreads.size(); iThread++) { vThreads[iThread].join(); }
+    vThreads.clear();
+
+    mFrames.clear();
+}
@@ -0,0 +1,69 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+// Standard Template
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+
+// Loads and decodes frames ahead of the tracking thread, so that it does not wait for the disk. A pool of threads
+// works through the frames in order and keeps at most 'queueCapacity' decoded frames in memory. Frames are handed
+// out in order; asking for a frame outside the window loads it directly.
+
+class FramePrefetcher
+{
+
+public:
+
+    FramePrefetcher();
+    ~FramePrefetcher();
+
+    cv::Mat getFrame(int frameIndex); // blocks until frame is decoded, empty if frame is missing
+    void start(std::function<cv::Mat(int)> loadFrame, int frameIndexStart, int frameIndexEnd, int numberOfThreads, int queueCapacity); // frames [start, end)
+    void stop();
+
+private:
+
+    bool PREFETCH_ACTIVE;
+
+    int frameIndexConsumed; // frames before this index are no longer needed
+    int frameIndexEnd;
+    int frameIndexNext;     // next frame to be claimed by a thread
+    int queueCapacity;
+
+    std::condition_variable frameReadyCV;
+    std::condition_variable queueNotFullCV;
+    std::function<cv::Mat(int)> loadFrame;
+    std::map<int, cv::Mat> mFrames; // decoded, not yet handed out
+    std::mutex queueMutex;
+    std::vector<std::thread> vThreads;
+
+    void threadDecoder();
+};
+
+#endif // FRAMEPREFETCHER_H
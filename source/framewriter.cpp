@@ -0,0 +1,247 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "framewriter.h"
+
+FrameWriter::FrameWriter()
+{
+    COMPRESSION      = false;
+    CONTAINER_FORMAT = false;
+    WRITER_ACTIVE    = false;
+
+    queueCapacity = 0;
+    queueSizeMax  = 0;
+    stallCount    = 0;
+    framesWritten = 0;
+    bytesWritten  = 0;
+    bytesStored   = 0;
+}
+
+FrameWriter::~FrameWriter()
+{
+    finish();
+}
+
+bool FrameWriter::start(const std::string& trialDirectory, int numberOfThreads, int queueCapacityNew, bool CONTAINER_FORMAT_NEW, bool COMPRESSION_NEW)
+{
+    finish(); // previous trial
+
+    CONTAINER_FORMAT = CONTAINER_FORMAT_NEW;
+    COMPRESSION      = CONTAINER_FORMAT_NEW && COMPRESSION_NEW;
+
+    if (CONTAINER_FORMAT) { directory = trialDirectory; }
+    else                  { directory = trialDirectory + "/raw"; }
+
+    return startThreads(numberOfThreads, queueCapacityNew);
+}
+
+bool FrameWriter::startImages(const std::string& imageDirectory, int numberOfThreads, int queueCapacityNew)
+{
+    finish();
+
+    CONTAINER_FORMAT = false;
+    COMPRESSION      = false;
+
+    directory = imageDirectory;
+
+    return startThreads(numberOfThreads, queueCapacityNew);
+}
+
+bool FrameWriter::startThreads(int numberOfThreads, int queueCapacityNew)
+{
+    boost::system::error_code errorCode;
+    boost::filesystem::create_directories(directory, errorCode); // done before recording starts, not per frame
+    if (!boost::filesystem::is_directory(directory)) { return false; }
+
+    if (CONTAINER_FORMAT)
+    {
+        if (!mContainerWriter.open(directory + "/" + frameContainerFilename)) { return false; }
+        mPendingTasks.clear();
+        sFramesEncoding.clear();
+    }
+
+    if (numberOfThreads  < 1) { numberOfThreads  = 1; }
+    if (queueCapacityNew < 1) { queueCapacityNew = 1; }
+
+    queueCapacity = queueCapacityNew;
+    queueSizeMax  = 0;
+    stallCount    = 0;
+    framesWritten = 0;
+    bytesWritten  = 0;
+    bytesStored   = 0;
+
+    timeStart     = std::chrono::steady_clock::now();
+    timeLastWrite = timeStart;
+
+    WRITER_ACTIVE = true;
+
+    for (int iThread = 0; iThread < numberOfThreads; iThread++) { vThreads.push_back(std::thread(&FrameWriter::threadWriter, this)); }
+
+    return true;
+}
+
+void FrameWriter::addFrame(int frameIndex, double timestamp, const cv::Mat& image)
+{
+    std::unique_lock<std::mutex> queueLock(queueMutex);
+
+    if (!WRITER_ACTIVE) { return; }
+
+    if ((int) qTasks.size() >= queueCapacity)
+    {
+        TraceSpan mStallSpan("writer queue full", "writer");
+        stallCount++;
+        while ((int) qTasks.size() >= queueCapacity && WRITER_ACTIVE) { queueNotFullCV.wait(queueLock); }
+        if (!WRITER_ACTIVE) { return; }
+    }
+
+    frameWriterTask mTask;
+    mTask.frameIndex = frameIndex;
+    mTask.timestamp  = timestamp;
+    mTask.image      = image; // shares image data, frame buffers are not re-used by camera
+
+    qTasks.push_back(mTask);
+
+    if ((int) qTasks.size() > queueSizeMax) { queueSizeMax = qTasks.size(); }
+
+    queueNotEmptyCV.notify_one();
+}
+
+void FrameWriter::threadWriter()
+{
+    std::vector<int> compressionParameters;
+    compressionParameters.push_back(CV_IMWRITE_PNG_COMPRESSION);
+    compressionParameters.push_back(0);
+
+    EventTracer::setThreadName("frame writer");
+
+    while (true)
+    {
+        frameWriterTask mTask;
+
+        {
+            std::unique_lock<std::mutex> queueLock(queueMutex);
+            while (qTasks.empty() && WRITER_ACTIVE) { queueNotEmptyCV.wait(queueLock); }
+            if (qTasks.empty()) { break; } // stopped and all frames written
+
+            mTask = qTasks.front();
+            qTasks.pop_front();
+            if (CONTAINER_FORMAT) { sFramesEncoding.insert(mTask.frameIndex); }
+            queueNotFullCV.notify_one();
+        }
+
+        long long imageSize       = mTask.image.total() * mTask.image.elemSize();
+        long long imageSizeStored = imageSize;
+
+        if (COMPRESSION) // encoding is done in parallel, appending in order
+        {
+            TraceSpan mEncodeSpan("encode", "writer");
+            if (!encodeFrame(mTask.image, mTask.imageEncoded) || (long long) mTask.imageEncoded.size() >= imageSize) { mTask.imageEncoded.clear(); }
+            else { imageSizeStored = mTask.imageEncoded.size(); }
+        }
+
+        if (CONTAINER_FORMAT)
+        {
+            TracedLock containerLock(containerMutex, "containerMutex");
+            TraceSpan mAppendSpan("append", "writer");
+            mPendingTasks[mTask.frameIndex] = mTask;
+
+            { std::lock_guard<std::mutex> queueLock(queueMutex);
+                sFramesEncoding.erase(sFramesEncoding.find(mTask.frameIndex));
+            }
+
+            appendPendingFrames(false);
+        }
+        else
+        {
+            std::stringstream filename;
+            filename << directory << "/" << mTask.frameIndex << ".png";
+
+            TraceSpan mWriteSpan("imwrite", "writer");
+            cv::imwrite(filename.str(), mTask.image, compressionParameters);
+        }
+
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex);
+            framesWritten++;
+            bytesWritten += imageSize;
+            bytesStored  += imageSizeStored;
+            timeLastWrite = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void FrameWriter::finish()
+{
+    {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        WRITER_ACTIVE = false;
+    }
+
+    queueNotEmptyCV.notify_all();
+    queueNotFullCV.notify_all();
+
+    for (int iThread = 0; iThread < (int) vThreads.size(); iThread++) { vThreads[iThread].join(); }
+    vThreads.clear();
+
+    if (CONTAINER_FORMAT)
+    {
+        std::lock_guard<std::mutex> containerLock(containerMutex);
+        appendPendingFrames(true); // frames after a gap in frame indices
+        mContainerWriter.close();
+    }
+}
+
+void FrameWriter::appendPendingFrames(bool FLUSH)
+{
+    // Container is append-only, so frames finished out of order by different threads wait here. Frames are queued in
+    // order, so a pending frame can only be preceded by frames that are still being encoded. Once those are done
+    // it is appended, even if frames before it never arrived, so that a gap in frame indices does not hold up the rest.
+
+    int frameIndexEncoding = std::numeric_limits<int>::max(); // lowest frame still being encoded
+
+    { std::lock_guard<std::mutex> queueLock(queueMutex);
+        if (!sFramesEncoding.empty()) { frameIndexEncoding = *sFramesEncoding.begin(); }
+    }
+
+    while (!mPendingTasks.empty() && (FLUSH || mPendingTasks.begin()->first < frameIndexEncoding))
+    {
+        const frameWriterTask& mTask = mPendingTasks.begin()->second;
+        if (mTask.imageEncoded.empty()) { mContainerWriter.appendFrame       (mTask.frameIndex, mTask.timestamp, mTask.image); }
+        else                            { mContainerWriter.appendEncodedFrame(mTask.frameIndex, mTask.timestamp, mTask.image, mTask.imageEncoded); }
+        mPendingTasks.erase(mPendingTasks.begin());
+    }
+}
+
+frameWriterStatistics FrameWriter::getStatistics()
+{
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+
+    frameWriterStatistics mStatistics;
+    mStatistics.framesWritten    = framesWritten;
+    mStatistics.megabytesWritten = bytesWritten / (double) (1024 * 1024);
+    mStatistics.megabytesStored  = bytesStored  / (double) (1024 * 1024);
+    mStatistics.queueCapacity    = queueCapacity;
+    mStatistics.queueSize        = qTasks.size();
+    mStatistics.queueSizeMax     = queueSizeMax;
+    mStatistics.stallCount       = stallCount;
+
+    double duration = std::chrono::duration<double>(timeLastWrite - timeStart).count(); // in s
+
+    if (duration > 0) { mStatistics.megabytesPerSecond = mStatistics.megabytesWritten / duration; }
+    else              { mStatistics.megabytesPerSecond = 0; }
+
+    return mStatistics;
+}
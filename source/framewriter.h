@@ -0,0 +1,121 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+// Files
+
+#include "eventtracer.h"
+#include "framecontainer.h"
+
+// Standard Template
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost
+
+#include <boost/filesystem.hpp>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+struct frameWriterStatistics
+{
+    double megabytesPerSecond; // sustained rate from first queued frame until last written frame
+    double megabytesWritten;   // uncompressed image data
+    double megabytesStored;    // after compression
+    int framesWritten;
+    int queueCapacity;
+    int queueSize;             // frames queued right now
+    int queueSizeMax;          // headroom is capacity minus this value
+    int stallCount;            // number of frames for which the recording thread had to wait for a free slot
+};
+
+// Writes raw camera frames to disk in the background, so that a slow disk does not hold up the tracking thread.
+// Frames are queued in memory (bounded) and encoded by a pool of threads. Frames either go into the trial
+// container (trial_N/raw.esv), optionally compressed, where they are appended in frame order, or into one PNG per frame (trial_N/raw/),
+// where the file name carries the frame index. Offline detection uses the same writer for processed images.
+
+class FrameWriter
+{
+
+public:
+
+    FrameWriter();
+    ~FrameWriter();
+
+    bool start(const std::string& trialDirectory, int numberOfThreads, int queueCapacity, bool CONTAINER_FORMAT, bool COMPRESSION); // creates directories if necessary
+    bool startImages(const std::string& imageDirectory, int numberOfThreads, int queueCapacity); // one PNG per frame in given directory, e.g. processed images
+    frameWriterStatistics getStatistics();
+    void addFrame(int frameIndex, double timestamp, const cv::Mat& image); // blocks only if queue is full
+    void finish(); // writes all queued frames and stops threads
+
+private:
+
+    struct frameWriterTask
+    {
+        int frameIndex;
+        double timestamp;
+        cv::Mat image;
+        std::vector<unsigned char> imageEncoded; // empty if frame is stored uncompressed
+    };
+
+    bool COMPRESSION; // container frames are encoded by the writer threads
+    bool CONTAINER_FORMAT;
+    bool WRITER_ACTIVE;
+
+    int queueCapacity;
+    int queueSizeMax;
+    int stallCount;
+    int framesWritten;
+
+    long long bytesWritten;
+    long long bytesStored;
+
+    std::chrono::steady_clock::time_point timeStart;
+    std::chrono::steady_clock::time_point timeLastWrite;
+
+    std::condition_variable queueNotEmptyCV;
+    std::condition_variable queueNotFullCV;
+    std::deque<frameWriterTask> qTasks;
+    std::map<int, frameWriterTask> mPendingTasks; // encoded frames waiting for their turn to be appended
+    std::multiset<int> sFramesEncoding;           // taken from queue, not yet pending (guarded by queueMutex)
+    std::mutex containerMutex;
+    std::mutex queueMutex;
+    std::string directory;
+    std::vector<std::thread> vThreads;
+
+    FrameContainerWriter mContainerWriter;
+
+    bool startThreads(int numberOfThreads, int queueCapacity);
+    void appendPendingFrames(bool FLUSH);
+    void threadWriter();
+};
+
+#endif // FRAMEWRITER_H
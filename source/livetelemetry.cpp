@@ -0,0 +1,284 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "livetelemetry.h"
+
+namespace
+{
+
+const double overloadRateRatio = 0.95; // trial is flagged if fewer frames than this fraction of the camera rate were tracked
+
+double getPercentile(std::vector<float> vValues, double fraction) // copy, since order is changed
+{
+    if (vValues.empty()) { return 0; }
+    int index = std::min((int) vValues.size() - 1, (int) std::ceil(fraction * vValues.size()) - 1);
+    index = std::max(index, 0);
+    std::nth_element(vValues.begin(), vValues.begin() + index, vValues.end());
+    return vValues[index];
+}
+
+double getRate(int frameTotal, unsigned long long timeFirst, unsigned long long timeLast) // Hz, 'frameTotal' intervals
+{
+    if (frameTotal <= 0 || timeLast <= timeFirst) { return 0; }
+    return 1e7 * frameTotal / (timeLast - timeFirst);
+}
+
+}
+
+const char* getFrameLossName(int cause)
+{
+    switch (cause)
+    {
+    case SKIP_INTERVAL:    return "skipped_interval";
+    case SKIP_AOI:         return "skipped_aoi";
+    case DROP_CAMERA:      return "dropped_camera";
+    case DROP_RING_FULL:   return "dropped_ring_full";
+    case DROP_OVERWRITTEN: return "dropped_overwritten";
+    default:               return "unknown";
+    }
+}
+
+LiveTelemetry::LiveTelemetry(int windowLength) : windowLength(windowLength), frameRate(0)
+{
+    vWindowDelivered   .assign(windowLength, 0);
+    vWindowRing        .assign(windowLength, 0);
+    vWindowLatencies   .assign(windowLength, 0);
+    vWindowCameraTimes .assign(windowLength, 0);
+    vWindowTrackedTimes.assign(windowLength, 0);
+
+    clear();
+}
+
+void LiveTelemetry::clear()
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+
+    CLOCK_OFFSET_VALID = false;
+    clockOffset = 0;
+
+    framesCaptured  = 0;
+    framesDelivered = 0;
+    framesTracked   = 0;
+    std::fill(frameLosses, frameLosses + FRAME_LOSS_TOTAL, 0);
+    ringCapacity = 0;
+    ringMaximum  = 0;
+    ringSum      = 0;
+    ringTotal    = 0;
+
+    timeCameraFirst  = 0;
+    timeCameraLast   = 0;
+    timeTrackedFirst = 0;
+    timeTrackedLast  = 0;
+
+    vLatencies.clear();
+
+    windowCaptured = 0;
+    windowRing     = 0;
+    windowTracked  = 0;
+}
+
+void LiveTelemetry::setFrameRate(double frameRateNew)
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+    frameRate = frameRateNew;
+}
+
+void LiveTelemetry::addCapturedFrame(unsigned long long timeCamera, bool RING_WAIT)
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+
+    int framesMissing = 0;
+
+    if (framesCaptured > 0 && frameRate > 0 && timeCamera > timeCameraLast)
+    {
+        double framePeriod = 1e7 / frameRate;
+        framesMissing = std::max(0, (int) std::round((timeCamera - timeCameraLast) / framePeriod) - 1);
+
+        if (RING_WAIT) { frameLosses[DROP_RING_FULL] += framesMissing; }
+        else           { frameLosses[DROP_CAMERA]    += framesMissing; }
+    }
+
+    if (framesCaptured == 0) { timeCameraFirst = timeCamera; }
+    timeCameraLast = timeCamera;
+
+    framesCaptured++;
+    framesDelivered += 1 + framesMissing;
+
+    int slot = windowCaptured % windowLength;
+    vWindowCameraTimes[slot] = timeCamera;
+    vWindowDelivered  [slot] = 1 + framesMissing;
+    windowCaptured++;
+}
+
+void LiveTelemetry::addFrameLoss(int cause)
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+    frameLosses[cause]++;
+}
+
+void LiveTelemetry::addRingOccupancy(int occupancy, int capacity)
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+
+    ringCapacity = capacity;
+    ringMaximum  = std::max(ringMaximum, occupancy);
+    ringSum     += occupancy;
+    ringTotal++;
+
+    vWindowRing[windowRing % windowLength] = occupancy;
+    windowRing++;
+}
+
+void LiveTelemetry::addTrackedFrame(unsigned long long timeCamera, unsigned long long timeHost, unsigned long long timeResult)
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+
+    long long offset = (long long) timeHost - (long long) timeCamera;
+    if (!CLOCK_OFFSET_VALID || offset < clockOffset)
+    {
+        clockOffset = offset;
+        CLOCK_OFFSET_VALID = true;
+    }
+
+    float latency = ((long long) timeResult - ((long long) timeCamera + clockOffset)) / 1e4; // ms
+
+    vLatencies.push_back(latency);
+
+    if (framesTracked == 0) { timeTrackedFirst = timeResult; }
+    timeTrackedLast = timeResult;
+    framesTracked++;
+
+    int slot = windowTracked % windowLength;
+    vWindowLatencies   [slot] = latency;
+    vWindowTrackedTimes[slot] = timeResult;
+    windowTracked++;
+}
+
+telemetryStatistics LiveTelemetry::getStatistics(bool WHOLE_TRIAL) const
+{
+    std::lock_guard<std::mutex> telemetryLock(telemetryMutex);
+
+    telemetryStatistics mStatistics;
+    mStatistics.framesCaptured = framesCaptured;
+    mStatistics.framesTracked  = framesTracked;
+    std::copy(frameLosses, frameLosses + FRAME_LOSS_TOTAL, mStatistics.frameLosses);
+    mStatistics.ringCapacity = ringCapacity;
+
+    std::vector<float> vLatenciesUsed;
+
+    if (WHOLE_TRIAL)
+    {
+        vLatenciesUsed = vLatencies;
+
+        mStatistics.ringMaximum   = ringMaximum;
+        mStatistics.ringMean      = (ringTotal > 0) ? (double) ringSum / ringTotal : 0;
+        mStatistics.cameraRate    = getRate(framesDelivered - 1, timeCameraFirst,  timeCameraLast);
+        mStatistics.detectionRate = getRate(framesTracked   - 1, timeTrackedFirst, timeTrackedLast);
+    }
+    else
+    {
+        int latencyTotal = std::min(windowTracked, windowLength);
+        vLatenciesUsed.assign(vWindowLatencies.begin(), vWindowLatencies.begin() + latencyTotal);
+
+        int ringTotalWindow = std::min(windowRing, windowLength);
+        long long ringSumWindow = 0;
+        mStatistics.ringMaximum = 0;
+        for (int i = 0; i < ringTotalWindow; i++)
+        {
+            ringSumWindow += vWindowRing[i];
+            mStatistics.ringMaximum = std::max(mStatistics.ringMaximum, vWindowRing[i]);
+        }
+        mStatistics.ringMean = (ringTotalWindow > 0) ? (double) ringSumWindow / ringTotalWindow : 0;
+
+        // Rates between oldest and newest frame in window
+
+        int capturedTotal = std::min(windowCaptured, windowLength);
+        mStatistics.cameraRate = 0;
+        if (capturedTotal > 1)
+        {
+            int slotFirst = (windowCaptured - capturedTotal) % windowLength;
+            int slotLast  = (windowCaptured - 1) % windowLength;
+            int deliveredTotal = 0;
+            for (int i = 0; i < capturedTotal; i++) { if (i != slotFirst) { deliveredTotal += vWindowDelivered[i]; } }
+            mStatistics.cameraRate = getRate(deliveredTotal, vWindowCameraTimes[slotFirst], vWindowCameraTimes[slotLast]);
+        }
+
+        mStatistics.detectionRate = 0;
+        if (latencyTotal > 1)
+        {
+            int slotFirst = (windowTracked - latencyTotal) % windowLength;
+            int slotLast  = (windowTracked - 1) % windowLength;
+            mStatistics.detectionRate = getRate(latencyTotal - 1, vWindowTrackedTimes[slotFirst], vWindowTrackedTimes[slotLast]);
+        }
+    }
+
+    mStatistics.latencyMedian       = getPercentile(vLatenciesUsed, 0.50);
+    mStatistics.latencyPercentile99 = getPercentile(vLatenciesUsed, 0.99);
+    mStatistics.latencyMaximum      = vLatenciesUsed.empty() ? 0 : *std::max_element(vLatenciesUsed.begin(), vLatenciesUsed.end());
+
+    mStatistics.OVERLOADED = (mStatistics.frameLosses[DROP_RING_FULL]   > 0 ||
+                              mStatistics.frameLosses[DROP_OVERWRITTEN] > 0 ||
+                              (mStatistics.ringCapacity > 0 && mStatistics.ringMaximum >= mStatistics.ringCapacity) ||
+                              (mStatistics.cameraRate   > 0 && mStatistics.detectionRate < overloadRateRatio * mStatistics.cameraRate));
+
+    return mStatistics;
+}
+
+std::string LiveTelemetry::getSummary() const
+{
+    telemetryStatistics mStatistics = getStatistics(false);
+
+    int framesSkipped = mStatistics.frameLosses[SKIP_INTERVAL] + mStatistics.frameLosses[SKIP_AOI];
+    int framesDropped = mStatistics.frameLosses[DROP_CAMERA] + mStatistics.frameLosses[DROP_RING_FULL] + mStatistics.frameLosses[DROP_OVERWRITTEN];
+
+    std::stringstream summary;
+    summary << std::fixed << std::setprecision(1)
+            << "camera " << mStatistics.cameraRate << " Hz, tracked " << mStatistics.detectionRate << " Hz, "
+            << "latency " << mStatistics.latencyMedian << " ms (p99 " << mStatistics.latencyPercentile99 << " ms), "
+            << "dropped " << framesDropped << " (ring " << mStatistics.frameLosses[DROP_RING_FULL]
+            << ", overwritten " << mStatistics.frameLosses[DROP_OVERWRITTEN] << "), skipped " << framesSkipped;
+
+    if (mStatistics.ringCapacity > 0) { summary << ", ring " << mStatistics.ringMaximum << "/" << mStatistics.ringCapacity; }
+    if (mStatistics.OVERLOADED)       { summary << ", OVERLOADED"; }
+
+    return summary.str();
+}
+
+bool LiveTelemetry::save(const std::string& filename) const
+{
+    telemetryStatistics mStatistics = getStatistics(true);
+
+    std::ofstream file;
+    file.open(filename, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    file << "overloaded "       << mStatistics.OVERLOADED          << "\n";
+    file << "frames_captured "  << mStatistics.framesCaptured      << "\n";
+    file << "frames_tracked "   << mStatistics.framesTracked       << "\n";
+    file << "camera_rate "      << mStatistics.cameraRate          << "\n";
+    file << "detection_rate "   << mStatistics.detectionRate       << "\n";
+    file << "latency_median "   << mStatistics.latencyMedian       << "\n";
+    file << "latency_p99 "      << mStatistics.latencyPercentile99 << "\n";
+    file << "latency_max "      << mStatistics.latencyMaximum      << "\n";
+
+    for (int iCause = 0; iCause < FRAME_LOSS_TOTAL; iCause++) { file << getFrameLossName(iCause) << " " << mStatistics.frameLosses[iCause] << "\n"; }
+
+    file << "ring_capacity "    << mStatistics.ringCapacity        << "\n";
+    file << "ring_max "         << mStatistics.ringMaximum         << "\n";
+    file << "ring_mean "        << mStatistics.ringMean            << "\n";
+
+    return file.good();
+}
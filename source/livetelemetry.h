@@ -0,0 +1,126 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef LIVETELEMETRY_H
+#define LIVETELEMETRY_H
+
+// Standard Template
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Counters of live tracking: latency from camera time stamp to tracking result, frames that were skipped or lost
+// (by cause), occupancy of the frame ring of the camera during recording, and the rate at which frames were tracked
+// compared to the camera frame rate. Statistics are kept over the whole trial and over the most recent frames.
+//
+// Camera and host clocks are not synchronised. Camera time stamps are mapped to host time with the smallest difference
+// between host and camera time seen so far, so latency is measured relative to the fastest frame transfer. All times are
+// in units of 0.1 microseconds, as the camera time stamps and getHostTime().
+
+const std::string telemetryFilename = "telemetry.dat"; // in trial directory
+
+enum frameLossCause
+{
+    SKIP_INTERVAL    = 0, // interval to previous frame too short (camera error), frame is not tracked
+    SKIP_AOI         = 1, // image or eye AOI smaller than minimum, frame is not tracked
+    DROP_CAMERA      = 2, // gap in camera time stamps, frames did not reach capture thread (driver or bus)
+    DROP_RING_FULL   = 3, // gap in camera time stamps after capture thread had to wait for a free slot in the frame ring
+    DROP_OVERWRITTEN = 4, // frame was replaced by the next one before the tracking thread took it (camera feed only)
+    FRAME_LOSS_TOTAL
+};
+
+const char* getFrameLossName(int cause); // e.g. "dropped_ring_full"
+
+struct telemetryStatistics
+{
+    bool OVERLOADED; // frames were lost because tracking did not keep up, or frames were tracked slower than camera frame rate
+    int framesCaptured;
+    int framesTracked;
+    int frameLosses[FRAME_LOSS_TOTAL];
+    int ringCapacity; // 0 if frame ring was not used
+    int ringMaximum;
+    double ringMean;
+    double cameraRate;    // Hz, frames delivered by camera (including lost ones)
+    double detectionRate; // Hz, frames tracked
+    double latencyMedian; // ms
+    double latencyPercentile99;
+    double latencyMaximum;
+};
+
+class LiveTelemetry
+{
+
+public:
+
+    LiveTelemetry(int windowLength = 1000); // recent statistics are over this number of frames
+
+    bool save(const std::string& filename) const; // whole trial
+    std::string getSummary() const; // recent frames, one line for display
+    telemetryStatistics getStatistics(bool WHOLE_TRIAL) const;
+    void addCapturedFrame(unsigned long long timeCamera, bool RING_WAIT); // by capture thread, 'RING_WAIT' if it waited for a free slot before this frame
+    void addFrameLoss(int cause);
+    void addRingOccupancy(int occupancy, int capacity); // frames waiting in ring, when tracking thread takes one
+    void addTrackedFrame(unsigned long long timeCamera, unsigned long long timeHost, unsigned long long timeResult); // 'timeHost' of frame arrival, 'timeResult' when tracking finished
+    void clear(); // at start of trial, and when camera is (re)started
+    void setFrameRate(double); // Hz, to find gaps in camera time stamps
+
+private:
+
+    int windowLength;
+    double frameRate;
+
+    // Whole trial
+
+    bool CLOCK_OFFSET_VALID;
+    long long clockOffset; // smallest host time minus camera time
+
+    int framesCaptured;
+    int framesDelivered; // captured plus lost in gaps
+    int framesTracked;
+    int frameLosses[FRAME_LOSS_TOTAL];
+    int ringCapacity;
+    int ringMaximum;
+    long long ringSum;
+    int ringTotal;
+
+    unsigned long long timeCameraFirst;
+    unsigned long long timeCameraLast;
+    unsigned long long timeTrackedFirst;
+    unsigned long long timeTrackedLast;
+
+    std::vector<float> vLatencies; // ms
+
+    // Most recent frames (circular)
+
+    std::vector<int> vWindowDelivered;
+    std::vector<int> vWindowRing;
+    std::vector<float> vWindowLatencies;
+    std::vector<unsigned long long> vWindowCameraTimes;
+    std::vector<unsigned long long> vWindowTrackedTimes;
+    int windowCaptured;
+    int windowRing;
+    int windowTracked;
+
+    mutable std::mutex telemetryMutex;
+};
+
+#endif // LIVETELEMETRY_H
@@ -29,10 +29,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     mVariableWidgetEye  = new VariableWidget;
 
-    Parameters::eyeAOIRatio.xPos = 0.0;
-    Parameters::eyeAOIRatio.yPos = 0.0;
-    Parameters::eyeAOIRatio.hght = 1.0;
-    Parameters::eyeAOIRatio.wdth = 1.0;
+    mCameraSession.eyeAOIRatio.xPos = 0.0;
+    mCameraSession.eyeAOIRatio.yPos = 0.0;
+    mCameraSession.eyeAOIRatio.hght = 1.0;
+    mCameraSession.eyeAOIRatio.wdth = 1.0;
 
     // AOI
 
@@ -53,10 +53,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     mAdvancedOptions.CURVATURE_MEASUREMENT = false;
 
+    SAVE_DATA_ASCII = true;
     SAVE_DATA_FIT   = false;
     SAVE_DATA_EDGE  = false;
     SAVE_DATA_EXTRA = false;
 
+    SAVE_PROCESSED_IMAGES = false;
+
     // Grab parameters from ini file
 
     LastUsedSettingsFileName = "config_user.ini";
@@ -66,8 +69,9 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     // Camera feed
 
     CamQImage = new QImageOpenCV();
+    CamQImage->setCameraSession(&mCameraSession);
     CamQImage->setSize(camImageWdth, camImageHght);
-    CamQImage->setAOIEye(Parameters::eyeAOI);
+    CamQImage->setAOIEye(mCameraSession.eyeAOI);
     CamQImage->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     QObject::connect(CamQImage, SIGNAL(updateImage(int)), this , SLOT(onUpdateImageRaw(int)));
 
@@ -251,6 +255,12 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QCheckBox *SaveDataExtraCheckBox = new QCheckBox;
     QObject::connect(SaveDataExtraCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetSaveDataExtra(int)));
 
+    QLabel *SaveProcessedImagesTextBox = new QLabel;
+    SaveProcessedImagesTextBox->setText("<b>Save processed images:</b>");
+
+    QCheckBox *SaveProcessedImagesCheckBox = new QCheckBox;
+    QObject::connect(SaveProcessedImagesCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetSaveProcessedImages(int)));
+
     QWidget* AdvancedOptionsWidget = new QWidget;
     QGridLayout* AdvancedOptionsLayout = new QGridLayout(AdvancedOptionsWidget);
     AdvancedOptionsLayout->addWidget(CurvatureMeasurementTextBox,  0, 0, Qt::AlignRight);
@@ -261,8 +271,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     AdvancedOptionsLayout->addWidget(SaveDataFitCheckBox,          2, 1, Qt::AlignRight);
     AdvancedOptionsLayout->addWidget(SaveDataExtraTextBox,         3, 0, Qt::AlignRight);
     AdvancedOptionsLayout->addWidget(SaveDataExtraCheckBox,        3, 1, Qt::AlignRight);
+    AdvancedOptionsLayout->addWidget(SaveProcessedImagesTextBox,   4, 0, Qt::AlignRight);
+    AdvancedOptionsLayout->addWidget(SaveProcessedImagesCheckBox,  4, 1, Qt::AlignRight);
 
-    AdvancedOptionsLayout->setRowStretch(4, 1);
+    AdvancedOptionsLayout->setRowStretch(5, 1);
     AdvancedOptionsLayout->setColumnStretch(2, 1);
 
     /////////////////// Tab layout ///////////////////////
@@ -327,9 +339,20 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QAction *about   = new QAction("&About EyeStalker...", this);
     QObject::connect(about, &QAction::triggered, this, &MainWindow::onDialogueOpen);
 
+    QAction *packRawImages   = new QAction("&Pack raw images", this);
+    QAction *unpackRawImages = new QAction("&Unpack raw images", this);
+    QObject::connect(packRawImages,   &QAction::triggered, this, &MainWindow::onPackRawImages);
+    QObject::connect(unpackRawImages, &QAction::triggered, this, &MainWindow::onUnpackRawImages);
+
+    QAction *benchmarkCodec = new QAction("&Benchmark codec", this);
+    QObject::connect(benchmarkCodec, &QAction::triggered, this, &MainWindow::onBenchmarkCodec);
+
     QMenu *file;
     file = menuBar()->addMenu("&Options");
     file->addAction(options);
+    file->addAction(packRawImages);
+    file->addAction(unpackRawImages);
+    file->addAction(benchmarkCodec);
     file = menuBar()->addMenu("&Help");
     file->addAction(about);
 
@@ -361,77 +384,9 @@ MainWindow::~MainWindow()
 
 void MainWindow::resetVariablesHard(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
 {
-    // Reset all variables
-
-    mDetectionVariables.averageAspectRatio   = initialAspectRatio; // close to perfect circle
-    mDetectionVariables.averageCircumference = 0.5 * (mDetectionParameters.thresholdCircumferenceMax + mDetectionParameters.thresholdCircumferenceMin); // calculate first
-    mDetectionVariables.averageCurvature     = initialCurvature;
-    mDetectionVariables.averageGradient      = 0;
-    mDetectionVariables.averageHeight        = mDetectionVariables.averageCircumference / M_PI;
-    mDetectionVariables.averageIntensity     = initialIntensity;
-    mDetectionVariables.averageHaarResponse  = 0;
-    mDetectionVariables.averageWidth         = mDetectionVariables.averageCircumference / M_PI;
-
-    mDetectionVariables.certaintyAverages      = 0;
-    mDetectionVariables.certaintyAveragesPrime = 0;
-
     cameraFrameRate = 250;
 
-    resetVariablesSoft(mDetectionVariables, mDetectionParameters, mAOI);
-}
-
-void MainWindow::resetVariablesSoft(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
-{
-    // Reset everything but averages
-
-    mDetectionVariables.predictedAngle         = 0;
-    mDetectionVariables.predictedAspectRatio   = mDetectionVariables.averageAspectRatio;
-    mDetectionVariables.predictedCircumference = mDetectionVariables.averageCircumference;
-    mDetectionVariables.predictedCurvature     = mDetectionVariables.averageCurvature;
-    mDetectionVariables.predictedGradient      = mDetectionVariables.averageGradient;
-    mDetectionVariables.predictedHaarResponse  = mDetectionVariables.averageHaarResponse;
-    mDetectionVariables.predictedHeight        = mDetectionVariables.averageHeight;
-    mDetectionVariables.predictedIntensity     = mDetectionVariables.averageIntensity;
-    mDetectionVariables.predictedWidth         = mDetectionVariables.averageWidth;
-    mDetectionVariables.predictedXPos          = 0.5 * (mAOI.wdth - 1); // centre of image
-    mDetectionVariables.predictedYPos          = 0.5 * (mAOI.hght - 1);
-
-    mDetectionVariables.momentumAspectRatio   = 0;
-    mDetectionVariables.momentumCircumference = 0;
-    mDetectionVariables.momentumCurvature     = 0;
-    mDetectionVariables.momentumGradient      = 0;
-    mDetectionVariables.momentumHaarResponse  = 0;
-    mDetectionVariables.momentumHeight        = 0;
-    mDetectionVariables.momentumIntensity     = 0;
-    mDetectionVariables.momentumWidth         = 0;
-    mDetectionVariables.momentumXPos          = 0;
-    mDetectionVariables.momentumYPos          = 0;
-
-    double maxChangeThresholdAspectRatio_1 = mDetectionVariables.predictedAspectRatio - mDetectionParameters.thresholdAspectRatioMin;
-    double maxChangeThresholdAspectRatio_2 = 1.0 - mDetectionVariables.predictedAspectRatio;
-    double maxChangeThresholdAspectRatio   = std::max(maxChangeThresholdAspectRatio_1, maxChangeThresholdAspectRatio_2);
-    double rangeChangeThresholdAspectRatio = maxChangeThresholdAspectRatio   - mDetectionParameters.thresholdChangeAspectRatioUpper;
-    mDetectionVariables.thresholdChangeAspectRatioUpper   = rangeChangeThresholdAspectRatio   + mDetectionParameters.thresholdChangeAspectRatioUpper;
-
-    double maxChangeThresholdCircumference_1 = (mDetectionParameters.thresholdCircumferenceMax - mDetectionVariables.predictedCircumference) / mDetectionParameters.thresholdCircumferenceMax;
-    double maxChangeThresholdCircumference_2 = (mDetectionVariables.predictedCircumference - mDetectionParameters.thresholdCircumferenceMin) / mDetectionVariables.predictedCircumference;
-    double maxChangeThresholdCircumference   = std::max(maxChangeThresholdCircumference_1, maxChangeThresholdCircumference_2);
-    double rangeChangeThresholdCircumference = maxChangeThresholdCircumference - mDetectionParameters.thresholdChangeCircumferenceUpper;
-    mDetectionVariables.thresholdChangeCircumferenceUpper = rangeChangeThresholdCircumference + mDetectionParameters.thresholdChangeCircumferenceUpper;
-
-    double maxChangeThresholdPositionX = mAOI.wdth - mDetectionVariables.predictedWidth;
-    double maxChangeThresholdPositionY = mAOI.hght - mDetectionVariables.predictedHeight;
-    double maxChangeThresholdPosition  = std::max(maxChangeThresholdPositionX, maxChangeThresholdPositionY);
-    double rangeChangeThresholdPosition = maxChangeThresholdPosition - mDetectionParameters.thresholdChangePositionUpper;
-    mDetectionVariables.thresholdChangePositionUpper = rangeChangeThresholdPosition + mDetectionParameters.thresholdChangePositionUpper;
-
-    mDetectionVariables.thresholdScoreEdge = 0;
-    mDetectionVariables.thresholdScoreFit  = 0;
-
-    mDetectionVariables.certaintyFeatures      = 0;
-    mDetectionVariables.certaintyPosition      = 0;
-    mDetectionVariables.certaintyFeaturesPrime = 0;
-    mDetectionVariables.certaintyPositionPrime = 0;
+    ::resetVariablesHard(mDetectionVariables, mDetectionParameters, mAOI);
 }
 
 // General functions
@@ -500,21 +455,21 @@ void MainWindow::onDialogueOpen()
 
 void MainWindow::updateAOIx()
 {
-    { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-        Parameters::eyeAOI.wdth = round(Parameters::camAOI.wdth * Parameters::eyeAOIRatio.wdth);
-        Parameters::eyeAOI.xPos = round(Parameters::camAOI.wdth * Parameters::eyeAOIRatio.xPos);
-        if (Parameters::eyeAOI.xPos + Parameters::eyeAOI.wdth > Parameters::camAOI.wdth)
-        {   Parameters::eyeAOI.xPos = Parameters::camAOI.wdth - Parameters::eyeAOI.wdth; }
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession.AOIEyeMutex);
+        mCameraSession.eyeAOI.wdth = round(mCameraSession.camAOI.wdth * mCameraSession.eyeAOIRatio.wdth);
+        mCameraSession.eyeAOI.xPos = round(mCameraSession.camAOI.wdth * mCameraSession.eyeAOIRatio.xPos);
+        if (mCameraSession.eyeAOI.xPos + mCameraSession.eyeAOI.wdth > mCameraSession.camAOI.wdth)
+        {   mCameraSession.eyeAOI.xPos = mCameraSession.camAOI.wdth - mCameraSession.eyeAOI.wdth; }
     }
 }
 
 void MainWindow::updateAOIy()
 {
-    { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-        Parameters::eyeAOI.hght = round(Parameters::camAOI.hght * Parameters::eyeAOIRatio.hght);
-        Parameters::eyeAOI.yPos = round(Parameters::camAOI.hght * Parameters::eyeAOIRatio.yPos);
-        if (Parameters::eyeAOI.yPos + Parameters::eyeAOI.hght > Parameters::camAOI.hght)
-        {   Parameters::eyeAOI.yPos = Parameters::camAOI.hght - Parameters::eyeAOI.hght; }
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession.AOIEyeMutex);
+        mCameraSession.eyeAOI.hght = round(mCameraSession.camAOI.hght * mCameraSession.eyeAOIRatio.hght);
+        mCameraSession.eyeAOI.yPos = round(mCameraSession.camAOI.hght * mCameraSession.eyeAOIRatio.yPos);
+        if (mCameraSession.eyeAOI.yPos + mCameraSession.eyeAOI.hght > mCameraSession.camAOI.hght)
+        {   mCameraSession.eyeAOI.yPos = mCameraSession.camAOI.hght - mCameraSession.eyeAOI.hght; }
     }
 }
 
@@ -544,6 +499,27 @@ void MainWindow::countNumImages()
 {
     imageTotalOffline = 0;
 
+    std::stringstream containerName;
+    containerName << dataDirectoryOffline.toStdString()
+                  << "/images/trial_"
+                  << trialIndexOffline
+                  << "/"
+                  << frameContainerFilename;
+
+    if (mFrameContainerReader.open(containerName.str())) // all frames of trial in one file
+    {
+        imageTotalOffline = mFrameContainerReader.getFrameCount();
+
+        if (imageTotalOffline > 0)
+        {
+            cv::Mat imageRaw = mFrameContainerReader.getFrame(0);
+            mCameraSession.eyeAOI.wdth = imageRaw.cols;
+            mCameraSession.eyeAOI.hght = imageRaw.rows;
+        }
+
+        return;
+    }
+
     while (1)
     {
         std::stringstream filename;
@@ -560,8 +536,8 @@ void MainWindow::countNumImages()
             if (imageTotalOffline == 0)
             {
                 cv::Mat imageRaw = cv::imread(filename.str(), CV_LOAD_IMAGE_COLOR);
-                Parameters::eyeAOI.wdth = imageRaw.cols;
-                Parameters::eyeAOI.hght = imageRaw.rows;
+                mCameraSession.eyeAOI.wdth = imageRaw.cols;
+                mCameraSession.eyeAOI.hght = imageRaw.rows;
             }
 
             imageTotalOffline++;
@@ -592,15 +568,6 @@ void MainWindow::setupOfflineSession()
             if (trialIndexOffline != 0) { OfflineTrialSlider->setValue(0); } // start with first trial
             else { onSetTrialOffline(0); }
 
-            std::stringstream directoryName;
-            directoryName << dataDirectoryOffline.toStdString()
-                          << "/images/trial_"
-                          << trialIndexOffline
-                          << "/processed";
-
-            if (!boost::filesystem::exists(directoryName.str()))
-            {    boost::filesystem::create_directory(directoryName.str().c_str()); }
-
             if (timeMatrix.empty()) // Grab time stamps
             {
                 std::stringstream directory;
@@ -636,13 +603,25 @@ void MainWindow::onSetTrialOffline(int index)
 
         countNumImages();
 
+        std::stringstream overlayPath;
+        overlayPath << dataDirectoryOffline.toStdString()
+                    << "/images/trial_"
+                    << trialIndexOffline
+                    << "/"
+                    << overlayFilename;
+
+        mOverlayReader.open(overlayPath.str()); // file may not exist yet
+
+        mDiagnosticsArena.clear();
+
         if (imageTotalOffline > 0)
         {
             vDataVariablesEye.resize( imageTotalOffline);
+            mDiagnosticsArena.resize( imageTotalOffline);
 
             vDetectionVariablesEye.resize( imageTotalOffline + 1);
 
-            resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
+            resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession.eyeAOI);
 
             vDetectionVariablesEye [0] = mDetectionVariablesEye;
 
@@ -650,40 +629,50 @@ void MainWindow::onSetTrialOffline(int index)
             else { onSetOfflineImage(0); }
 
             OfflineImageSlider->setMaximum(imageTotalOffline - 1);
-
-            // Create folder
-
-            std::stringstream directoryPath;
-            directoryPath << dataDirectoryOffline.toStdString()
-                          << "/images/trial_"
-                          << trialIndexOffline
-                          << "/processed/";
-
-            if (!boost::filesystem::exists(directoryPath.str()))
-            {    boost::filesystem::create_directory(directoryPath.str().c_str()); }
         }
     }
 }
 
-void MainWindow::onUpdateImageRaw(int imgIndex) // for signal from qimageopencv
+cv::Mat MainWindow::loadImageRaw(int imageIndex)
 {
-    if (imgIndex < 0) { imgIndex = imageIndexOffline; }
+    cv::Mat imageRaw;
+
+    if (mFrameContainerReader.isOpen())
+    {
+        cv::Mat imageContainer = mFrameContainerReader.getFrame(imageIndex); // points into mapped file
+
+        if      (imageContainer.empty())         { return imageRaw; }
+        else if (imageContainer.channels() == 1) { cv::cvtColor(imageContainer, imageRaw, cv::COLOR_GRAY2BGR); } // same as loading PNG in color
+        else                                     { imageRaw = imageContainer.clone(); }
+
+        return imageRaw;
+    }
 
     std::stringstream imagePath;
     imagePath << dataDirectoryOffline.toStdString()
               << "/images/trial_"
               << trialIndexOffline
               << "/raw/"
-              << imgIndex
+              << imageIndex
               << ".png";
 
-    if (boost::filesystem::exists(imagePath.str()))
+    if (boost::filesystem::exists(imagePath.str())) { imageRaw = cv::imread(imagePath.str(), CV_LOAD_IMAGE_COLOR); }
+
+    return imageRaw;
+}
+
+void MainWindow::onUpdateImageRaw(int imgIndex) // for signal from qimageopencv
+{
+    if (imgIndex < 0) { imgIndex = imageIndexOffline; }
+
+    cv::Mat eyeImageRaw = loadImageRaw(imgIndex);
+
+    if (!eyeImageRaw.empty())
     {
-        cv::Mat eyeImageRaw = cv::imread(imagePath.str(), CV_LOAD_IMAGE_COLOR);
         CamQImage->loadImage(eyeImageRaw);
-        { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-            Parameters::camAOI.wdth = eyeImageRaw.cols;
-            Parameters::camAOI.hght = eyeImageRaw.rows;
+        { std::lock_guard<std::mutex> AOICamLock(mCameraSession.AOICamMutex);
+            mCameraSession.camAOI.wdth = eyeImageRaw.cols;
+            mCameraSession.camAOI.hght = eyeImageRaw.rows;
         }
         updateAOIx();
         updateAOIy();
@@ -693,6 +682,27 @@ void MainWindow::onUpdateImageRaw(int imgIndex) // for signal from qimageopencv
 
 void MainWindow::onUpdateImageProcessed(int imgIndex)
 {
+    // Detection results are drawn on the raw frame, with the current draw settings
+
+    std::vector<drawVariables> vDrawVariables;
+
+    mOverlayReader.update(); // records of running detection
+
+    if (mOverlayReader.getFrame(imgIndex, vDrawVariables))
+    {
+        cv::Mat eyeImage = loadImageRaw(imgIndex);
+
+        if (!eyeImage.empty())
+        {
+            drawAll(eyeImage, vDrawVariables);
+            CamQImage->loadImage(eyeImage);
+            CamQImage->setImage();
+            return;
+        }
+    }
+
+    // Processed images saved by older versions, or exported
+
     std::stringstream fileName;
     fileName << dataDirectoryOffline.toStdString()
              << "/images/trial_"
@@ -735,7 +745,7 @@ void MainWindow::onSetOfflineImage(int imgIndex)
 {
     if (!PROCESSING_ALL_IMAGES) { imageIndexOffline = imgIndex; }
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession.AOICamMutex);
         mVariableWidgetEye ->setWidgets(vDataVariablesEye[imgIndex]);
     }
 
@@ -758,20 +768,41 @@ void MainWindow::onSetOfflineImage(int imgIndex)
 
 void MainWindow::detectCurrentFrame(int imageIndex)
 {
-    // Grab raw images
+    cv::Mat imageRaw = loadImageRaw(imageIndex);
 
-    cv::Mat imageRaw;
+    std::vector<drawVariables> vDrawVariables = detectFrame(imageIndex, imageRaw);
+    if (vDrawVariables.empty()) { return; }
 
-    std::stringstream imagePathRaw;
-    imagePathRaw << dataDirectoryOffline.toStdString()
-                 << "/images/trial_"
-                 << trialIndexOffline
-                 << "/raw/"
-                 << imageIndex
-                 << ".png";
+    std::stringstream trialDirectory;
+    trialDirectory << dataDirectoryOffline.toStdString()
+                   << "/images/trial_"
+                   << trialIndexOffline;
+
+    OverlayWriter mOverlayWriter;
+    mOverlayWriter.open(trialDirectory.str() + "/" + overlayFilename, true);
+    mOverlayWriter.addFrame(imageIndex, vDrawVariables);
+
+    if (SAVE_PROCESSED_IMAGES)
+    {
+        std::stringstream imagePath;
+        imagePath << trialDirectory.str()
+                  << "/processed/"
+                  << imageIndex
+                  << ".png";
+
+        boost::filesystem::create_directories(trialDirectory.str() + "/processed");
+
+        cv::Mat imageProcessed = imageRaw.clone();
+        drawAll(imageProcessed, vDrawVariables);
+        cv::imwrite(imagePath.str(), imageProcessed);
+    }
+}
+
+std::vector<drawVariables> MainWindow::detectFrame(int imageIndex, const cv::Mat& imageRaw)
+{
+    std::vector<drawVariables> vDrawVariables;
 
-    if (boost::filesystem::exists(imagePathRaw.str())) { imageRaw = cv::imread(imagePathRaw.str(), CV_LOAD_IMAGE_COLOR); }
-    else                                               { return; }
+    if (imageRaw.empty()) { return vDrawVariables; }
 
     // Detect pupil
 
@@ -780,32 +811,38 @@ void MainWindow::detectCurrentFrame(int imageIndex)
 
     AOIProperties AOIEyeTemp;
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession.AOICamMutex);
 
         mDetectionVariablesEyeTemp  = vDetectionVariablesEye[imageIndex];
         mDetectionParametersEyeTemp = mParameterWidgetEye->getStructure();
 
         mDetectionParametersEyeTemp.cameraFrameRate = cameraFrameRate;
 
-        Parameters::camAOI.wdth = imageRaw.cols;
-        Parameters::camAOI.hght = imageRaw.rows;
+        mCameraSession.camAOI.wdth = imageRaw.cols;
+        mCameraSession.camAOI.hght = imageRaw.rows;
 
         if (mAdvancedOptions.CURVATURE_MEASUREMENT) { setCurvatureMeasurement(mDetectionParametersEyeTemp, imageRaw.cols); }
 
         updateAOIx();
         updateAOIy();
 
-        AOIEyeTemp  = Parameters::eyeAOI;
+        AOIEyeTemp  = mCameraSession.eyeAOI;
     }
 
+    PreprocessedFrame mPreprocessedFrame(imageRaw); // grayscale and down-sampled images are computed once
+
+    bool SAVE_DIAGNOSTICS = SAVE_DATA_EDGE || SAVE_DATA_FIT; // per-edge and per-fit data is not kept otherwise
+    diagnosticVariables mDiagnosticVariablesEye;
+
     auto t1 = std::chrono::high_resolution_clock::now();
-    detectionVariables mDetectionVariablesEyeNew = eyeStalker(imageRaw,
+    detectionVariables mDetectionVariablesEyeNew = eyeStalker(mPreprocessedFrame,
                                                               AOIEyeTemp,
                                                               mDetectionVariablesEyeTemp,
                                                               mDetectionParametersEyeTemp,
                                                               mDataVariablesEye,
                                                               mDrawVariablesEye,
-                                                              mAdvancedOptions);
+                                                              mAdvancedOptions,
+                                                              SAVE_DIAGNOSTICS ? &mDiagnosticVariablesEye : NULL);
     auto t2 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> fp_ms = t2 - t1;
 
@@ -816,27 +853,18 @@ void MainWindow::detectCurrentFrame(int imageIndex)
     mDataVariablesEye.absoluteYPos  = mDataVariablesEye.exactYPos;
     vDataVariablesEye[imageIndex]   = mDataVariablesEye;
 
-    cv::Mat imageProcessed = imageRaw.clone();
-    drawAll(imageProcessed, mDrawVariablesEye);
-
-    // Save image
-
-    std::stringstream imagePath;
-    imagePath << dataDirectoryOffline.toStdString()
-              << "/images/trial_"
-              << trialIndexOffline
-              << "/processed/"
-              << imageIndex
-              << ".png";
+    if (SAVE_DIAGNOSTICS) { mDiagnosticsArena.store(imageIndex, mDiagnosticVariablesEye); }
 
-    cv::imwrite(imagePath.str(), imageProcessed);
+    vDrawVariables.push_back(mDrawVariablesEye);
 
     // Record variables for next frame(s)
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession.AOICamMutex);
         mDetectionVariablesEye = mDetectionVariablesEyeNew;
         vDetectionVariablesEye[imageIndex + 1] = mDetectionVariablesEye;
     }
+
+    return vDrawVariables;
 }
 
 void MainWindow::onDetectCurrentFrame()
@@ -883,11 +911,43 @@ void MainWindow::detectAllFrames()
 {
     int initialIndex = imageIndexOffline; // needed for progressbar
 
+    // Frames are decoded ahead and processed images written behind by separate threads, so that tracking does not wait for the disk
+
+    std::stringstream trialDirectory;
+    trialDirectory << dataDirectoryOffline.toStdString()
+                   << "/images/trial_"
+                   << trialIndexOffline;
+
+    FramePrefetcher mFramePrefetcher;
+    mFramePrefetcher.start([this](int imageIndex) { return loadImageRaw(imageIndex); }, initialIndex, imageTotalOffline, offlineDecoderThreads, offlineQueueSize);
+
+    OverlayWriter mOverlayWriter;
+    mOverlayWriter.open(trialDirectory.str() + "/" + overlayFilename, initialIndex > 0); // detection from first frame replaces previous overlays
+
+    FrameWriter mProcessedWriter;
+    if (SAVE_PROCESSED_IMAGES) { mProcessedWriter.startImages(trialDirectory.str() + "/processed", offlineWriterThreads, offlineQueueSize); }
+
     for (imageIndexOffline = initialIndex; imageIndexOffline < imageTotalOffline && PROCESSING_ALL_IMAGES; imageIndexOffline++)
     {
-        detectCurrentFrame(imageIndexOffline);
+        cv::Mat imageRaw = mFramePrefetcher.getFrame(imageIndexOffline);
+
+        std::vector<drawVariables> vDrawVariables = detectFrame(imageIndexOffline, imageRaw);
+        if (vDrawVariables.empty()) { continue; }
+
+        mOverlayWriter.addFrame(imageIndexOffline, vDrawVariables);
+
+        if (SAVE_PROCESSED_IMAGES)
+        {
+            cv::Mat imageProcessed = imageRaw.clone();
+            drawAll(imageProcessed, vDrawVariables);
+            mProcessedWriter.addFrame(imageIndexOffline, 0, imageProcessed);
+        }
     }
 
+    mFramePrefetcher.stop();
+    mOverlayWriter.close();
+    mProcessedWriter.finish(); // processed images are on disk before they are shown
+
     imageIndexOffline--; // for-loop overshoots value
 
     if (PROCESSING_ALL_IMAGES)
@@ -913,10 +973,14 @@ void MainWindow::onDetectAllTrials()
     {
         PROCESSING_ALL_TRIALS = true;
 
-        for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline && PROCESSING_ALL_TRIALS; iTrial++)
+        if (offlineThreads != 1) { detectAllTrialsParallel(); }
+        else
         {
-            OfflineTrialSlider->setValue(iTrial);
-            onDetectAllFrames();
+            for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline && PROCESSING_ALL_TRIALS; iTrial++)
+            {
+                OfflineTrialSlider->setValue(iTrial);
+                onDetectAllFrames();
+            }
         }
     }
 
@@ -924,6 +988,45 @@ void MainWindow::onDetectAllTrials()
     PROCESSING_ALL_TRIALS = false;
 }
 
+void MainWindow::detectAllTrialsParallel()
+{
+    trialTrackerSettings mSettings;
+    mSettings.SAVE_ASPECT_RATIO    = true;
+    mSettings.SAVE_CIRCUMFERENCE   = true;
+    mSettings.SAVE_POSITION        = true;
+    mSettings.SAVE_SAMPLING_RATE   = false;
+    mSettings.SAVE_DATA_ASCII      = SAVE_DATA_ASCII;
+    mSettings.SAVE_DATA_EDGE       = SAVE_DATA_EDGE;
+    mSettings.SAVE_DATA_EXTRA      = SAVE_DATA_EXTRA;
+    mSettings.SAVE_DATA_FIT        = SAVE_DATA_FIT;
+    mSettings.chunkOverlap         = offlineChunkOverlap;
+    mSettings.chunkTotal           = offlineChunks;
+    mSettings.cameraFrameRate      = cameraFrameRate;
+    mSettings.eyeAOIRatio          = mCameraSession.eyeAOIRatio;
+    mSettings.mDetectionParameters = mParameterWidgetEye->getStructure();
+    mSettings.mAdvancedOptions     = mAdvancedOptions;
+
+    TrialPool mTrialPool;
+    for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline; iTrial++) { mTrialPool.addTrial(dataDirectoryOffline.toStdString(), iTrial); }
+    mTrialPool.start(mSettings, offlineThreads);
+
+    while (!mTrialPool.isFinished())
+    {
+        if (!PROCESSING_ALL_TRIALS) { mTrialPool.stop(); } // button was pressed again
+
+        std::stringstream ss;
+        ss << "<b>" << mTrialPool.getTrialsDone() << " / " << mTrialPool.getTrialsTotal() << " trials</b>";
+        QString title = QString::fromStdString(ss.str());
+        OfflineImageFrameTextBox->setText(title);
+
+        msWait(1000 / guiUpdateFrequency);
+    }
+
+    mTrialPool.wait();
+
+    onSetTrialOffline(trialIndexOffline);
+}
+
 void MainWindow::onDetectAllExperiments()
 {
     if (!PROCESSING_ALL_EXPS)
@@ -956,6 +1059,65 @@ void MainWindow::onDetectAllExperiments()
 
 
 void MainWindow::onSaveTrialData()
+{
+    { // binary data, the ASCII files are an export
+
+        std::vector<double> vTimestamps(imageTotalOffline, 0.0);
+        long long systemTime = 0;
+
+        if (trialIndexOffline < (int) timeMatrix.size())
+        {
+            const std::vector<double>& timestamps = timeMatrix[trialIndexOffline];
+            for (int i = 0; i < imageTotalOffline && i + 2 < (int) timestamps.size(); i++) { vTimestamps[i] = timestamps[i + 2]; }
+            if (timestamps.size() > 1) { systemTime = timestamps[1]; }
+        }
+
+        TrackingDataWriter mWriter;
+        addDataColumns(mWriter, "", vDataVariablesEye, imageTotalOffline);
+        mWriter.addColumn("timestamp", vTimestamps);
+        if (SAVE_DATA_EXTRA) { addExtraColumns(mWriter, vDataVariablesEye, vDetectionVariablesEye, imageTotalOffline); }
+        if (SAVE_DATA_EDGE)  { addEdgeColumns (mWriter, mDiagnosticsArena, imageTotalOffline); }
+        if (SAVE_DATA_FIT)   { addFitColumns  (mWriter, mDiagnosticsArena, imageTotalOffline); }
+        addStageColumns(mWriter, vDataVariablesEye, imageTotalOffline);
+
+        std::stringstream filename;
+        filename << dataDirectoryOffline.toStdString()
+                 << "/images/trial_"
+                 << trialIndexOffline
+                 << "/"
+                 << trackingDataFilename;
+
+        if (!mWriter.save(filename.str(), trialIndexOffline, systemTime, cameraFrameRate, imageTotalOffline))
+        {
+            QString text = "Could not save <b>" + QString::fromStdString(filename.str()) + "</b>";
+            ConfirmationWindow mConfirmationWindow(text, false);
+            mConfirmationWindow.setWindowTitle("Warning");
+            mConfirmationWindow.exec();
+        }
+    }
+
+    { // stage timing, only in profiling builds
+
+        std::stringstream filename;
+        filename << dataDirectoryOffline.toStdString()
+                 << "/images/trial_"
+                 << trialIndexOffline
+                 << "/"
+                 << stageProfileFilename;
+
+        if (!saveStageProfile(filename.str(), vDataVariablesEye, imageTotalOffline))
+        {
+            QString text = "Could not save <b>" + QString::fromStdString(filename.str()) + "</b>";
+            ConfirmationWindow mConfirmationWindow(text, false);
+            mConfirmationWindow.setWindowTitle("Warning");
+            mConfirmationWindow.exec();
+        }
+    }
+
+    if (SAVE_DATA_ASCII) { exportTrialData(); }
+}
+
+void MainWindow::exportTrialData()
 {
     std::string delimiter = ";";
 
@@ -1017,16 +1179,17 @@ void MainWindow::onSaveTrialData()
 
         for (int i = 0; i < imageTotalOffline; i++)
         {
-            int numEdges = vDataVariablesEye[i].edgeData.size();
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].tag          << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvature    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvatureMax << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvatureMin << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].length       << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].radius       << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].radiusVar    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].intensity    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].gradient     << delimiter; }
+            int numEdges;
+            const edgeSummary* edgeData = mDiagnosticsArena.getEdgeData(i, numEdges);
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].tag          << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvature    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMax << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMin << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].length       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radius       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radiusVar    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].intensity    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].gradient     << delimiter; }
             file << "\n";
         }
 
@@ -1046,16 +1209,17 @@ void MainWindow::onSaveTrialData()
 
         for (int i = 0; i < imageTotalOffline; i++)
         {
-            int numFits = vDataVariablesEye[i].ellipseData.size();
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].tag           << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].xPos          << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].yPos          << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].circumference << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].aspectRatio   << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].fitError      << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].edgeLength    << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].angle         << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].edgeScore     << delimiter; }
+            int numFits;
+            const ellipseSummary* ellipseData = mDiagnosticsArena.getEllipseData(i, numFits);
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].tag           << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].xPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].yPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].circumference << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].aspectRatio   << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].fitError      << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeLength    << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].angle         << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeScore     << delimiter; }
             file << "\n";
         }
 
@@ -1070,20 +1234,41 @@ void MainWindow::onCombineData()
                     << "/combined_data.dat";
 
     std::string fileNameWrite = fileNameWriteSS.str();
+    std::string fileNameIndex = dataDirectoryOffline.toStdString() + "/combined_data.esi";
+
+    bool ASCII_EXISTS = SAVE_DATA_ASCII && boost::filesystem::exists(fileNameWrite);
+    bool INDEX_EXISTS = boost::filesystem::exists(fileNameIndex);
 
-    if (boost::filesystem::exists(fileNameWrite))
+    if (ASCII_EXISTS || INDEX_EXISTS)
     {
-        QString text = "The file <b>combined_data.dat</b> already exists in <b>" + dataDirectoryOffline + "/</b>. Do you wish to add data to the end of this file?";
+        QString fileNames;
+        if      (ASCII_EXISTS && INDEX_EXISTS) { fileNames = "<b>combined_data.dat</b> and <b>combined_data.esi</b> already exist"; }
+        else if (ASCII_EXISTS)                 { fileNames = "<b>combined_data.dat</b> already exists"; }
+        else                                   { fileNames = "<b>combined_data.esi</b> already exists"; }
+
+        QString text = "The file " + fileNames + " in <b>" + dataDirectoryOffline + "/</b>. Do you wish to add data to the end?";
         ConfirmationWindow mConfirmationWindow(text);
         mConfirmationWindow.setWindowTitle("Please select option");
 
         if(mConfirmationWindow.exec() == QDialog::Rejected) { return; }
     }
 
+    std::vector<std::string> vDataFilenames; // binary data is combined through an index, without copying
+
     for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
     {
         OfflineTrialSlider->setValue(iTrial);
 
+        std::stringstream dataFilenameTrial;
+        dataFilenameTrial << "images/trial_"
+                          << iTrial
+                          << "/"
+                          << trackingDataFilename;
+
+        if (boost::filesystem::exists(dataDirectoryOffline.toStdString() + "/" + dataFilenameTrial.str())) { vDataFilenames.push_back(dataFilenameTrial.str()); }
+
+        if (!SAVE_DATA_ASCII) { continue; }
+
         std::stringstream fileNameRead;
         fileNameRead << dataDirectoryOffline.toStdString()
                      << "/images/trial_"
@@ -1102,6 +1287,95 @@ void MainWindow::onCombineData()
         file << "\n";
         file.close();
     }
+
+    if (!appendTrackingIndex(fileNameIndex, vDataFilenames))
+    {
+        QString text = "Could not save <b>" + QString::fromStdString(fileNameIndex) + "</b>";
+        ConfirmationWindow mConfirmationWindow(text, false);
+        mConfirmationWindow.setWindowTitle("Warning");
+        mConfirmationWindow.exec();
+    }
+}
+
+void MainWindow::onPackRawImages()
+{
+    QString text = "Do you wish to pack the raw images of all trials into one file per trial? The images themselves are kept.";
+    ConfirmationWindow mConfirmationWindow(text);
+    mConfirmationWindow.setWindowTitle("Please select option");
+
+    if(mConfirmationWindow.exec() == QDialog::Rejected) { return; }
+
+    for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
+    {
+        std::stringstream trialDirectory;
+        trialDirectory << dataDirectoryOffline.toStdString()
+                       << "/images/trial_"
+                       << iTrial;
+
+        std::vector<double> timestamps; // first two entries are trial index and start time
+
+        if (iTrial < (int) timeMatrix.size() && timeMatrix[iTrial].size() > 2)
+        {   timestamps.assign(timeMatrix[iTrial].begin() + 2, timeMatrix[iTrial].end()); }
+
+        if (iTrial == trialIndexOffline) { mFrameContainerReader.close(); } // file is about to be replaced
+
+        convertPNGToContainer(trialDirectory.str(), timestamps);
+    }
+
+    onSetTrialOffline(trialIndexOffline);
+}
+
+void MainWindow::onUnpackRawImages()
+{
+    for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
+    {
+        std::stringstream trialDirectory;
+        trialDirectory << dataDirectoryOffline.toStdString()
+                       << "/images/trial_"
+                       << iTrial;
+
+        convertContainerToPNG(trialDirectory.str());
+    }
+}
+
+void MainWindow::onBenchmarkCodec()
+{
+    if (imageTotalOffline <= 0) { return; }
+
+    // Frames spread over current trial
+
+    int numberOfFrames = std::min(imageTotalOffline, 100);
+
+    std::vector<cv::Mat> vImages;
+
+    for (int iFrame = 0; iFrame < numberOfFrames; iFrame++)
+    {
+        cv::Mat imageRaw = loadImageRaw(iFrame * imageTotalOffline / numberOfFrames);
+        if (imageRaw.empty()) { continue; }
+
+        cv::Mat imageGray;
+        cv::cvtColor(imageRaw, imageGray, cv::COLOR_BGR2GRAY); // recordings are saved in grayscale
+        vImages.push_back(imageGray);
+    }
+
+    std::stringstream results;
+    benchmarkFrameCodec(vImages, results);
+
+    std::stringstream filename;
+    filename << dataDirectoryOffline.toStdString()
+             << "/codec_benchmark.dat";
+
+    std::ofstream file;
+    file.open(filename.str(), std::ios::out | std::ios::trunc);
+    file << results.str();
+    file.close();
+
+    QString text = QString::fromStdString(results.str());
+    text.replace("\n", "<br>");
+
+    ConfirmationWindow mConfirmationWindow(text, false);
+    mConfirmationWindow.setWindowTitle("Codec benchmark");
+    mConfirmationWindow.exec();
 }
 
 ///////////////////////////////////////////////////////////////
@@ -1116,11 +1390,18 @@ void MainWindow::loadSettings(QString filename)
     Parameters::drawFlags.haar      = settings.value("DrawHaar",                false).toBool();
     Parameters::drawFlags.edge      = settings.value("DrawEdge",                false).toBool();
     Parameters::drawFlags.elps      = settings.value("DrawElps",                 true).toBool();
+    offlineChunkOverlap             = settings.value("OfflineChunkOverlap",       500).toInt();
+    offlineChunks                   = settings.value("OfflineChunks",               1).toInt();
+    offlineDecoderThreads           = settings.value("OfflineDecoderThreads",       2).toInt();
+    offlineQueueSize                = settings.value("OfflineQueueSize",           64).toInt();
+    offlineThreads                  = settings.value("OfflineThreads",              1).toInt();
+    offlineWriterThreads            = settings.value("OfflineWriterThreads",        2).toInt();
+    SAVE_DATA_ASCII                 = settings.value("SaveDataASCII",            true).toBool();
 
     detectionParameters mDetectionParametersEye  = loadParameters(filename, "Eye",  parametersEye);
     mParameterWidgetEye ->setStructure(mDetectionParametersEye);
 
-    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye->getStructure(), Parameters::eyeAOI);
+    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye->getStructure(), mCameraSession.eyeAOI);
 }
 
 detectionParameters MainWindow::loadParameters(QString filename, QString prefix, std::vector<double> parameters)
@@ -1156,6 +1437,8 @@ detectionParameters MainWindow::loadParameters(QString filename, QString prefix,
     mDetectionParameters.thresholdScoreDiffFit              = settings.value(prefix + "ScoreThresholdDiffFit",          parameters[25]).toDouble();
     mDetectionParameters.windowLengthEdge                   = settings.value(prefix + "WindowLengthEdge",               parameters[26]).toDouble();
     mDetectionParameters.fitMaximum                         = settings.value(prefix + "FitMaximum",                     parameters[27]).toDouble();
+    mDetectionParameters.thresholdBlinkContrast             = settings.value(prefix + "BlinkContrast",                  parameters[28]).toDouble();
+    mDetectionParameters.circumferenceScaled                = settings.value(prefix + "CircumferenceScaled",            parameters[29]).toDouble();
     cameraFrameRate                                         = settings.value(prefix + "CameraFrameRate",                           250).toDouble();
 
     return mDetectionParameters;
@@ -1169,6 +1452,13 @@ void MainWindow::saveSettings(QString filename)
     settings.setValue("DrawHaar",               Parameters::drawFlags.haar);
     settings.setValue("DrawEdge",               Parameters::drawFlags.edge);
     settings.setValue("DrawElps",               Parameters::drawFlags.elps);
+    settings.setValue("OfflineChunkOverlap",    offlineChunkOverlap);
+    settings.setValue("OfflineChunks",          offlineChunks);
+    settings.setValue("OfflineDecoderThreads",  offlineDecoderThreads);
+    settings.setValue("OfflineQueueSize",       offlineQueueSize);
+    settings.setValue("OfflineThreads",         offlineThreads);
+    settings.setValue("OfflineWriterThreads",   offlineWriterThreads);
+    settings.setValue("SaveDataASCII",          SAVE_DATA_ASCII);
 
     detectionParameters mDetectionParametersEye  = mParameterWidgetEye->getStructure();
     saveParameters(filename,  "Eye", mDetectionParametersEye);
@@ -1193,6 +1483,8 @@ void MainWindow::saveParameters(QString filename, QString prefix, detectionParam
     settings.setValue(prefix + "FitMaximum",                mDetectionParameters.fitMaximum);
     settings.setValue(prefix + "ThresholdFitError",         mDetectionParameters.thresholdFitError);
     settings.setValue(prefix + "AspectRatioMin",            mDetectionParameters.thresholdAspectRatioMin);
+    settings.setValue(prefix + "BlinkContrast",             mDetectionParameters.thresholdBlinkContrast);
+    settings.setValue(prefix + "CircumferenceScaled",       mDetectionParameters.circumferenceScaled);
     settings.setValue(prefix + "GlintSize",                 mDetectionParameters.glintWdth);
     settings.setValue(prefix + "CircumferenceChangeUpper",  mDetectionParameters.thresholdChangeCircumferenceUpper);
     settings.setValue(prefix + "CircumferenceChangeLower",  mDetectionParameters.thresholdChangeCircumferenceLower);
@@ -1220,7 +1512,7 @@ void MainWindow::onResetParameters()
     loadSettings(filename);
 
     mParameterWidgetEye ->reset();
-    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
+    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession.eyeAOI);
 }
 
 void MainWindow::onSetDrawHaar             (int state) { Parameters::drawFlags.haar = state; }
@@ -1238,10 +1530,14 @@ void MainWindow::setCurvatureMeasurement(detectionParameters& mDetectionParamete
     mDetectionParameters.thresholdScoreDiffEdge     = 1.0;
     mDetectionParameters.curvatureOffset            = 360;
     mDetectionParameters.glintWdth                  = 0.0;
+    mDetectionParameters.thresholdBlinkContrast     = 0.0;
+    mDetectionParameters.circumferenceScaled        = 0.0;
 }
 
 void MainWindow::onSetSaveDataEdge (int state) { SAVE_DATA_EDGE  = state; }
 void MainWindow::onSetSaveDataFit  (int state) { SAVE_DATA_FIT   = state; }
 void MainWindow::onSetSaveDataExtra(int state) { SAVE_DATA_EXTRA = state; }
 
+void MainWindow::onSetSaveProcessedImages(int state) { SAVE_PROCESSED_IMAGES = state; }
+
 void MainWindow::onSetCameraFrameRate(double val) { cameraFrameRate = val; }
@@ -23,14 +23,23 @@
 
 // Files
 
+#include "../camerasession.h"
 #include "../confirmationwindow.h"
 #include "../constants.h"
+#include "../diagnosticsarena.h"
 #include "../drawfunctions.h"
 #include "../eyestalker.h"
+#include "../framecontainer.h"
+#include "../frameprefetcher.h"
+#include "../framewriter.h"
+#include "../overlayfile.h"
 #include "../parameters.h"
 #include "../parameterwidget.h"
+#include "../preprocessedframe.h"
 #include "../sliderdouble.h"
 #include "../structures.h"
+#include "../trackingdata.h"
+#include "../trialpool.h"
 #include "../qimageopencv.h"
 #include "../variablewidget.h"
 
@@ -128,6 +137,8 @@ private:
     int imageTotalOffline;
     int getCurrentTime();
 
+    CameraSession mCameraSession; // areas of interest of the loaded images
+
     QImageOpenCV *CamQImage;
 
     QLabel      *OfflineImageFrameTextBox;
@@ -160,8 +171,7 @@ private:
 
     // Variables and parameters
 
-    void resetVariablesHard(detectionVariables&, const detectionParameters&, const AOIProperties&);
-    void resetVariablesSoft(detectionVariables&, const detectionParameters&, const AOIProperties&);
+    void resetVariablesHard(detectionVariables&, const detectionParameters&, const AOIProperties&); // also resets frame rate
 
     detectionVariables  mDetectionVariablesEye;
     drawVariables       mDrawVariablesEye;
@@ -170,6 +180,8 @@ private:
     std::vector<detectionVariables> vDetectionVariablesEye;
     std::vector<dataVariables>      vDataVariablesEye;
 
+    DiagnosticsArena mDiagnosticsArena; // per-edge and per-fit data of trial, only kept when it is saved
+
     ParameterWidget *mParameterWidgetEye;
     VariableWidget  *mVariableWidgetEye;
 
@@ -195,12 +207,26 @@ private:
 
     void countNumTrials();
     void countNumImages();
+    cv::Mat loadImageRaw(int); // from trial container or PNG file
+
+    FrameContainerReader mFrameContainerReader;
+    OverlayReader mOverlayReader; // detection results of trial, drawn on raw frames
 
     void setupOfflineSession();
     void updateOfflineTrial();
 
+    std::vector<drawVariables> detectFrame(int imageIndex, const cv::Mat& imageRaw); // returns overlays of all tracked objects, empty if frame is missing
     void detectCurrentFrame(int);
     void detectAllFrames();
+    void detectAllTrialsParallel(); // one trial per thread, without saving processed images
+    void exportTrialData(); // semicolon-delimited text files, next to binary tracking data
+
+    int offlineChunkOverlap; // warm-up frames before each chunk
+    int offlineChunks; // each trial is split in chunks that are tracked in parallel
+    int offlineDecoderThreads; // frames decoded ahead of tracking thread
+    int offlineQueueSize; // decoded frames and processed images held in memory
+    int offlineThreads; // number of trials tracked at once, 0 uses all cores, 1 tracks serially and saves processed images
+    int offlineWriterThreads; // exported processed images written behind tracking thread
 
     void setCurvatureMeasurement(detectionParameters&, int);
 
@@ -208,10 +234,13 @@ private:
 
     developmentOptions mAdvancedOptions;
 
+    bool SAVE_DATA_ASCII;
     bool SAVE_DATA_EDGE;
     bool SAVE_DATA_FIT;
     bool SAVE_DATA_EXTRA;
 
+    bool SAVE_PROCESSED_IMAGES; // overlays are always saved, images only on request
+
     // General
 
     void msWait(int ms);
@@ -224,6 +253,7 @@ public slots:
 
 private slots:
 
+    void onBenchmarkCodec           ();
     void onCombineData              ();
     void onDetectAllExperiments     ();
     void onDetectAllFrames          ();
@@ -233,6 +263,7 @@ private slots:
     void onImageNext                ();
     void onImagePrevious            ();
     void onLoadSession              ();
+    void onPackRawImages            ();
     void onQuitButtonClicked        ();
     void onResetParameters          ();
     void onSaveTrialData            ();
@@ -243,6 +274,7 @@ private slots:
     void onSetDrawHaar              (int);
     void onSetOfflineImage          (int);
     void onSetTrialOffline          (int);
+    void onUnpackRawImages          ();
     void onUpdateImageProcessed     (int);
     void onUpdateImageRaw           (int);
 
@@ -254,6 +286,8 @@ private slots:
     void onSetSaveDataFit  (int);
     void onSetSaveDataExtra(int);
 
+    void onSetSaveProcessedImages(int);
+
 };
 
 #endif // MAINWINDOW_H
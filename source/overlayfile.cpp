@@ -0,0 +1,360 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "overlayfile.h"
+
+namespace
+{
+
+const uint32_t overlayFileVersion = 1;
+
+void appendValue(std::vector<unsigned char>& vBuffer, const void* value, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(value);
+    vBuffer.insert(vBuffer.end(), bytes, bytes + size);
+}
+
+void appendInt(std::vector<unsigned char>& vBuffer, int32_t value) { appendValue(vBuffer, &value, sizeof(value)); }
+
+void appendAOI(std::vector<unsigned char>& vBuffer, const AOIProperties& mAOI)
+{
+    appendInt(vBuffer, mAOI.xPos);
+    appendInt(vBuffer, mAOI.yPos);
+    appendInt(vBuffer, mAOI.wdth);
+    appendInt(vBuffer, mAOI.hght);
+}
+
+void appendSpans(std::vector<unsigned char>& vBuffer, const std::vector<int>& indices)
+{
+    // Runs of consecutive indices (pixels next to each other on a row) are stored as start and length
+
+    std::vector<int32_t> vSpans;
+
+    int numIndices = indices.size();
+
+    for (int i = 0; i < numIndices; )
+    {
+        int j = i + 1;
+        while (j < numIndices && indices[j] == indices[j - 1] + 1) { j++; }
+        vSpans.push_back(indices[i]);
+        vSpans.push_back(j - i);
+        i = j;
+    }
+
+    appendInt(vBuffer, vSpans.size() / 2);
+    if (!vSpans.empty()) { appendValue(vBuffer, vSpans.data(), vSpans.size() * sizeof(int32_t)); }
+}
+
+// Reading checks bounds, so that a damaged file does not crash the viewer
+
+struct payloadCursor
+{
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    bool VALID;
+};
+
+void readValue(payloadCursor& mCursor, void* value, size_t size)
+{
+    if (!mCursor.VALID || mCursor.offset + size > mCursor.size) { mCursor.VALID = false; return; }
+    std::memcpy(value, mCursor.data + mCursor.offset, size);
+    mCursor.offset += size;
+}
+
+bool checkCount(payloadCursor& mCursor, int count, size_t sizeMin) // 'count' items of at least 'sizeMin' bytes must fit in rest of payload
+{
+    if (!mCursor.VALID || count < 0 || (uint64_t) count * sizeMin > mCursor.size - mCursor.offset) { mCursor.VALID = false; }
+    return mCursor.VALID;
+}
+
+int readInt(payloadCursor& mCursor)
+{
+    int32_t value = 0;
+    readValue(mCursor, &value, sizeof(value));
+    return value;
+}
+
+AOIProperties readAOI(payloadCursor& mCursor)
+{
+    AOIProperties mAOI;
+    mAOI.xPos = readInt(mCursor);
+    mAOI.yPos = readInt(mCursor);
+    mAOI.wdth = readInt(mCursor);
+    mAOI.hght = readInt(mCursor);
+    return mAOI;
+}
+
+std::vector<int> readSpans(payloadCursor& mCursor, const AOIProperties& mAOI) // indices are pixels of given AOI
+{
+    std::vector<int> indices;
+
+    int spanTotal = readInt(mCursor);
+    if (!checkCount(mCursor, spanTotal, 2 * sizeof(int32_t))) { return indices; }
+
+    int64_t indexTotal = (int64_t) std::max(mAOI.wdth, 0) * std::max(mAOI.hght, 0);
+
+    for (int iSpan = 0; iSpan < spanTotal && mCursor.VALID; iSpan++)
+    {
+        int start  = readInt(mCursor);
+        int length = readInt(mCursor);
+
+        if (start < 0 || length < 1 || (int64_t) start + length > indexTotal || (int64_t) indices.size() + length > indexTotal) // outside AOI
+        {
+            mCursor.VALID = false;
+            break;
+        }
+
+        for (int i = 0; i < length; i++) { indices.push_back(start + i); }
+    }
+
+    return indices;
+}
+
+}
+
+// Writer
+
+OverlayWriter::OverlayWriter() {}
+
+OverlayWriter::~OverlayWriter()
+{
+    close();
+}
+
+bool OverlayWriter::open(const std::string& filename, bool APPEND)
+{
+    close();
+
+    if (APPEND) // keep records if file is a valid overlay file
+    {
+        std::ifstream fileExisting(filename, std::ios::binary);
+
+        overlayFileHeader mHeader;
+        if (fileExisting.read(reinterpret_cast<char*>(&mHeader), sizeof(mHeader)) && std::memcmp(mHeader.magic, overlayFileMagic, sizeof(mHeader.magic)) == 0)
+        {
+            fileExisting.close();
+            file.open(filename, std::ios::binary | std::ios::app);
+            return file.is_open();
+        }
+    }
+
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    overlayFileHeader mHeader;
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    std::memcpy(mHeader.magic, overlayFileMagic, sizeof(mHeader.magic));
+    mHeader.version = overlayFileVersion;
+    mHeader.fileId  = std::chrono::system_clock::now().time_since_epoch().count();
+
+    file.write(reinterpret_cast<const char*>(&mHeader), sizeof(mHeader));
+
+    return file.good();
+}
+
+bool OverlayWriter::addFrame(int frameIndex, const std::vector<drawVariables>& vDrawVariables)
+{
+    if (!file.is_open()) { return false; }
+
+    vPayload.clear(); // buffer is re-used between frames
+
+    for (int iLayer = 0; iLayer < (int) vDrawVariables.size(); iLayer++)
+    {
+        const drawVariables& mDrawVariables = vDrawVariables[iLayer];
+
+        appendInt(vPayload, mDrawVariables.PROCESSED);
+        appendInt(vPayload, mDrawVariables.DETECTED);
+        appendInt(vPayload, mDrawVariables.exactXPos);
+        appendInt(vPayload, mDrawVariables.exactYPos);
+        appendInt(vPayload, mDrawVariables.predictedXPos);
+        appendInt(vPayload, mDrawVariables.predictedYPos);
+        appendAOI(vPayload, mDrawVariables.glintAOI);
+        appendAOI(vPayload, mDrawVariables.haarAOI);
+        appendAOI(vPayload, mDrawVariables.cannyAOI);
+
+        appendInt(vPayload, mDrawVariables.ellipseCoefficients.size());
+        for (int i = 0; i < (int) mDrawVariables.ellipseCoefficients.size(); i++) { appendValue(vPayload, &mDrawVariables.ellipseCoefficients[i], sizeof(double)); }
+
+        appendSpans(vPayload, mDrawVariables.cannyEdgeIndices);
+
+        appendInt(vPayload, mDrawVariables.edgeData.size());
+        for (int iEdge = 0; iEdge < (int) mDrawVariables.edgeData.size(); iEdge++)
+        {
+            appendInt  (vPayload, mDrawVariables.edgeData[iEdge].tag);
+            appendSpans(vPayload, mDrawVariables.edgeData[iEdge].pointIndices);
+        }
+    }
+
+    overlayRecordHeader mRecordHeader;
+    mRecordHeader.frameIndex  = frameIndex;
+    mRecordHeader.layerTotal  = vDrawVariables.size();
+    mRecordHeader.payloadSize = vPayload.size();
+
+    file.write(reinterpret_cast<const char*>(&mRecordHeader), sizeof(mRecordHeader));
+    if (!vPayload.empty()) { file.write(reinterpret_cast<const char*>(vPayload.data()), vPayload.size()); }
+    file.flush(); // viewer reads records while detection is running
+
+    return file.good();
+}
+
+void OverlayWriter::close()
+{
+    if (file.is_open()) { file.close(); }
+}
+
+// Reader
+
+OverlayReader::OverlayReader()
+{
+    dataParsed = 0;
+}
+
+bool OverlayReader::open(const std::string& filenameNew)
+{
+    close();
+    filename = filenameNew;
+    return update();
+}
+
+bool OverlayReader::update()
+{
+    if (filename.empty()) { return false; }
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) { close(); return false; }
+
+    size_t fileSize = file.tellg();
+
+    bool FILE_REPLACED = (fileSize < vData.size());
+
+    if (!FILE_REPLACED && vData.size() >= sizeof(overlayFileHeader))
+    {
+        overlayFileHeader mHeader;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(&mHeader), sizeof(mHeader));
+        FILE_REPLACED = (!file || std::memcmp(&mHeader, vData.data(), sizeof(mHeader)) != 0);
+    }
+
+    if (FILE_REPLACED) // by a new detection
+    {
+        vData.clear();
+        mRecords.clear();
+        dataParsed = 0;
+    }
+
+    if (fileSize > vData.size())
+    {
+        size_t dataRead = vData.size();
+        vData.resize(fileSize);
+        file.seekg(dataRead);
+        file.read(reinterpret_cast<char*>(vData.data() + dataRead), fileSize - dataRead);
+        vData.resize(dataRead + file.gcount());
+    }
+
+    if (dataParsed == 0)
+    {
+        overlayFileHeader mHeader;
+        if (vData.size() < sizeof(mHeader)) { return false; }
+        std::memcpy(&mHeader, vData.data(), sizeof(mHeader));
+        if (std::memcmp(mHeader.magic, overlayFileMagic, sizeof(mHeader.magic)) != 0) { return false; }
+        dataParsed = sizeof(mHeader);
+    }
+
+    while (dataParsed + sizeof(overlayRecordHeader) <= vData.size())
+    {
+        overlayRecordHeader mRecordHeader;
+        std::memcpy(&mRecordHeader, vData.data() + dataParsed, sizeof(mRecordHeader));
+
+        if (dataParsed + sizeof(overlayRecordHeader) + mRecordHeader.payloadSize > vData.size()) { break; } // record still being written
+
+        mRecords[mRecordHeader.frameIndex] = dataParsed;
+        dataParsed += sizeof(overlayRecordHeader) + mRecordHeader.payloadSize;
+    }
+
+    return true;
+}
+
+bool OverlayReader::getFrame(int frameIndex, std::vector<drawVariables>& vDrawVariables) const
+{
+    vDrawVariables.clear();
+
+    auto it = mRecords.find(frameIndex);
+    if (it == mRecords.end()) { return false; }
+
+    overlayRecordHeader mRecordHeader;
+    std::memcpy(&mRecordHeader, vData.data() + it->second, sizeof(mRecordHeader));
+
+    payloadCursor mCursor;
+    mCursor.data   = vData.data() + it->second + sizeof(mRecordHeader);
+    mCursor.size   = mRecordHeader.payloadSize;
+    mCursor.offset = 0;
+    mCursor.VALID  = true;
+
+    const size_t layerSizeMin = 21 * sizeof(int32_t); // fixed part of a layer and the three counts
+
+    if (mRecordHeader.layerTotal > mCursor.size / layerSizeMin) { return false; }
+
+    for (int iLayer = 0; iLayer < (int) mRecordHeader.layerTotal && mCursor.VALID; iLayer++)
+    {
+        drawVariables mDrawVariables;
+        mDrawVariables.PROCESSED     = readInt(mCursor);
+        mDrawVariables.DETECTED      = readInt(mCursor);
+        mDrawVariables.exactXPos     = readInt(mCursor);
+        mDrawVariables.exactYPos     = readInt(mCursor);
+        mDrawVariables.predictedXPos = readInt(mCursor);
+        mDrawVariables.predictedYPos = readInt(mCursor);
+        mDrawVariables.glintAOI      = readAOI(mCursor);
+        mDrawVariables.haarAOI       = readAOI(mCursor);
+        mDrawVariables.cannyAOI      = readAOI(mCursor);
+
+        int coefficientTotal = readInt(mCursor);
+        checkCount(mCursor, coefficientTotal, sizeof(double));
+
+        for (int i = 0; i < coefficientTotal && mCursor.VALID; i++)
+        {
+            double coefficient = 0;
+            readValue(mCursor, &coefficient, sizeof(coefficient));
+            mDrawVariables.ellipseCoefficients.push_back(coefficient);
+        }
+
+        mDrawVariables.cannyEdgeIndices = readSpans(mCursor, mDrawVariables.cannyAOI);
+
+        int edgeTotal = readInt(mCursor);
+        checkCount(mCursor, edgeTotal, 2 * sizeof(int32_t)); // tag and span count
+
+        for (int iEdge = 0; iEdge < edgeTotal && mCursor.VALID; iEdge++)
+        {
+            edgeProperties mEdgeProperties; // only what is drawn
+            mEdgeProperties.tag          = readInt(mCursor);
+            mEdgeProperties.pointIndices = readSpans(mCursor, mDrawVariables.cannyAOI);
+            mDrawVariables.edgeData.push_back(mEdgeProperties);
+        }
+
+        vDrawVariables.push_back(mDrawVariables);
+    }
+
+    if (!mCursor.VALID) { vDrawVariables.clear(); }
+
+    return mCursor.VALID;
+}
+
+void OverlayReader::close()
+{
+    dataParsed = 0;
+    mRecords.clear();
+    vData.clear();
+}
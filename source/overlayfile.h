@@ -0,0 +1,97 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef OVERLAYFILE_H
+#define OVERLAYFILE_H
+
+// Files
+
+#include "structures.h"
+
+// Standard Template
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Overlay geometry of offline detection (trial_N/overlay.eso), so that the viewer can draw the detection results
+// on the raw frame instead of loading a processed image.
+//
+// Layout: file header, followed by one record per detected frame (record header + payload). A record holds the draw
+// variables of every tracked object in the frame (eye, second eye, bead). Edge points are stored as spans of
+// consecutive pixel indices. Records are only ever appended; if a frame is detected again, the last record counts.
+
+const char overlayFileMagic[8] = {'E', 'S', 'T', 'K', 'O', 'V', 'L', '1'};
+const std::string overlayFilename = "overlay.eso";
+
+struct overlayFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t fileId; // new for every rewrite of the file, so that a reader notices
+};
+
+struct overlayRecordHeader
+{
+    uint32_t frameIndex;
+    uint32_t layerTotal;  // number of draw variables
+    uint32_t payloadSize; // in bytes, following this header
+};
+
+class OverlayWriter
+{
+
+public:
+
+    OverlayWriter();
+    ~OverlayWriter();
+
+    bool addFrame(int frameIndex, const std::vector<drawVariables>&);
+    bool open(const std::string& filename, bool APPEND); // existing records are kept if appending
+    void close();
+
+private:
+
+    std::ofstream file;
+    std::vector<unsigned char> vPayload;
+};
+
+class OverlayReader
+{
+
+public:
+
+    OverlayReader();
+
+    bool getFrame(int frameIndex, std::vector<drawVariables>&) const; // false if frame has no record
+    bool open(const std::string& filename);
+    bool update(); // reads records appended since last call, re-reads file if it was replaced
+    void close();
+
+private:
+
+    size_t dataParsed; // complete records up to here
+
+    std::map<int, size_t> mRecords; // frame index, offset of record header
+    std::string filename;
+    std::vector<unsigned char> vData;
+};
+
+#endif // OVERLAYFILE_H
@@ -16,29 +16,9 @@
 
 #include "parameters.h"
 
-bool Parameters::CAMERA_READY;
-bool Parameters::CAMERA_RUNNING;
 bool Parameters::ONLINE_MODE;
 
-AOIProperties Parameters::eyeAOI;
-AOIPropertiesDouble Parameters::eyeAOIRatio;
-
-AOIProperties Parameters::beadAOI;
-AOIPropertiesDouble Parameters::beadAOIRatio;
-
-int Parameters::cameraXResolution;
-int Parameters::cameraYResolution;
-AOIProperties Parameters::camAOI;
-
 double Parameters::ellipseDrawOutlineWidth;
 int    Parameters::ellipseDrawCrossSize;
 
 drawBooleans Parameters::drawFlags;
-
-std::condition_variable Parameters::frameCaptureCV;
-
-std::mutex Parameters::frameCaptureMutex;
-
-std::mutex Parameters::AOICamMutex;
-std::mutex Parameters::AOIEyeMutex;
-std::mutex Parameters::AOIBeadMutex;
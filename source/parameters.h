@@ -27,44 +27,21 @@
 // Standard Template
 
 #include <cmath>
-#include <condition_variable>
-#include <mutex>              // std::mutex, std::unique_lock
 
-// QT
-
-#include <QColor>
+// Process-wide settings. State that belongs to a single camera lives in CameraSession.
 
 class Parameters
 {
 
 public:
 
-    static bool CAMERA_READY;
-    static bool CAMERA_RUNNING;
     static bool ONLINE_MODE;
 
     static double ellipseDrawOutlineWidth;
 
-    static AOIProperties camAOI;
-    static AOIProperties eyeAOI;
-    static AOIProperties beadAOI;
-
-    static AOIPropertiesDouble eyeAOIRatio;
-    static AOIPropertiesDouble beadAOIRatio;
-
     static drawBooleans drawFlags;
 
-    static int cameraXResolution;
-    static int cameraYResolution;
-
     static int ellipseDrawCrossSize;
-
-    static std::condition_variable frameCaptureCV;
-
-    static std::mutex frameCaptureMutex;
-    static std::mutex AOICamMutex;
-    static std::mutex AOIEyeMutex;
-    static std::mutex AOIBeadMutex;
 };
 
 #endif // PARAMETERS_H
@@ -326,6 +326,26 @@ ParameterWidget::ParameterWidget(QWidget *parent) : QWidget(parent)
     FitMaximumSlider->setOrientation(Qt::Horizontal);
     QObject::connect(FitMaximumSlider, SIGNAL(valueChanged(int)), this, SLOT(setFitMaximum(int)));
 
+    QLabel *BlinkContrastTextBox = new QLabel;
+    BlinkContrastTextBox->setText("<b>Blink contrast:</b>");
+
+    BlinkContrastLabel  = new QLabel;
+    BlinkContrastSlider = new SliderDouble;
+    BlinkContrastSlider->setPrecision(0);
+    BlinkContrastSlider->setDoubleRange(0, 100);
+    BlinkContrastSlider->setOrientation(Qt::Horizontal);
+    QObject::connect(BlinkContrastSlider, SIGNAL(doubleValueChanged(double)), this, SLOT(setBlinkContrast(double)));
+
+    QLabel *CircumferenceScaledTextBox = new QLabel;
+    CircumferenceScaledTextBox->setText("<b>Reduced-scale circumference:</b>");
+
+    CircumferenceScaledLabel  = new QLabel;
+    CircumferenceScaledSlider = new SliderDouble;
+    CircumferenceScaledSlider->setPrecision(0);
+    CircumferenceScaledSlider->setDoubleRange(0, 300);
+    CircumferenceScaledSlider->setOrientation(Qt::Horizontal);
+    QObject::connect(CircumferenceScaledSlider, SIGNAL(doubleValueChanged(double)), this, SLOT(setCircumferenceScaled(double)));
+
     QLabel *TitleLimitTextBox  = new QLabel;
     QLabel *TitleCannyTextBox  = new QLabel;
     QLabel *TitleLearnTextBox  = new QLabel;
@@ -375,6 +395,8 @@ ParameterWidget::ParameterWidget(QWidget *parent) : QWidget(parent)
     MainLayout->addWidget(FitEdgeFractionTextBox,               30, 0, 1, 1, Qt::AlignRight);
     MainLayout->addWidget(FitEdgeMaximumTextBox,                31, 0, 1, 1, Qt::AlignRight);
     MainLayout->addWidget(FitMaximumTextBox,                    32, 0, 1, 1, Qt::AlignRight);
+    MainLayout->addWidget(BlinkContrastTextBox,                 33, 0, 1, 1, Qt::AlignRight);
+    MainLayout->addWidget(CircumferenceScaledTextBox,           34, 0, 1, 1, Qt::AlignRight);
 
     // Sliders and titles
 
@@ -420,6 +442,8 @@ ParameterWidget::ParameterWidget(QWidget *parent) : QWidget(parent)
     MainLayout->addWidget(FitEdgeFractionSlider,                30, 1);
     MainLayout->addWidget(FitEdgeMaximumSlider,                 31, 1);
     MainLayout->addWidget(FitMaximumSlider,                     32, 1);
+    MainLayout->addWidget(BlinkContrastSlider,                  33, 1);
+    MainLayout->addWidget(CircumferenceScaledSlider,            34, 1);
 
     // Value labels
 
@@ -455,6 +479,8 @@ ParameterWidget::ParameterWidget(QWidget *parent) : QWidget(parent)
     MainLayout->addWidget(FitEdgeFractionLabel,                 30, 2);
     MainLayout->addWidget(FitEdgeMaximumLabel,                  31, 2);
     MainLayout->addWidget(FitMaximumLabel,                      32, 2);
+    MainLayout->addWidget(BlinkContrastLabel,                   33, 2);
+    MainLayout->addWidget(CircumferenceScaledLabel,             34, 2);
 
     MainLayout->setColumnStretch(0,1);
     MainLayout->setColumnStretch(1,3);
@@ -582,6 +608,12 @@ void ParameterWidget::reset()
 
     FitMaximumSlider->setValue(mDetectionParameters.fitMaximum);
     FitMaximumLabel ->setText(QString::number(mDetectionParameters.fitMaximum));
+
+    BlinkContrastSlider->setDoubleValue(mDetectionParameters.thresholdBlinkContrast);
+    BlinkContrastLabel ->setText(QString::number(mDetectionParameters.thresholdBlinkContrast, 'f', 0));
+
+    CircumferenceScaledSlider->setDoubleValue(mDetectionParameters.circumferenceScaled);
+    CircumferenceScaledLabel ->setText(QString::number(mDetectionParameters.circumferenceScaled, 'f', 0));
 }
 
 void ParameterWidget::setCircumferenceMin(double value)
@@ -778,6 +810,18 @@ void ParameterWidget::setFitMaximum(int value)
     FitMaximumLabel->setText(QString::number(value));
 }
 
+void ParameterWidget::setBlinkContrast(double value)
+{
+    mDetectionParameters.thresholdBlinkContrast = value;
+    BlinkContrastLabel->setText(QString::number(value, 'f', 0));
+}
+
+void ParameterWidget::setCircumferenceScaled(double value)
+{
+    mDetectionParameters.circumferenceScaled = value;
+    CircumferenceScaledLabel->setText(QString::number(value, 'f', 0));
+}
+
 void ParameterWidget::setThresholdFitError(double value)
 {
     mDetectionParameters.thresholdFitError = value;
@@ -57,6 +57,8 @@ private:
     SliderDouble*GainPositionSlider;
     QLabel      *AspectRatioMinLabel;
     SliderDouble*AspectRatioMinSlider;
+    QLabel      *BlinkContrastLabel;
+    SliderDouble*BlinkContrastSlider;
     QLabel      *CannyBlurLevelLabel;
     QSlider     *CannyBlurLevelSlider;
     QLabel      *CannyKernelSizeLabel;
@@ -69,6 +71,8 @@ private:
     SliderDouble*CircumferenceMaxSlider;
     QLabel      *CircumferenceMinLabel;
     SliderDouble*CircumferenceMinSlider;
+    QLabel      *CircumferenceScaledLabel;
+    SliderDouble*CircumferenceScaledSlider;
     QLabel      *CurvatureOffsetLabel;
     SliderDouble*CurvatureOffsetSlider;
     QLabel      *FitEdgeFractionLabel;
@@ -127,6 +131,8 @@ private slots:
     void setCircumferenceMin                (double);
     void setCircumferenceMax                (double);
     void setAspectRatioMin                  (double);
+    void setBlinkContrast                   (double);
+    void setCircumferenceScaled             (double);
     void setThresholdCircumferenceLower     (double);
     void setThresholdCircumferenceUpper     (double);
     void setThresholdAspectRatioLower       (double);
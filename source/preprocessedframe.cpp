@@ -0,0 +1,117 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "preprocessedframe.h"
+
+PreprocessedFrame::PreprocessedFrame(const cv::Mat& image)
+{
+    GRAY_READY     = false;
+    RESIZED_READY  = false;
+    INTEGRAL_READY = false;
+
+    grayscaleDuration = 0;
+    integralDuration  = 0;
+    resizeDuration    = 0;
+
+    imageOriginal = image;
+    imageWdth = image.cols;
+    imageHght = image.rows;
+}
+
+const cv::Mat& PreprocessedFrame::getGray()
+{
+    std::lock_guard<std::mutex> preprocessingLock(preprocessingMutex);
+
+    if (!GRAY_READY)
+    {
+        long long timeStart = getProfileTime();
+        if (imageOriginal.channels() == 1) { imageGray = imageOriginal; }
+        else { cv::cvtColor(imageOriginal, imageGray, cv::COLOR_BGR2GRAY); }
+        grayscaleDuration = getProfileTime() - timeStart;
+        GRAY_READY = true;
+    }
+
+    return imageGray;
+}
+
+const cv::Mat& PreprocessedFrame::getResized()
+{
+    const cv::Mat& imageGrayTemp = getGray();
+
+    std::lock_guard<std::mutex> preprocessingLock(preprocessingMutex);
+
+    if (!RESIZED_READY)
+    {
+        long long timeStart = getProfileTime();
+
+        int imgWdthResized = round(imageWdth * sizeFactorDown);
+        int imgHghtResized = round(imageHght * sizeFactorDown);
+
+        cv::Size size(imgWdthResized, imgHghtResized);
+        cv::resize(imageGrayTemp, imageResized, size);
+        resizeDuration = getProfileTime() - timeStart;
+        RESIZED_READY = true;
+    }
+
+    return imageResized;
+}
+
+const std::vector<unsigned int>& PreprocessedFrame::getIntegralImage()
+{
+    const cv::Mat& imageResizedTemp = getResized();
+
+    std::lock_guard<std::mutex> preprocessingLock(preprocessingMutex);
+
+    if (!INTEGRAL_READY)
+    {
+        long long timeStart = getProfileTime();
+
+        int wdth = imageResizedTemp.cols;
+        int hght = imageResizedTemp.rows;
+
+        integralImage.resize(wdth * hght); // unsigned due to large positive values
+
+        for (int y = 0; y < hght; y++)
+        {
+            const uchar *ptr = imageResizedTemp.ptr<uchar>(y);
+
+            unsigned int rowSum = 0;
+
+            for (int x = 0; x < wdth; x++)
+            {
+                int i = wdth * y + x;
+                rowSum += ptr[x];
+                if (y == 0) { integralImage[i] = rowSum; }
+                else        { integralImage[i] = rowSum + integralImage[i - wdth]; }
+            }
+        }
+
+        integralDuration = getProfileTime() - timeStart;
+        INTEGRAL_READY = true;
+    }
+
+    return integralImage;
+}
+
+long long PreprocessedFrame::getDuration(int stage) const
+{
+    std::lock_guard<std::mutex> preprocessingLock(preprocessingMutex);
+
+    if      (stage == STAGE_GRAYSCALE) { return grayscaleDuration; }
+    else if (stage == STAGE_RESIZE)    { return resizeDuration; }
+    else if (stage == STAGE_INTEGRAL)  { return integralDuration; }
+    else                               { return 0; }
+}
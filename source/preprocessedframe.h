@@ -0,0 +1,81 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef PREPROCESSEDFRAME_H
+#define PREPROCESSEDFRAME_H
+
+// Files
+
+#include "stageprofiler.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/core/core.hpp>
+
+// Camera frame that is shared by all trackers (eye, bead, left and right eye) processing it.
+// Grayscale conversion, down-sampling and the integral image are computed on first request and cached,
+// so that every tracker after the first one gets them for free.
+
+class PreprocessedFrame
+{
+
+public:
+
+    PreprocessedFrame(const cv::Mat& image); // BGR or grayscale camera frame
+
+    const cv::Mat& getGray();
+    const cv::Mat& getResized(); // grayscale image down-sampled by 'sizeFactorDown'
+    const std::vector<unsigned int>& getIntegralImage(); // integral image of down-sampled image
+
+    long long getDuration(int stage) const; // ns of grayscale, resize or integral stage, 0 without profiling or if not computed yet
+    int getWdth() const { return imageWdth; }
+    int getHght() const { return imageHght; }
+
+    static constexpr double sizeFactorUp   = 2;
+    static constexpr double sizeFactorDown = 1 / sizeFactorUp;
+
+private:
+
+    bool GRAY_READY;
+    bool RESIZED_READY;
+    bool INTEGRAL_READY;
+
+    int imageWdth;
+    int imageHght;
+
+    long long grayscaleDuration;
+    long long integralDuration;
+    long long resizeDuration;
+
+    cv::Mat imageOriginal;
+    cv::Mat imageGray;
+    cv::Mat imageResized;
+
+    mutable std::mutex preprocessingMutex; // trackers may request data from different threads
+
+    std::vector<unsigned int> integralImage;
+
+};
+
+#endif // PREPROCESSEDFRAME_H
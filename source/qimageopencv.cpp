@@ -27,7 +27,10 @@ QImageOpenCV::QImageOpenCV(QWidget *parent) : QLabel(parent)
     backgroundColour = QColor( 48,  47,  47);
     textColour       = QColor(177, 177, 177);
 
-    SHOW_BEAD_AOI = false;
+    mCameraSession = NULL;
+
+    SHOW_BEAD_AOI     = false;
+    SHOW_EYE_RGHT_AOI = false;
 
     this->setLineWidth(2);
     this->setAlignment(Qt::AlignCenter);
@@ -39,6 +42,8 @@ QImageOpenCV::~QImageOpenCV()
 
 }
 
+void QImageOpenCV::setCameraSession(CameraSession* session) { mCameraSession = session; }
+
 void QImageOpenCV::setSize(int W, int H)
 {
     widgetWdth  = W;
@@ -120,6 +125,7 @@ void QImageOpenCV::setImage()
         drawAOI(imageEdited,   eyeAOI, QColor(255,   0,   0));
         drawAOI(imageEdited, flashAOI, QColor(  0,   0, 255));
         if (SHOW_BEAD_AOI) { drawAOI(imageEdited,  beadAOI, QColor(  0, 255,   0)); }
+        if (SHOW_EYE_RGHT_AOI) { drawAOI(imageEdited, eyeAOIRght, QColor(255, 0, 255)); }
         this->setPixmap(imageEdited);
     }
 }
@@ -127,13 +133,14 @@ void QImageOpenCV::setImage()
 void QImageOpenCV::clearImage() { this->clear(); }
 
 void QImageOpenCV::setAOIEye (AOIProperties eyeAOINew)  { eyeAOI  = eyeAOINew; }
+void QImageOpenCV::setAOIEyeRght(AOIProperties eyeAOINew) { eyeAOIRght = eyeAOINew; }
 void QImageOpenCV::setAOIBead(AOIProperties beadAOINew) { beadAOI = beadAOINew; }
 
 void QImageOpenCV::setAOIFlash(AOIProperties flashAOINew)
 {
     flashAOI = flashAOINew;
-    flashAOI.xPos = flashAOI.xPos - Parameters::camAOI.xPos;
-    flashAOI.yPos = flashAOI.yPos - Parameters::camAOI.yPos;
+    flashAOI.xPos = flashAOI.xPos - mCameraSession->camAOI.xPos;
+    flashAOI.yPos = flashAOI.yPos - mCameraSession->camAOI.yPos;
 
     if (flashAOI.xPos < 0)
     {
@@ -162,6 +169,12 @@ void QImageOpenCV::showAOIBead(bool state)
     this->setImage();
 }
 
+void QImageOpenCV::showAOIEyeRght(bool state)
+{
+    SHOW_EYE_RGHT_AOI = state;
+    this->setImage();
+}
+
 void QImageOpenCV::setAOIError()
 {
     QPixmap pic(widgetWdth, widgetHght);
@@ -211,61 +224,91 @@ void QImageOpenCV::setSpinner()
 
 void QImageOpenCV::mousePressEvent(QMouseEvent *event)
 {
+    if (mCameraSession == NULL) { return; }
+
     int imageScaledXOffset = 0.5 * (widgetWdth - imageWdthScaled);
     int imageScaledYOffset = 0.5 * (widgetHght - imageHghtScaled);
 
     if (event->button() == Qt::LeftButton)
     {
-        std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-        std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
+        std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
 
         double mouseXPos = (event->x()) - imageScaledXOffset;
 
-        Parameters::eyeAOI.xPos = round(mouseXPos * (imageWdth / (double) imageWdthScaled) - 0.5 * Parameters::eyeAOI.wdth);
-        if (Parameters::eyeAOI.xPos + Parameters::eyeAOI.wdth >= imageWdth)
-        {   Parameters::eyeAOI.xPos = imageWdth - Parameters::eyeAOI.wdth; }
-        else if (Parameters::eyeAOI.xPos < 0)
-        {        Parameters::eyeAOI.xPos = 0; }
-        Parameters::eyeAOIRatio.xPos = Parameters::eyeAOI.xPos / (double) imageWdth;
+        mCameraSession->eyeAOI.xPos = round(mouseXPos * (imageWdth / (double) imageWdthScaled) - 0.5 * mCameraSession->eyeAOI.wdth);
+        if (mCameraSession->eyeAOI.xPos + mCameraSession->eyeAOI.wdth >= imageWdth)
+        {   mCameraSession->eyeAOI.xPos = imageWdth - mCameraSession->eyeAOI.wdth; }
+        else if (mCameraSession->eyeAOI.xPos < 0)
+        {        mCameraSession->eyeAOI.xPos = 0; }
+        mCameraSession->eyeAOIRatio.xPos = mCameraSession->eyeAOI.xPos / (double) imageWdth;
 
         double mouseYPos = (event->y()) - imageScaledYOffset;
 
-        Parameters::eyeAOI.yPos = round(mouseYPos * (imageHght / (double) imageHghtScaled) - 0.5 * Parameters::eyeAOI.hght);
-        if (Parameters::eyeAOI.yPos + Parameters::eyeAOI.hght >= imageHght)
-        {   Parameters::eyeAOI.yPos = imageHght - Parameters::eyeAOI.hght; }
-        else if (Parameters::eyeAOI.yPos < 0)
-        {        Parameters::eyeAOI.yPos = 0; }
-        Parameters::eyeAOIRatio.yPos = Parameters::eyeAOI.yPos / (double) imageHght;
+        mCameraSession->eyeAOI.yPos = round(mouseYPos * (imageHght / (double) imageHghtScaled) - 0.5 * mCameraSession->eyeAOI.hght);
+        if (mCameraSession->eyeAOI.yPos + mCameraSession->eyeAOI.hght >= imageHght)
+        {   mCameraSession->eyeAOI.yPos = imageHght - mCameraSession->eyeAOI.hght; }
+        else if (mCameraSession->eyeAOI.yPos < 0)
+        {        mCameraSession->eyeAOI.yPos = 0; }
+        mCameraSession->eyeAOIRatio.yPos = mCameraSession->eyeAOI.yPos / (double) imageHght;
 
-        setAOIEye(Parameters::eyeAOI);
+        setAOIEye(mCameraSession->eyeAOI);
         setImage();
 
         emit updateImage(-1);
     }
     else if (event->button() == Qt::RightButton)
     {
-        std::lock_guard<std::mutex> AOICamLock (Parameters::AOICamMutex);
-        std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
+        std::lock_guard<std::mutex> AOICamLock (mCameraSession->AOICamMutex);
+        std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+
+        double mouseXPos = (event->x()) - imageScaledXOffset;
+
+        mCameraSession->beadAOI.xPos = round(mouseXPos * (imageWdth / (double) imageWdthScaled) - 0.5 * mCameraSession->beadAOI.wdth);
+        if (mCameraSession->beadAOI.xPos + mCameraSession->beadAOI.wdth >= imageWdth)
+        {   mCameraSession->beadAOI.xPos = imageWdth - mCameraSession->beadAOI.wdth; }
+        else if (mCameraSession->beadAOI.xPos < 0)
+        {        mCameraSession->beadAOI.xPos = 0; }
+        mCameraSession->beadAOIRatio.xPos = mCameraSession->beadAOI.xPos / (double) imageWdth;
+
+        double mouseYPos = (event->y()) - imageScaledYOffset;
+
+        mCameraSession->beadAOI.yPos = round(mouseYPos * (imageHght / (double) imageHghtScaled) - 0.5 * mCameraSession->beadAOI.hght);
+        if (mCameraSession->beadAOI.yPos + mCameraSession->beadAOI.hght >= imageHght)
+        {   mCameraSession->beadAOI.yPos = imageHght - mCameraSession->beadAOI.hght; }
+        else if (mCameraSession->beadAOI.yPos < 0)
+        {        mCameraSession->beadAOI.yPos = 0; }
+        mCameraSession->beadAOIRatio.yPos = mCameraSession->beadAOI.yPos / (double) imageHght;
+
+        setAOIBead(mCameraSession->beadAOI);
+        setImage();
+
+        emit updateImage(-1);
+    }
+    else if (event->button() == Qt::MiddleButton && SHOW_EYE_RGHT_AOI)
+    {
+        std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
 
         double mouseXPos = (event->x()) - imageScaledXOffset;
 
-        Parameters::beadAOI.xPos = round(mouseXPos * (imageWdth / (double) imageWdthScaled) - 0.5 * Parameters::beadAOI.wdth);
-        if (Parameters::beadAOI.xPos + Parameters::beadAOI.wdth >= imageWdth)
-        {   Parameters::beadAOI.xPos = imageWdth - Parameters::beadAOI.wdth; }
-        else if (Parameters::beadAOI.xPos < 0)
-        {        Parameters::beadAOI.xPos = 0; }
-        Parameters::beadAOIRatio.xPos = Parameters::beadAOI.xPos / (double) imageWdth;
+        mCameraSession->eyeAOIRght.xPos = round(mouseXPos * (imageWdth / (double) imageWdthScaled) - 0.5 * mCameraSession->eyeAOIRght.wdth);
+        if (mCameraSession->eyeAOIRght.xPos + mCameraSession->eyeAOIRght.wdth >= imageWdth)
+        {   mCameraSession->eyeAOIRght.xPos = imageWdth - mCameraSession->eyeAOIRght.wdth; }
+        else if (mCameraSession->eyeAOIRght.xPos < 0)
+        {        mCameraSession->eyeAOIRght.xPos = 0; }
+        mCameraSession->eyeAOIRatioRght.xPos = mCameraSession->eyeAOIRght.xPos / (double) imageWdth;
 
         double mouseYPos = (event->y()) - imageScaledYOffset;
 
-        Parameters::beadAOI.yPos = round(mouseYPos * (imageHght / (double) imageHghtScaled) - 0.5 * Parameters::beadAOI.hght);
-        if (Parameters::beadAOI.yPos + Parameters::beadAOI.hght >= imageHght)
-        {   Parameters::beadAOI.yPos = imageHght - Parameters::beadAOI.hght; }
-        else if (Parameters::beadAOI.yPos < 0)
-        {        Parameters::beadAOI.yPos = 0; }
-        Parameters::beadAOIRatio.yPos = Parameters::beadAOI.yPos / (double) imageHght;
+        mCameraSession->eyeAOIRght.yPos = round(mouseYPos * (imageHght / (double) imageHghtScaled) - 0.5 * mCameraSession->eyeAOIRght.hght);
+        if (mCameraSession->eyeAOIRght.yPos + mCameraSession->eyeAOIRght.hght >= imageHght)
+        {   mCameraSession->eyeAOIRght.yPos = imageHght - mCameraSession->eyeAOIRght.hght; }
+        else if (mCameraSession->eyeAOIRght.yPos < 0)
+        {        mCameraSession->eyeAOIRght.yPos = 0; }
+        mCameraSession->eyeAOIRatioRght.yPos = mCameraSession->eyeAOIRght.yPos / (double) imageHght;
 
-        setAOIBead(Parameters::beadAOI);
+        setAOIEyeRght(mCameraSession->eyeAOIRght);
         setImage();
 
         emit updateImage(-1);
@@ -17,6 +17,7 @@
 #ifndef QIMAGEOPENCV_H
 #define QIMAGEOPENCV_H
 
+#include "camerasession.h"
 #include "parameters.h"
 
 #include <iostream>     // std::ofstream
@@ -59,12 +60,15 @@ public:
     void setImage();
 
     void setAOIError();
+    void setCameraSession(CameraSession*);
     void setAOIBead (AOIProperties beadAOINew);
     void setAOIEye  (AOIProperties eyeAOINew);
+    void setAOIEyeRght(AOIProperties eyeAOINew);
     void setAOIFlash(AOIProperties flashAOINew);
     void drawAOI(QPixmap &img, AOIProperties mAOI, QColor col);
 
     void showAOIBead(bool);
+    void showAOIEyeRght(bool);
 
     void setSize(int, int);
     void setSpinner();
@@ -72,13 +76,17 @@ public:
 private:
 
     bool SHOW_BEAD_AOI;
+    bool SHOW_EYE_RGHT_AOI;
 
     double aspectRatio;
     double imageScaleFactorX;
     double imageScaleFactorY;
 
+    CameraSession *mCameraSession;
+
     AOIProperties beadAOI;
     AOIProperties eyeAOI;
+    AOIProperties eyeAOIRght;
     AOIProperties flashAOI;
 
     int imageHght;
@@ -0,0 +1,617 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+// Regression check of eyeStalker(): compares detections with golden outputs and checks that tracking has not become slower
+
+#include "../eyestalker.h"
+#include "../syntheticeye.h"
+#include "../trackingdata.h"
+#include "../trialtracker.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+const std::string performanceFilename = "performance.dat"; // frames/s and 99th percentile latency of each sequence
+
+struct regressionSettings
+{
+    bool CHECK_SPEED;
+    bool UPDATE;           // write golden outputs instead of comparing
+    int frameTotal;        // frames per synthetic sequence
+    int maxMismatches;     // frames where only one of golden and current output detected the pupil
+    int repetitionTotal;   // timing runs per sequence, the fastest is used
+    double maxSlowdown;    // allowed relative decrease of frames/s and increase of 99th percentile latency
+    double toleranceAngle;         // rad
+    double toleranceAspectRatio;
+    double toleranceCircumference; // px
+    double tolerancePosition;      // px
+    double angleAspectRatioMax;    // angle is only compared for less round pupils, since it is ill-defined for circles
+};
+
+struct regressionSequence
+{
+    std::string name;
+    AOIProperties eyeAOI;
+    std::vector<cv::Mat> vImages;
+};
+
+struct regressionOutput // per frame
+{
+    bool DETECTED;
+    double angle; // mean of accepted fits
+    double aspectRatio;
+    double circumference;
+    double xPos;
+    double yPos;
+};
+
+struct regressionPerformance
+{
+    double frameRate; // frames/s
+    double latency;   // 99th percentile (ms)
+};
+
+void printUsage()
+{
+    std::cout << "Usage: eyestalker-regression [options] <golden directory>\n"
+              << "\n"
+              << "  --update                 record golden outputs instead of comparing\n"
+              << "  -s <file>                settings file saved by EyeStalker (default: built-in parameters)\n"
+              << "  -t <trial directory>     also use a recorded trial (session/images/trial_N), can be repeated\n"
+              << "  --frames <n>             frames per synthetic sequence (default: 500)\n"
+              << "  --repeat <n>             timing runs per sequence, the fastest counts (default: 3)\n"
+              << "  --max-mismatches <n>     frames with different detection result (default: 0)\n"
+              << "  --max-slowdown <f>       allowed loss of frames/s and gain of p99 latency (default: 0.1)\n"
+              << "  --no-speed               only check accuracy\n"
+              << "  --tol-angle <rad>        (default: 0.001)\n"
+              << "  --tol-aspect-ratio <r>   (default: 0.0001)\n"
+              << "  --tol-circumference <px> (default: 0.001)\n"
+              << "  --tol-position <px>      (default: 0.001)\n"
+              << "\n"
+              << "Golden outputs (detection, position, circumference, aspect ratio and angle of every frame) are stored per\n"
+              << "sequence as <name>.esd, speed in " << performanceFilename << ". Returns 1 if any sequence fails.\n";
+}
+
+std::vector<regressionSequence> getSyntheticSequences(int frameTotal)
+{
+    std::vector<syntheticEyeParameters> vParameters;
+    std::vector<std::string> vNames;
+
+    { syntheticEyeParameters mParameters; // default: fixation at 640 x 480
+        mParameters.tremorAmplitude = 0.3;
+        vParameters.push_back(mParameters);
+        vNames.push_back("fixation");
+    }
+
+    { syntheticEyeParameters mParameters;
+        mParameters.trajectory   = TRAJECTORY_PURSUIT;
+        mParameters.pupilAngle   = 0.6;
+        mParameters.eyelashTotal = 8;
+        vParameters.push_back(mParameters);
+        vNames.push_back("pursuit");
+    }
+
+    { syntheticEyeParameters mParameters;
+        mParameters.trajectory      = TRAJECTORY_SACCADES;
+        mParameters.blinkInterval   = 1.0;
+        mParameters.pupilSizeChange = 0.15;
+        vParameters.push_back(mParameters);
+        vNames.push_back("saccades_blinks");
+    }
+
+    { syntheticEyeParameters mParameters;
+        mParameters.imageWdth       = 320;
+        mParameters.imageHght       = 240;
+        mParameters.pupilRadius     = 12;
+        mParameters.irisRadius      = 34;
+        mParameters.motionAmplitude = 40;
+        mParameters.trajectory      = TRAJECTORY_PURSUIT;
+        mParameters.eyelidCoverage  = 0.3;
+        mParameters.eyelashTotal    = 12;
+        mParameters.glintTotal      = 2;
+        mParameters.noiseSigma      = 5;
+        vParameters.push_back(mParameters);
+        vNames.push_back("occlusion_small");
+    }
+
+    { syntheticEyeParameters mParameters;
+        mParameters.imageWdth       = 1280;
+        mParameters.imageHght       = 960;
+        mParameters.pupilRadius     = 50;
+        mParameters.irisRadius      = 140;
+        mParameters.motionAmplitude = 160;
+        mParameters.trajectory      = TRAJECTORY_SACCADES;
+        vParameters.push_back(mParameters);
+        vNames.push_back("saccades_large");
+    }
+
+    std::vector<regressionSequence> vSequences(vParameters.size());
+
+    for (int iSequence = 0; iSequence < (int) vParameters.size(); iSequence++)
+    {
+        regressionSequence& mSequence = vSequences[iSequence];
+        mSequence.name = "synthetic_" + vNames[iSequence];
+        mSequence.eyeAOI.xPos = 0;
+        mSequence.eyeAOI.yPos = 0;
+        mSequence.eyeAOI.wdth = vParameters[iSequence].imageWdth;
+        mSequence.eyeAOI.hght = vParameters[iSequence].imageHght;
+
+        SyntheticEye mSyntheticEye(vParameters[iSequence]);
+        for (int iFrame = 0; iFrame < frameTotal; iFrame++) { mSequence.vImages.push_back(mSyntheticEye.getFrame(iFrame)); }
+    }
+
+    return vSequences;
+}
+
+bool loadRecordedSequence(const std::string& trialDirectory, const trialTrackerSettings& mSettings, regressionSequence& mSequence)
+{
+    boost::filesystem::path trialPath(trialDirectory);
+    std::string trialName = trialPath.filename().string();
+    if (trialName.empty()) { trialName = trialPath.parent_path().filename().string(); trialPath = trialPath.parent_path(); } // trailing slash
+
+    if (trialName.compare(0, 6, "trial_") != 0) { return false; }
+
+    boost::filesystem::path sessionPath = trialPath.parent_path().parent_path(); // session/images/trial_N
+
+    TrialTracker mTrialTracker;
+    if (!mTrialTracker.open(sessionPath.string(), std::atoi(trialName.c_str() + 6))) { return false; }
+
+    for (int iFrame = 0; iFrame < mTrialTracker.getImageTotal(); iFrame++)
+    {
+        cv::Mat imageRaw = mTrialTracker.loadImageRaw(iFrame);
+        if (imageRaw.empty()) { return false; }
+        mSequence.vImages.push_back(imageRaw.clone()); // frame may point into container, which is closed with tracker
+    }
+
+    if (mSequence.vImages.empty()) { return false; }
+
+    mSequence.name = "recorded_" + sessionPath.filename().string() + "_" + trialName;
+
+    // Same eye AOI as 'Detect all frames'
+
+    int imageWdth = mSequence.vImages[0].cols;
+    int imageHght = mSequence.vImages[0].rows;
+
+    AOIProperties& eyeAOI = mSequence.eyeAOI;
+    eyeAOI.wdth = round(imageWdth * mSettings.eyeAOIRatio.wdth);
+    eyeAOI.hght = round(imageHght * mSettings.eyeAOIRatio.hght);
+    eyeAOI.xPos = round(imageWdth * mSettings.eyeAOIRatio.xPos);
+    eyeAOI.yPos = round(imageHght * mSettings.eyeAOIRatio.yPos);
+    if (eyeAOI.xPos + eyeAOI.wdth > imageWdth) { eyeAOI.xPos = imageWdth - eyeAOI.wdth; }
+    if (eyeAOI.yPos + eyeAOI.hght > imageHght) { eyeAOI.yPos = imageHght - eyeAOI.hght; }
+
+    return true;
+}
+
+// Accuracy run, with fit diagnostics for the angle
+
+std::vector<regressionOutput> trackSequence(const regressionSequence& mSequence, const detectionParameters& mDetectionParameters)
+{
+    int frameTotal = mSequence.vImages.size();
+
+    std::vector<regressionOutput> vOutputs(frameTotal);
+
+    detectionVariables mDetectionVariables;
+    resetVariablesHard(mDetectionVariables, mDetectionParameters, mSequence.eyeAOI);
+
+    for (int iFrame = 0; iFrame < frameTotal; iFrame++)
+    {
+        dataVariables mDataVariables = dataVariables();
+        drawVariables mDrawVariables;
+        diagnosticVariables mDiagnosticVariables;
+
+        mDetectionVariables = eyeStalker(mSequence.vImages[iFrame], mSequence.eyeAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables, developmentOptions(), &mDiagnosticVariables);
+
+        regressionOutput& mOutput = vOutputs[iFrame];
+        mOutput.DETECTED      = mDataVariables.DETECTED;
+        mOutput.aspectRatio   = mDataVariables.exactAspectRatio;
+        mOutput.circumference = mDataVariables.exactCircumference;
+        mOutput.xPos          = mDataVariables.exactXPos;
+        mOutput.yPos          = mDataVariables.exactYPos;
+        mOutput.angle         = 0;
+
+        if (!mOutput.DETECTED) { continue; }
+
+        int fitTotal = 0;
+
+        for (int iFit = 0; iFit < (int) mDiagnosticVariables.ellipseData.size(); iFit++)
+        {
+            if (mDiagnosticVariables.ellipseData[iFit].tag == 1)
+            {
+                mOutput.angle += mDiagnosticVariables.ellipseData[iFit].angle;
+                fitTotal++;
+            }
+        }
+
+        if (fitTotal > 0) { mOutput.angle /= fitTotal; }
+    }
+
+    return vOutputs;
+}
+
+// Speed run, without diagnostics. Frames are in memory, so only tracking itself is timed.
+
+regressionPerformance timeSequence(const regressionSequence& mSequence, const detectionParameters& mDetectionParameters, int repetitionTotal)
+{
+    int frameTotal = mSequence.vImages.size();
+
+    regressionPerformance mPerformance;
+    mPerformance.frameRate = 0;
+    mPerformance.latency   = 0;
+
+    std::vector<double> vDurations(frameTotal);
+
+    for (int iRepetition = 0; iRepetition < repetitionTotal; iRepetition++)
+    {
+        detectionVariables mDetectionVariables;
+        resetVariablesHard(mDetectionVariables, mDetectionParameters, mSequence.eyeAOI);
+
+        double durationTotal = 0;
+
+        for (int iFrame = 0; iFrame < frameTotal; iFrame++)
+        {
+            dataVariables mDataVariables;
+            drawVariables mDrawVariables;
+
+            auto t1 = std::chrono::steady_clock::now();
+            mDetectionVariables = eyeStalker(mSequence.vImages[iFrame], mSequence.eyeAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables);
+            auto t2 = std::chrono::steady_clock::now();
+
+            vDurations[iFrame] = std::chrono::duration<double, std::milli>(t2 - t1).count();
+            durationTotal += vDurations[iFrame];
+        }
+
+        int percentileIndex = std::min(frameTotal - 1, (int) std::ceil(0.99 * frameTotal) - 1);
+        std::nth_element(vDurations.begin(), vDurations.begin() + percentileIndex, vDurations.end());
+
+        double frameRate = 1000 * frameTotal / durationTotal;
+        double latency   = vDurations[percentileIndex];
+
+        if (iRepetition == 0 || frameRate > mPerformance.frameRate) { mPerformance.frameRate = frameRate; }
+        if (iRepetition == 0 || latency   < mPerformance.latency)   { mPerformance.latency   = latency;   }
+    }
+
+    return mPerformance;
+}
+
+bool saveGoldenOutputs(const std::string& filename, const std::vector<regressionOutput>& vOutputs)
+{
+    int frameTotal = vOutputs.size();
+
+    std::vector<uint8_t> vDetected(frameTotal);
+    std::vector<double> vXPos(frameTotal);
+    std::vector<double> vYPos(frameTotal);
+    std::vector<double> vCircumference(frameTotal);
+    std::vector<double> vAspectRatio(frameTotal);
+    std::vector<double> vAngle(frameTotal);
+
+    for (int i = 0; i < frameTotal; i++)
+    {
+        vDetected[i]      = vOutputs[i].DETECTED;
+        vXPos[i]          = vOutputs[i].xPos;
+        vYPos[i]          = vOutputs[i].yPos;
+        vCircumference[i] = vOutputs[i].circumference;
+        vAspectRatio[i]   = vOutputs[i].aspectRatio;
+        vAngle[i]         = vOutputs[i].angle;
+    }
+
+    TrackingDataWriter mWriter;
+    mWriter.addColumn("detected",      vDetected);
+    mWriter.addColumn("x",             vXPos);
+    mWriter.addColumn("y",             vYPos);
+    mWriter.addColumn("circumference", vCircumference);
+    mWriter.addColumn("aspect_ratio",  vAspectRatio);
+    mWriter.addColumn("angle",         vAngle);
+
+    return mWriter.save(filename, 0, 0, 0, frameTotal);
+}
+
+bool loadGoldenOutputs(const std::string& filename, std::vector<regressionOutput>& vOutputs)
+{
+    TrackingDataReader mReader;
+    if (!mReader.open(filename)) { return false; }
+
+    int frameTotal = mReader.getSampleTotal();
+
+    trackingColumn mDetected, mXPos, mYPos, mCircumference, mAspectRatio, mAngle;
+
+    if (!mReader.getColumn("detected",      mDetected)      || mDetected.type      != COLUMN_UINT8   ||
+        !mReader.getColumn("x",             mXPos)          || mXPos.type          != COLUMN_FLOAT64 ||
+        !mReader.getColumn("y",             mYPos)          || mYPos.type          != COLUMN_FLOAT64 ||
+        !mReader.getColumn("circumference", mCircumference) || mCircumference.type != COLUMN_FLOAT64 ||
+        !mReader.getColumn("aspect_ratio",  mAspectRatio)   || mAspectRatio.type   != COLUMN_FLOAT64 ||
+        !mReader.getColumn("angle",         mAngle)         || mAngle.type         != COLUMN_FLOAT64)
+    {   return false; }
+
+    vOutputs.resize(frameTotal);
+
+    for (int i = 0; i < frameTotal; i++)
+    {
+        vOutputs[i].DETECTED      = static_cast<const uint8_t*>(mDetected.values)[i];
+        vOutputs[i].xPos          = static_cast<const double*>(mXPos.values)[i];
+        vOutputs[i].yPos          = static_cast<const double*>(mYPos.values)[i];
+        vOutputs[i].circumference = static_cast<const double*>(mCircumference.values)[i];
+        vOutputs[i].aspectRatio   = static_cast<const double*>(mAspectRatio.values)[i];
+        vOutputs[i].angle         = static_cast<const double*>(mAngle.values)[i];
+    }
+
+    return true;
+}
+
+std::map<std::string, regressionPerformance> loadPerformance(const std::string& filename)
+{
+    std::map<std::string, regressionPerformance> mPerformances;
+
+    std::ifstream file(filename);
+    std::string line;
+    std::getline(file, line); // header
+
+    std::string name;
+    regressionPerformance mPerformance;
+
+    while (file >> name >> mPerformance.frameRate >> mPerformance.latency) { mPerformances[name] = mPerformance; }
+
+    return mPerformances;
+}
+
+bool savePerformance(const std::string& filename, const std::map<std::string, regressionPerformance>& mPerformances)
+{
+    std::ofstream file(filename);
+    if (!file.is_open()) { return false; }
+
+    file << "sequence frames_per_s p99_ms" << std::endl;
+
+    for (auto it = mPerformances.begin(); it != mPerformances.end(); it++)
+    {   file << it->first << " " << std::fixed << std::setprecision(3) << it->second.frameRate << " " << it->second.latency << std::endl; }
+
+    return file.good();
+}
+
+// Returns false if outputs differ more than the tolerances
+
+bool compareOutputs(const std::vector<regressionOutput>& vGolden, const std::vector<regressionOutput>& vOutputs, const regressionSettings& mSettings)
+{
+    if (vGolden.size() != vOutputs.size())
+    {
+        std::cout << "  frame total " << vOutputs.size() << " differs from golden " << vGolden.size() << std::endl;
+        return false;
+    }
+
+    int mismatchTotal       = 0;
+    int firstFailure        = -1;
+    double maxAngle         = 0;
+    double maxAspectRatio   = 0;
+    double maxCircumference = 0;
+    double maxPosition      = 0;
+
+    for (int iFrame = 0; iFrame < (int) vOutputs.size(); iFrame++)
+    {
+        const regressionOutput& mGolden = vGolden[iFrame];
+        const regressionOutput& mOutput = vOutputs[iFrame];
+
+        if (mGolden.DETECTED != mOutput.DETECTED)
+        {
+            mismatchTotal++;
+            if (firstFailure < 0 && mismatchTotal > mSettings.maxMismatches) { firstFailure = iFrame; }
+            continue;
+        }
+
+        if (!mGolden.DETECTED) { continue; }
+
+        double errorPosition      = std::max(std::abs(mOutput.xPos - mGolden.xPos), std::abs(mOutput.yPos - mGolden.yPos));
+        double errorCircumference = std::abs(mOutput.circumference - mGolden.circumference);
+        double errorAspectRatio   = std::abs(mOutput.aspectRatio   - mGolden.aspectRatio);
+        double errorAngle         = 0;
+
+        if (mGolden.aspectRatio < mSettings.angleAspectRatioMax)
+        {
+            errorAngle = std::fmod(std::abs(mOutput.angle - mGolden.angle), M_PI); // ellipse is symmetric under rotation by pi
+            errorAngle = std::min(errorAngle, M_PI - errorAngle);
+        }
+
+        maxAngle         = std::max(maxAngle,         errorAngle);
+        maxAspectRatio   = std::max(maxAspectRatio,   errorAspectRatio);
+        maxCircumference = std::max(maxCircumference, errorCircumference);
+        maxPosition      = std::max(maxPosition,      errorPosition);
+
+        if (firstFailure < 0 && (errorPosition      > mSettings.tolerancePosition      ||
+                                 errorCircumference > mSettings.toleranceCircumference ||
+                                 errorAspectRatio   > mSettings.toleranceAspectRatio   ||
+                                 errorAngle         > mSettings.toleranceAngle))
+        {   firstFailure = iFrame; }
+    }
+
+    std::cout << "  mismatches " << mismatchTotal
+              << ", max error: position " << maxPosition << " px, circumference " << maxCircumference
+              << " px, aspect ratio " << maxAspectRatio << ", angle " << maxAngle << " rad" << std::endl;
+
+    if (firstFailure >= 0) { std::cout << "  accuracy FAILED, first at frame " << firstFailure << std::endl; }
+
+    return (firstFailure < 0);
+}
+
+int main(int argc, char* argv[])
+{
+    regressionSettings mSettings;
+    mSettings.CHECK_SPEED            = true;
+    mSettings.UPDATE                 = false;
+    mSettings.frameTotal             = 500;
+    mSettings.maxMismatches          = 0;
+    mSettings.repetitionTotal        = 3;
+    mSettings.maxSlowdown            = 0.1;
+    mSettings.toleranceAngle         = 0.001;
+    mSettings.toleranceAspectRatio   = 0.0001;
+    mSettings.toleranceCircumference = 0.001;
+    mSettings.tolerancePosition      = 0.001;
+    mSettings.angleAspectRatioMax    = 0.95;
+
+    std::string goldenDirectory;
+    std::string settingsFilename;
+    std::vector<std::string> vTrialDirectories;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if      (std::strcmp(argv[iArg], "-s")                  == 0 && iArg + 1 < argc) { settingsFilename                = argv[++iArg]; }
+        else if (std::strcmp(argv[iArg], "-t")                  == 0 && iArg + 1 < argc) { vTrialDirectories.push_back(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--frames")            == 0 && iArg + 1 < argc) { mSettings.frameTotal             = std::max(1, std::atoi(argv[++iArg])); }
+        else if (std::strcmp(argv[iArg], "--repeat")            == 0 && iArg + 1 < argc) { mSettings.repetitionTotal        = std::max(1, std::atoi(argv[++iArg])); }
+        else if (std::strcmp(argv[iArg], "--max-mismatches")    == 0 && iArg + 1 < argc) { mSettings.maxMismatches          = std::atoi(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--max-slowdown")      == 0 && iArg + 1 < argc) { mSettings.maxSlowdown            = std::atof(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--tol-angle")         == 0 && iArg + 1 < argc) { mSettings.toleranceAngle         = std::atof(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--tol-aspect-ratio")  == 0 && iArg + 1 < argc) { mSettings.toleranceAspectRatio   = std::atof(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--tol-circumference") == 0 && iArg + 1 < argc) { mSettings.toleranceCircumference = std::atof(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--tol-position")      == 0 && iArg + 1 < argc) { mSettings.tolerancePosition      = std::atof(argv[++iArg]); }
+        else if (std::strcmp(argv[iArg], "--update")   == 0) { mSettings.UPDATE      = true; }
+        else if (std::strcmp(argv[iArg], "--no-speed") == 0) { mSettings.CHECK_SPEED = false; }
+        else if (argv[iArg][0] != '-' && goldenDirectory.empty()) { goldenDirectory = argv[iArg]; }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (goldenDirectory.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    trialTrackerSettings mTrackerSettings;
+    loadTrialTrackerSettings(settingsFilename, mTrackerSettings); // built-in defaults if no file is given
+
+    detectionParameters mDetectionParameters = mTrackerSettings.mDetectionParameters;
+    mDetectionParameters.cameraFrameRate = mTrackerSettings.cameraFrameRate;
+
+    std::vector<regressionSequence> vSequences = getSyntheticSequences(mSettings.frameTotal);
+
+    for (int iTrial = 0; iTrial < (int) vTrialDirectories.size(); iTrial++)
+    {
+        regressionSequence mSequence;
+
+        if (!loadRecordedSequence(vTrialDirectories[iTrial], mTrackerSettings, mSequence))
+        {
+            std::cout << "No frames found in " << vTrialDirectories[iTrial] << std::endl;
+            return 1;
+        }
+
+        vSequences.push_back(mSequence);
+    }
+
+    boost::filesystem::path goldenPath(goldenDirectory);
+    std::string performancePath = (goldenPath / performanceFilename).string();
+
+    if (mSettings.UPDATE) { boost::filesystem::create_directories(goldenPath); }
+
+    std::map<std::string, regressionPerformance> mPerformancesGolden = loadPerformance(performancePath);
+    std::map<std::string, regressionPerformance> mPerformances = mPerformancesGolden; // golden values of sequences that are not run are kept
+
+    int failureTotal = 0;
+
+    for (int iSequence = 0; iSequence < (int) vSequences.size(); iSequence++)
+    {
+        const regressionSequence& mSequence = vSequences[iSequence];
+        std::string goldenFilename = (goldenPath / (mSequence.name + ".esd")).string();
+
+        std::cout << mSequence.name << " (" << mSequence.vImages.size() << " frames)" << std::endl;
+
+        bool SUCCESS = true;
+
+        std::vector<regressionOutput> vOutputs = trackSequence(mSequence, mDetectionParameters);
+
+        regressionPerformance mPerformance;
+
+        if (mSettings.CHECK_SPEED) // with --no-speed, golden values are kept as they were
+        {
+            mPerformance = timeSequence(mSequence, mDetectionParameters, mSettings.repetitionTotal);
+            mPerformances[mSequence.name] = mPerformance;
+
+            std::cout << "  " << std::fixed << std::setprecision(1) << mPerformance.frameRate << " frames/s, p99 "
+                      << std::setprecision(3) << mPerformance.latency << " ms" << std::defaultfloat << std::endl;
+        }
+
+        if (mSettings.UPDATE)
+        {
+            if (!saveGoldenOutputs(goldenFilename, vOutputs))
+            {
+                std::cout << "  unable to save " << goldenFilename << std::endl;
+                SUCCESS = false;
+            }
+        }
+        else
+        {
+            std::vector<regressionOutput> vGolden;
+
+            if (!loadGoldenOutputs(goldenFilename, vGolden))
+            {
+                std::cout << "  no golden outputs in " << goldenFilename << " (record with --update)" << std::endl;
+                SUCCESS = false;
+            }
+            else if (!compareOutputs(vGolden, vOutputs, mSettings)) { SUCCESS = false; }
+
+            auto it = mPerformancesGolden.find(mSequence.name);
+
+            if (mSettings.CHECK_SPEED && it == mPerformancesGolden.end())
+            {
+                std::cout << "  no golden speed in " << performancePath << " (record with --update, or use --no-speed)" << std::endl;
+                SUCCESS = false;
+            }
+            else if (mSettings.CHECK_SPEED)
+            {
+                const regressionPerformance& mGolden = it->second;
+
+                std::cout << "  golden " << std::fixed << std::setprecision(1) << mGolden.frameRate << " frames/s, p99 "
+                          << std::setprecision(3) << mGolden.latency << " ms" << std::defaultfloat << std::endl;
+
+                if (mPerformance.frameRate < (1 - mSettings.maxSlowdown) * mGolden.frameRate ||
+                    mPerformance.latency   > (1 + mSettings.maxSlowdown) * mGolden.latency)
+                {
+                    std::cout << "  speed FAILED" << std::endl;
+                    SUCCESS = false;
+                }
+            }
+        }
+
+        if (!SUCCESS) { failureTotal++; }
+    }
+
+    if (mSettings.UPDATE)
+    {
+        if (!savePerformance(performancePath, mPerformances))
+        {
+            std::cout << "Unable to save " << performancePath << std::endl;
+            return 1;
+        }
+
+        std::cout << "Golden outputs saved to " << goldenDirectory << std::endl;
+        return (failureTotal == 0) ? 0 : 1;
+    }
+
+    std::cout << (vSequences.size() - failureTotal) << " of " << vSequences.size() << " sequences passed" << std::endl;
+
+    return (failureTotal == 0) ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "resultstream.h"
+
+static_assert(sizeof(resultStreamHeader) == 64, "result stream header must be 64 bytes");
+static_assert(sizeof(resultRecord)       == 96, "result record must be 96 bytes");
+
+namespace
+{
+
+const uint64_t blockSizeMin = 1024; // records
+const uint64_t syncRecords  = 1024; // flush to disk after this many records ...
+const int syncInterval = 250;       // ... or after this many ms, whichever comes first
+const int pollInterval = 2;         // ms, writer thread checks queue
+
+#ifdef _WIN32
+
+int  openFile  (const std::string& filename) { return _open(filename.c_str(), _O_RDWR | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE); }
+bool resizeFile(int fileDescriptor, uint64_t size, bool) { return _chsize_s(fileDescriptor, size) == 0; }
+bool seekFile  (int fileDescriptor, uint64_t offset) { return _lseeki64(fileDescriptor, offset, SEEK_SET) >= 0; }
+bool syncFile  (int fileDescriptor) { return _commit(fileDescriptor) == 0; }
+void closeFile (int fileDescriptor) { _close(fileDescriptor); }
+int  writeSome (int fileDescriptor, const char* data, uint64_t size) { return _write(fileDescriptor, data, size); }
+
+#else
+
+int  openFile  (const std::string& filename) { return ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644); }
+bool seekFile  (int fileDescriptor, uint64_t offset) { return lseek(fileDescriptor, offset, SEEK_SET) >= 0; }
+void closeFile (int fileDescriptor) { ::close(fileDescriptor); }
+long writeSome (int fileDescriptor, const char* data, uint64_t size) { return ::write(fileDescriptor, data, size); }
+
+bool resizeFile(int fileDescriptor, uint64_t size, bool PREALLOCATE)
+{
+#ifdef __linux__
+    if (PREALLOCATE) { return posix_fallocate(fileDescriptor, 0, size) == 0; } // reserves disk blocks, so writes do not allocate
+#else
+    (void) PREALLOCATE;
+#endif
+    return ftruncate(fileDescriptor, size) == 0;
+}
+
+bool syncFile(int fileDescriptor)
+{
+#ifdef __linux__
+    return fdatasync(fileDescriptor) == 0;
+#else
+    return fsync(fileDescriptor) == 0;
+#endif
+}
+
+#endif
+
+bool writeFile(int fileDescriptor, const void* data, uint64_t size)
+{
+    const char* dataBytes = (const char*) data;
+
+    while (size > 0) // write may return early
+    {
+        long bytesWritten = writeSome(fileDescriptor, dataBytes, size);
+        if (bytesWritten <= 0) { return false; }
+        dataBytes += bytesWritten;
+        size      -= bytesWritten;
+    }
+
+    return true;
+}
+
+}
+
+ResultStream::ResultStream()
+{
+    STREAM_ACTIVE = false;
+
+    headIndex = 0;
+    tailIndex = 0;
+    dropCount = 0;
+
+    fileDescriptor = -1;
+
+    std::memset(&mHeader, 0, sizeof(mHeader));
+
+    blockSize        = blockSizeMin;
+    recordsAllocated = 0;
+    recordsSinceSync = 0;
+    recordsWritten   = 0;
+}
+
+ResultStream::~ResultStream()
+{
+    close();
+}
+
+bool ResultStream::open(const std::string& filename, int trialIndex, long long systemTime, int flags, int recordsExpected, int queueCapacity)
+{
+    close(); // previous trial
+
+    boost::system::error_code errorCode;
+    boost::filesystem::path directory = boost::filesystem::path(filename).parent_path();
+    if (!directory.empty()) { boost::filesystem::create_directories(directory, errorCode); }
+
+    fileDescriptor = openFile(filename);
+    if (fileDescriptor < 0) { return false; }
+
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    std::memcpy(mHeader.magic, resultStreamMagic, sizeof(mHeader.magic));
+    mHeader.version    = 1;
+    mHeader.recordSize = sizeof(resultRecord);
+    mHeader.systemTime = systemTime;
+    mHeader.trialIndex = trialIndex;
+    mHeader.flags      = flags;
+
+    blockSize        = std::max<uint64_t>(recordsExpected, blockSizeMin);
+    recordsAllocated = blockSize;
+    recordsSinceSync = 0;
+    recordsWritten   = 0;
+
+    if (!writeFile(fileDescriptor, &mHeader, sizeof(mHeader)) || !resizeFile(fileDescriptor, sizeof(mHeader) + recordsAllocated * sizeof(resultRecord), true))
+    {
+        closeFile(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+
+    if (queueCapacity < 1) { queueCapacity = 1; }
+
+    vRing.assign(queueCapacity, resultRecord());
+
+    headIndex = 0;
+    tailIndex = 0;
+    dropCount = 0;
+
+    timeLastSync  = std::chrono::steady_clock::now();
+    STREAM_ACTIVE = true;
+    writerThread  = std::thread(&ResultStream::threadWriter, this);
+
+    return true;
+}
+
+bool ResultStream::addRecord(const resultRecord& mRecord)
+{
+    if (!STREAM_ACTIVE) { return false; }
+
+    uint64_t head = headIndex.load(std::memory_order_relaxed);
+    uint64_t tail = tailIndex.load(std::memory_order_acquire);
+
+    if (head - tail >= vRing.size()) // writer thread has fallen behind a full queue
+    {
+        dropCount++;
+        return false;
+    }
+
+    vRing[head % vRing.size()] = mRecord;
+    headIndex.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+void ResultStream::threadWriter()
+{
+    EventTracer::setThreadName("result writer");
+
+    while (true)
+    {
+        bool ACTIVE = STREAM_ACTIVE; // checked before queue, so that records added before close() are written
+
+        uint64_t tail = tailIndex.load(std::memory_order_relaxed);
+        uint64_t head = headIndex.load(std::memory_order_acquire);
+
+        if (head > tail)
+        {
+            uint64_t capacity   = vRing.size();
+            uint64_t slot       = tail % capacity;
+            uint64_t total      = head - tail;
+            uint64_t totalFirst = std::min(total, capacity - slot); // queue wraps around
+
+            TraceSpan mWriteSpan("write results", "writer");
+            bool SUCCESS = writeRecords(&vRing[slot], totalFirst);
+            if (total > totalFirst) { SUCCESS = writeRecords(&vRing[0], total - totalFirst) && SUCCESS; }
+            if (!SUCCESS) { dropCount += total; }
+
+            tailIndex.store(head, std::memory_order_release);
+            mWriteSpan.end();
+        }
+
+        if (recordsSinceSync > 0)
+        {
+            int timeSinceSync = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - timeLastSync).count();
+            if (recordsSinceSync >= syncRecords || timeSinceSync >= syncInterval)
+            {
+                TraceSpan mSyncSpan("sync", "writer");
+                synchronise();
+            }
+        }
+
+        if (head == tail)
+        {
+            if (!ACTIVE) { break; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollInterval));
+        }
+    }
+}
+
+bool ResultStream::writeRecords(const resultRecord* records, uint64_t recordTotal)
+{
+    if (recordsWritten + recordTotal > recordsAllocated) // trial runs longer than expected, extend by another block
+    {
+        recordsAllocated += std::max(blockSize, recordTotal);
+        if (!resizeFile(fileDescriptor, sizeof(mHeader) + recordsAllocated * sizeof(resultRecord), true)) { return false; }
+    }
+
+    if (!writeFile(fileDescriptor, records, recordTotal * sizeof(resultRecord))) { return false; }
+
+    recordsWritten   += recordTotal;
+    recordsSinceSync += recordTotal;
+
+    return true;
+}
+
+void ResultStream::synchronise()
+{
+    syncFile(fileDescriptor);
+    recordsSinceSync = 0;
+    timeLastSync     = std::chrono::steady_clock::now();
+}
+
+void ResultStream::close()
+{
+    if (!writerThread.joinable()) { return; }
+
+    STREAM_ACTIVE = false;
+    writerThread.join();
+
+    // Trim preallocated space and complete header
+
+    mHeader.recordTotal = recordsWritten;
+
+    resizeFile(fileDescriptor, sizeof(mHeader) + recordsWritten * sizeof(resultRecord), false);
+    if (seekFile(fileDescriptor, 0)) { writeFile(fileDescriptor, &mHeader, sizeof(mHeader)); }
+    syncFile(fileDescriptor);
+    closeFile(fileDescriptor);
+
+    fileDescriptor = -1;
+}
+
+int ResultStream::getDropCount() const
+{
+    return dropCount;
+}
+
+int ResultStream::getRecordTotal() const
+{
+    return headIndex;
+}
+
+bool readResultStream(const std::string& filename, resultStreamHeader& mHeader, std::vector<resultRecord>& vRecords)
+{
+    vRecords.clear();
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) { return false; }
+
+    file.read((char*) &mHeader, sizeof(mHeader));
+
+    if (!file || std::memcmp(mHeader.magic, resultStreamMagic, sizeof(mHeader.magic)) != 0) { return false; }
+    if (mHeader.recordSize != sizeof(resultRecord)) { return false; }
+
+    resultRecord mRecord;
+
+    while (file.read((char*) &mRecord, sizeof(mRecord)))
+    {
+        if (!mRecord.VALID) { break; } // preallocated space of interrupted stream
+        vRecords.push_back(mRecord);
+        if (mHeader.recordTotal > 0 && vRecords.size() >= mHeader.recordTotal) { break; }
+    }
+
+    return true;
+}
+
+bool updateResultStream(const std::string& filename, const std::vector<resultRecord>& vRecordsNew)
+{
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) { return false; }
+
+    resultStreamHeader mHeader;
+    file.read((char*) &mHeader, sizeof(mHeader));
+
+    if (!file || std::memcmp(mHeader.magic, resultStreamMagic, sizeof(mHeader.magic)) != 0) { return false; }
+    if (mHeader.recordSize != sizeof(resultRecord)) { return false; }
+
+    resultRecord mRecord;
+    int recordIndex = 0;
+    int updateIndex = 0;
+    int updateTotal = vRecordsNew.size();
+
+    while (updateIndex < updateTotal && file.read((char*) &mRecord, sizeof(mRecord)))
+    {
+        if (!mRecord.VALID) { break; }
+
+        while (updateIndex < updateTotal && vRecordsNew[updateIndex].frameIndex < mRecord.frameIndex) { updateIndex++; } // frame has no record
+
+        if (updateIndex < updateTotal && vRecordsNew[updateIndex].frameIndex == mRecord.frameIndex)
+        {
+            file.seekp(sizeof(mHeader) + (std::streamoff) recordIndex * sizeof(resultRecord));
+            file.write((const char*) &vRecordsNew[updateIndex], sizeof(resultRecord));
+            file.seekg(sizeof(mHeader) + (std::streamoff) (recordIndex + 1) * sizeof(resultRecord));
+            updateIndex++;
+        }
+
+        recordIndex++;
+    }
+
+    return !file.bad();
+}
+
+void setResultRecord(resultRecord& mRecord, int frameIndex, double timestamp, const dataVariables* eye, const dataVariables* rght, const dataVariables* bead)
+{
+    std::memset(&mRecord, 0, sizeof(mRecord));
+
+    mRecord.VALID      = 1;
+    mRecord.frameIndex = frameIndex;
+    mRecord.timestamp  = timestamp;
+
+    if (eye != NULL)
+    {
+        mRecord.eyeDETECTED      = eye->DETECTED;
+        mRecord.eyeXPos          = eye->absoluteXPos;
+        mRecord.eyeYPos          = eye->absoluteYPos;
+        mRecord.eyeCircumference = eye->exactCircumference;
+        mRecord.eyeAspectRatio   = eye->exactAspectRatio;
+    }
+
+    if (rght != NULL)
+    {
+        mRecord.rghtDETECTED      = rght->DETECTED;
+        mRecord.rghtXPos          = rght->absoluteXPos;
+        mRecord.rghtYPos          = rght->absoluteYPos;
+        mRecord.rghtCircumference = rght->exactCircumference;
+        mRecord.rghtAspectRatio   = rght->exactAspectRatio;
+    }
+
+    if (bead != NULL)
+    {
+        mRecord.beadDETECTED = bead->DETECTED;
+        mRecord.beadXPos     = bead->absoluteXPos;
+        mRecord.beadYPos     = bead->absoluteYPos;
+    }
+}
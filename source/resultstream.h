@@ -0,0 +1,147 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef RESULTSTREAM_H
+#define RESULTSTREAM_H
+
+// Files
+
+#include "eventtracer.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost
+
+#include <boost/filesystem.hpp>
+
+// File descriptors
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Results of a live trial (trial_N/live_data.esr), written while the trial is recorded.
+//
+// The tracking thread hands each frame's result to a lock-free queue and never waits for the disk. A writer thread
+// appends the queued records to a file that is preallocated in blocks and flushed to disk in batches, so that a crash
+// loses at most the last batch, and memory use does not grow with trial length. The file is trimmed and its header
+// completed when the stream is closed; records of an interrupted trial are recovered from their VALID flag.
+
+const char resultStreamMagic[8] = {'E', 'S', 'T', 'K', 'L', 'I', 'V', '1'};
+const std::string resultStreamFilename = "live_data.esr";
+
+enum resultStreamFlags
+{
+    RESULT_STREAM_BINOCULAR = 1,
+    RESULT_STREAM_BEAD      = 2
+};
+
+struct resultStreamHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordTotal; // 0 until stream is closed
+    int64_t  systemTime;  // of trial start (ms)
+    int32_t  trialIndex;
+    uint32_t flags;
+    uint8_t  padding[24];
+};
+
+struct resultRecord
+{
+    double  timestamp; // relative to trial start (ms)
+    double  eyeXPos;
+    double  eyeYPos;
+    double  eyeCircumference;
+    double  eyeAspectRatio;
+    double  rghtXPos;
+    double  rghtYPos;
+    double  rghtCircumference;
+    double  rghtAspectRatio;
+    double  beadXPos;
+    double  beadYPos;
+    int32_t frameIndex;
+    uint8_t VALID;     // preallocated space is zero
+    uint8_t eyeDETECTED;
+    uint8_t rghtDETECTED;
+    uint8_t beadDETECTED;
+};
+
+class ResultStream
+{
+
+public:
+
+    ResultStream();
+    ~ResultStream();
+
+    bool addRecord(const resultRecord&); // never blocks, false if queue is full and record was dropped
+    bool open(const std::string& filename, int trialIndex, long long systemTime, int flags, int recordsExpected, int queueCapacity); // creates directories if necessary
+    int getDropCount() const;   // queue full or disk error
+    int getRecordTotal() const; // records accepted by queue
+    void close(); // writes queued records and trims preallocated space
+
+private:
+
+    std::atomic<bool> STREAM_ACTIVE;
+
+    // Single producer (tracking thread), single consumer (writer thread)
+
+    std::atomic<uint64_t> headIndex; // next slot to be filled by tracking thread
+    std::atomic<uint64_t> tailIndex; // next slot to be written to disk
+    std::atomic<int> dropCount;
+    std::vector<resultRecord> vRing;
+
+    int fileDescriptor;
+
+    resultStreamHeader mHeader;
+
+    uint64_t blockSize;          // records preallocated at once
+    uint64_t recordsAllocated;
+    uint64_t recordsSinceSync;
+    uint64_t recordsWritten;
+
+    std::chrono::steady_clock::time_point timeLastSync;
+    std::thread writerThread;
+
+    bool writeRecords(const resultRecord* records, uint64_t recordTotal);
+    void synchronise();
+    void threadWriter();
+};
+
+bool readResultStream(const std::string& filename, resultStreamHeader&, std::vector<resultRecord>&); // also reads interrupted streams
+bool updateResultStream(const std::string& filename, const std::vector<resultRecord>&); // replaces records with same frame index (ordered), after stream was closed
+void setResultRecord(resultRecord&, int frameIndex, double timestamp, const dataVariables* eye, const dataVariables* rght, const dataVariables* bead); // NULL if not tracked
+
+#endif // RESULTSTREAM_H
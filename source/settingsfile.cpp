@@ -0,0 +1,131 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "settingsfile.h"
+
+namespace
+{
+
+std::string trim(const std::string& text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) { return ""; }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+std::string unquote(const std::string& text) // strings with special characters are quoted and escaped
+{
+    if (text.size() < 2 || text.front() != '"' || text.back() != '"') { return text; }
+
+    std::string result;
+
+    for (size_t i = 1; i + 1 < text.size(); i++)
+    {
+        if (text[i] == '\\' && i + 2 < text.size()) { i++; }
+        result += text[i];
+    }
+
+    return result;
+}
+
+}
+
+bool SettingsFile::load(const std::string& filename)
+{
+    mValues.clear();
+
+    std::ifstream file(filename);
+    if (!file.is_open()) { return false; }
+
+    std::string section;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        line = trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') { continue; }
+
+        if (line[0] == '[')
+        {
+            section = line.substr(1, line.find(']') - 1);
+            if (section == "General") { section.clear(); }
+            continue;
+        }
+
+        size_t separator = line.find('=');
+        if (separator == std::string::npos) { continue; }
+
+        std::string key   = trim(line.substr(0, separator));
+        std::string value = unquote(trim(line.substr(separator + 1)));
+
+        if (!section.empty()) { key = section + "/" + key; }
+
+        mValues[key] = value;
+    }
+
+    return true;
+}
+
+bool SettingsFile::getValue(const std::string& key, std::string& value) const
+{
+    auto itr = mValues.find(key);
+    if (itr == mValues.end()) { return false; }
+    value = itr->second;
+    return true;
+}
+
+bool SettingsFile::getBool(const std::string& key, bool defaultValue) const
+{
+    std::string value;
+    if (!getValue(key, value)) { return defaultValue; }
+
+    if (value == "true")  { return true;  }
+    if (value == "false") { return false; }
+
+    return (std::atof(value.c_str()) != 0);
+}
+
+double SettingsFile::getDouble(const std::string& key, double defaultValue) const
+{
+    std::string value;
+    if (!getValue(key, value)) { return defaultValue; }
+
+    char* end;
+    double result = std::strtod(value.c_str(), &end);
+    if (end == value.c_str()) { return defaultValue; }
+
+    return result;
+}
+
+int SettingsFile::getInt(const std::string& key, int defaultValue) const
+{
+    std::string value;
+    if (!getValue(key, value)) { return defaultValue; }
+
+    char* end;
+    long result = std::strtol(value.c_str(), &end, 10);
+    if (end == value.c_str()) { return defaultValue; }
+
+    return result;
+}
+
+std::string SettingsFile::getString(const std::string& key, const std::string& defaultValue) const
+{
+    std::string value;
+    if (!getValue(key, value)) { return defaultValue; }
+    return value;
+}
@@ -0,0 +1,49 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SETTINGSFILE_H
+#define SETTINGSFILE_H
+
+// Standard Template
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+
+// Read-only access to a settings file written by the GUI (QSettings, ini format), for programs that do not link Qt.
+// Keys outside of a section belong to [General], which is where the GUI stores all of its settings.
+
+class SettingsFile
+{
+
+public:
+
+    bool load(const std::string& filename);
+
+    bool        getBool  (const std::string& key, bool   defaultValue) const;
+    double      getDouble(const std::string& key, double defaultValue) const;
+    int         getInt   (const std::string& key, int    defaultValue) const;
+    std::string getString(const std::string& key, const std::string& defaultValue) const;
+
+private:
+
+    std::map<std::string, std::string> mValues; // key is prefixed by section, unless section is [General]
+
+    bool getValue(const std::string& key, std::string& value) const;
+};
+
+#endif // SETTINGSFILE_H
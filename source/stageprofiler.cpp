@@ -0,0 +1,210 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "stageprofiler.h"
+
+namespace
+{
+
+const int bucketTotal = 16 + 27 * 8; // exact below 16 ns, then 8 buckets per power of two up to INT_MAX
+
+const char* stageNames[STAGE_TOTAL] =
+{
+    "grayscale",
+    "resize",
+    "integral",
+    "glint",
+    "haar",
+    "blur",
+    "canny",
+    "sharpening",
+    "edge_selection",
+    "segmentation_curvature",
+    "segmentation_length",
+    "segmentation_score",
+    "classification",
+    "subsets",
+    "fitting",
+    "update"
+};
+
+int getBucket(int nanoseconds)
+{
+    if (nanoseconds < 16) { return std::max(0, nanoseconds); }
+
+#if defined(__GNUC__) || defined(__clang__)
+    int exponent = 31 - __builtin_clz(nanoseconds); // at least 4
+#else
+    int exponent = 4;
+    while (nanoseconds >> (exponent + 1)) { exponent++; }
+#endif
+    return 16 + (exponent - 4) * 8 + ((nanoseconds >> (exponent - 3)) & 7);
+}
+
+int getBucketValue(int bucket) // centre of bucket
+{
+    if (bucket < 16) { return bucket; }
+
+    int exponent = (bucket - 16) / 8 + 4;
+    long long lowerBound = (8LL + (bucket - 16) % 8) << (exponent - 3);
+    long long width      = 1LL << (exponent - 3);
+    return std::min((long long) INT_MAX, lowerBound + width / 2);
+}
+
+int getPercentile(const unsigned int* histogram, const unsigned int* histogramOther, long long frameTotal, double fraction)
+{
+    long long rank = std::max(1LL, (long long) std::ceil(fraction * frameTotal));
+    long long count = 0;
+
+    for (int iBucket = 0; iBucket < bucketTotal; iBucket++)
+    {
+        count += histogram[iBucket];
+        if (histogramOther != NULL) { count += histogramOther[iBucket]; }
+        if (count >= rank) { return getBucketValue(iBucket); }
+    }
+
+    return 0;
+}
+
+}
+
+const char* getStageName(int stage)
+{
+    if (stage < 0 || stage >= STAGE_TOTAL) { return ""; }
+    return stageNames[stage];
+}
+
+StageProfiler::StageProfiler(int windowLengthNew)
+{
+    windowLength = std::max(1, windowLengthNew);
+    clear();
+}
+
+void StageProfiler::clear()
+{
+    std::lock_guard<std::mutex> profilerLock(profilerMutex);
+
+    frameTotalWindow = 0;
+
+    maximumTrial         .assign(STAGE_TOTAL, 0);
+    maximumWindow        .assign(STAGE_TOTAL, 0);
+    maximumWindowPrevious.assign(STAGE_TOTAL, 0);
+
+    histogramTrial         .assign(STAGE_TOTAL * bucketTotal, 0);
+    histogramWindow        .assign(STAGE_TOTAL * bucketTotal, 0);
+    histogramWindowPrevious.assign(STAGE_TOTAL * bucketTotal, 0);
+}
+
+void StageProfiler::addFrame(const dataVariables& mDataVariables)
+{
+#ifdef EYESTALKER_PROFILING
+    std::lock_guard<std::mutex> profilerLock(profilerMutex);
+
+    if (frameTotalWindow >= windowLength) // start new window, previous one is kept so window never holds less than 'windowLength' frames
+    {
+        histogramWindowPrevious.swap(histogramWindow);
+        maximumWindowPrevious  .swap(maximumWindow);
+        std::fill(histogramWindow.begin(), histogramWindow.end(), 0);
+        std::fill(maximumWindow  .begin(), maximumWindow  .end(), 0);
+        frameTotalWindow = 0;
+    }
+
+    for (int iStage = 0; iStage < STAGE_TOTAL; iStage++)
+    {
+        int nanoseconds = mDataVariables.stageDuration.nanoseconds[iStage];
+        int bucket = iStage * bucketTotal + getBucket(nanoseconds);
+
+        histogramTrial [bucket]++;
+        histogramWindow[bucket]++;
+
+        maximumTrial [iStage] = std::max(maximumTrial [iStage], nanoseconds);
+        maximumWindow[iStage] = std::max(maximumWindow[iStage], nanoseconds);
+    }
+
+    frameTotalWindow++;
+#else
+    (void) mDataVariables;
+#endif
+}
+
+stageStatistics StageProfiler::getStatistics(int stage, bool WHOLE_TRIAL) const
+{
+    std::lock_guard<std::mutex> profilerLock(profilerMutex);
+
+    stageStatistics mStageStatistics = {0, 0, 0, 0};
+
+    if (stage < 0 || stage >= STAGE_TOTAL) { return mStageStatistics; }
+
+    const unsigned int* histogram      = WHOLE_TRIAL ? &histogramTrial[stage * bucketTotal] : &histogramWindow[stage * bucketTotal];
+    const unsigned int* histogramOther = WHOLE_TRIAL ? NULL : &histogramWindowPrevious[stage * bucketTotal];
+
+    long long frameTotal = 0;
+    for (int iBucket = 0; iBucket < bucketTotal; iBucket++)
+    {
+        frameTotal += histogram[iBucket];
+        if (histogramOther != NULL) { frameTotal += histogramOther[iBucket]; }
+    }
+
+    if (frameTotal == 0) { return mStageStatistics; }
+
+    int maximum;
+    if (WHOLE_TRIAL) { maximum = maximumTrial[stage]; }
+    else             { maximum = std::max(maximumWindow[stage], maximumWindowPrevious[stage]); }
+
+    mStageStatistics.frameTotal   = std::min(frameTotal, (long long) INT_MAX);
+    mStageStatistics.median       = std::min(maximum, getPercentile(histogram, histogramOther, frameTotal, 0.50));
+    mStageStatistics.percentile99 = std::min(maximum, getPercentile(histogram, histogramOther, frameTotal, 0.99));
+    mStageStatistics.maximum      = maximum;
+
+    return mStageStatistics;
+}
+
+bool StageProfiler::save(const std::string& filename) const
+{
+    if (!profilingEnabled) { return true; } // nothing was measured
+
+    std::ofstream file;
+    file.open(filename, std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    std::string delimiter = ";";
+
+    file << "stage;frames;median_ns;p99_ns;max_ns" << std::endl;
+
+    for (int iStage = 0; iStage < STAGE_TOTAL; iStage++)
+    {
+        stageStatistics mStageStatistics = getStatistics(iStage, true);
+
+        file << getStageName(iStage)           << delimiter
+             << mStageStatistics.frameTotal    << delimiter
+             << mStageStatistics.median        << delimiter
+             << mStageStatistics.percentile99  << delimiter
+             << mStageStatistics.maximum       << std::endl;
+    }
+
+    file.close(); // flushes, so that a full disk is noticed
+
+    return file.good();
+}
+
+bool saveStageProfile(const std::string& filename, const std::vector<dataVariables>& vDataVariables, int frameTotal)
+{
+    if (!profilingEnabled) { return true; }
+
+    StageProfiler mStageProfiler(frameTotal);
+    for (int i = 0; i < frameTotal && i < (int) vDataVariables.size(); i++) { mStageProfiler.addFrame(vDataVariables[i]); }
+    return mStageProfiler.save(filename);
+}
@@ -0,0 +1,152 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+// Files
+
+#include "structures.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Per-stage timing of eyeStalker(). Only compiled in when EYESTALKER_PROFILING is defined (e.g. DEFINES += EYESTALKER_PROFILING
+// in the project file); otherwise the timers below are empty inline functions, dataVariables keeps its size and no file is written.
+
+#ifdef EYESTALKER_PROFILING
+const bool profilingEnabled = true;
+#else
+const bool profilingEnabled = false;
+#endif
+
+const std::string stageProfileFilename = "stage_profile.dat"; // in trial directory
+
+const char* getStageName(int stage); // e.g. "canny", used for column names
+
+inline long long getProfileTime() // ns, 0 without profiling
+{
+#ifdef EYESTALKER_PROFILING
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return 0;
+#endif
+}
+
+// Adds the time since the previous mark to a stage of the frame record.
+
+class StageTimer
+{
+
+public:
+
+    StageTimer(dataVariables& mDataVariables)
+#ifdef EYESTALKER_PROFILING
+        : durations(mDataVariables.stageDuration.nanoseconds)
+    {
+        std::fill(durations, durations + STAGE_TOTAL, 0);
+        timeLast = getProfileTime();
+    }
+#else
+    { (void) mDataVariables; }
+#endif
+
+    void add(int stage, long long nanoseconds) // time measured elsewhere (e.g. shared preprocessing)
+    {
+#ifdef EYESTALKER_PROFILING
+        durations[stage] = std::min((long long) INT_MAX, durations[stage] + nanoseconds);
+#else
+        (void) stage; (void) nanoseconds;
+#endif
+    }
+
+    void mark(int stage)
+    {
+#ifdef EYESTALKER_PROFILING
+        long long timeNow = getProfileTime();
+        add(stage, timeNow - timeLast);
+        timeLast = timeNow;
+#else
+        (void) stage;
+#endif
+    }
+
+    void restart() // time until next mark is not counted
+    {
+#ifdef EYESTALKER_PROFILING
+        timeLast = getProfileTime();
+#endif
+    }
+
+private:
+
+#ifdef EYESTALKER_PROFILING
+    int* durations;
+    long long timeLast;
+#endif
+};
+
+// Histograms of stage durations, over the whole trial and over the most recent frames (rolling window).
+// Buckets are spaced logarithmically (8 per power of two), so percentiles are within 7% of the measured value.
+// Frames may be added from one thread while another one queries the statistics.
+
+struct stageStatistics // ns
+{
+    int frameTotal;
+    int median;
+    int percentile99;
+    int maximum;
+};
+
+class StageProfiler
+{
+
+public:
+
+    StageProfiler(int windowLength = 1000); // frames in rolling window (between one and two times this value)
+
+    stageStatistics getStatistics(int stage, bool WHOLE_TRIAL = false) const;
+    bool save(const std::string& filename) const; // whole trial, one row per stage
+    void addFrame(const dataVariables&);
+    void clear();
+
+private:
+
+    int frameTotalWindow;
+    int windowLength;
+
+    mutable std::mutex profilerMutex;
+
+    std::vector<int> maximumTrial;
+    std::vector<int> maximumWindow;
+    std::vector<int> maximumWindowPrevious;
+
+    std::vector<unsigned int> histogramTrial; // bucket counts, stage after stage
+    std::vector<unsigned int> histogramWindow;
+    std::vector<unsigned int> histogramWindowPrevious;
+};
+
+bool saveStageProfile(const std::string& filename, const std::vector<dataVariables>&, int frameTotal); // statistics of whole trial
+
+#endif // STAGEPROFILER_H
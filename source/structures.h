@@ -23,10 +23,6 @@
 
 #include <vector>
 
-// QT
-
-#include <QColor>
-
 // OpenCV
 
 #include <opencv2/imgproc/imgproc.hpp>
@@ -96,7 +92,7 @@ struct ellipseProperties
 
 struct detectionParameters
 {
-    detectionParameters(): DETECTION_ON(false) { }
+    detectionParameters(): DETECTION_ON(false), circumferenceScaled(0), thresholdBlinkContrast(0), timeBudget(0) { }
 
     bool   DETECTION_ON;
     double gainAverages;
@@ -110,7 +106,9 @@ struct detectionParameters
     double cameraFrameRate;
     int    glintWdth;
     double curvatureOffset;
+    double circumferenceScaled; // edge detection at reduced scale, where pupil circumference is one to two times this (px, 0 = off)
     double thresholdAspectRatioMin;
+    double thresholdBlinkContrast; // intensity difference between pupil and its surroundings, below which eye is closed (0 = off)
     double thresholdCircumferenceMax;
     double thresholdCircumferenceMin;
     double thresholdChangeAspectRatioUpper;
@@ -124,6 +122,7 @@ struct detectionParameters
     double thresholdScoreFit;
     double thresholdScoreDiffEdge;
     double thresholdScoreDiffFit;
+    double timeBudget; // ms for detection of a frame (live tracking), no limit if 0
     int    fitMaximum;
     int    fitEdgeMaximum;
     double fitEdgeFraction;
@@ -179,22 +178,122 @@ struct detectionVariables
     double thresholdChangePositionUpper;
     double thresholdScoreEdge;
     double thresholdScoreFit;
+    int blinkLength; // frames since eye closed
     int windowLengthEdge;
 };
 
-struct dataVariables
+// Detection stages, timed in builds with EYESTALKER_PROFILING (see stageprofiler.h)
+
+enum detectionStage
+{
+    STAGE_GRAYSCALE,
+    STAGE_RESIZE,
+    STAGE_INTEGRAL,
+    STAGE_GLINT,
+    STAGE_HAAR,
+    STAGE_BLUR,
+    STAGE_CANNY,
+    STAGE_SHARPENING,
+    STAGE_EDGE_SELECTION,
+    STAGE_SEGMENTATION_CURVATURE,
+    STAGE_SEGMENTATION_LENGTH,
+    STAGE_SEGMENTATION_SCORE,
+    STAGE_CLASSIFICATION,
+    STAGE_SUBSETS,
+    STAGE_FITTING,
+    STAGE_UPDATE,
+    STAGE_TOTAL
+};
+
+struct stageDurations
+{
+    int nanoseconds[STAGE_TOTAL];
+};
+
+struct dataVariables // one sample per frame (64 bytes), kept for the whole trial
 {
-    bool DETECTED;
     double absoluteXPos;
     double absoluteYPos;
-    std::vector<edgeProperties> edgeData;
-    std::vector<ellipseProperties> ellipseData;
-    double duration;
     double exactAspectRatio;
     double exactCircumference;
     double exactXPos;
     double exactYPos;
     double timestamp;
+    float  duration; // ms
+    bool   DETECTED;
+    bool   DEADLINE_EXCEEDED; // time budget ran out, detection used what was found until then
+    bool   BLINK; // eye closed, detection was skipped
+#ifdef EYESTALKER_PROFILING
+    stageDurations stageDuration; // profiling builds only, 64 bytes more
+#endif
+};
+
+// Per-edge and per-fit values that are exported, without the point data used during detection
+
+struct edgeSummary
+{
+    double curvature;
+    double curvatureMax;
+    double curvatureMin;
+    double gradient;
+    double intensity;
+    double length;
+    double radius;
+    double radiusVar;
+    int tag;
+};
+
+struct ellipseSummary
+{
+    double angle;
+    double aspectRatio;
+    double circumference;
+    double edgeLength;
+    double edgeScore;
+    double fitError;
+    double xPos;
+    double yPos;
+    int tag;
+};
+
+struct diagnosticVariables // only filled when requested, see DiagnosticsArena for keeping them per trial
+{
+    std::vector<edgeSummary> edgeData;
+    std::vector<ellipseSummary> ellipseData;
+};
+
+struct stageInputs // only filled when requested, inputs of the individual stages of one frame (see bench/main.cpp)
+{
+    bool PROCESSED; // false if frame was a blink or image AOI was too small, then only inputs of Haar-like detector are set
+
+    double curvatureLowerLimit;
+    double curvatureUpperLimit;
+    int scaleFactor; // of reduced-scale pass, edge stages run on down-scaled Canny AOI if larger than 1
+
+    AOIProperties cannyAOI;
+    AOIProperties glintAOIResized;
+    AOIProperties haarAOIResized;
+    AOIProperties integralAOI;
+    AOIProperties searchAOIResized;
+
+    cv::Mat imageAOIGray;
+    cv::Mat imageAOIGrayBlurred;
+    cv::Mat imageResized;
+
+    detectionParameters mDetectionParameters; // as used by edge stages
+    detectionVariables  mDetectionVariables;  // as used by edge stages
+
+    std::vector<unsigned int> integralImage;
+
+    std::vector<int> cannyEdgesOriginal;
+    std::vector<int> cannyEdgesSharpened;
+    std::vector<int> edgePointsOriginal;
+
+    std::vector<edgeProperties> vEdgesSelected;   // input of curvature segmentation
+    std::vector<edgeProperties> vEdgesCurvature;  // input of length segmentation
+    std::vector<edgeProperties> vEdgesLength;     // input of score segmentation
+    std::vector<edgeProperties> vEdgesClassified; // input of subset enumeration
+    std::vector<edgeProperties> vEdgeCollections; // input of ellipse fitting
 };
 
 struct developmentOptions
@@ -217,7 +316,7 @@ struct drawVariables
     AOIProperties cannyAOI;
     std::vector<int> cannyEdgeIndices;
     std::vector<double> ellipseCoefficients;
-    std::vector<edgeProperties> edgeData;
+    std::vector<edgeProperties> edgeData; // tag and point indices only
 };
 
 struct vertexProperties
@@ -237,7 +336,8 @@ struct arcProperties
 
 struct imageInfo
 {
-    unsigned long long time;
+    unsigned long long time;     // camera clock
+    unsigned long long timeHost; // host clock, shared between cameras
     cv::Mat image;
 };
 
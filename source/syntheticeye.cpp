@@ -0,0 +1,417 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "syntheticeye.h"
+
+namespace
+{
+
+const double eyelidCurvature = 0.35; // drop of eyelid at one iris radius from pupil, relative to iris radius
+const double eyelidGap       = 0.8;  // distance between open eyelid and pupil, relative to pupil radius
+
+unsigned int getSeed(unsigned int seed, unsigned int index, unsigned int stream) // independent seed for every frame and purpose
+{
+    uint64_t z = ((uint64_t) seed << 32) ^ ((uint64_t) stream << 56) ^ index;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z =  z ^ (z >> 31);
+    return (unsigned int) z;
+}
+
+double getUniform(std::mt19937& rng) // [0, 1)
+{
+    return rng() / 4294967296.0;
+}
+
+double getNormal(std::mt19937& rng) // Box-Muller, so that values do not depend on standard library implementation
+{
+    double u1 = (rng() + 1.0) / 4294967297.0;
+    double u2 =  rng()        / 4294967296.0;
+    return std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+}
+
+void blurGaussian(std::vector<float>& image, int wdth, int hght, double sigma) // separable, border values are repeated
+{
+    int radius = std::ceil(3 * sigma);
+
+    std::vector<float> kernel(2 * radius + 1);
+    float kernelSum = 0;
+    for (int i = -radius; i <= radius; i++) { kernel[i + radius] = std::exp(-0.5 * i * i / (sigma * sigma)); kernelSum += kernel[i + radius]; }
+    for (int i = 0; i < (int) kernel.size(); i++) { kernel[i] /= kernelSum; }
+
+    std::vector<float> imageTemp(image.size());
+
+    for (int y = 0; y < hght; y++)
+    {
+        for (int x = 0; x < wdth; x++)
+        {
+            float value = 0;
+            for (int i = -radius; i <= radius; i++) { value += kernel[i + radius] * image[y * wdth + std::min(wdth - 1, std::max(0, x + i))]; }
+            imageTemp[y * wdth + x] = value;
+        }
+    }
+
+    for (int y = 0; y < hght; y++)
+    {
+        for (int x = 0; x < wdth; x++)
+        {
+            float value = 0;
+            for (int i = -radius; i <= radius; i++) { value += kernel[i + radius] * imageTemp[std::min(hght - 1, std::max(0, y + i)) * wdth + x]; }
+            image[y * wdth + x] = value;
+        }
+    }
+}
+
+}
+
+syntheticEyeParameters::syntheticEyeParameters()
+{
+    imageWdth = 640;
+    imageHght = 480;
+    frameRate = 250;
+    seed      = 1;
+
+    pupilRadius      = 25;
+    pupilAspectRatio = 0.9;
+    pupilAngle       = 0;
+    pupilSizeChange  = 0;
+    pupilSizePeriod  = 2.0;
+    irisRadius       = 70;
+
+    trajectory       = TRAJECTORY_FIXATION;
+    motionAmplitude  = 80;
+    pursuitFrequency = 0.5;
+    saccadeInterval  = 0.40;
+    saccadeDuration  = 0.04;
+    tremorAmplitude  = 0.1;
+
+    glintTotal     = 1;
+    glintRadius    = 4;
+    eyelidCoverage = 0;
+    blinkInterval  = 0;
+    blinkDuration  = 0.15;
+    eyelashTotal   = 0;
+    blurSigma      = 1.0;
+    noiseSigma     = 2.0;
+
+    intensityEyelash =  40;
+    intensityGlint   = 250;
+    intensityIris    = 110;
+    intensityPupil   =  25;
+    intensitySclera  = 170;
+    intensitySkin    = 150;
+}
+
+SyntheticEye::SyntheticEye(const syntheticEyeParameters& mParametersNew)
+{
+    mParameters = mParametersNew;
+
+    std::mt19937 rng(getSeed(mParameters.seed, 0, 5));
+
+    for (int iEyelash = 0; iEyelash < mParameters.eyelashTotal; iEyelash++)
+    {
+        eyelash mEyelash;
+        mEyelash.position  = 2 * getUniform(rng) - 1;
+        mEyelash.angle     = std::max(-1.0, std::min(1.0, 0.35 * getNormal(rng)));
+        mEyelash.length    = mParameters.pupilRadius * (0.6 + 0.6 * getUniform(rng));
+        mEyelash.thickness = 1.0 + getUniform(rng);
+        vEyelashes.push_back(mEyelash);
+    }
+}
+
+double SyntheticEye::getSaccadeTarget(int saccadeIndex, int axis) const
+{
+    if (saccadeIndex < 0) { return 0; } // trial starts in centre
+
+    std::mt19937 rng(getSeed(mParameters.seed, saccadeIndex, 1 + axis));
+    return 2 * getUniform(rng) - 1;
+}
+
+SyntheticEye::eyeState SyntheticEye::getState(int frameIndex) const
+{
+    double time = frameIndex / mParameters.frameRate;
+
+    double xCentre = 0.5 * (mParameters.imageWdth - 1);
+    double yCentre = 0.5 * (mParameters.imageHght - 1);
+    double amplitude = mParameters.motionAmplitude;
+
+    eyeState mEyeState;
+    mEyeState.xPos = xCentre;
+    mEyeState.yPos = yCentre;
+
+    if (mParameters.trajectory == TRAJECTORY_PURSUIT)
+    {
+        double phase = 2 * M_PI * mParameters.pursuitFrequency * time;
+        mEyeState.xPos = xCentre +       amplitude * std::sin(phase);
+        mEyeState.yPos = yCentre + 0.5 * amplitude * std::sin(2 * phase);
+    }
+    else if (mParameters.trajectory == TRAJECTORY_SACCADES && mParameters.saccadeInterval > 0)
+    {
+        int saccadeIndex = std::floor(time / mParameters.saccadeInterval);
+        double saccadeTime = time - saccadeIndex * mParameters.saccadeInterval;
+
+        double fraction = 1; // minimum-jerk profile
+        if (saccadeTime < mParameters.saccadeDuration)
+        {
+            double tau = saccadeTime / mParameters.saccadeDuration;
+            fraction = tau * tau * tau * (10 - 15 * tau + 6 * tau * tau);
+        }
+
+        double xStart = getSaccadeTarget(saccadeIndex - 1, 0);
+        double yStart = getSaccadeTarget(saccadeIndex - 1, 1);
+        double xEnd   = getSaccadeTarget(saccadeIndex,     0);
+        double yEnd   = getSaccadeTarget(saccadeIndex,     1);
+
+        mEyeState.xPos = xCentre +       amplitude * (xStart + fraction * (xEnd - xStart));
+        mEyeState.yPos = yCentre + 0.6 * amplitude * (yStart + fraction * (yEnd - yStart));
+    }
+
+    if (mParameters.tremorAmplitude > 0)
+    {
+        std::mt19937 rng(getSeed(mParameters.seed, frameIndex, 3));
+        mEyeState.xPos += mParameters.tremorAmplitude * getNormal(rng);
+        mEyeState.yPos += mParameters.tremorAmplitude * getNormal(rng);
+    }
+
+    // Pupil size
+
+    double radius = mParameters.pupilRadius;
+    if (mParameters.pupilSizePeriod > 0) { radius *= 1 + mParameters.pupilSizeChange * std::sin(2 * M_PI * time / mParameters.pupilSizePeriod); }
+
+    mEyeState.semiMajor = radius;
+    mEyeState.semiMinor = radius * mParameters.pupilAspectRatio;
+
+    double margin = mEyeState.semiMajor + 2;
+    mEyeState.xPos = std::max(margin, std::min(mParameters.imageWdth - 1 - margin, mEyeState.xPos));
+    mEyeState.yPos = std::max(margin, std::min(mParameters.imageHght - 1 - margin, mEyeState.yPos));
+
+    // Eyelids. Upper eyelid moves down to lower eyelid during a blink
+
+    double pupilHalfHeight = std::sqrt(std::pow(mEyeState.semiMajor * std::sin(mParameters.pupilAngle), 2) + std::pow(mEyeState.semiMinor * std::cos(mParameters.pupilAngle), 2));
+    double gap = eyelidGap * radius;
+
+    double lidOpen = mEyeState.yPos - pupilHalfHeight - gap; // gap above pupil
+    if (mParameters.eyelidCoverage > 0) { lidOpen = mEyeState.yPos - pupilHalfHeight + mParameters.eyelidCoverage * 2 * pupilHalfHeight; }
+    mEyeState.lowerLidPosition = mEyeState.yPos + 0.85 * mParameters.irisRadius;
+
+    double closure = 0;
+    if (mParameters.blinkInterval > 0 && mParameters.blinkDuration > 0)
+    {
+        double blinkTime = time - 0.5 * mParameters.blinkInterval; // first blink halfway first interval
+        if (blinkTime >= 0)
+        {
+            blinkTime = std::fmod(blinkTime, mParameters.blinkInterval);
+            if (blinkTime < mParameters.blinkDuration) { closure = std::sin(M_PI * blinkTime / mParameters.blinkDuration); }
+        }
+    }
+
+    mEyeState.lidPosition = lidOpen + closure * (mEyeState.lowerLidPosition - lidOpen);
+
+    return mEyeState;
+}
+
+double SyntheticEye::getEyelidY(const eyeState& mEyeState, double x) const
+{
+    double dx = (x - mEyeState.xPos) / mParameters.irisRadius;
+    return mEyeState.lidPosition + eyelidCurvature * mParameters.irisRadius * dx * dx;
+}
+
+syntheticEyeTruth SyntheticEye::getTruth(int frameIndex) const
+{
+    eyeState mEyeState = getState(frameIndex);
+
+    double a = mEyeState.semiMajor;
+    double b = mEyeState.semiMinor;
+    double h = std::pow(a - b, 2) / std::pow(a + b, 2);
+
+    double pupilHalfHeight = std::sqrt(std::pow(a * std::sin(mParameters.pupilAngle), 2) + std::pow(b * std::cos(mParameters.pupilAngle), 2));
+    double pupilTop = mEyeState.yPos - pupilHalfHeight;
+
+    syntheticEyeTruth mTruth;
+    mTruth.xPos          = mEyeState.xPos;
+    mTruth.yPos          = mEyeState.yPos;
+    mTruth.angle         = mParameters.pupilAngle;
+    mTruth.aspectRatio   = b / a;
+    mTruth.circumference = M_PI * (a + b) * (1 + (3 * h) / (10 + std::sqrt(4 - 3 * h))); // same approximation as eyeStalker
+    mTruth.occlusion     = std::max(0.0, std::min(1.0, (getEyelidY(mEyeState, mEyeState.xPos) - pupilTop) / (2 * pupilHalfHeight)));
+    mTruth.VISIBLE       = mTruth.occlusion < 1;
+
+    return mTruth;
+}
+
+cv::Mat SyntheticEye::getFrame(int frameIndex, syntheticEyeTruth* mTruth) const
+{
+    int wdth = mParameters.imageWdth;
+    int hght = mParameters.imageHght;
+
+    eyeState mEyeState = getState(frameIndex);
+
+    if (mTruth != NULL) { *mTruth = getTruth(frameIndex); }
+
+    std::vector<float> image(wdth * hght);
+
+    // Sclera and iris
+
+    double irisRadiusSquared = mParameters.irisRadius * mParameters.irisRadius;
+
+    for (int y = 0; y < hght; y++)
+    {
+        for (int x = 0; x < wdth; x++)
+        {
+            double dx = x - mEyeState.xPos;
+            double dy = y - mEyeState.yPos;
+            image[y * wdth + x] = (dx * dx + dy * dy <= irisRadiusSquared) ? mParameters.intensityIris : mParameters.intensitySclera;
+        }
+    }
+
+    // Pupil, with 4 x 4 samples per pixel for sub-pixel edges
+
+    {
+        double cosAngle = std::cos(mParameters.pupilAngle);
+        double sinAngle = std::sin(mParameters.pupilAngle);
+        double a = mEyeState.semiMajor;
+        double b = mEyeState.semiMinor;
+
+        int xStart = std::max(0,        (int) std::floor(mEyeState.xPos - a) - 1);
+        int yStart = std::max(0,        (int) std::floor(mEyeState.yPos - a) - 1);
+        int xEnd   = std::min(wdth - 1, (int) std::ceil (mEyeState.xPos + a) + 1);
+        int yEnd   = std::min(hght - 1, (int) std::ceil (mEyeState.yPos + a) + 1);
+
+        for (int y = yStart; y <= yEnd; y++)
+        {
+            for (int x = xStart; x <= xEnd; x++)
+            {
+                int sampleTotal = 0;
+
+                for (int iSample = 0; iSample < 16; iSample++)
+                {
+                    double dx = x + ((iSample % 4) + 0.5) / 4 - 0.5 - mEyeState.xPos;
+                    double dy = y + ((iSample / 4) + 0.5) / 4 - 0.5 - mEyeState.yPos;
+                    double u  =  cosAngle * dx + sinAngle * dy;
+                    double v  = -sinAngle * dx + cosAngle * dy;
+                    if ((u * u) / (a * a) + (v * v) / (b * b) <= 1) { sampleTotal++; }
+                }
+
+                double coverage = sampleTotal / 16.0;
+                float& value = image[y * wdth + x];
+                value = (1 - coverage) * value + coverage * mParameters.intensityPupil;
+            }
+        }
+    }
+
+    // Glints. Corneal reflections move less than the pupil
+
+    for (int iGlint = 0; iGlint < mParameters.glintTotal; iGlint++)
+    {
+        double xCentre = 0.5 * (wdth - 1);
+        double xGlint  = xCentre + 0.3 * (mEyeState.xPos - xCentre) + (iGlint - 0.5 * (mParameters.glintTotal - 1)) * 3 * mParameters.glintRadius;
+        double yGlint  = mEyeState.yPos - 0.5 * mEyeState.semiMinor;
+        double sigma   = 0.5 * mParameters.glintRadius;
+
+        int range = std::ceil(2 * mParameters.glintRadius);
+
+        for (int y = std::max(0, (int) yGlint - range); y <= std::min(hght - 1, (int) yGlint + range); y++)
+        {
+            for (int x = std::max(0, (int) xGlint - range); x <= std::min(wdth - 1, (int) xGlint + range); x++)
+            {
+                double distanceSquared = (x - xGlint) * (x - xGlint) + (y - yGlint) * (y - yGlint);
+                double weight = std::min(1.0, 1.5 * std::exp(-0.5 * distanceSquared / (sigma * sigma)));
+                float& value = image[y * wdth + x];
+                value = (1 - weight) * value + weight * mParameters.intensityGlint;
+            }
+        }
+    }
+
+    // Eyelids, with one pixel wide edge
+
+    for (int y = 0; y < hght; y++)
+    {
+        for (int x = 0; x < wdth; x++)
+        {
+            double dx = (x - mEyeState.xPos) / mParameters.irisRadius;
+            double yUpper = getEyelidY(mEyeState, x);
+            double yLower = mEyeState.lowerLidPosition - eyelidCurvature * mParameters.irisRadius * dx * dx;
+
+            double weight = std::max(std::min(1.0, std::max(0.0, yUpper - y + 0.5)), std::min(1.0, std::max(0.0, y - yLower + 0.5)));
+
+            if (weight > 0)
+            {
+                float& value = image[y * wdth + x];
+                value = (1 - weight) * value + weight * mParameters.intensitySkin;
+            }
+        }
+    }
+
+    // Eyelashes hang from upper eyelid
+
+    for (int iEyelash = 0; iEyelash < (int) vEyelashes.size(); iEyelash++)
+    {
+        const eyelash& mEyelash = vEyelashes[iEyelash];
+
+        double xBase = mEyeState.xPos + 1.6 * mParameters.irisRadius * mEyelash.position;
+        double yBase = getEyelidY(mEyeState, xBase);
+        double xStep = std::sin(mEyelash.angle);
+        double yStep = std::cos(mEyelash.angle);
+        double halfThickness = 0.5 * mEyelash.thickness;
+
+        for (double distance = 0; distance <= mEyelash.length; distance += 0.25)
+        {
+            double xPoint = xBase + distance * xStep;
+            double yPoint = yBase + distance * yStep;
+
+            for (int y = std::max(0, (int) std::floor(yPoint - halfThickness - 1)); y <= std::min(hght - 1, (int) std::ceil(yPoint + halfThickness + 1)); y++)
+            {
+                for (int x = std::max(0, (int) std::floor(xPoint - halfThickness - 1)); x <= std::min(wdth - 1, (int) std::ceil(xPoint + halfThickness + 1)); x++)
+                {
+                    double distancePoint = std::sqrt((x - xPoint) * (x - xPoint) + (y - yPoint) * (y - yPoint));
+                    double weight = std::min(1.0, std::max(0.0, halfThickness + 0.5 - distancePoint));
+                    float& value = image[y * wdth + x];
+                    value = std::min((double) value, (1 - weight) * value + weight * mParameters.intensityEyelash);
+                }
+            }
+        }
+    }
+
+    // Optics and sensor
+
+    if (mParameters.blurSigma > 0) { blurGaussian(image, wdth, hght, mParameters.blurSigma); }
+
+    cv::Mat imageOutput(hght, wdth, CV_8UC1);
+
+    std::mt19937 rng(getSeed(mParameters.seed, frameIndex, 4));
+
+    for (int y = 0; y < hght; y++)
+    {
+        uchar* ptr = imageOutput.ptr<uchar>(y);
+
+        for (int x = 0; x < wdth; x++)
+        {
+            double value = image[y * wdth + x];
+            if (mParameters.noiseSigma > 0) { value += mParameters.noiseSigma * getNormal(rng); }
+            ptr[x] = std::max(0, std::min(255, (int) std::lround(value)));
+        }
+    }
+
+    return imageOutput;
+}
+
+void SyntheticEye::getSequence(int frameTotal, std::vector<cv::Mat>& vImages, std::vector<syntheticEyeTruth>& vTruth) const
+{
+    vImages.resize(frameTotal);
+    vTruth .resize(frameTotal);
+
+    for (int iFrame = 0; iFrame < frameTotal; iFrame++) { vImages[iFrame] = getFrame(iFrame, &vTruth[iFrame]); }
+}
@@ -0,0 +1,149 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef SYNTHETICEYE_H
+#define SYNTHETICEYE_H
+
+// Files
+
+#include "constants.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+
+// Deterministic generator of synthetic eye frames, for benchmarks and regression tests without recorded data.
+//
+// A frame is rendered from the parameters and its frame index only, so any frame of a sequence can be produced on its
+// own and the same frame is produced on every platform (random values come from std::mt19937, which is fully specified).
+// The pupil is a dark ellipse inside the iris, moving along a fixation, pursuit or saccade trajectory. Glints, an upper
+// eyelid with eyelashes, blinks, Gaussian blur and sensor noise can be added.
+
+enum syntheticTrajectory
+{
+    TRAJECTORY_FIXATION = 0, // small tremor around centre
+    TRAJECTORY_PURSUIT  = 1, // smooth sinusoidal movement
+    TRAJECTORY_SACCADES = 2  // fixations at random positions, with fast movements between them
+};
+
+struct syntheticEyeParameters
+{
+    syntheticEyeParameters(); // 640 x 480 px at 250 Hz, fixating pupil, one glint, no blinks
+
+    int imageWdth;
+    int imageHght;
+    double frameRate; // Hz
+    unsigned int seed;
+
+    // Pupil
+
+    double pupilRadius;      // semi-major axis (px)
+    double pupilAspectRatio; // minor axis / major axis
+    double pupilAngle;       // of major axis (rad)
+    double pupilSizeChange;  // relative amplitude of slow dilation (0.1 is +/- 10%)
+    double pupilSizePeriod;  // s
+    double irisRadius;       // px
+
+    // Motion
+
+    int trajectory;
+    double motionAmplitude;  // largest distance from image centre (px)
+    double pursuitFrequency; // Hz
+    double saccadeInterval;  // s between start of saccades
+    double saccadeDuration;  // s
+    double tremorAmplitude;  // standard deviation of position noise (px)
+
+    // Artefacts
+
+    int glintTotal;
+    double glintRadius;    // px
+    double eyelidCoverage; // fraction of pupil height covered by upper eyelid when eye is open, 0 leaves a gap above pupil
+    double blinkInterval;  // s between start of blinks, 0 for no blinks
+    double blinkDuration;  // s
+    int eyelashTotal;
+    double blurSigma;      // px, 0 for no blur
+    double noiseSigma;     // grey levels, 0 for no noise
+
+    // Grey levels
+
+    double intensityEyelash;
+    double intensityGlint;
+    double intensityIris;
+    double intensityPupil;
+    double intensitySclera;
+    double intensitySkin;
+};
+
+struct syntheticEyeTruth // pupil as it would be measured by eyeStalker
+{
+    bool VISIBLE; // false while eye is closed
+    double angle;
+    double aspectRatio;
+    double circumference;
+    double occlusion; // fraction of pupil height covered by eyelid
+    double xPos;
+    double yPos;
+};
+
+class SyntheticEye
+{
+
+public:
+
+    SyntheticEye(const syntheticEyeParameters&);
+
+    cv::Mat getFrame(int frameIndex, syntheticEyeTruth* = NULL) const; // grayscale
+    syntheticEyeTruth getTruth(int frameIndex) const;
+    void getSequence(int frameTotal, std::vector<cv::Mat>& vImages, std::vector<syntheticEyeTruth>& vTruth) const;
+
+private:
+
+    struct eyelash
+    {
+        double angle;     // from vertical
+        double length;    // px
+        double position;  // along eyelid, -1 to 1
+        double thickness; // px
+    };
+
+    struct eyeState
+    {
+        double lidPosition; // y of upper eyelid above pupil centre
+        double lowerLidPosition;
+        double semiMajor;
+        double semiMinor;
+        double xPos;
+        double yPos;
+    };
+
+    syntheticEyeParameters mParameters;
+
+    std::vector<eyelash> vEyelashes;
+
+    eyeState getState(int frameIndex) const;
+    double getEyelidY(const eyeState&, double x) const;
+    double getSaccadeTarget(int saccadeIndex, int axis) const; // -1 to 1
+};
+
+#endif // SYNTHETICEYE_H
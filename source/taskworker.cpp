@@ -0,0 +1,74 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "taskworker.h"
+
+TaskWorker::TaskWorker()
+{
+    TASK_PENDING  = false;
+    WORKER_ACTIVE = true;
+    workerThread  = std::thread(&TaskWorker::threadWorker, this);
+}
+
+TaskWorker::~TaskWorker()
+{
+    wait();
+
+    { std::lock_guard<std::mutex> taskLock(taskMutex);
+        WORKER_ACTIVE = false;
+    }
+
+    taskReadyCV.notify_one();
+    workerThread.join();
+}
+
+void TaskWorker::run(std::function<void()> task)
+{
+    { std::lock_guard<std::mutex> taskLock(taskMutex);
+        mTask        = task;
+        TASK_PENDING = true;
+    }
+
+    taskReadyCV.notify_one();
+}
+
+void TaskWorker::wait()
+{
+    std::unique_lock<std::mutex> taskLock(taskMutex);
+    taskDoneCV.wait(taskLock, [this] { return !TASK_PENDING; });
+}
+
+void TaskWorker::threadWorker()
+{
+    std::unique_lock<std::mutex> taskLock(taskMutex);
+
+    while (true)
+    {
+        taskReadyCV.wait(taskLock, [this] { return TASK_PENDING || !WORKER_ACTIVE; });
+
+        if (!TASK_PENDING) { return; } // worker is shut down
+
+        std::function<void()> task = mTask;
+
+        taskLock.unlock();
+        task();
+        taskLock.lock();
+
+        mTask        = nullptr;
+        TASK_PENDING = false;
+        taskDoneCV.notify_all();
+    }
+}
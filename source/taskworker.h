@@ -0,0 +1,57 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TASKWORKER_H
+#define TASKWORKER_H
+
+// Standard Template
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Runs one task at a time on a thread that lives as long as the worker, so that work which is split off every frame
+// (e.g. tracking the second eye) does not pay for creating and joining a thread each time. 'run' hands a task over
+// and returns at once; 'wait' blocks until that task has finished. Tasks must not be handed over before the previous
+// one has been waited for.
+
+class TaskWorker
+{
+
+public:
+
+    TaskWorker();
+    ~TaskWorker();
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+
+    bool TASK_PENDING;
+    bool WORKER_ACTIVE;
+
+    std::condition_variable taskDoneCV;
+    std::condition_variable taskReadyCV;
+    std::function<void()> mTask;
+    std::mutex taskMutex;
+    std::thread workerThread;
+
+    void threadWorker();
+};
+
+#endif // TASKWORKER_H
@@ -0,0 +1,213 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "temporalreuse.h"
+
+const int    contourSampleTotal  = 32;   // points on pupil contour that are checked
+const double contourOffset       = 0.15; // samples inside and outside contour, relative to radius
+const double contourOffsetMin    = 2;    // px
+
+TemporalReuse::TemporalReuse()
+{
+    ENABLED = false;
+
+    thresholdContrast   = 0.7;
+    thresholdDifference = 2.0;
+    reuseMaximum        = 100;
+
+    clear();
+    clearCounters();
+}
+
+void TemporalReuse::clear()
+{
+    REFERENCE_VALID = false;
+    reuseCount      = 0;
+    imageReference  = cv::Mat();
+}
+
+void TemporalReuse::clearCounters()
+{
+    framesTracked        = 0;
+    framesReused         = 0;
+    verificationFailures = 0;
+}
+
+void TemporalReuse::setParameters(bool ENABLED_NEW, double thresholdDifferenceNew, double thresholdContrastNew, int reuseMaximumNew)
+{
+    ENABLED             = ENABLED_NEW;
+    thresholdDifference = thresholdDifferenceNew;
+    thresholdContrast   = thresholdContrastNew;
+    reuseMaximum        = reuseMaximumNew;
+}
+
+std::string TemporalReuse::getSummary() const
+{
+    int framesTotal = framesTracked;
+    if (framesTotal == 0) { framesTotal = 1; }
+
+    std::stringstream summary;
+    summary << std::fixed << std::setprecision(1)
+            << "reused " << 100.0 * framesReused / framesTotal << "% (verification failed " << 100.0 * verificationFailures / framesTotal << "%)";
+    return summary.str();
+}
+
+double TemporalReuse::measureDifference(const cv::Mat& imageResized) const
+{
+    // Mean absolute difference per pixel with reference frame
+
+    if (referenceAOI.xPos + referenceAOI.wdth > imageResized.cols || referenceAOI.yPos + referenceAOI.hght > imageResized.rows)
+    {   return std::numeric_limits<double>::max(); } // frame size has changed
+
+    double difference = 0;
+
+    for (int y = 0; y < referenceAOI.hght; y++)
+    {
+        const uchar* rowImage     = imageResized.ptr<uchar>(referenceAOI.yPos + y) + referenceAOI.xPos;
+        const uchar* rowReference = imageReference.ptr<uchar>(y);
+
+        int rowDifference = 0;
+        for (int x = 0; x < referenceAOI.wdth; x++) { rowDifference += std::abs(rowImage[x] - rowReference[x]); }
+        difference += rowDifference;
+    }
+
+    return (difference / (referenceAOI.wdth * referenceAOI.hght));
+}
+
+double TemporalReuse::measureContrast(const cv::Mat& imageGray) const
+{
+    // Mean intensity difference between points just outside and just inside the pupil contour of the reference frame.
+    // Distance of contour to centre follows from ellipse coefficients: A x^2 + B xy + C y^2 + value at centre = 0
+
+    double contrast = 0;
+    int sampleTotal = 0;
+
+    for (int iSample = 0; iSample < contourSampleTotal; iSample++)
+    {
+        double angle = 2 * M_PI * iSample / contourSampleTotal;
+        double xDirection = cos(angle);
+        double yDirection = sin(angle);
+
+        double quadratic = conic[0] * xDirection * xDirection + conic[1] * xDirection * yDirection + conic[2] * yDirection * yDirection;
+        double radiusSquared = -conic[3] / quadratic;
+        if (!(radiusSquared > 0)) { continue; }
+
+        double radius = sqrt(radiusSquared);
+        double offset = std::max(contourOffset * radius, contourOffsetMin);
+
+        int xInner = round(xCentre + (radius - offset) * xDirection);
+        int yInner = round(yCentre + (radius - offset) * yDirection);
+        int xOuter = round(xCentre + (radius + offset) * xDirection);
+        int yOuter = round(yCentre + (radius + offset) * yDirection);
+
+        if (xInner < 0 || xInner >= imageGray.cols || yInner < 0 || yInner >= imageGray.rows) { continue; }
+        if (xOuter < 0 || xOuter >= imageGray.cols || yOuter < 0 || yOuter >= imageGray.rows) { continue; }
+
+        contrast += imageGray.ptr<uchar>(yOuter)[xOuter] - imageGray.ptr<uchar>(yInner)[xInner];
+        sampleTotal++;
+    }
+
+    if (sampleTotal < 0.5 * contourSampleTotal) { return 0; } // contour mostly outside image
+
+    return (contrast / sampleTotal);
+}
+
+void TemporalReuse::setReference(PreprocessedFrame& mPreprocessedFrame, const detectionVariables& mDetectionVariables, const dataVariables& mDataVariables, const drawVariables& mDrawVariables)
+{
+    clear();
+
+    if (!mDataVariables.DETECTED || mDrawVariables.ellipseCoefficients.size() != 6) { return; }
+
+    // Ellipse coefficients are relative to Canny AOI
+
+    const std::vector<double>& c = mDrawVariables.ellipseCoefficients;
+
+    double x = mDataVariables.exactXPos - mDrawVariables.cannyAOI.xPos;
+    double y = mDataVariables.exactYPos - mDrawVariables.cannyAOI.yPos;
+
+    conic.resize(4);
+    conic[0] = c[0];
+    conic[1] = c[1];
+    conic[2] = c[2];
+    conic[3] = c[0] * x * x + c[1] * x * y + c[2] * y * y + c[3] * x + c[4] * y + c[5];
+
+    xCentre = mDataVariables.exactXPos;
+    yCentre = mDataVariables.exactYPos;
+
+    contrastReference = measureContrast(mPreprocessedFrame.getGray());
+    if (!(contrastReference > 0)) { return; }
+
+    // Canny AOI in down-sampled image
+
+    const cv::Mat& imageResized = mPreprocessedFrame.getResized();
+
+    double sizeFactorDown = PreprocessedFrame::sizeFactorDown;
+
+    referenceAOI.xPos = sizeFactorDown * mDrawVariables.cannyAOI.xPos;
+    referenceAOI.yPos = sizeFactorDown * mDrawVariables.cannyAOI.yPos;
+    referenceAOI.wdth = std::min((int) (sizeFactorDown * mDrawVariables.cannyAOI.wdth), imageResized.cols - referenceAOI.xPos);
+    referenceAOI.hght = std::min((int) (sizeFactorDown * mDrawVariables.cannyAOI.hght), imageResized.rows - referenceAOI.yPos);
+
+    if (referenceAOI.wdth <= 0 || referenceAOI.hght <= 0) { return; }
+
+    cv::Rect referenceRect(referenceAOI.xPos, referenceAOI.yPos, referenceAOI.wdth, referenceAOI.hght);
+    imageReference = imageResized(referenceRect).clone();
+
+    mDetectionVariablesReference = mDetectionVariables;
+    mDataVariablesReference      = mDataVariables;
+    mDrawVariablesReference      = mDrawVariables;
+
+    REFERENCE_VALID = true;
+}
+
+detectionVariables TemporalReuse::track(PreprocessedFrame& mPreprocessedFrame,
+                                        const AOIProperties& imageAOI,
+                                        detectionVariables& mDetectionVariables,
+                                        const detectionParameters& mDetectionParameters,
+                                        dataVariables& mDataVariables,
+                                        drawVariables& mDrawVariables)
+{
+    if (!ENABLED) { return eyeStalker(mPreprocessedFrame, imageAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables); }
+
+    framesTracked++;
+
+    if (REFERENCE_VALID && reuseCount < reuseMaximum && measureDifference(mPreprocessedFrame.getResized()) < thresholdDifference)
+    {
+        if (measureContrast(mPreprocessedFrame.getGray()) >= thresholdContrast * contrastReference) // pupil is still where it was
+        {
+            mDataVariables = mDataVariablesReference;
+            mDrawVariables = mDrawVariablesReference;
+
+            mDataVariables.DEADLINE_EXCEEDED = false;
+
+#ifdef EYESTALKER_PROFILING
+            mDataVariables.stageDuration = stageDurations(); // no stages were run
+#endif
+            reuseCount++;
+            framesReused++;
+
+            return mDetectionVariablesReference;
+        }
+
+        verificationFailures++;
+    }
+
+    detectionVariables mDetectionVariablesNew = eyeStalker(mPreprocessedFrame, imageAOI, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables);
+
+    setReference(mPreprocessedFrame, mDetectionVariablesNew, mDataVariables, mDrawVariables);
+
+    return mDetectionVariablesNew;
+}
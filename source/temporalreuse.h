@@ -0,0 +1,99 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TEMPORALREUSE_H
+#define TEMPORALREUSE_H
+
+// Files
+
+#include "eyestalker.h"
+#include "preprocessedframe.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+
+// Re-use of the last detection during fixations (live tracking). The Canny AOI of the last fully detected frame is kept
+// in down-sampled form. When a new frame differs from it by less than a mean absolute difference per pixel, and the
+// pupil contour of that detection still has the dark-inside, bright-outside contrast it had, the frame gets the result
+// of the last detection without running eyeStalker(). Otherwise, and after a maximum number of re-used frames in a row,
+// the frame is detected in full and becomes the new reference. One object per tracked eye.
+
+class TemporalReuse
+{
+
+public:
+
+    TemporalReuse();
+
+    detectionVariables track(PreprocessedFrame&, const AOIProperties&, detectionVariables&, const detectionParameters&, dataVariables&, drawVariables&); // same as eyeStalker()
+
+    void clear(); // forget reference frame, e.g. when detection variables are reset
+    void clearCounters();
+    void setParameters(bool ENABLED, double thresholdDifference, double thresholdContrast, int reuseMaximum); // reference frame is kept, it is checked before use
+
+    int getFramesTracked()        const { return framesTracked; }
+    int getFramesReused()         const { return framesReused; }
+    int getVerificationFailures() const { return verificationFailures; } // frames that were similar enough, but failed contour check
+    std::string getSummary() const; // e.g. "reused 61.2% (verification failed 0.4%)"
+
+private:
+
+    bool ENABLED;
+    bool REFERENCE_VALID;
+
+    double thresholdContrast;   // fraction of contour contrast of reference frame
+    double thresholdDifference; // grey levels per pixel
+    int reuseCount;   // frames re-used in a row
+    int reuseMaximum;
+
+    std::atomic<int> framesTracked;
+    std::atomic<int> framesReused;
+    std::atomic<int> verificationFailures;
+
+    // Reference frame
+
+    AOIProperties referenceAOI; // Canny AOI in down-sampled image
+    cv::Mat imageReference;
+
+    double contrastReference;
+    double xCentre; // of pupil, in frame
+    double yCentre;
+    std::vector<double> conic; // A, B, C of ellipse coefficients and value at centre
+
+    detectionVariables mDetectionVariablesReference;
+    dataVariables      mDataVariablesReference;
+    drawVariables      mDrawVariablesReference;
+
+    double measureContrast   (const cv::Mat& imageGray) const;
+    double measureDifference (const cv::Mat& imageResized) const;
+    void   setReference(PreprocessedFrame&, const detectionVariables&, const dataVariables&, const drawVariables&);
+};
+
+#endif // TEMPORALREUSE_H
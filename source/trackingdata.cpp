@@ -0,0 +1,502 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "trackingdata.h"
+
+static_assert(sizeof(trackingFileHeader)   == 64, "tracking data header must be 64 bytes");
+static_assert(sizeof(trackingColumnHeader) == 64, "column header must be 64 bytes");
+
+namespace
+{
+
+const uint32_t trackingFileVersion = 1;
+
+uint64_t alignOffset(uint64_t offset) { return (offset + 7) & ~((uint64_t) 7); }
+
+size_t getTypeSize(int type)
+{
+    if      (type == COLUMN_UINT8) { return 1; }
+    else if (type == COLUMN_INT32) { return 4; }
+    else                           { return 8; }
+}
+
+void writePadding(std::ofstream& file, uint64_t& fileOffset)
+{
+    static const char zeros[8] = {0};
+    uint64_t fileOffsetAligned = alignOffset(fileOffset);
+    file.write(zeros, fileOffsetAligned - fileOffset);
+    fileOffset = fileOffsetAligned;
+}
+
+}
+
+// Writer
+
+TrackingDataWriter::TrackingDataWriter() {}
+
+void TrackingDataWriter::addColumnData(const std::string& name, int type, const void* values, size_t size, const std::vector<uint64_t>* rowStarts)
+{
+    columnData mColumn;
+    mColumn.RAGGED = (rowStarts != NULL);
+    mColumn.type   = type;
+    mColumn.name   = name.substr(0, sizeof(trackingColumnHeader().name) - 1); // null-terminated
+    mColumn.values.assign(static_cast<const unsigned char*>(values), static_cast<const unsigned char*>(values) + size);
+    if (rowStarts != NULL) { mColumn.rowStarts = *rowStarts; }
+    vColumns.push_back(mColumn);
+}
+
+void TrackingDataWriter::addColumn(const std::string& name, const std::vector<uint8_t>& values) { addColumnData(name, COLUMN_UINT8,   values.data(), values.size() * sizeof(uint8_t), NULL); }
+void TrackingDataWriter::addColumn(const std::string& name, const std::vector<int32_t>& values) { addColumnData(name, COLUMN_INT32,   values.data(), values.size() * sizeof(int32_t), NULL); }
+void TrackingDataWriter::addColumn(const std::string& name, const std::vector<double>&  values) { addColumnData(name, COLUMN_FLOAT64, values.data(), values.size() * sizeof(double),  NULL); }
+
+void TrackingDataWriter::addRaggedColumn(const std::string& name, const std::vector<int32_t>& values, const std::vector<uint64_t>& rowStarts) { addColumnData(name, COLUMN_INT32,   values.data(), values.size() * sizeof(int32_t), &rowStarts); }
+void TrackingDataWriter::addRaggedColumn(const std::string& name, const std::vector<double>&  values, const std::vector<uint64_t>& rowStarts) { addColumnData(name, COLUMN_FLOAT64, values.data(), values.size() * sizeof(double),  &rowStarts); }
+
+bool TrackingDataWriter::save(const std::string& filename, int trialIndex, long long systemTime, double samplingRate, int sampleTotal) const
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    trackingFileHeader mHeader;
+    std::memset(&mHeader, 0, sizeof(mHeader));
+    std::memcpy(mHeader.magic, trackingFileMagic, sizeof(mHeader.magic));
+    mHeader.version      = trackingFileVersion;
+    mHeader.columnTotal  = vColumns.size();
+    mHeader.sampleTotal  = sampleTotal;
+    mHeader.systemTime   = systemTime;
+    mHeader.trialIndex   = trialIndex;
+    mHeader.samplingRate = samplingRate;
+
+    // Column offsets follow from the sizes, so headers can be written first
+
+    std::vector<trackingColumnHeader> vColumnHeaders(vColumns.size());
+
+    uint64_t fileOffset = sizeof(trackingFileHeader) + vColumns.size() * sizeof(trackingColumnHeader);
+
+    for (int iColumn = 0; iColumn < (int) vColumns.size(); iColumn++)
+    {
+        const columnData& mColumn = vColumns[iColumn];
+        trackingColumnHeader& mColumnHeader = vColumnHeaders[iColumn];
+
+        std::memset(&mColumnHeader, 0, sizeof(mColumnHeader));
+        std::memcpy(mColumnHeader.name, mColumn.name.c_str(), mColumn.name.size());
+        mColumnHeader.type   = mColumn.type;
+        mColumnHeader.RAGGED = mColumn.RAGGED;
+
+        fileOffset = alignOffset(fileOffset);
+        mColumnHeader.valueOffset = fileOffset;
+        mColumnHeader.valueTotal  = mColumn.values.size() / getTypeSize(mColumn.type);
+        fileOffset += mColumn.values.size();
+
+        if (mColumn.RAGGED)
+        {
+            fileOffset = alignOffset(fileOffset);
+            mColumnHeader.rowStartOffset = fileOffset;
+            fileOffset += mColumn.rowStarts.size() * sizeof(uint64_t);
+        }
+    }
+
+    file.write(reinterpret_cast<const char*>(&mHeader), sizeof(mHeader));
+    if (!vColumnHeaders.empty()) { file.write(reinterpret_cast<const char*>(vColumnHeaders.data()), vColumnHeaders.size() * sizeof(trackingColumnHeader)); }
+
+    fileOffset = sizeof(trackingFileHeader) + vColumns.size() * sizeof(trackingColumnHeader);
+
+    for (int iColumn = 0; iColumn < (int) vColumns.size(); iColumn++)
+    {
+        const columnData& mColumn = vColumns[iColumn];
+
+        writePadding(file, fileOffset);
+        file.write(reinterpret_cast<const char*>(mColumn.values.data()), mColumn.values.size());
+        fileOffset += mColumn.values.size();
+
+        if (mColumn.RAGGED)
+        {
+            writePadding(file, fileOffset);
+            file.write(reinterpret_cast<const char*>(mColumn.rowStarts.data()), mColumn.rowStarts.size() * sizeof(uint64_t));
+            fileOffset += mColumn.rowStarts.size() * sizeof(uint64_t);
+        }
+    }
+
+    return file.good();
+}
+
+// Reader
+
+TrackingDataReader::TrackingDataReader()
+{
+    data     = NULL;
+    dataSize = 0;
+
+    std::memset(&mHeader, 0, sizeof(mHeader));
+
+#ifdef _WIN32
+    hFile    = INVALID_HANDLE_VALUE;
+    hMapping = NULL;
+#else
+    fileDescriptor = -1;
+#endif
+}
+
+TrackingDataReader::~TrackingDataReader()
+{
+    close();
+}
+
+bool TrackingDataReader::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+
+    hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(hFile, &fileSize);
+    dataSize = fileSize.QuadPart;
+
+    hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL) { close(); return false; }
+
+    data = (const unsigned char*) MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+#else
+
+    fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) { return false; }
+
+    struct stat fileStatus;
+    fstat(fileDescriptor, &fileStatus);
+    dataSize = fileStatus.st_size;
+
+    void* mapping = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) { close(); return false; }
+
+    data = (const unsigned char*) mapping;
+
+#endif
+
+    if (data == NULL || !readHeaders()) { close(); return false; }
+
+    return true;
+}
+
+bool TrackingDataReader::readHeaders()
+{
+    if (dataSize < sizeof(trackingFileHeader)) { return false; }
+
+    std::memcpy(&mHeader, data, sizeof(mHeader));
+
+    if (std::memcmp(mHeader.magic, trackingFileMagic, sizeof(mHeader.magic)) != 0) { return false; }
+    if (sizeof(trackingFileHeader) + mHeader.columnTotal * sizeof(trackingColumnHeader) > dataSize) { return false; }
+
+    for (int iColumn = 0; iColumn < (int) mHeader.columnTotal; iColumn++)
+    {
+        trackingColumnHeader mColumnHeader;
+        std::memcpy(&mColumnHeader, data + sizeof(trackingFileHeader) + iColumn * sizeof(trackingColumnHeader), sizeof(mColumnHeader));
+        mColumnHeader.name[sizeof(mColumnHeader.name) - 1] = 0;
+
+        trackingColumn mColumn;
+        mColumn.RAGGED     = mColumnHeader.RAGGED;
+        mColumn.type       = mColumnHeader.type;
+        mColumn.valueTotal = mColumnHeader.valueTotal;
+        mColumn.values     = data + mColumnHeader.valueOffset;
+        mColumn.rowStarts  = NULL;
+
+        if (mColumnHeader.valueOffset + mColumn.valueTotal * getTypeSize(mColumn.type) > dataSize) { return false; } // truncated file
+
+        if (mColumn.RAGGED)
+        {
+            if (mColumnHeader.rowStartOffset + (mHeader.sampleTotal + 1) * sizeof(uint64_t) > dataSize) { return false; }
+            mColumn.rowStarts = reinterpret_cast<const uint64_t*>(data + mColumnHeader.rowStartOffset);
+
+            // Rows must cover the values in order, so that no row reaches outside the column
+
+            if (mColumn.rowStarts[0] != 0 || mColumn.rowStarts[mHeader.sampleTotal] != mColumn.valueTotal) { return false; }
+
+            for (uint64_t iSample = 0; iSample < mHeader.sampleTotal; iSample++)
+            {
+                if (mColumn.rowStarts[iSample] > mColumn.rowStarts[iSample + 1]) { return false; }
+            }
+        }
+        else if (mColumn.valueTotal != mHeader.sampleTotal) { return false; }
+
+        mColumns[mColumnHeader.name] = mColumn;
+    }
+
+    return true;
+}
+
+bool TrackingDataReader::getColumn(const std::string& name, trackingColumn& mColumn) const
+{
+    auto it = mColumns.find(name);
+    if (it == mColumns.end()) { return false; }
+    mColumn = it->second;
+    return true;
+}
+
+std::vector<std::string> TrackingDataReader::getColumnNames() const
+{
+    std::vector<std::string> vNames;
+    for (auto it = mColumns.begin(); it != mColumns.end(); it++) { vNames.push_back(it->first); }
+    return vNames;
+}
+
+bool TrackingDataReader::isOpen() const { return (data != NULL); }
+
+double TrackingDataReader::getSamplingRate() const { return mHeader.samplingRate; }
+
+int TrackingDataReader::getSampleTotal() const { return mHeader.sampleTotal; }
+
+int TrackingDataReader::getTrialIndex() const { return mHeader.trialIndex; }
+
+long long TrackingDataReader::getSystemTime() const { return mHeader.systemTime; }
+
+void TrackingDataReader::close()
+{
+#ifdef _WIN32
+    if (data != NULL)                  { UnmapViewOfFile(data); }
+    if (hMapping != NULL)              { CloseHandle(hMapping); }
+    if (hFile != INVALID_HANDLE_VALUE) { CloseHandle(hFile); }
+    hMapping = NULL;
+    hFile    = INVALID_HANDLE_VALUE;
+#else
+    if (data != NULL)        { munmap((void*) data, dataSize); }
+    if (fileDescriptor >= 0) { ::close(fileDescriptor); }
+    fileDescriptor = -1;
+#endif
+
+    data     = NULL;
+    dataSize = 0;
+    mColumns.clear();
+    std::memset(&mHeader, 0, sizeof(mHeader));
+}
+
+// Data set
+
+bool TrackingDataSet::open(const std::string& indexFilename)
+{
+    vSampleStarts.clear();
+    vTrials.clear();
+
+    std::ifstream file(indexFilename);
+    if (!file.is_open()) { return false; }
+
+    boost::filesystem::path indexDirectory = boost::filesystem::path(indexFilename).parent_path();
+
+    int sampleTotal = 0;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty()) { continue; }
+
+        boost::filesystem::path dataPath(line);
+        if (dataPath.is_relative()) { dataPath = indexDirectory / dataPath; }
+
+        std::unique_ptr<TrackingDataReader> mReader(new TrackingDataReader);
+        if (!mReader->open(dataPath.string())) { continue; } // trial was removed
+
+        vSampleStarts.push_back(sampleTotal);
+        sampleTotal += mReader->getSampleTotal();
+        vTrials.push_back(std::move(mReader));
+    }
+
+    vSampleStarts.push_back(sampleTotal);
+
+    return true;
+}
+
+const TrackingDataReader& TrackingDataSet::getTrial(int trialNumber) const { return *vTrials[trialNumber]; }
+
+int TrackingDataSet::getSampleStart(int trialNumber) const { return vSampleStarts[trialNumber]; }
+
+int TrackingDataSet::getSampleTotal() const { return vSampleStarts.empty() ? 0 : vSampleStarts.back(); }
+
+int TrackingDataSet::getTrialTotal() const { return vTrials.size(); }
+
+bool appendTrackingIndex(const std::string& indexFilename, const std::vector<std::string>& dataFilenames)
+{
+    std::ofstream file(indexFilename, std::ios::app);
+    if (!file.is_open()) { return false; }
+
+    boost::filesystem::path indexPath = boost::filesystem::absolute(boost::filesystem::path(indexFilename).parent_path());
+
+    for (int iFile = 0; iFile < (int) dataFilenames.size(); iFile++)
+    {
+        // Relative paths are relative to the index directory. Paths inside it are stored relative to it, so that the
+        // directory can be moved
+
+        std::string dataPath       = boost::filesystem::absolute(dataFilenames[iFile], indexPath).string();
+        std::string indexDirectory = indexPath.string() + "/";
+
+        if (dataPath.compare(0, indexDirectory.size(), indexDirectory) == 0) { file << dataPath.substr(indexDirectory.size()) << "\n"; }
+        else                                                                 { file << dataPath << "\n"; }
+    }
+
+    return file.good();
+}
+
+// Columns of tracking results
+
+void addDataColumns(TrackingDataWriter& mWriter, const std::string& prefix, const std::vector<dataVariables>& vDataVariables, int sampleTotal)
+{
+    std::vector<uint8_t> vDetected(sampleTotal);
+    std::vector<uint8_t> vBlink(sampleTotal);
+    std::vector<double> vXPos(sampleTotal);
+    std::vector<double> vYPos(sampleTotal);
+    std::vector<double> vCircumference(sampleTotal);
+    std::vector<double> vAspectRatio(sampleTotal);
+
+    for (int i = 0; i < sampleTotal; i++)
+    {
+        vDetected[i]      = vDataVariables[i].DETECTED;
+        vBlink[i]         = vDataVariables[i].BLINK;
+        vXPos[i]          = vDataVariables[i].absoluteXPos;
+        vYPos[i]          = vDataVariables[i].absoluteYPos;
+        vCircumference[i] = vDataVariables[i].exactCircumference;
+        vAspectRatio[i]   = vDataVariables[i].exactAspectRatio;
+    }
+
+    mWriter.addColumn(prefix + "detected",      vDetected);
+    mWriter.addColumn(prefix + "blink",         vBlink);
+    mWriter.addColumn(prefix + "x",             vXPos);
+    mWriter.addColumn(prefix + "y",             vYPos);
+    mWriter.addColumn(prefix + "circumference", vCircumference);
+    mWriter.addColumn(prefix + "aspect_ratio",  vAspectRatio);
+}
+
+void addExtraColumns(TrackingDataWriter& mWriter, const std::vector<dataVariables>& vDataVariables, const std::vector<detectionVariables>& vDetectionVariables, int sampleTotal)
+{
+    std::vector<std::vector<double>> vValues(9, std::vector<double>(sampleTotal));
+
+    for (int i = 0; i < sampleTotal; i++)
+    {
+        vValues[0][i] = vDetectionVariables[i].predictedXPos;
+        vValues[1][i] = vDetectionVariables[i].predictedYPos;
+        vValues[2][i] = vDetectionVariables[i].predictedCircumference;
+        vValues[3][i] = vDetectionVariables[i].predictedAspectRatio;
+        vValues[4][i] = vDetectionVariables[i].predictedCurvature;
+        vValues[5][i] = vDetectionVariables[i].predictedIntensity;
+        vValues[6][i] = vDetectionVariables[i].predictedGradient;
+        vValues[7][i] = vDetectionVariables[i].predictedAngle;
+        vValues[8][i] = vDataVariables[i].duration;
+    }
+
+    mWriter.addColumn("predicted_x",             vValues[0]);
+    mWriter.addColumn("predicted_y",             vValues[1]);
+    mWriter.addColumn("predicted_circumference", vValues[2]);
+    mWriter.addColumn("predicted_aspect_ratio",  vValues[3]);
+    mWriter.addColumn("predicted_curvature",     vValues[4]);
+    mWriter.addColumn("predicted_intensity",     vValues[5]);
+    mWriter.addColumn("predicted_gradient",      vValues[6]);
+    mWriter.addColumn("predicted_angle",         vValues[7]);
+    mWriter.addColumn("duration",                vValues[8]);
+}
+
+void addEdgeColumns(TrackingDataWriter& mWriter, const DiagnosticsArena& mDiagnosticsArena, int sampleTotal)
+{
+    std::vector<uint64_t> vRowStarts(sampleTotal + 1, 0);
+    std::vector<int32_t> vTag;
+    std::vector<std::vector<double>> vValues(8);
+
+    for (int i = 0; i < sampleTotal; i++)
+    {
+        vRowStarts[i] = vTag.size();
+
+        int edgeTotal;
+        const edgeSummary* vEdgeData = mDiagnosticsArena.getEdgeData(i, edgeTotal);
+
+        for (int j = 0; j < edgeTotal; j++)
+        {
+            vTag.push_back(vEdgeData[j].tag);
+            vValues[0].push_back(vEdgeData[j].curvature);
+            vValues[1].push_back(vEdgeData[j].curvatureMax);
+            vValues[2].push_back(vEdgeData[j].curvatureMin);
+            vValues[3].push_back(vEdgeData[j].length);
+            vValues[4].push_back(vEdgeData[j].radius);
+            vValues[5].push_back(vEdgeData[j].radiusVar);
+            vValues[6].push_back(vEdgeData[j].intensity);
+            vValues[7].push_back(vEdgeData[j].gradient);
+        }
+    }
+
+    vRowStarts[sampleTotal] = vTag.size();
+
+    mWriter.addRaggedColumn("edge_tag",           vTag,       vRowStarts);
+    mWriter.addRaggedColumn("edge_curvature",     vValues[0], vRowStarts);
+    mWriter.addRaggedColumn("edge_curvature_max", vValues[1], vRowStarts);
+    mWriter.addRaggedColumn("edge_curvature_min", vValues[2], vRowStarts);
+    mWriter.addRaggedColumn("edge_length",        vValues[3], vRowStarts);
+    mWriter.addRaggedColumn("edge_radius",        vValues[4], vRowStarts);
+    mWriter.addRaggedColumn("edge_radius_var",    vValues[5], vRowStarts);
+    mWriter.addRaggedColumn("edge_intensity",     vValues[6], vRowStarts);
+    mWriter.addRaggedColumn("edge_gradient",      vValues[7], vRowStarts);
+}
+
+void addFitColumns(TrackingDataWriter& mWriter, const DiagnosticsArena& mDiagnosticsArena, int sampleTotal)
+{
+    std::vector<uint64_t> vRowStarts(sampleTotal + 1, 0);
+    std::vector<int32_t> vTag;
+    std::vector<std::vector<double>> vValues(8);
+
+    for (int i = 0; i < sampleTotal; i++)
+    {
+        vRowStarts[i] = vTag.size();
+
+        int ellipseTotal;
+        const ellipseSummary* vEllipseData = mDiagnosticsArena.getEllipseData(i, ellipseTotal);
+
+        for (int j = 0; j < ellipseTotal; j++)
+        {
+            vTag.push_back(vEllipseData[j].tag);
+            vValues[0].push_back(vEllipseData[j].xPos);
+            vValues[1].push_back(vEllipseData[j].yPos);
+            vValues[2].push_back(vEllipseData[j].circumference);
+            vValues[3].push_back(vEllipseData[j].aspectRatio);
+            vValues[4].push_back(vEllipseData[j].fitError);
+            vValues[5].push_back(vEllipseData[j].edgeLength);
+            vValues[6].push_back(vEllipseData[j].angle);
+            vValues[7].push_back(vEllipseData[j].edgeScore);
+        }
+    }
+
+    vRowStarts[sampleTotal] = vTag.size();
+
+    mWriter.addRaggedColumn("fit_tag",           vTag,       vRowStarts);
+    mWriter.addRaggedColumn("fit_x",             vValues[0], vRowStarts);
+    mWriter.addRaggedColumn("fit_y",             vValues[1], vRowStarts);
+    mWriter.addRaggedColumn("fit_circumference", vValues[2], vRowStarts);
+    mWriter.addRaggedColumn("fit_aspect_ratio",  vValues[3], vRowStarts);
+    mWriter.addRaggedColumn("fit_error",         vValues[4], vRowStarts);
+    mWriter.addRaggedColumn("fit_edge_length",   vValues[5], vRowStarts);
+    mWriter.addRaggedColumn("fit_angle",         vValues[6], vRowStarts);
+    mWriter.addRaggedColumn("fit_edge_score",    vValues[7], vRowStarts);
+}
+
+void addStageColumns(TrackingDataWriter& mWriter, const std::vector<dataVariables>& vDataVariables, int sampleTotal)
+{
+#ifdef EYESTALKER_PROFILING
+    for (int iStage = 0; iStage < STAGE_TOTAL; iStage++)
+    {
+        std::vector<int32_t> vDurations(sampleTotal);
+        for (int i = 0; i < sampleTotal; i++) { vDurations[i] = vDataVariables[i].stageDuration.nanoseconds[iStage]; }
+        mWriter.addColumn(std::string("stage_") + getStageName(iStage), vDurations);
+    }
+#else
+    (void) mWriter; (void) vDataVariables; (void) sampleTotal;
+#endif
+}
@@ -0,0 +1,198 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TRACKINGDATA_H
+#define TRACKINGDATA_H
+
+// Files
+
+#include "diagnosticsarena.h"
+#include "stageprofiler.h"
+#include "structures.h"
+
+// Standard Template
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Boost
+
+#include <boost/filesystem.hpp>
+
+// Memory mapping
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Binary tracking data of one trial (trial_N/tracking_data.esd), next to or instead of the ASCII files.
+//
+// Layout: file header, followed by one header per column, followed by the column data. Every column holds one
+// value per sample, except ragged columns (per-edge and per-fit data), which hold any number of values per sample
+// and an array with the index of the first value of every sample (sample total + 1 entries). Column data starts
+// at a multiple of 8 bytes, so a reader can use it in place.
+//
+// Trials, also of different sessions, are combined through an index file that lists the data files,
+// instead of copying their data into one file.
+
+const char trackingFileMagic[8] = {'E', 'S', 'T', 'K', 'D', 'A', 'T', '1'};
+const std::string trackingDataFilename = "tracking_data.esd";
+
+enum trackingColumnType
+{
+    COLUMN_UINT8   = 0,
+    COLUMN_INT32   = 1,
+    COLUMN_FLOAT64 = 2
+};
+
+struct trackingFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t columnTotal;
+    uint64_t sampleTotal;
+    int64_t  systemTime;   // of trial start (ms)
+    int32_t  trialIndex;
+    uint32_t reserved;
+    double   samplingRate; // 0 if unknown
+    uint8_t  padding[16];
+};
+
+struct trackingColumnHeader
+{
+    char     name[32];
+    uint32_t type;
+    uint32_t RAGGED;
+    uint64_t valueOffset;
+    uint64_t valueTotal;
+    uint64_t rowStartOffset; // ragged columns only
+};
+
+struct trackingColumn
+{
+    bool RAGGED;
+    int type;
+    const void* values;        // points into mapped file
+    const uint64_t* rowStarts; // index of first value of each sample, ragged columns only
+    uint64_t valueTotal;
+};
+
+class TrackingDataWriter
+{
+
+public:
+
+    TrackingDataWriter();
+
+    bool save(const std::string& filename, int trialIndex, long long systemTime, double samplingRate, int sampleTotal) const;
+    void addColumn(const std::string& name, const std::vector<uint8_t>&);
+    void addColumn(const std::string& name, const std::vector<int32_t>&);
+    void addColumn(const std::string& name, const std::vector<double>&);
+    void addRaggedColumn(const std::string& name, const std::vector<int32_t>&, const std::vector<uint64_t>& rowStarts);
+    void addRaggedColumn(const std::string& name, const std::vector<double>&,  const std::vector<uint64_t>& rowStarts);
+
+private:
+
+    struct columnData
+    {
+        bool RAGGED;
+        int type;
+        std::string name;
+        std::vector<unsigned char> values;
+        std::vector<uint64_t> rowStarts;
+    };
+
+    std::vector<columnData> vColumns;
+
+    void addColumnData(const std::string& name, int type, const void* values, size_t size, const std::vector<uint64_t>* rowStarts);
+};
+
+class TrackingDataReader
+{
+
+public:
+
+    TrackingDataReader();
+    ~TrackingDataReader();
+
+    bool getColumn(const std::string& name, trackingColumn&) const; // false if column is missing
+    bool isOpen() const;
+    bool open(const std::string& filename);
+    double getSamplingRate() const;
+    int getSampleTotal() const;
+    int getTrialIndex() const;
+    long long getSystemTime() const;
+    std::vector<std::string> getColumnNames() const;
+    void close();
+
+private:
+
+    const unsigned char* data;
+    size_t dataSize;
+
+#ifdef _WIN32
+    HANDLE hFile;
+    HANDLE hMapping;
+#else
+    int fileDescriptor;
+#endif
+
+    trackingFileHeader mHeader;
+    std::map<std::string, trackingColumn> mColumns;
+
+    bool readHeaders();
+};
+
+// Several trials as one data set, through an index file (one data file per line, relative to index file)
+
+class TrackingDataSet
+{
+
+public:
+
+    bool open(const std::string& indexFilename);
+    const TrackingDataReader& getTrial(int trialNumber) const;
+    int getSampleStart(int trialNumber) const; // of trial in concatenated samples
+    int getSampleTotal() const;
+    int getTrialTotal() const;
+
+private:
+
+    std::vector<int> vSampleStarts;
+    std::vector<std::unique_ptr<TrackingDataReader>> vTrials;
+};
+
+bool appendTrackingIndex(const std::string& indexFilename, const std::vector<std::string>& dataFilenames); // entries are added to existing index, relative names are relative to index directory
+
+// Columns of tracking results, 'prefix' distinguishes tracked objects in the same file
+
+void addDataColumns (TrackingDataWriter&, const std::string& prefix, const std::vector<dataVariables>&, int sampleTotal);
+void addEdgeColumns (TrackingDataWriter&, const DiagnosticsArena&, int sampleTotal);
+void addExtraColumns(TrackingDataWriter&, const std::vector<dataVariables>&, const std::vector<detectionVariables>&, int sampleTotal);
+void addFitColumns  (TrackingDataWriter&, const DiagnosticsArena&, int sampleTotal);
+void addStageColumns(TrackingDataWriter&, const std::vector<dataVariables>&, int sampleTotal); // ns per stage, only in profiling builds
+
+#endif // TRACKINGDATA_H
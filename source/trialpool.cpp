@@ -0,0 +1,222 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "trialpool.h"
+
+namespace
+{
+
+unsigned long long getTrialSize(const std::string& sessionDirectory, int trialIndex) // without opening the trial
+{
+    std::stringstream trialDirectory;
+    trialDirectory << sessionDirectory << "/images/trial_" << trialIndex;
+
+    boost::system::error_code errorCode;
+
+    unsigned long long trialSize = boost::filesystem::file_size(trialDirectory.str() + "/" + frameContainerFilename, errorCode);
+    if (!errorCode) { return trialSize; }
+
+    trialSize = 0; // one PNG per frame
+
+    boost::filesystem::directory_iterator iFile(trialDirectory.str() + "/raw", errorCode);
+    if (errorCode) { return 0; }
+
+    for (; iFile != boost::filesystem::directory_iterator(); iFile.increment(errorCode))
+    {
+        unsigned long long fileSize = boost::filesystem::file_size(iFile->path(), errorCode);
+        if (!errorCode) { trialSize += fileSize; }
+    }
+
+    return trialSize;
+}
+
+}
+
+TrialPool::TrialPool()
+{
+    POOL_ACTIVE    = false;
+    threadsRunning = 0;
+    trialsTotal    = 0;
+}
+
+TrialPool::~TrialPool()
+{
+    stop();
+    wait();
+}
+
+void TrialPool::addTrial(const std::string& sessionDirectory, int trialIndex)
+{
+    trialTask mTask;
+    mTask.trialSize        = 0;
+    mTask.trialIndex       = trialIndex;
+    mTask.sessionDirectory = sessionDirectory;
+    vTasks.push_back(mTask);
+}
+
+void TrialPool::start(const trialTrackerSettings& mSettingsNew, int numberOfThreads)
+{
+    wait(); // previous batch
+
+    mSettings = mSettingsNew;
+
+    if (numberOfThreads < 1) { numberOfThreads = std::max((int) std::thread::hardware_concurrency(), 1); } // all cores
+
+    int threadTotal = numberOfThreads; // trials and chunks together
+
+    if (numberOfThreads > (int) vTasks.size()) { numberOfThreads = std::max((int) vTasks.size(), 1); }
+
+    mThreadBudget.reset(threadTotal - numberOfThreads); // trial threads return their core when they run out of trials
+
+    // Longest trials first, so that the shortest ones are left to fill up the gaps at the end. Trials are ranked
+    // by their size on disk, so that they do not all have to be opened before tracking starts.
+
+    for (int iTask = 0; iTask < (int) vTasks.size(); iTask++)
+    {
+        vTasks[iTask].trialSize = getTrialSize(vTasks[iTask].sessionDirectory, vTasks[iTask].trialIndex);
+
+        if (mTimestamps.find(vTasks[iTask].sessionDirectory) == mTimestamps.end())
+        {   mTimestamps[vTasks[iTask].sessionDirectory] = loadTimestamps(vTasks[iTask].sessionDirectory); }
+    }
+
+    std::stable_sort(vTasks.begin(), vTasks.end(), [](const trialTask& a, const trialTask& b) { return a.trialSize > b.trialSize; });
+
+    vQueues.clear();
+    for (int iThread = 0; iThread < numberOfThreads; iThread++) { vQueues.push_back(std::unique_ptr<workerQueue>(new workerQueue)); }
+    for (int iTask = 0; iTask < (int) vTasks.size(); iTask++) { vQueues[iTask % numberOfThreads]->qTasks.push_back(vTasks[iTask]); }
+
+    trialsTotal = vTasks.size();
+    vTasks.clear();
+    vResults.clear();
+
+    POOL_ACTIVE    = true;
+    threadsRunning = numberOfThreads;
+
+    for (int iThread = 0; iThread < numberOfThreads; iThread++) { vThreads.push_back(std::thread(&TrialPool::threadWorker, this, iThread)); }
+}
+
+bool TrialPool::getTask(int threadIndex, trialTask& mTask)
+{
+    { std::lock_guard<std::mutex> resultsLock(resultsMutex);
+        if (!POOL_ACTIVE) { return false; }
+    }
+
+    { std::lock_guard<std::mutex> queueLock(vQueues[threadIndex]->queueMutex);
+        std::deque<trialTask>& qTasks = vQueues[threadIndex]->qTasks;
+
+        if (!qTasks.empty())
+        {
+            mTask = qTasks.front(); // longest trial of own queue
+            qTasks.pop_front();
+            return true;
+        }
+    }
+
+    for (int iOffset = 1; iOffset < (int) vQueues.size(); iOffset++)
+    {
+        int victimIndex = (threadIndex + iOffset) % vQueues.size();
+
+        { std::lock_guard<std::mutex> queueLock(vQueues[victimIndex]->queueMutex);
+            std::deque<trialTask>& qTasks = vQueues[victimIndex]->qTasks;
+
+            if (!qTasks.empty())
+            {
+                mTask = qTasks.back(); // shortest trial of other queue
+                qTasks.pop_back();
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void TrialPool::threadWorker(int threadIndex)
+{
+    trialTask mTask;
+
+    while (getTask(threadIndex, mTask))
+    {
+        trialPoolResult mResult;
+        mResult.SUCCESS          = false;
+        mResult.duration         = 0;
+        mResult.imageTotal       = 0;
+        mResult.trialIndex       = mTask.trialIndex;
+        mResult.sessionDirectory = mTask.sessionDirectory;
+
+        TrialTracker mTrialTracker; // own detection variables and output buffers
+
+        if (mTrialTracker.open(mTask.sessionDirectory, mTask.trialIndex))
+        {
+            auto t1 = std::chrono::steady_clock::now();
+            mTrialTracker.track(mSettings, &mThreadBudget);
+            auto t2 = std::chrono::steady_clock::now();
+
+            std::vector<double> timestamps;
+            const std::vector<std::vector<double>>& timeMatrix = mTimestamps.find(mTask.sessionDirectory)->second; // read-only while threads run
+            if (mTask.trialIndex < (int) timeMatrix.size()) { timestamps = timeMatrix[mTask.trialIndex]; }
+
+            mResult.SUCCESS    = mTrialTracker.saveData(mSettings, timestamps);
+            mResult.duration   = std::chrono::duration<double>(t2 - t1).count();
+            mResult.imageTotal = mTrialTracker.getImageTotal();
+        }
+
+        { std::lock_guard<std::mutex> resultsLock(resultsMutex);
+            vResults.push_back(mResult);
+        }
+    }
+
+    mThreadBudget.release(1);
+
+    { std::lock_guard<std::mutex> resultsLock(resultsMutex);
+        threadsRunning--;
+    }
+}
+
+void TrialPool::stop()
+{
+    std::lock_guard<std::mutex> resultsLock(resultsMutex);
+    POOL_ACTIVE = false;
+}
+
+void TrialPool::wait()
+{
+    for (int iThread = 0; iThread < (int) vThreads.size(); iThread++) { vThreads[iThread].join(); }
+    vThreads.clear();
+
+    std::lock_guard<std::mutex> resultsLock(resultsMutex);
+    POOL_ACTIVE = false;
+}
+
+bool TrialPool::isFinished()
+{
+    std::lock_guard<std::mutex> resultsLock(resultsMutex);
+    return (threadsRunning == 0);
+}
+
+int TrialPool::getTrialsDone()
+{
+    std::lock_guard<std::mutex> resultsLock(resultsMutex);
+    return vResults.size();
+}
+
+int TrialPool::getTrialsTotal() const { return trialsTotal; }
+
+std::vector<trialPoolResult> TrialPool::getResults()
+{
+    std::lock_guard<std::mutex> resultsLock(resultsMutex);
+    return vResults;
+}
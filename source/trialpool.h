@@ -0,0 +1,101 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TRIALPOOL_H
+#define TRIALPOOL_H
+
+// Files
+
+#include "trialtracker.h"
+
+// Standard Template
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct trialPoolResult
+{
+    bool SUCCESS;
+    double duration; // in s
+    int imageTotal;
+    int trialIndex;
+    std::string sessionDirectory;
+};
+
+// Tracks many trials at once, one trial per thread. Trials are independent of each other, since tracker state is reset at
+// the start of every trial, so each thread tracks whole trials with its own TrialTracker and saves their data itself.
+// Trials are dealt out largest first over per-thread queues, and a thread that runs out of work steals the shortest
+// trial left in another queue, so that a few long trials do not keep one core busy while the others are idle.
+
+class TrialPool
+{
+
+public:
+
+    TrialPool();
+    ~TrialPool();
+
+    bool isFinished();
+    int getTrialsDone();
+    int getTrialsTotal() const;
+    std::vector<trialPoolResult> getResults(); // of finished trials
+    void addTrial(const std::string& sessionDirectory, int trialIndex); // before 'start'
+    void start(const trialTrackerSettings&, int numberOfThreads); // 0 uses all cores, cores left over by trials go to chunks
+    void stop(); // trials in progress are completed, remaining trials are skipped
+    void wait();
+
+private:
+
+    struct trialTask
+    {
+        unsigned long long trialSize; // bytes of raw frames on disk, stands in for trial length
+        int trialIndex;
+        std::string sessionDirectory;
+    };
+
+    struct workerQueue
+    {
+        std::deque<trialTask> qTasks;
+        std::mutex queueMutex;
+    };
+
+    bool POOL_ACTIVE;
+
+    int threadsRunning;
+    int trialsTotal;
+
+    std::map<std::string, std::vector<std::vector<double>>> mTimestamps; // per session
+    std::mutex resultsMutex;
+    std::vector<std::unique_ptr<workerQueue>> vQueues;
+    std::vector<std::thread> vThreads;
+    std::vector<trialPoolResult> vResults;
+    std::vector<trialTask> vTasks;
+
+    ThreadBudget mThreadBudget; // cores not used by a trial thread, taken by chunks
+    trialTrackerSettings mSettings;
+
+    bool getTask(int threadIndex, trialTask& mTask);
+    void threadWorker(int threadIndex);
+};
+
+#endif // TRIALPOOL_H
@@ -0,0 +1,731 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "trialtracker.h"
+
+bool loadTrialTrackerSettings(const std::string& filename, trialTrackerSettings& mSettings)
+{
+    SettingsFile settings;
+    bool FILE_FOUND = settings.load(filename);
+
+    // Same keys and defaults as GUI
+
+    const std::string prefix = "Eye";
+    const std::vector<double>& parameters = parametersEye;
+
+    detectionParameters mDetectionParameters;
+    mDetectionParameters.gainAverages                       = settings.getDouble(prefix + "GainAverage",                parameters[ 0]);
+    mDetectionParameters.gainAppearance                     = settings.getDouble(prefix + "GainAppearance",             parameters[ 1]);
+    mDetectionParameters.gainCertainty                      = settings.getDouble(prefix + "GainCertainty",              parameters[ 2]);
+    mDetectionParameters.gainPosition                       = settings.getDouble(prefix + "GainPosition",               parameters[ 3]);
+    mDetectionParameters.cannyBlurLevel                     = settings.getInt   (prefix + "CannyBlurLevel",             parameters[ 4]);
+    mDetectionParameters.cannyKernelSize                    = settings.getInt   (prefix + "CannyKernelSize",            parameters[ 5]);
+    mDetectionParameters.cannyThresholdLow                  = settings.getDouble(prefix + "CannyThresholdLow",          parameters[ 6]);
+    mDetectionParameters.cannyThresholdHigh                 = settings.getDouble(prefix + "CannyThresholdHigh",         parameters[ 7]);
+    mDetectionParameters.curvatureOffset                    = settings.getDouble(prefix + "CurvatureOffset",            parameters[ 8]);
+    mDetectionParameters.fitEdgeFraction                    = settings.getDouble(prefix + "FitEdgeFraction",            parameters[ 9]);
+    mDetectionParameters.fitEdgeMaximum                     = settings.getInt   (prefix + "FitEdgeMaximum",             parameters[10]);
+    mDetectionParameters.thresholdFitError                  = settings.getDouble(prefix + "ThresholdFitError",          parameters[11]);
+    mDetectionParameters.glintWdth                          = settings.getInt   (prefix + "GlintSize",                  parameters[12]);
+    mDetectionParameters.thresholdCircumferenceMax          = settings.getDouble(prefix + "CircumferenceMax",           parameters[13]);
+    mDetectionParameters.thresholdCircumferenceMin          = settings.getDouble(prefix + "CircumferenceMin",           parameters[14]);
+    mDetectionParameters.thresholdAspectRatioMin            = settings.getDouble(prefix + "AspectRatioMin",             parameters[15]);
+    mDetectionParameters.thresholdChangeCircumferenceUpper  = settings.getDouble(prefix + "CircumferenceChangeUpper",   parameters[16]);
+    mDetectionParameters.thresholdChangeCircumferenceLower  = settings.getDouble(prefix + "CircumferenceChangeLower",   parameters[17]);
+    mDetectionParameters.thresholdChangeAspectRatioUpper    = settings.getDouble(prefix + "AspectRatioChangeUpper",     parameters[18]);
+    mDetectionParameters.thresholdChangeAspectRatioLower    = settings.getDouble(prefix + "AspectRatioChangeLower",     parameters[19]);
+    mDetectionParameters.thresholdChangePositionUpper       = settings.getDouble(prefix + "PositionChangeUpper",        parameters[20]);
+    mDetectionParameters.thresholdChangePositionLower       = settings.getDouble(prefix + "PositionChangeLower",        parameters[21]);
+    mDetectionParameters.thresholdScoreEdge                 = settings.getDouble(prefix + "ScoreThresholdEdge",         parameters[22]);
+    mDetectionParameters.thresholdScoreFit                  = settings.getDouble(prefix + "ScoreThresholdFit",          parameters[23]);
+    mDetectionParameters.thresholdScoreDiffEdge             = settings.getDouble(prefix + "ScoreThresholdDiffEdge",     parameters[24]);
+    mDetectionParameters.thresholdScoreDiffFit              = settings.getDouble(prefix + "ScoreThresholdDiffFit",      parameters[25]);
+    mDetectionParameters.windowLengthEdge                   = settings.getDouble(prefix + "WindowLengthEdge",           parameters[26]);
+    mDetectionParameters.fitMaximum                         = settings.getDouble(prefix + "FitMaximum",                 parameters[27]);
+    mDetectionParameters.thresholdBlinkContrast             = settings.getDouble(prefix + "BlinkContrast",              parameters[28]);
+    mDetectionParameters.circumferenceScaled                = settings.getDouble(prefix + "CircumferenceScaled",        parameters[29]);
+
+    mSettings.mDetectionParameters = mDetectionParameters;
+    mSettings.cameraFrameRate      = settings.getDouble(prefix + "CameraFrameRate", 250);
+
+    mSettings.eyeAOIRatio.xPos = settings.getDouble("AOIXPosRatio", 0.0);
+    mSettings.eyeAOIRatio.yPos = settings.getDouble("AOIYPosRatio", 0.0);
+    mSettings.eyeAOIRatio.hght = settings.getDouble("AOIHghtRatio", 1.0);
+    mSettings.eyeAOIRatio.wdth = settings.getDouble("AOIWdthRatio", 1.0);
+
+    mSettings.SAVE_ASPECT_RATIO  = settings.getBool("SaveAspectRatio",   true);
+    mSettings.SAVE_CIRCUMFERENCE = settings.getBool("SaveCircumference", true);
+    mSettings.SAVE_POSITION      = settings.getBool("SavePosition",      true);
+    mSettings.SAVE_SAMPLING_RATE = false;
+
+    mSettings.SAVE_DATA_ASCII = settings.getBool("SaveDataASCII", true);
+    mSettings.SAVE_DATA_EDGE  = false;
+    mSettings.SAVE_DATA_EXTRA = false;
+    mSettings.SAVE_DATA_FIT   = false;
+
+    mSettings.chunkTotal   = settings.getInt("OfflineChunks",       1);
+    mSettings.chunkOverlap = settings.getInt("OfflineChunkOverlap", 500);
+
+    mSettings.mAdvancedOptions = developmentOptions{};
+
+    return FILE_FOUND;
+}
+
+int countTrials(const std::string& sessionDirectory)
+{
+    int trialTotal = 0;
+
+    while (1)
+    {
+        std::stringstream folderName;
+        folderName << sessionDirectory
+                   << "/images/trial_"
+                   << trialTotal;
+        if (!boost::filesystem::exists(folderName.str())) { break; }
+        trialTotal++;
+    }
+
+    return trialTotal;
+}
+
+std::vector<std::vector<double>> loadTimestamps(const std::string& sessionDirectory)
+{
+    std::vector<std::vector<double>> timeMatrix;
+
+    std::ifstream data;
+    data.open(sessionDirectory + "/images/timestamps.dat");
+
+    std::string str;
+
+    while (std::getline(data, str))
+    {
+        std::vector<double> times;
+        std::istringstream sin(str);
+        double time;
+        while (sin >> time) { times.push_back(time); }
+        timeMatrix.push_back(times);
+    }
+
+    return timeMatrix;
+}
+
+// Thread budget
+
+ThreadBudget::ThreadBudget()
+{
+    slotsFree = 0;
+}
+
+int ThreadBudget::acquire(int slotsWanted)
+{
+    std::lock_guard<std::mutex> budgetLock(budgetMutex);
+
+    int slots = std::max(0, std::min(slotsWanted, slotsFree));
+    slotsFree -= slots;
+    return slots;
+}
+
+void ThreadBudget::release(int slots)
+{
+    std::lock_guard<std::mutex> budgetLock(budgetMutex);
+    slotsFree += slots;
+}
+
+void ThreadBudget::reset(int slotsFreeNew)
+{
+    std::lock_guard<std::mutex> budgetLock(budgetMutex);
+    slotsFree = std::max(0, slotsFreeNew);
+}
+
+TrialTracker::TrialTracker()
+{
+    imageTotal = 0;
+    trialIndex = 0;
+}
+
+bool TrialTracker::open(const std::string& sessionDirectory, int trialIndexNew)
+{
+    std::stringstream directoryName;
+    directoryName << sessionDirectory
+                  << "/images/trial_"
+                  << trialIndexNew;
+
+    trialDirectory = directoryName.str();
+    imageTotal = 0;
+
+    trialIndex = trialIndexNew;
+
+    vChunkBoundaries.clear();
+    vDataVariables.clear();
+    vDetectionVariables.clear();
+    mDiagnosticsArena.clear();
+
+    if (mFrameContainerReader.open(trialDirectory + "/" + frameContainerFilename)) // all frames of trial in one file
+    {
+        imageTotal = mFrameContainerReader.getFrameCount();
+        return (imageTotal > 0);
+    }
+
+    while (1)
+    {
+        std::stringstream filename;
+        filename << trialDirectory
+                 << "/raw/"
+                 << imageTotal
+                 << ".png";
+
+        if (!boost::filesystem::exists(filename.str())) { break; }
+        imageTotal++;
+    }
+
+    return (imageTotal > 0);
+}
+
+int TrialTracker::getImageTotal() const { return imageTotal; }
+
+std::vector<chunkBoundary> TrialTracker::getChunkBoundaries() const { return vChunkBoundaries; }
+
+cv::Mat TrialTracker::loadImageRaw(int imageIndex) const
+{
+    if (mFrameContainerReader.isOpen()) { return mFrameContainerReader.getFrame(imageIndex); } // recordings are saved in grayscale
+
+    std::stringstream imagePath;
+    imagePath << trialDirectory
+              << "/raw/"
+              << imageIndex
+              << ".png";
+
+    return cv::imread(imagePath.str(), CV_LOAD_IMAGE_GRAYSCALE);
+}
+
+void TrialTracker::track(const trialTrackerSettings& mSettings, ThreadBudget* mThreadBudget)
+{
+    vChunkBoundaries.clear();
+    vDataVariables.assign(imageTotal, dataVariables());
+    vDetectionVariables.assign(imageTotal + 1, detectionVariables());
+    mDiagnosticsArena.clear();
+
+    DiagnosticsArena* mDiagnosticsArenaUsed = NULL; // not kept if they are not saved
+    if (mSettings.SAVE_DATA_EDGE || mSettings.SAVE_DATA_FIT)
+    {
+        mDiagnosticsArena.resize(imageTotal);
+        mDiagnosticsArenaUsed = &mDiagnosticsArena;
+    }
+
+    if (imageTotal == 0) { return; }
+
+    // AOI is the same for all frames of trial
+
+    cv::Mat imageFirst = loadImageRaw(0);
+
+    AOIProperties camAOI;
+    camAOI.xPos = 0;
+    camAOI.yPos = 0;
+    camAOI.wdth = imageFirst.cols;
+    camAOI.hght = imageFirst.rows;
+
+    AOIProperties eyeAOI;
+    eyeAOI.wdth = round(camAOI.wdth * mSettings.eyeAOIRatio.wdth);
+    eyeAOI.hght = round(camAOI.hght * mSettings.eyeAOIRatio.hght);
+    eyeAOI.xPos = round(camAOI.wdth * mSettings.eyeAOIRatio.xPos);
+    eyeAOI.yPos = round(camAOI.hght * mSettings.eyeAOIRatio.yPos);
+    if (eyeAOI.xPos + eyeAOI.wdth > camAOI.wdth) { eyeAOI.xPos = camAOI.wdth - eyeAOI.wdth; }
+    if (eyeAOI.yPos + eyeAOI.hght > camAOI.hght) { eyeAOI.yPos = camAOI.hght - eyeAOI.hght; }
+
+    detectionParameters mDetectionParameters = mSettings.mDetectionParameters;
+    mDetectionParameters.cameraFrameRate = mSettings.cameraFrameRate;
+
+    if (mSettings.mAdvancedOptions.CURVATURE_MEASUREMENT)
+    {
+        mDetectionParameters.thresholdAspectRatioMin    = 0.0;
+        mDetectionParameters.thresholdCircumferenceMax  = M_PI * camAOI.wdth;
+        mDetectionParameters.thresholdCircumferenceMin  = 1.0; // 1.0 avoids inf
+        mDetectionParameters.thresholdScoreEdge         = 0.0;
+        mDetectionParameters.thresholdScoreFit          = 0.0;
+        mDetectionParameters.thresholdScoreDiffEdge     = 1.0;
+        mDetectionParameters.curvatureOffset            = 360;
+        mDetectionParameters.glintWdth                  = 0.0;
+        mDetectionParameters.thresholdBlinkContrast     = 0.0;
+        mDetectionParameters.circumferenceScaled        = 0.0;
+    }
+
+    mOverlayWriter.open(trialDirectory + "/" + overlayFilename, false); // detection of whole trial replaces previous overlays
+
+    int chunkTotal = std::min(mSettings.chunkTotal, imageTotal);
+
+    if (chunkTotal > 1)
+    {
+        trackChunks(eyeAOI, mDetectionParameters, mSettings.mAdvancedOptions, mDiagnosticsArenaUsed, mThreadBudget, chunkTotal, mSettings.chunkOverlap);
+    }
+    else
+    {
+        resetVariablesHard(vDetectionVariables[0], mDetectionParameters, eyeAOI);
+
+        for (int imageIndex = 0; imageIndex < imageTotal; imageIndex++)
+        {
+            trackFrame(imageIndex,
+                       eyeAOI,
+                       mDetectionParameters,
+                       mSettings.mAdvancedOptions,
+                       vDetectionVariables[imageIndex],
+                       vDataVariables[imageIndex],
+                       vDetectionVariables[imageIndex + 1],
+                       mDiagnosticsArenaUsed,
+                       true);
+        }
+    }
+
+    mOverlayWriter.close();
+}
+
+void TrialTracker::trackFrame(int imageIndex,
+                              const AOIProperties& eyeAOI,
+                              const detectionParameters& mDetectionParameters,
+                              const developmentOptions& mAdvancedOptions,
+                              const detectionVariables& mDetectionVariablesOld,
+                              dataVariables& mDataVariables,
+                              detectionVariables& mDetectionVariablesNew,
+                              DiagnosticsArena* mDiagnosticsArenaUsed,
+                              bool SAVE_OVERLAY)
+{
+    cv::Mat imageRaw = loadImageRaw(imageIndex);
+
+    diagnosticVariables mDiagnosticVariables;
+
+    if (imageRaw.empty()) // missing frame
+    {
+        mDataVariables         = dataVariables();
+        mDetectionVariablesNew = mDetectionVariablesOld;
+        if (mDiagnosticsArenaUsed != NULL) { mDiagnosticsArenaUsed->store(imageIndex, mDiagnosticVariables); }
+        return;
+    }
+
+    PreprocessedFrame mPreprocessedFrame(imageRaw);
+
+    detectionVariables mDetectionVariables = mDetectionVariablesOld; // copy, since input is modified by tracker
+    drawVariables mDrawVariables;
+
+    mDataVariables = dataVariables();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    mDetectionVariablesNew = eyeStalker(mPreprocessedFrame,
+                                        eyeAOI,
+                                        mDetectionVariables,
+                                        mDetectionParameters,
+                                        mDataVariables,
+                                        mDrawVariables,
+                                        mAdvancedOptions,
+                                        mDiagnosticsArenaUsed != NULL ? &mDiagnosticVariables : NULL);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> fp_ms = t2 - t1;
+
+    mDataVariables.duration     = fp_ms.count();
+    mDataVariables.absoluteXPos = mDataVariables.exactXPos;
+    mDataVariables.absoluteYPos = mDataVariables.exactYPos;
+
+    if (mDiagnosticsArenaUsed != NULL) { mDiagnosticsArenaUsed->store(imageIndex, mDiagnosticVariables); }
+
+    if (SAVE_OVERLAY) // records are appended in any order, last record of a frame counts
+    {
+        std::lock_guard<std::mutex> overlayLock(overlayMutex);
+        mOverlayWriter.addFrame(imageIndex, std::vector<drawVariables>(1, mDrawVariables));
+    }
+}
+
+// Chunked tracking
+
+namespace
+{
+
+const double chunkTolerance         = 0.5; // maximum difference (px) for estimates to agree
+const int    chunkConvergenceFrames = 5;   // consecutive frames that must agree
+
+bool isEstimateEqual(const dataVariables& mDataVariablesA, const detectionVariables& mDetectionVariablesA,
+                     const dataVariables& mDataVariablesB, const detectionVariables& mDetectionVariablesB)
+{
+    if (mDataVariablesA.DETECTED != mDataVariablesB.DETECTED) { return false; }
+
+    if (std::abs(mDetectionVariablesA.predictedXPos          - mDetectionVariablesB.predictedXPos)          > chunkTolerance) { return false; }
+    if (std::abs(mDetectionVariablesA.predictedYPos          - mDetectionVariablesB.predictedYPos)          > chunkTolerance) { return false; }
+    if (std::abs(mDetectionVariablesA.predictedCircumference - mDetectionVariablesB.predictedCircumference) > chunkTolerance) { return false; }
+
+    if (!mDataVariablesA.DETECTED) { return true; }
+
+    if (std::abs(mDataVariablesA.exactXPos          - mDataVariablesB.exactXPos)          > chunkTolerance) { return false; }
+    if (std::abs(mDataVariablesA.exactYPos          - mDataVariablesB.exactYPos)          > chunkTolerance) { return false; }
+    if (std::abs(mDataVariablesA.exactCircumference - mDataVariablesB.exactCircumference) > chunkTolerance) { return false; }
+
+    return true;
+}
+
+}
+
+void TrialTracker::trackChunks(const AOIProperties& eyeAOI,
+                               const detectionParameters& mDetectionParameters,
+                               const developmentOptions& mAdvancedOptions,
+                               DiagnosticsArena* mDiagnosticsArenaUsed,
+                               ThreadBudget* mThreadBudget,
+                               int chunkTotal,
+                               int chunkOverlap)
+{
+    int chunkLength = ceil(imageTotal / (double) chunkTotal);
+    chunkTotal      = ceil(imageTotal / (double) chunkLength);
+    chunkOverlap    = std::max(0, std::min(chunkOverlap, chunkLength));
+
+    // Track chunks in parallel, each from a hard reset at the start of its warm-up window. This thread tracks chunks
+    // itself and is joined by as many threads as the budget has free cores, which take chunks in order.
+
+    std::vector<int> vWarmUpIndex(chunkTotal);
+    std::vector<int> vStartIndex(chunkTotal);
+    std::vector<int> vEndIndex(chunkTotal);
+
+    std::vector<std::vector<dataVariables>>      vChunkDataVariables(chunkTotal);
+    std::vector<std::vector<detectionVariables>> vChunkDetectionVariables(chunkTotal);
+
+    for (int iChunk = 0; iChunk < chunkTotal; iChunk++)
+    {
+        vStartIndex[iChunk]  = iChunk * chunkLength;
+        vEndIndex[iChunk]    = std::min(imageTotal, vStartIndex[iChunk] + chunkLength);
+        vWarmUpIndex[iChunk] = std::max(0, vStartIndex[iChunk] - chunkOverlap);
+
+        int frameTotal = vEndIndex[iChunk] - vWarmUpIndex[iChunk];
+        vChunkDataVariables[iChunk].resize(frameTotal);
+        vChunkDetectionVariables[iChunk].resize(frameTotal + 1);
+
+        resetVariablesHard(vChunkDetectionVariables[iChunk][0], mDetectionParameters, eyeAOI);
+    }
+
+    std::atomic<int> chunkIndexNext(0);
+
+    auto trackChunksWorker = [&]()
+    {
+        for (int iChunk = chunkIndexNext++; iChunk < chunkTotal; iChunk = chunkIndexNext++)
+        {
+            for (int imageIndex = vWarmUpIndex[iChunk]; imageIndex < vEndIndex[iChunk]; imageIndex++)
+            {
+                int i = imageIndex - vWarmUpIndex[iChunk];
+
+                bool WARM_UP = (imageIndex < vStartIndex[iChunk]); // frame belongs to previous chunk
+
+                trackFrame(imageIndex,
+                           eyeAOI,
+                           mDetectionParameters,
+                           mAdvancedOptions,
+                           vChunkDetectionVariables[iChunk][i],
+                           vChunkDataVariables[iChunk][i],
+                           vChunkDetectionVariables[iChunk][i + 1],
+                           WARM_UP ? NULL : mDiagnosticsArenaUsed,
+                           !WARM_UP);
+            }
+        }
+    };
+
+    ThreadBudget mThreadBudgetLocal; // all cores, if trial is not tracked by a pool
+    if (mThreadBudget == NULL)
+    {
+        mThreadBudgetLocal.reset(std::max((int) std::thread::hardware_concurrency(), 1) - 1); // this thread holds one core
+        mThreadBudget = &mThreadBudgetLocal;
+    }
+
+    int threadTotal = mThreadBudget->acquire(chunkTotal - 1);
+
+    std::vector<std::thread> vThreads;
+    for (int iThread = 0; iThread < threadTotal; iThread++) { vThreads.push_back(std::thread(trackChunksWorker)); }
+
+    trackChunksWorker();
+
+    for (int iThread = 0; iThread < threadTotal; iThread++) { vThreads[iThread].join(); }
+    mThreadBudget->release(threadTotal);
+
+    // Copy chunks without their warm-up windows
+
+    vDetectionVariables[0] = vChunkDetectionVariables[0][0];
+
+    for (int iChunk = 0; iChunk < chunkTotal; iChunk++)
+    {
+        for (int imageIndex = vStartIndex[iChunk]; imageIndex < vEndIndex[iChunk]; imageIndex++)
+        {
+            int i = imageIndex - vWarmUpIndex[iChunk];
+            vDataVariables[imageIndex]          = vChunkDataVariables[iChunk][i];
+            vDetectionVariables[imageIndex + 1] = vChunkDetectionVariables[iChunk][i + 1];
+        }
+    }
+
+    // Stitch chunks in order, so a previous chunk that continued into this one is taken into account
+
+    for (int iChunk = 1; iChunk < chunkTotal; iChunk++)
+    {
+        chunkBoundary mChunkBoundary;
+        mChunkBoundary.CONVERGED      = false;
+        mChunkBoundary.boundaryIndex  = vStartIndex[iChunk];
+        mChunkBoundary.stitchIndex    = vStartIndex[iChunk];
+        mChunkBoundary.warmUpIndex    = vWarmUpIndex[iChunk];
+        mChunkBoundary.mismatchTotal  = 0;
+        mChunkBoundary.divergenceMax  = 0;
+        mChunkBoundary.divergenceMean = 0;
+
+        // Compare estimates in warm-up window
+
+        int divergenceTotal = 0;
+        int agreementCount  = 0;
+
+        for (int imageIndex = vWarmUpIndex[iChunk]; imageIndex < vStartIndex[iChunk]; imageIndex++)
+        {
+            int i = imageIndex - vWarmUpIndex[iChunk];
+
+            const dataVariables& mDataVariablesPrevious = vDataVariables[imageIndex];
+            const dataVariables& mDataVariablesChunk    = vChunkDataVariables[iChunk][i];
+
+            if (isEstimateEqual(mDataVariablesPrevious, vDetectionVariables[imageIndex + 1],
+                                mDataVariablesChunk,    vChunkDetectionVariables[iChunk][i + 1]))
+            {
+                if (agreementCount == 0) { mChunkBoundary.stitchIndex = imageIndex; }
+                agreementCount++;
+            }
+            else { agreementCount = 0; }
+
+            if (mDataVariablesPrevious.DETECTED != mDataVariablesChunk.DETECTED) { mChunkBoundary.mismatchTotal++; }
+            else if (mDataVariablesChunk.DETECTED)
+            {
+                double dX = mDataVariablesPrevious.exactXPos - mDataVariablesChunk.exactXPos;
+                double dY = mDataVariablesPrevious.exactYPos - mDataVariablesChunk.exactYPos;
+                double divergence = sqrt(dX * dX + dY * dY);
+
+                if (divergence > mChunkBoundary.divergenceMax) { mChunkBoundary.divergenceMax = divergence; }
+                mChunkBoundary.divergenceMean += divergence;
+                divergenceTotal++;
+            }
+        }
+
+        if (divergenceTotal > 0) { mChunkBoundary.divergenceMean /= divergenceTotal; }
+
+        if (agreementCount >= chunkConvergenceFrames) { mChunkBoundary.CONVERGED = true; }
+        else
+        {
+            // Continue previous chunk until estimates agree
+
+            agreementCount = 0;
+
+            for (int imageIndex = vStartIndex[iChunk]; imageIndex < vEndIndex[iChunk]; imageIndex++)
+            {
+                dataVariables mDataVariables;
+                detectionVariables mDetectionVariables;
+
+                trackFrame(imageIndex,
+                           eyeAOI,
+                           mDetectionParameters,
+                           mAdvancedOptions,
+                           vDetectionVariables[imageIndex],
+                           mDataVariables,
+                           mDetectionVariables,
+                           mDiagnosticsArenaUsed,
+                           true); // replaces overlay of chunk
+
+                if (isEstimateEqual(mDataVariables,              mDetectionVariables,
+                                    vDataVariables[imageIndex], vDetectionVariables[imageIndex + 1]))
+                {
+                    agreementCount++;
+                }
+                else { agreementCount = 0; }
+
+                vDataVariables[imageIndex]          = mDataVariables;
+                vDetectionVariables[imageIndex + 1] = mDetectionVariables;
+
+                if (agreementCount >= chunkConvergenceFrames)
+                {
+                    mChunkBoundary.CONVERGED   = true;
+                    mChunkBoundary.stitchIndex = imageIndex + 1;
+                    break;
+                }
+            }
+
+            if (!mChunkBoundary.CONVERGED) { mChunkBoundary.stitchIndex = vEndIndex[iChunk]; } // whole chunk tracked again
+        }
+
+        vChunkBoundaries.push_back(mChunkBoundary);
+    }
+
+}
+
+bool TrialTracker::saveData(const trialTrackerSettings& mSettings, const std::vector<double>& timestamps) const
+{
+    { // binary data, the ASCII files are an export
+
+        std::vector<double> vTimestamps(imageTotal, 0.0);
+        for (int i = 0; i < imageTotal && i + 2 < (int) timestamps.size(); i++) { vTimestamps[i] = timestamps[i + 2]; }
+
+        TrackingDataWriter mWriter;
+        addDataColumns(mWriter, "", vDataVariables, imageTotal);
+        mWriter.addColumn("timestamp", vTimestamps);
+        if (mSettings.SAVE_DATA_EXTRA) { addExtraColumns(mWriter, vDataVariables, vDetectionVariables, imageTotal); }
+        if (mSettings.SAVE_DATA_EDGE)  { addEdgeColumns (mWriter, mDiagnosticsArena, imageTotal); }
+        if (mSettings.SAVE_DATA_FIT)   { addFitColumns  (mWriter, mDiagnosticsArena, imageTotal); }
+        addStageColumns(mWriter, vDataVariables, imageTotal);
+
+        long long systemTime = 0;
+        if (timestamps.size() > 1) { systemTime = timestamps[1]; }
+
+        if (!mWriter.save(trialDirectory + "/" + trackingDataFilename, trialIndex, systemTime, mSettings.cameraFrameRate, imageTotal)) { return false; }
+    }
+
+    if (mSettings.SAVE_DATA_ASCII && !saveDataASCII(mSettings, timestamps)) { return false; }
+
+    if (!saveStageProfile(trialDirectory + "/" + stageProfileFilename, vDataVariables, imageTotal)) { return false; }
+
+    std::string delimiter = ";";
+
+    if (vChunkBoundaries.size() > 0) // divergence between chunks
+    {
+        std::ofstream file;
+        file.open(trialDirectory + "/chunk_report.dat", std::ios::trunc);
+        if (!file.is_open()) { return false; }
+
+        file << "warm_up;boundary;stitch;converged;mismatches;divergence_mean;divergence_max" << std::endl;
+        file << std::fixed;
+        file << std::setprecision(3);
+
+        for (int i = 0; i < (int) vChunkBoundaries.size(); i++)
+        {
+            const chunkBoundary& mChunkBoundary = vChunkBoundaries[i];
+
+            file << mChunkBoundary.warmUpIndex    << delimiter
+                 << mChunkBoundary.boundaryIndex  << delimiter
+                 << mChunkBoundary.stitchIndex    << delimiter
+                 << mChunkBoundary.CONVERGED      << delimiter
+                 << mChunkBoundary.mismatchTotal  << delimiter
+                 << mChunkBoundary.divergenceMean << delimiter
+                 << mChunkBoundary.divergenceMax  << std::endl;
+        }
+
+        file.close();
+    }
+
+    return true;
+}
+
+bool TrialTracker::saveDataASCII(const trialTrackerSettings& mSettings, const std::vector<double>& timestamps) const
+{
+    std::string delimiter = ";";
+
+    { // save pupil data
+
+        std::ofstream file;
+        file.open(trialDirectory + "/tracking_data.dat", std::ios::trunc); // open file and remove any existing data
+        if (!file.is_open()) { return false; }
+
+        if (timestamps.size() > 0) { file << std::setw(3) << std::setfill('0') << timestamps[0] << ";"; } // trial index
+        file << imageTotal << ";";  // data samples
+        if (mSettings.SAVE_SAMPLING_RATE) { file << mSettings.cameraFrameRate << ";"; } // sampling rate
+        if (timestamps.size() > 1) { file << (int) timestamps[1] << ";"; } // system clock time
+
+        file << std::fixed;
+        file << std::setprecision(3);
+
+        // write data
+
+        for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].DETECTED << delimiter; }
+
+        if (timestamps.size() > 0)
+        {
+            for (int i = 0; i < imageTotal; i++)
+            {
+                if (i + 2 < (int) timestamps.size()) { file << timestamps[i + 2] << delimiter; }
+                else                                 { file << 0.0               << delimiter; }
+            }
+        }
+
+        if (mSettings.SAVE_POSITION)
+        {
+            for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].absoluteXPos  << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].absoluteYPos  << delimiter; }
+        }
+
+        if (mSettings.SAVE_CIRCUMFERENCE)
+        {
+            for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].exactCircumference << delimiter; }
+        }
+
+        if (mSettings.SAVE_ASPECT_RATIO)
+        {
+            for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].exactAspectRatio << delimiter; }
+        }
+
+        if (mSettings.SAVE_DATA_EXTRA)
+        {
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedXPos          << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedYPos          << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedCircumference << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedAspectRatio   << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedCurvature     << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedIntensity     << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedGradient      << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDetectionVariables[i].predictedAngle         << delimiter; }
+            for (int i = 0; i < imageTotal; i++) { file << vDataVariables[i].duration                    << delimiter; }
+        }
+
+        file.close();
+    }
+
+    if (mSettings.SAVE_DATA_EDGE)
+    {
+        std::ofstream file;
+        file.open(trialDirectory + "/edge_data.dat");
+
+        for (int i = 0; i < imageTotal; i++)
+        {
+            int numEdges;
+            const edgeSummary* edgeData = mDiagnosticsArena.getEdgeData(i, numEdges);
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].tag          << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvature    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMax << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMin << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].length       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radius       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radiusVar    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].intensity    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].gradient     << delimiter; }
+            file << "\n";
+        }
+
+        file.close();
+    }
+
+    if (mSettings.SAVE_DATA_FIT)
+    {
+        std::ofstream file;
+        file.open(trialDirectory + "/fit_data.dat");
+
+        for (int i = 0; i < imageTotal; i++)
+        {
+            int numFits;
+            const ellipseSummary* ellipseData = mDiagnosticsArena.getEllipseData(i, numFits);
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].tag           << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].xPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].yPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].circumference << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].aspectRatio   << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].fitError      << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeLength    << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].angle         << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeScore     << delimiter; }
+            file << "\n";
+        }
+
+        file.close();
+    }
+
+    return true;
+}
@@ -0,0 +1,155 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TRIALTRACKER_H
+#define TRIALTRACKER_H
+
+// Files
+
+#include "constants.h"
+#include "diagnosticsarena.h"
+#include "eyestalker.h"
+#include "framecontainer.h"
+#include "overlayfile.h"
+#include "preprocessedframe.h"
+#include "settingsfile.h"
+#include "structures.h"
+#include "trackingdata.h"
+
+// Standard Template
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost
+
+#include <boost/filesystem.hpp>
+
+// OpenCV
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// Offline tracking of recorded trials without the GUI (session/images/trial_N, with frames in raw.esv or raw/N.png).
+// Results are written to the same files, in the same format, as 'Detect all frames' in the GUI, including the overlays
+// that the GUI draws on the raw frames (trial_N/overlay.eso).
+// Only the first eye is tracked: sessions recorded in binocular mode are re-tracked with both eyes by 'Detect all frames'
+// in the camera version of the GUI.
+
+struct trialTrackerSettings
+{
+    bool SAVE_ASPECT_RATIO;
+    bool SAVE_CIRCUMFERENCE;
+    bool SAVE_POSITION;
+    bool SAVE_SAMPLING_RATE; // after number of samples, as saved by camera version of GUI
+    bool SAVE_DATA_ASCII;    // tracking_data.dat next to binary tracking_data.esd
+    bool SAVE_DATA_EDGE;
+    bool SAVE_DATA_EXTRA;
+    bool SAVE_DATA_FIT;
+    int chunkOverlap; // frames tracked before start of chunk to warm up tracker
+    int chunkTotal;   // trial is split in chunks that are tracked in parallel, 1 tracks trial in one pass
+    double cameraFrameRate;
+    AOIPropertiesDouble eyeAOIRatio;
+    detectionParameters mDetectionParameters;
+    developmentOptions mAdvancedOptions;
+};
+
+// Each chunk starts from a hard reset at the start of its warm-up window, which overlaps the end of the previous chunk.
+// The previous chunk is used up to the chunk boundary. When the two estimates have not converged by then,
+// the previous chunk continues into the next one until they agree.
+
+struct chunkBoundary
+{
+    bool CONVERGED;
+    int boundaryIndex;  // first frame of chunk
+    int stitchIndex;    // first frame taken from chunk
+    int warmUpIndex;    // first frame of warm-up window
+    int mismatchTotal;  // frames in warm-up window where only one chunk detected the pupil
+    double divergenceMax;  // position difference in warm-up window (px)
+    double divergenceMean;
+};
+
+// Cores shared by the trials that are tracked at once (TrialPool) and by the chunks within each trial. Every thread
+// that tracks holds one slot; chunk threads only take slots that are free, so that the total stays within the budget.
+
+class ThreadBudget
+{
+
+public:
+
+    ThreadBudget();
+
+    int  acquire(int slotsWanted); // takes up to 'slotsWanted' free slots without waiting, returns number taken
+    void release(int slots);
+    void reset(int slotsFreeNew);
+
+private:
+
+    int slotsFree;
+    std::mutex budgetMutex;
+};
+
+bool loadTrialTrackerSettings(const std::string& filename, trialTrackerSettings&); // settings file of GUI, missing keys get default values
+
+int countTrials(const std::string& sessionDirectory);
+std::vector<std::vector<double>> loadTimestamps(const std::string& sessionDirectory); // per trial: trial index, system clock time, frame time stamps
+
+class TrialTracker
+{
+
+public:
+
+    TrialTracker();
+
+    bool open(const std::string& sessionDirectory, int trialIndex);
+    bool saveData(const trialTrackerSettings&, const std::vector<double>& timestamps) const; // 'timestamps' as given by 'loadTimestamps', also saves chunk report
+    cv::Mat loadImageRaw(int imageIndex) const; // grayscale
+    int getImageTotal() const;
+    std::vector<chunkBoundary> getChunkBoundaries() const;
+    void track(const trialTrackerSettings&, ThreadBudget* mThreadBudget = NULL); // chunks use free cores of budget, or all cores if NULL
+
+private:
+
+    int imageTotal;
+    int trialIndex;
+
+    std::vector<chunkBoundary> vChunkBoundaries;
+
+    std::string trialDirectory;
+
+    std::vector<dataVariables> vDataVariables;
+    std::vector<detectionVariables> vDetectionVariables; // input of each frame
+
+    DiagnosticsArena mDiagnosticsArena; // per-edge and per-fit values, only if they are saved
+
+    FrameContainerReader mFrameContainerReader;
+
+    OverlayWriter mOverlayWriter; // written while tracking, shared by chunk threads
+    std::mutex overlayMutex;
+
+    bool saveDataASCII(const trialTrackerSettings&, const std::vector<double>& timestamps) const;
+    void trackChunks(const AOIProperties& eyeAOI, const detectionParameters&, const developmentOptions&, DiagnosticsArena*, ThreadBudget*, int chunkTotal, int chunkOverlap);
+    void trackFrame(int imageIndex, const AOIProperties& eyeAOI, const detectionParameters&, const developmentOptions&, const detectionVariables&, dataVariables&, detectionVariables&, DiagnosticsArena*, bool SAVE_OVERLAY); // diagnostics are not kept if NULL
+};
+
+#endif // TRIALTRACKER_H
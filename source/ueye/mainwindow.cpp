@@ -28,15 +28,24 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     strftime(currentDate, 80, "%Y_%m_%d", timeinfo);
 
+    // Main camera is the first pipeline of the tracker manager
+
+    mCameraSession = &mTrackerManager.getPipeline(0)->mCameraSession;
+    mUEyeOpencvCam = &mTrackerManager.getPipeline(0)->mUEyeOpencvCam;
+
+    EventTracer::setThreadName("gui");
+
     // Initialize default values
 
-    mUEyeOpencvCam.setDeviceInfo(5129, 5445);
+    mUEyeOpencvCam->setDeviceInfo(5129, 5445);
 
     APP_EXIT    = false;
     APP_RUNNING = true;
 
-    Parameters::CAMERA_READY    = false;
-    Parameters::CAMERA_RUNNING  = false;
+    CamQImage = NULL; // created after settings have been loaded
+
+    mCameraSession->CAMERA_READY    = false;
+    mCameraSession->CAMERA_RUNNING  = false;
     Parameters::ONLINE_MODE     = true;
 
     TRIAL_RECORDING = false;
@@ -56,6 +65,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     relativeTime       = 0;
 
     startTime         = 0;
+    startTimeHost     = 0;
     trialIndex        = 0;
 
     mParameterWidgetEye  = new ParameterWidget;
@@ -66,8 +76,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     // AOI
 
-    Parameters::cameraXResolution = 1280;
-    Parameters::cameraYResolution = 1024;
+    mCameraSession->cameraXResolution = 1280;
+    mCameraSession->cameraYResolution = 1024;
 
     camAOIRatioLeft.hght = 0.19;
     camAOIRatioRght.hght = 0.22;
@@ -103,10 +113,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     mAdvancedOptions.CURVATURE_MEASUREMENT = false;
 
+    SAVE_DATA_ASCII = true;
     SAVE_DATA_FIT   = false;
     SAVE_DATA_EDGE  = false;
     SAVE_DATA_EXTRA = false;
 
+    SAVE_PROCESSED_IMAGES = false;
+
     // Grab parameters from ini file
 
     LastUsedSettingsFileName = "config_user.ini";
@@ -141,19 +154,22 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     // Camera feed
 
     flashAOI    = flashAOILeft;
-    camAOITemp  = Parameters::camAOI;
+    camAOITemp  = mCameraSession->camAOI;
 
     cv::Mat imgCam(camImageWdth, camImageWdth, CV_8UC3, cv::Scalar(150, 150, 150));
 
     CamQImage = new QImageOpenCV();
+    CamQImage->setCameraSession(mCameraSession);
     CamQImage->setSize(camImageWdth, camImageHght);
-    CamQImage->setAOIEye  (Parameters::eyeAOI);
-    CamQImage->setAOIBead (Parameters::beadAOI);
+    CamQImage->setAOIEye  (mCameraSession->eyeAOI);
+    CamQImage->setAOIEyeRght(mCameraSession->eyeAOIRght);
+    CamQImage->setAOIBead (mCameraSession->beadAOI);
     CamQImage->setAOIFlash(flashAOI);
 
     CamQImage->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     CamQImage->loadImage(imgCam);
     CamQImage->setImage();
+    CamQImage->showAOIEyeRght(BINOCULAR_MODE);
     QObject::connect(CamQImage, SIGNAL(updateImage(int)), this , SLOT(onUpdateImageRaw(int)));
 
     // Cam AOI sliders
@@ -183,8 +199,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     EyeAOIHghtSlider->setInvertedAppearance(true);
     QObject::connect(EyeAOIHghtSlider, SIGNAL(doubleValueChanged(double)), this, SLOT(onSetEyeAOIHght(double)));
 
-    EyeAOIWdthSlider->setDoubleValue(Parameters::eyeAOIRatio.wdth);
-    EyeAOIHghtSlider->setDoubleValue(Parameters::eyeAOIRatio.hght);
+    EyeAOIWdthSlider->setDoubleValue(mCameraSession->eyeAOIRatio.wdth);
+    EyeAOIHghtSlider->setDoubleValue(mCameraSession->eyeAOIRatio.hght);
 
     // Bead AOI sliders
 
@@ -200,8 +216,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     BeadAOIHghtSlider->setOrientation(Qt::Horizontal);
     QObject::connect(BeadAOIHghtSlider, SIGNAL(doubleValueChanged(double)), this, SLOT(onSetBeadAOIHght(double)));
 
-    BeadAOIWdthSlider->setDoubleValue(Parameters::beadAOIRatio.wdth);
-    BeadAOIHghtSlider->setDoubleValue(Parameters::beadAOIRatio.hght);
+    BeadAOIWdthSlider->setDoubleValue(mCameraSession->beadAOIRatio.wdth);
+    BeadAOIHghtSlider->setDoubleValue(mCameraSession->beadAOIRatio.hght);
 
     //
 
@@ -213,7 +229,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     // Qwt plot
 
-    mQwtPlotWidget = new QwtPlotWidget;
+    mQwtPlotWidget = new QwtPlotWidget(mCameraSession);
     mQwtPlotWidget->setWidth(350);
     mQwtPlotWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     mQwtPlotWidget->setVisible(false);
@@ -258,9 +274,16 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     OnlineProcessingTextBox->setText("Online processing:");
 
     OnlineProcessingCheckBox = new QCheckBox;
-    OnlineProcessingCheckBox->setChecked(!SAVE_EYE_IMAGE);
+    OnlineProcessingCheckBox->setChecked(ONLINE_PROCESSING);
     QObject::connect(OnlineProcessingCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetOnlineProcessing(int)));
 
+    QLabel *SaveEyeImageTextBox = new QLabel;
+    SaveEyeImageTextBox->setText("Save images:");
+
+    SaveEyeImageCheckBox = new QCheckBox;
+    SaveEyeImageCheckBox->setChecked(SAVE_EYE_IMAGE);
+    QObject::connect(SaveEyeImageCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetSaveEyeImage(int)));
+
     QLabel *OfflineModeTextBox = new QLabel;
     OfflineModeTextBox->setText("Offline mode:");
 
@@ -279,6 +302,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     OptionsLayout->addStretch();
     OptionsLayout->addWidget(OnlineProcessingTextBox);
     OptionsLayout->addWidget(OnlineProcessingCheckBox);
+    OptionsLayout->addWidget(SaveEyeImageTextBox);
+    OptionsLayout->addWidget(SaveEyeImageCheckBox);
     OptionsLayout->addWidget(OfflineModeTextBox);
     OptionsLayout->addWidget(OfflineModeCheckBox);
     OptionsLayout->addWidget(BeadDetectionTextBox);
@@ -291,11 +316,15 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QPushButton *AOIRghtEyeButton = new QPushButton("&Right eye");
     QObject::connect(AOIRghtEyeButton, SIGNAL(clicked()), this, SLOT(onSetAOIEyeRght()));
 
+    QPushButton *AOIBothEyesButton = new QPushButton("&Both eyes");
+    QObject::connect(AOIBothEyesButton, SIGNAL(clicked()), this, SLOT(onSetAOIEyeBoth()));
+
     AOIEyeOptionsWidget = new QWidget;
     QHBoxLayout* AOIEyeOptionsLayout = new QHBoxLayout(AOIEyeOptionsWidget);
     AOIEyeOptionsLayout->addStretch();
     AOIEyeOptionsLayout->addWidget(AOILeftEyeButton);
     AOIEyeOptionsLayout->addWidget(AOIRghtEyeButton);
+    AOIEyeOptionsLayout->addWidget(AOIBothEyesButton);
     AOIEyeOptionsLayout->addWidget(AOISetButton);
     AOIEyeOptionsLayout->addWidget(AOICropButton);
     AOIEyeOptionsLayout->addStretch();
@@ -579,6 +608,28 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     CameraParametersLayout->addLayout(CameraHardwareGainOptionsLayout, 7, 1);
 
+    // Telemetry of live tracking (most recent frames)
+
+    QLabel *CameraTelemetryTextBox = new QLabel;
+    CameraTelemetryTextBox->setText("<b>Telemetry: </b>");
+
+    CameraTelemetryLabel = new QLabel;
+    CameraTelemetryLabel->setWordWrap(true);
+
+    CameraParametersLayout->addWidget(CameraTelemetryTextBox, 9, 0);
+    CameraParametersLayout->addWidget(CameraTelemetryLabel,   9, 1, 1, 2);
+
+    // Problems of last trial (dropped samples, stalls, lost frames)
+
+    QLabel *CameraTrialWarningTextBox = new QLabel;
+    CameraTrialWarningTextBox->setText("<b>Last trial: </b>");
+
+    CameraTrialWarningLabel = new QLabel;
+    CameraTrialWarningLabel->setWordWrap(true);
+
+    CameraParametersLayout->addWidget(CameraTrialWarningTextBox, 10, 0);
+    CameraParametersLayout->addWidget(CameraTrialWarningLabel,   10, 1, 1, 2);
+
     //    CameraParametersLayout->addWidget(CameraSubSamplingTextBox,  8, 0);
     //    CameraParametersLayout->addWidget(CameraSubSamplingCheckBox, 8, 1);
 
@@ -655,10 +706,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QSpinBox* FlashWdthSpinBoxLeft = new QSpinBox;
     QSpinBox* FlashHghtSpinBoxLeft = new QSpinBox;
 
-    FlashXPosSpinBoxLeft->setRange(0, Parameters::cameraXResolution);
-    FlashYPosSpinBoxLeft->setRange(0, Parameters::cameraYResolution);
-    FlashWdthSpinBoxLeft->setRange(0, Parameters::cameraXResolution);
-    FlashHghtSpinBoxLeft->setRange(0, Parameters::cameraYResolution);
+    FlashXPosSpinBoxLeft->setRange(0, mCameraSession->cameraXResolution);
+    FlashYPosSpinBoxLeft->setRange(0, mCameraSession->cameraYResolution);
+    FlashWdthSpinBoxLeft->setRange(0, mCameraSession->cameraXResolution);
+    FlashHghtSpinBoxLeft->setRange(0, mCameraSession->cameraYResolution);
 
     FlashXPosSpinBoxLeft->setValue(flashAOILeft.xPos);
     FlashYPosSpinBoxLeft->setValue(flashAOILeft.yPos);
@@ -702,10 +753,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QSpinBox* FlashWdthSpinBoxRght = new QSpinBox;
     QSpinBox* FlashHghtSpinBoxRght = new QSpinBox;
 
-    FlashXPosSpinBoxRght->setRange(0, Parameters::cameraXResolution);
-    FlashYPosSpinBoxRght->setRange(0, Parameters::cameraYResolution);
-    FlashWdthSpinBoxRght->setRange(0, Parameters::cameraXResolution);
-    FlashHghtSpinBoxRght->setRange(0, Parameters::cameraYResolution);
+    FlashXPosSpinBoxRght->setRange(0, mCameraSession->cameraXResolution);
+    FlashYPosSpinBoxRght->setRange(0, mCameraSession->cameraYResolution);
+    FlashWdthSpinBoxRght->setRange(0, mCameraSession->cameraXResolution);
+    FlashHghtSpinBoxRght->setRange(0, mCameraSession->cameraYResolution);
 
     FlashXPosSpinBoxRght->setValue(flashAOIRght.xPos);
     FlashYPosSpinBoxRght->setValue(flashAOIRght.yPos);
@@ -860,6 +911,12 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QCheckBox *SaveDataExtraCheckBox = new QCheckBox;
     QObject::connect(SaveDataExtraCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetSaveDataExtra(int)));
 
+    QLabel *SaveProcessedImagesTextBox = new QLabel;
+    SaveProcessedImagesTextBox->setText("<b>Save processed images:</b>");
+
+    QCheckBox *SaveProcessedImagesCheckBox = new QCheckBox;
+    QObject::connect(SaveProcessedImagesCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onSetSaveProcessedImages(int)));
+
     QWidget* AdvancedOptionsWidget = new QWidget;
     QGridLayout* AdvancedOptionsLayout = new QGridLayout(AdvancedOptionsWidget);
     AdvancedOptionsLayout->addWidget(CurvatureMeasurementTextBox,  0, 0, Qt::AlignRight);
@@ -870,8 +927,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     AdvancedOptionsLayout->addWidget(SaveDataFitCheckBox,          2, 1, Qt::AlignRight);
     AdvancedOptionsLayout->addWidget(SaveDataExtraTextBox,         3, 0, Qt::AlignRight);
     AdvancedOptionsLayout->addWidget(SaveDataExtraCheckBox,        3, 1, Qt::AlignRight);
+    AdvancedOptionsLayout->addWidget(SaveProcessedImagesTextBox,   4, 0, Qt::AlignRight);
+    AdvancedOptionsLayout->addWidget(SaveProcessedImagesCheckBox,  4, 1, Qt::AlignRight);
 
-    AdvancedOptionsLayout->setRowStretch(4, 1);
+    AdvancedOptionsLayout->setRowStretch(5, 1);
     AdvancedOptionsLayout->setColumnStretch(2, 1);
 
     /////////////////// Tab layout ///////////////////////
@@ -970,9 +1029,29 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     QAction *about   = new QAction("&About EyeStalker...", this);
     QObject::connect(about, &QAction::triggered, this, &MainWindow::onDialogueOpen);
 
+    QAction *packRawImages   = new QAction("&Pack raw images", this);
+    QAction *unpackRawImages = new QAction("&Unpack raw images", this);
+    QObject::connect(packRawImages,   &QAction::triggered, this, &MainWindow::onPackRawImages);
+    QObject::connect(unpackRawImages, &QAction::triggered, this, &MainWindow::onUnpackRawImages);
+
+    QAction *benchmarkCodec = new QAction("&Benchmark codec", this);
+    QObject::connect(benchmarkCodec, &QAction::triggered, this, &MainWindow::onBenchmarkCodec);
+
+    QAction *recordTrace = new QAction("&Record trace", this);
+    recordTrace->setCheckable(true);
+    QObject::connect(recordTrace, &QAction::triggered, this, &MainWindow::onSetTracing);
+
+    QAction *saveTraceNow = new QAction("&Save trace", this);
+    QObject::connect(saveTraceNow, &QAction::triggered, this, &MainWindow::onSaveTrace);
+
     QMenu *file;
     file = menuBar()->addMenu("&Options");
     file->addAction(options);
+    file->addAction(packRawImages);
+    file->addAction(unpackRawImages);
+    file->addAction(benchmarkCodec);
+    file->addAction(recordTrace);
+    file->addAction(saveTraceNow);
     file = menuBar()->addMenu("&Help");
     file->addAction(about);
 
@@ -999,6 +1078,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     //////////////////////// START-UP /////////////////////////////
     ///////////////////////////////////////////////////////////////
 
+    // Session files are written by one thread, which takes trials in order as they end
+
+    EXPORT_ACTIVE = true;
+    exportThread  = std::thread(&MainWindow::threadExport, this);
+
     // Start camera
 
     std::thread findCameraThread(&MainWindow::findCamera, this);
@@ -1013,22 +1097,34 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
 MainWindow::~MainWindow()
 {
-
+    int trialNumber;
+    mCatchUpTracker.stopTrial(trialNumber); // tracking has stopped, so skipped frames are detected without waiting
+    finishExports();
 }
 
 void MainWindow::pupilTracking()
 {   
-    { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-        resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
+    setThreadAffinity(mTrackerManager.getPipeline(0)->getCPUCore());
+    EventTracer::setThreadName("tracking");
+
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+        resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession->eyeAOI);
+    }
+
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+        resetVariablesHard(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), mCameraSession->eyeAOIRght);
     }
 
-    { std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-        resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), Parameters::beadAOI);
+    { std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+        resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), mCameraSession->beadAOI);
     }
 
-    while(APP_RUNNING && Parameters::CAMERA_RUNNING && Parameters::ONLINE_MODE)
+    mTemporalReuseEye    .clear();
+    mTemporalReuseEyeRght.clear();
+
+    while(APP_RUNNING && mCameraSession->CAMERA_RUNNING && Parameters::ONLINE_MODE)
     {
-        std::lock_guard<std::mutex> AOILock_1(mutexAOI_1);
+        TracedLock AOILock_1(mutexAOI_1, "mutexAOI_1");
 
         detectionVariables mDetectionVariablesEyeTemp;
         detectionParameters mDetectionParametersEyeTemp;
@@ -1036,6 +1132,11 @@ void MainWindow::pupilTracking()
         dataVariables mDataVariablesEyeTemp;
         drawVariables mDrawVariablesEyeTemp;
 
+        detectionVariables mDetectionVariablesEyeRghtTemp;
+
+        dataVariables mDataVariablesEyeRghtTemp;
+        drawVariables mDrawVariablesEyeRghtTemp;
+
         detectionVariables mDetectionVariablesBeadTemp;
         detectionParameters mDetectionParametersBeadTemp;
 
@@ -1046,37 +1147,62 @@ void MainWindow::pupilTracking()
         AOIProperties AOIFlashTemp;
         AOIProperties AOIBeadTemp;
         AOIProperties AOIEyeTemp;
+        AOIProperties AOIEyeRghtTemp;
+
+        bool BINOCULAR_MODE_TEMP;
 
-        imageInfo mImageInfo = mUEyeOpencvCam.getFrame(); // get new frame from camera
+        imageInfo mImageInfo = mUEyeOpencvCam->getFrame(); // get new frame from camera
         cv::Mat imageOriginal = mImageInfo.image;
         absoluteTime = mImageInfo.time; // Get frame timestamp
 
         double relativeTimeNew = (absoluteTime - startTime) / (double) 10000; // in ms
 
         // ignore frame if time interval was too short (possible camera error)
-        if (relativeTimeNew <= (relativeTime + 0.9 * (1000 / cameraFrameRate))) { continue; }
+        if (relativeTimeNew <= (relativeTime + 0.9 * (1000 / cameraFrameRate)))
+        {
+            if (relativeTimeNew != relativeTime) { mCameraSession->mTelemetry.addFrameLoss(SKIP_INTERVAL); } // same frame is returned until next one arrives
+            continue;
+        }
 
         relativeTime = relativeTimeNew;
 
-        { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+        PreprocessedFrame mPreprocessedFrame(imageOriginal); // shared by eye and bead tracking
+
+        { TracedLock AOICamLock(mCameraSession->AOICamMutex, "AOICamMutex");
             imageCamera = imageOriginal.clone();
 
             mDetectionVariablesEyeTemp  = mDetectionVariablesEye;
             mDetectionParametersEyeTemp = mParameterWidgetEye->getStructure();
 
+            mDetectionVariablesEyeRghtTemp = mDetectionVariablesEyeRght;
+
             mDetectionVariablesBeadTemp  = mDetectionVariablesBead;
             mDetectionParametersBeadTemp = mParameterWidgetBead->getStructure();
 
+            // Detection of a frame should finish before next frame arrives
+
+            double timeBudget = 0;
+            if      (detectionTimeBudget > 0)  { timeBudget = detectionTimeBudget; }
+            else if (detectionTimeBudget == 0 && cameraFrameRate > 0) { timeBudget = 1000 / cameraFrameRate; }
+
+            mDetectionParametersEyeTemp .cameraFrameRate = cameraFrameRate;
+            mDetectionParametersEyeTemp .timeBudget      = timeBudget;
+            mDetectionParametersBeadTemp.cameraFrameRate = cameraFrameRate;
+            mDetectionParametersBeadTemp.timeBudget      = timeBudget;
+
             AOIFlashTemp  = flashAOI;
-            AOICameraTemp = Parameters::camAOI;
+            AOICameraTemp = mCameraSession->camAOI;
+
+            BINOCULAR_MODE_TEMP = BINOCULAR_MODE;
         }
 
-        { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-            AOIEyeTemp = Parameters::eyeAOI;
+        { TracedLock AOIEyeLock(mCameraSession->AOIEyeMutex, "AOIEyeMutex");
+            AOIEyeTemp     = mCameraSession->eyeAOI;
+            AOIEyeRghtTemp = mCameraSession->eyeAOIRght;
         }
 
-        { std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-            AOIBeadTemp = Parameters::beadAOI;
+        { TracedLock AOIBeadLock(mCameraSession->AOIBeadMutex, "AOIBeadMutex");
+            AOIBeadTemp = mCameraSession->beadAOI;
         }
 
         AOIProperties AOIFlashRelative;
@@ -1110,8 +1236,12 @@ void MainWindow::pupilTracking()
                     if (avgIntensity > flashThreshold)
                     {
                         resetVariablesSoft(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), AOIEyeTemp);
+                        resetVariablesSoft(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), AOIEyeRghtTemp);
                         resetVariablesSoft(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), AOIBeadTemp);
+                        mTemporalReuseEye    .clear();
+                        mTemporalReuseEyeRght.clear();
                         startTime = mImageInfo.time;
+                        startTimeHost = mImageInfo.timeHost;
                         startTrialRecording();
                     }
                 }
@@ -1123,84 +1253,160 @@ void MainWindow::pupilTracking()
                         FlashThresholdSlider->setValue(  floor(avgIntensity));
                     }
 
-                    mDetectionVariablesEyeTemp = eyeStalker(imageOriginal, AOIEyeTemp, mDetectionVariablesEyeTemp, mDetectionParametersEyeTemp, mDataVariablesEyeTemp, mDrawVariablesEyeTemp); // Pupil tracking algorithm
+                    if (BINOCULAR_MODE_TEMP) // second eye is tracked in parallel on the same preprocessed frame
+                    {
+                        mWorkerEyeRght.run([&] {
+                            EventTracer::setThreadName("tracking (right eye)");
+                            TraceSpan mDetectSpan("detect right eye");
+                            mDetectionVariablesEyeRghtTemp = mTemporalReuseEyeRght.track(mPreprocessedFrame, AOIEyeRghtTemp, mDetectionVariablesEyeRghtTemp, mDetectionParametersEyeTemp, mDataVariablesEyeRghtTemp, mDrawVariablesEyeRghtTemp);
+                        });
+                    }
+
+                    { TraceSpan mDetectSpan("detect");
+                        mDetectionVariablesEyeTemp = mTemporalReuseEye.track(mPreprocessedFrame, AOIEyeTemp, mDetectionVariablesEyeTemp, mDetectionParametersEyeTemp, mDataVariablesEyeTemp, mDrawVariablesEyeTemp); // Pupil tracking algorithm
+                    }
+                    mStageProfiler.addFrame(mDataVariablesEyeTemp);
+
+                    if (BINOCULAR_MODE_TEMP)
+                    {
+                        TraceSpan mJoinSpan("right eye wait");
+                        mWorkerEyeRght.wait();
+                    }
 
                     if (mDetectionParametersBeadTemp.DETECTION_ON) // bead detection
                     {
-                        mDetectionVariablesBeadTemp = eyeStalker(imageOriginal, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBeadTemp, mDrawVariablesBeadTemp);
+                        TraceSpan mDetectSpan("detect bead");
+                        mDetectionVariablesBeadTemp = eyeStalker(mPreprocessedFrame, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBeadTemp, mDrawVariablesBeadTemp);
                     }
+
+                    mCameraSession->mTelemetry.addTrackedFrame(mImageInfo.time, mImageInfo.timeHost, getHostTime());
                 }
             }
             else // Trial recording
             {
-                if (!SAVE_EYE_IMAGE)
+                if (SAVE_EYE_IMAGE) // queued before detection, so that frame is written while it is being tracked
                 {
-                    mDetectionVariablesEyeTemp         = eyeStalker(imageOriginal, AOIEyeTemp, mDetectionVariablesEyeTemp, mDetectionParametersEyeTemp, mDataVariablesEyeTemp, mDrawVariablesEyeTemp); // Pupil tracking algorithm
+                    TraceSpan mQueueSpan("queue frame", "writer"); // includes grayscale conversion, waits if writer queue is full
+                    mFrameWriter.addFrame(frameCount, relativeTime, mPreprocessedFrame.getGray()); // grayscale image is shared with tracker, not copied
+                }
+
+                bool SKIP_DETECTION = false; // tracking is behind camera, frame is detected after trial or when load drops
+
+                if (ONLINE_PROCESSING && mCatchUpTracker.skipFrame(mUEyeOpencvCam->getBacklog()))
+                {
+                    catchUpCheckpoint mCheckpoint;
+                    mCheckpoint.BINOCULAR_MODE             = BINOCULAR_MODE_TEMP;
+                    mCheckpoint.BEAD_DETECTION             = mDetectionParametersBeadTemp.DETECTION_ON;
+                    mCheckpoint.cameraAOI                  = AOICameraTemp;
+                    mCheckpoint.eyeAOI                     = AOIEyeTemp;
+                    mCheckpoint.eyeAOIRght                 = AOIEyeRghtTemp;
+                    mCheckpoint.beadAOI                    = AOIBeadTemp;
+                    mCheckpoint.mDetectionParametersEye    = mDetectionParametersEyeTemp;
+                    mCheckpoint.mDetectionParametersBead   = mDetectionParametersBeadTemp;
+                    mCheckpoint.mDetectionVariablesEye     = mDetectionVariablesEyeTemp;
+                    mCheckpoint.mDetectionVariablesEyeRght = mDetectionVariablesEyeRghtTemp;
+                    mCheckpoint.mDetectionVariablesBead    = mDetectionVariablesBeadTemp;
+
+                    SKIP_DETECTION = mCatchUpTracker.addFrame(frameCount, relativeTime, mPreprocessedFrame.getGray(), mCheckpoint);
+                }
+
+                if (SKIP_DETECTION)
+                {
+                    resultRecord mResultRecord; // time stamp only, replaced when frame has been detected
+                    setResultRecord(mResultRecord, frameCount, relativeTime, NULL, NULL, NULL);
+                    mResultStream.addRecord(mResultRecord);
+                }
+                else if (ONLINE_PROCESSING)
+                {
+                    if (BINOCULAR_MODE_TEMP)
+                    {
+                        mWorkerEyeRght.run([&] {
+                            EventTracer::setThreadName("tracking (right eye)");
+                            TraceSpan mDetectSpan("detect right eye");
+                            mDetectionVariablesEyeRghtTemp         = mTemporalReuseEyeRght.track(mPreprocessedFrame, AOIEyeRghtTemp, mDetectionVariablesEyeRghtTemp, mDetectionParametersEyeTemp, mDataVariablesEyeRghtTemp, mDrawVariablesEyeRghtTemp);
+                            mDataVariablesEyeRghtTemp.absoluteXPos = mDataVariablesEyeRghtTemp.exactXPos + AOIEyeRghtTemp.xPos + AOICameraTemp.xPos;
+                            mDataVariablesEyeRghtTemp.absoluteYPos = mDataVariablesEyeRghtTemp.exactYPos + AOIEyeRghtTemp.yPos + AOICameraTemp.yPos;
+                        });
+                    }
+
+                    { TraceSpan mDetectSpan("detect");
+                        mDetectionVariablesEyeTemp = mTemporalReuseEye.track(mPreprocessedFrame, AOIEyeTemp, mDetectionVariablesEyeTemp, mDetectionParametersEyeTemp, mDataVariablesEyeTemp, mDrawVariablesEyeTemp); // Pupil tracking algorithm
+                    }
+
                     mDataVariablesEyeTemp.absoluteXPos = mDataVariablesEyeTemp.exactXPos + AOIEyeTemp.xPos + AOICameraTemp.xPos;
                     mDataVariablesEyeTemp.absoluteYPos = mDataVariablesEyeTemp.exactYPos + AOIEyeTemp.yPos + AOICameraTemp.yPos;
-                    vDataVariablesEye[frameCount]      = mDataVariablesEyeTemp;
+                    mStageProfiler.addFrame(mDataVariablesEyeTemp);
+
+                    if (mTrackerManager.getNumberOfPipelines() > 1) { mTrackerManager.getPipeline(0)->addSample(mDataVariablesEyeTemp, mImageInfo.timeHost); }
+
+                    if (BINOCULAR_MODE_TEMP)
+                    {
+                        TraceSpan mJoinSpan("right eye wait");
+                        mWorkerEyeRght.wait();
+                    }
 
                     if (mDetectionParametersBeadTemp.DETECTION_ON) // bead detection
                     {
-                        mDetectionVariablesBeadTemp         = eyeStalker(imageOriginal, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBeadTemp, mDrawVariablesBeadTemp); // Pupil tracking algorithm
+                        TraceSpan mDetectSpan("detect bead");
+                        mDetectionVariablesBeadTemp         = eyeStalker(mPreprocessedFrame, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBeadTemp, mDrawVariablesBeadTemp); // Pupil tracking algorithm
                         mDataVariablesBeadTemp.absoluteXPos = mDataVariablesBeadTemp.exactXPos + AOIBeadTemp.xPos + AOICameraTemp.xPos;
                         mDataVariablesBeadTemp.absoluteYPos = mDataVariablesBeadTemp.exactYPos + AOIBeadTemp.yPos + AOICameraTemp.yPos;
-                        vDataVariablesBead[frameCount]      = mDataVariablesBeadTemp;
                     }
 
-                    mDataVariablesEyeTemp.timestamp    = relativeTime; // save time stamps
+                    mDataVariablesEyeTemp.timestamp = relativeTime; // save time stamps
 
-                    frameCount++;
+                    resultRecord mResultRecord; // queued for writer thread, does not wait for disk
+                    setResultRecord(mResultRecord, frameCount, relativeTime, &mDataVariablesEyeTemp,
+                                    BINOCULAR_MODE_TEMP                        ? &mDataVariablesEyeRghtTemp : NULL,
+                                    mDetectionParametersBeadTemp.DETECTION_ON ? &mDataVariablesBeadTemp    : NULL);
+                    mResultStream.addRecord(mResultRecord);
                 }
                 else
                 {
-                    vDataVariablesEye[frameCount].timestamp = relativeTime; // save time stamps
-
-                    // Saving camera frame
-
-                    std::stringstream filename;
-                    filename << dataDirectory
-                             << "/"
-                             << currentDate
-                             << "/trial_"
-                             << trialIndex
-                             << "/raw/"
-                             << frameCount
-                             << ".png";
-
-                    std::vector<int> compression_params;
-                    compression_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
-                    compression_params.push_back(0);
+                    resultRecord mResultRecord; // save time stamps
+                    setResultRecord(mResultRecord, frameCount, relativeTime, NULL, NULL, NULL);
+                    mResultStream.addRecord(mResultRecord);
+                }
 
-                    cv::Mat imageOriginalGray;
-                    cv::cvtColor(imageOriginal, imageOriginalGray, cv::COLOR_BGR2GRAY);
-                    cv::imwrite(filename.str(), imageOriginalGray, compression_params);
+                frameCount++;
 
-                    frameCount++;
-                }
+                mCameraSession->mTelemetry.addTrackedFrame(mImageInfo.time, mImageInfo.timeHost, getHostTime());
 
                 if (frameCount >= trialFrameTotal)
                 {
-                    mUEyeOpencvCam.stopRecording();
+                    TraceSpan mSaveSpan("save trial", "writer");
+                    mUEyeOpencvCam->stopRecording();
+                    mTrackerManager.stopRecording();
+                    if (SAVE_EYE_IMAGE) { mFrameWriter.finish(); } // wait for remaining frames
                     saveTrialData();
+                    mSaveSpan.end();
+                    saveTrace();
                     trialIndex++;
                     TrialIndexSpinBox->setValue(trialIndex);
                     TRIAL_RECORDING = false;
-                    Parameters::frameCaptureCV.notify_all(); // continue regular frame capture
-                    if (!SAVE_EYE_IMAGE) { emit showPlot(); }
+                    mCameraSession->frameCaptureCV.notify_all(); // continue regular frame capture
                     emit startTimer(round(1000 / guiUpdateFrequency));
                 }
             }
         }
+        else { mCameraSession->mTelemetry.addFrameLoss(SKIP_AOI); }
 
         // Update structures
 
         {
-            std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+            TracedLock AOICamLock(mCameraSession->AOICamMutex, "AOICamMutex");
 
             mDetectionVariablesEye = mDetectionVariablesEyeTemp;
             mDrawVariablesEye      = mDrawVariablesEyeTemp;
             mDataVariablesEye      = mDataVariablesEyeTemp;
+
+            if (BINOCULAR_MODE_TEMP)
+            {
+                mDetectionVariablesEyeRght = mDetectionVariablesEyeRghtTemp;
+                mDrawVariablesEyeRght      = mDrawVariablesEyeRghtTemp;
+                mDataVariablesEyeRght      = mDataVariablesEyeRghtTemp;
+            }
+
             mDrawVariablesBead     = mDrawVariablesBeadTemp;
             mDataVariablesBead     = mDataVariablesBeadTemp;
         }
@@ -1215,10 +1421,10 @@ void MainWindow::pupilTracking()
     else if (!Parameters::ONLINE_MODE)
     {
         std::unique_lock<std::mutex> mtxLock(mutexQuit);
-        Parameters::CAMERA_RUNNING = false;
+        mCameraSession->CAMERA_RUNNING = false;
         cv.notify_all();
     }
-    else if (!Parameters::CAMERA_RUNNING)
+    else if (!mCameraSession->CAMERA_RUNNING)
     {
         std::thread findCameraThread(&MainWindow::findCamera, this);
         findCameraThread.detach();
@@ -1232,9 +1438,10 @@ void MainWindow::onUpdateCameraImage()
     {
         if (!TRIAL_RECORDING)
         {
-            if (Parameters::CAMERA_RUNNING)
+            if (mCameraSession->CAMERA_RUNNING)
             {
-                std::lock_guard<std::mutex> AOILock_2(mutexAOI_2);
+                TraceSpan mUpdateSpan("gui update", "gui");
+                TracedLock AOILock_2(mutexAOI_2, "mutexAOI_2");
 
                 drawVariables mDrawVariablesEyeTemp;
                 dataVariables mDataVariablesEyeTemp;
@@ -1242,18 +1449,22 @@ void MainWindow::onUpdateCameraImage()
                 drawVariables mDrawVariablesBeadTemp;
                 dataVariables mDataVariablesBeadTemp;
 
+                drawVariables mDrawVariablesEyeRghtTemp;
+
                 cv::Mat imageOriginal;
 
                 int imgWdth = 0;
                 int imgHght = 0;
 
                 AOIProperties AOIEyeTemp;
+                AOIProperties AOIEyeRghtTemp;
                 AOIProperties AOIBeadTemp;
                 AOIProperties AOIFlashTemp;
 
-                bool DRAW_BEAD = false;
+                bool DRAW_BEAD     = false;
+                bool DRAW_EYE_RGHT = false;
 
-                { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+                { TracedLock AOICamLock(mCameraSession->AOICamMutex, "AOICamMutex");
                     if (!imageCamera.empty())
                     {
                         imageOriginal = imageCamera.clone();
@@ -1267,6 +1478,9 @@ void MainWindow::onUpdateCameraImage()
                         mDrawVariablesBeadTemp = mDrawVariablesBead;
                         mDataVariablesBeadTemp = mDataVariablesBead;
 
+                        mDrawVariablesEyeRghtTemp = mDrawVariablesEyeRght;
+                        DRAW_EYE_RGHT = BINOCULAR_MODE;
+
                         detectionParameters mDetectionParameters = mParameterWidgetBead->getStructure();
                         DRAW_BEAD = mDetectionParameters.DETECTION_ON;
 
@@ -1275,12 +1489,13 @@ void MainWindow::onUpdateCameraImage()
                     } else { return; }
                 }
 
-                { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-                    AOIEyeTemp = Parameters::eyeAOI;
+                { TracedLock AOIEyeLock(mCameraSession->AOIEyeMutex, "AOIEyeMutex");
+                    AOIEyeTemp     = mCameraSession->eyeAOI;
+                    AOIEyeRghtTemp = mCameraSession->eyeAOIRght;
                 }
 
-                { std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-                    AOIBeadTemp  = Parameters::beadAOI;
+                { TracedLock AOIBeadLock(mCameraSession->AOIBeadMutex, "AOIBeadMutex");
+                    AOIBeadTemp  = mCameraSession->beadAOI;
                 }
 
                 if
@@ -1290,7 +1505,7 @@ void MainWindow::onUpdateCameraImage()
                          AOIEyeTemp.hght >= eyeAOIHghtMin)
                 {
 
-                    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+                    { TracedLock AOICamLock(mCameraSession->AOICamMutex, "AOICamMutex");
 
                         // Increase pixel clock if desired frame-rate has not been reached
 
@@ -1337,30 +1552,54 @@ void MainWindow::onUpdateCameraImage()
 
                         if (CameraHardwareGainAutoCheckBox->checkState())
                         {
-                            int hardwareGain = mUEyeOpencvCam.getHardwareGain();
+                            int hardwareGain = mUEyeOpencvCam->getHardwareGain();
                             CameraHardwareGainSlider->setValue(hardwareGain);
                             CameraHardwareGainLabel->setText(QString::number(hardwareGain));
                         }
                     }
 
                     mVariableWidgetEye->setWidgets(mDataVariablesEyeTemp); // update sliders
+                    std::string telemetrySummary = mCameraSession->mTelemetry.getSummary();
+                    if (REUSE_ENABLED) { telemetrySummary += ", " + mTemporalReuseEye.getSummary(); }
+                    CameraTelemetryLabel->setText(QString::fromStdString(telemetrySummary));
+
+                    { std::lock_guard<std::mutex> trialWarningLock(trialWarningMutex);
+                        CameraTrialWarningLabel->setText(QString::fromStdString(trialWarnings));
+                    }
 
+                    TraceSpan mDrawSpan("draw", "gui");
                     cv::Mat imageProcessed = imageOriginal.clone();
                     drawAll(imageProcessed, mDrawVariablesEyeTemp);  // draw eye features
+                    if (DRAW_EYE_RGHT) { drawAll(imageProcessed, mDrawVariablesEyeRghtTemp); } // draw second eye features
                     if (DRAW_BEAD) { drawAll(imageProcessed, mDrawVariablesBeadTemp); } // draw bead features
+                    mDrawSpan.end();
+
+                    TraceSpan mDisplaySpan("display", "gui");
                     CamQImage->loadImage(imageProcessed);
                     CamQImage->setAOIEye  (  AOIEyeTemp);
+                    CamQImage->setAOIEyeRght(AOIEyeRghtTemp);
                     CamQImage->setAOIBead ( AOIBeadTemp);
                     CamQImage->setAOIFlash(AOIFlashTemp);
                     CamQImage->setImage();
                 }
                 else { CamQImage->setAOIError(); }
             }
-            else if (!Parameters::CAMERA_RUNNING)
+            else if (!mCameraSession->CAMERA_RUNNING)
             {
                 CamQImage->setSpinner();
             }
         }
+        else if (SAVE_EYE_IMAGE) // camera image is not updated during trial, but disk headroom is shown next to telemetry
+        {
+            frameWriterStatistics mStatistics = mFrameWriter.getStatistics();
+
+            std::stringstream writerSummary;
+            writerSummary << mCameraSession->mTelemetry.getSummary()
+                          << ", writer queue " << mStatistics.queueSize << "/" << mStatistics.queueCapacity
+                          << " (max " << mStatistics.queueSizeMax << ", " << mStatistics.stallCount << " stalls)";
+
+            CameraTelemetryLabel->setText(QString::fromStdString(writerSummary.str()));
+        }
     }
     else
     {
@@ -1370,20 +1609,20 @@ void MainWindow::onUpdateCameraImage()
 
 void MainWindow::getCameraParameters()
 {
-    std::vector<int> pixelClockRange = mUEyeOpencvCam.getPixelClockRange();
+    std::vector<int> pixelClockRange = mUEyeOpencvCam->getPixelClockRange();
 
     CameraPixelClockSlider->setRange(pixelClockRange[0], pixelClockRange[1]);
     CameraPixelClockSlider->setValue(cameraPixelClock);
     CameraPixelClockLabel ->setText(QString::number(cameraPixelClock));
 
-    std::vector<double> frameRateRange = mUEyeOpencvCam.getFrameRateRange();
+    std::vector<double> frameRateRange = mUEyeOpencvCam->getFrameRateRange();
 
     cameraFrameRate = frameRateRange[1]; // set to max
     CameraFrameRateSlider->setDoubleRange(frameRateRange[0], cameraFrameRate);
     CameraFrameRateSlider->setDoubleValue(cameraFrameRate);
     CameraFrameRateLabel ->setText(QString::number(cameraFrameRate, 'f', 1));
 
-    std::vector<int> blackLevelOffsetRange = mUEyeOpencvCam.getBlackLevelOffsetRange();
+    std::vector<int> blackLevelOffsetRange = mUEyeOpencvCam->getBlackLevelOffsetRange();
 
     CameraBlackLevelOffsetSlider->setRange(blackLevelOffsetRange[0], blackLevelOffsetRange[1]);
     CameraBlackLevelOffsetLabel ->setText(QString::number(blackLevelOffsetRange[1]));
@@ -1393,29 +1632,31 @@ void MainWindow::findCamera()
 {
     bool CAMERA_START = false;
 
-    while (APP_RUNNING && !Parameters::CAMERA_RUNNING && Parameters::ONLINE_MODE)
+    mTrackerManager.setNumberOfPipelines(numberOfCameras);
+
+    while (APP_RUNNING && !mCameraSession->CAMERA_RUNNING && Parameters::ONLINE_MODE)
     {
-        if (mUEyeOpencvCam.findCamera())
+        if (mUEyeOpencvCam->findCamera())
         {
-            int retInt = mUEyeOpencvCam.initCamera();
+            int retInt = mUEyeOpencvCam->initCamera();
 
             if      (retInt == 0) { continue; }
             else if (retInt == 1)
             {
-                if (!mUEyeOpencvCam.setColorMode()) { continue; }
+                if (!mUEyeOpencvCam->setColorMode()) { continue; }
             }
             else if (retInt == 2)
             {
-                mUEyeOpencvCam.exitCamera();
+                mUEyeOpencvCam->exitCamera();
 
-                if (!mUEyeOpencvCam.initCamera()) { continue; }
+                if (!mUEyeOpencvCam->initCamera()) { continue; }
             }
 
-            if (mUEyeOpencvCam.setSubSampling(cameraSubSamplingFactor))
+            if (mUEyeOpencvCam->setSubSampling(cameraSubSamplingFactor))
             {
-                if (mUEyeOpencvCam.allocateMemory(Parameters::camAOI.wdth, Parameters::camAOI.hght))
+                if (mUEyeOpencvCam->allocateMemory(mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght))
                 {
-                    if (mUEyeOpencvCam.setAOI(Parameters::camAOI.xPos, Parameters::camAOI.yPos, Parameters::camAOI.wdth, Parameters::camAOI.hght))
+                    if (mUEyeOpencvCam->setAOI(mCameraSession->camAOI.xPos, mCameraSession->camAOI.yPos, mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght))
                     {
                         CAMERA_START = true;
                         break;
@@ -1427,96 +1668,63 @@ void MainWindow::findCamera()
 
     if (CAMERA_START)
     {
-        if (mUEyeOpencvCam.startVideoCapture())
+        if (mUEyeOpencvCam->startVideoCapture())
         {
-            mUEyeOpencvCam.setAutoGain(true);
+            mUEyeOpencvCam->setAutoGain(true);
 
-            Parameters::CAMERA_RUNNING  = true;
-            Parameters::CAMERA_READY    = true;
+            mCameraSession->CAMERA_RUNNING  = true;
+            mCameraSession->CAMERA_READY    = true;
 
             std::thread pupilTrackingThread(&MainWindow::pupilTracking, this);
             pupilTrackingThread.detach();
 
-            getCameraParameters();
-            emit startTimer(round(1000 / guiUpdateFrequency));
-        }
-    }
-    else { std::this_thread::sleep_for(std::chrono::milliseconds(2000)); }
-}
-
-// Variables
-
-void MainWindow::resetVariablesHard(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
-{
-    // Reset all variables
-
-    mDetectionVariables.averageAspectRatio   = initialAspectRatio; // close to perfect circle
-    mDetectionVariables.averageCircumference = 0.5 * (mDetectionParameters.thresholdCircumferenceMax + mDetectionParameters.thresholdCircumferenceMin); // calculate first
-    mDetectionVariables.averageCurvature     = initialCurvature;
-    mDetectionVariables.averageGradient      = 0;
-    mDetectionVariables.averageHeight        = mDetectionVariables.averageCircumference / M_PI;
-    mDetectionVariables.averageIntensity     = initialIntensity;
-    mDetectionVariables.averageHaarResponse  = 0;
-    mDetectionVariables.averageWidth         = mDetectionVariables.averageCircumference / M_PI;
+            if (numberOfCameras > 1) // additional cameras copy AOI and eye parameters of main camera
+            {
+                AOIProperties camAOI;
+                AOIPropertiesDouble eyeAOIRatio;
+                AOIProperties eyeAOI;
 
-    mDetectionVariables.certaintyAverages      = 0;
-    mDetectionVariables.certaintyAveragesPrime = 0;
+                { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+                    camAOI = mCameraSession->camAOI;
+                }
 
-    resetVariablesSoft(mDetectionVariables, mDetectionParameters, mAOI);
-}
+                { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+                    eyeAOI      = mCameraSession->eyeAOI;
+                    eyeAOIRatio = mCameraSession->eyeAOIRatio;
+                }
 
-void MainWindow::resetVariablesSoft(detectionVariables& mDetectionVariables, const detectionParameters& mDetectionParameters, const AOIProperties& mAOI)
-{
-    // Reset everything but averages
+                // Same frame rate and time budget as main camera, so that detection of a frame finishes before next frame arrives
 
-    mDetectionVariables.predictedAngle         = 0;
-    mDetectionVariables.predictedAspectRatio   = mDetectionVariables.averageAspectRatio;
-    mDetectionVariables.predictedCircumference = mDetectionVariables.averageCircumference;
-    mDetectionVariables.predictedCurvature     = mDetectionVariables.averageCurvature;
-    mDetectionVariables.predictedGradient      = mDetectionVariables.averageGradient;
-    mDetectionVariables.predictedHaarResponse  = mDetectionVariables.averageHaarResponse;
-    mDetectionVariables.predictedHeight        = mDetectionVariables.averageHeight;
-    mDetectionVariables.predictedIntensity     = mDetectionVariables.averageIntensity;
-    mDetectionVariables.predictedWidth         = mDetectionVariables.averageWidth;
-    mDetectionVariables.predictedXPos          = 0.5 * (mAOI.wdth - 1); // centre of image
-    mDetectionVariables.predictedYPos          = 0.5 * (mAOI.hght - 1);
+                double timeBudget = 0;
+                if      (detectionTimeBudget > 0)  { timeBudget = detectionTimeBudget; }
+                else if (detectionTimeBudget == 0 && cameraFrameRate > 0) { timeBudget = 1000 / cameraFrameRate; }
 
-    mDetectionVariables.momentumAspectRatio   = 0;
-    mDetectionVariables.momentumCircumference = 0;
-    mDetectionVariables.momentumCurvature     = 0;
-    mDetectionVariables.momentumGradient      = 0;
-    mDetectionVariables.momentumHaarResponse  = 0;
-    mDetectionVariables.momentumHeight        = 0;
-    mDetectionVariables.momentumIntensity     = 0;
-    mDetectionVariables.momentumWidth         = 0;
-    mDetectionVariables.momentumXPos          = 0;
-    mDetectionVariables.momentumYPos          = 0;
+                detectionParameters mDetectionParametersEye = mParameterWidgetEye->getStructure();
+                mDetectionParametersEye.cameraFrameRate = cameraFrameRate;
+                mDetectionParametersEye.timeBudget      = timeBudget;
 
-    double maxChangeThresholdAspectRatio_1 = mDetectionVariables.predictedAspectRatio - mDetectionParameters.thresholdAspectRatioMin;
-    double maxChangeThresholdAspectRatio_2 = 1.0 - mDetectionVariables.predictedAspectRatio;
-    double maxChangeThresholdAspectRatio   = std::max(maxChangeThresholdAspectRatio_1, maxChangeThresholdAspectRatio_2);
-    double rangeChangeThresholdAspectRatio = maxChangeThresholdAspectRatio   - mDetectionParameters.thresholdChangeAspectRatioUpper;
-    mDetectionVariables.thresholdChangeAspectRatioUpper   = rangeChangeThresholdAspectRatio   + mDetectionParameters.thresholdChangeAspectRatioUpper;
+                detectionVariables mDetectionVariablesInitial;
+                resetVariablesHard(mDetectionVariablesInitial, mDetectionParametersEye, eyeAOI);
 
-    double maxChangeThresholdCircumference_1 = (mDetectionParameters.thresholdCircumferenceMax - mDetectionVariables.predictedCircumference) / mDetectionParameters.thresholdCircumferenceMax;
-    double maxChangeThresholdCircumference_2 = (mDetectionVariables.predictedCircumference - mDetectionParameters.thresholdCircumferenceMin) / mDetectionVariables.predictedCircumference;
-    double maxChangeThresholdCircumference   = std::max(maxChangeThresholdCircumference_1, maxChangeThresholdCircumference_2);
-    double rangeChangeThresholdCircumference = maxChangeThresholdCircumference - mDetectionParameters.thresholdChangeCircumferenceUpper;
-    mDetectionVariables.thresholdChangeCircumferenceUpper = rangeChangeThresholdCircumference + mDetectionParameters.thresholdChangeCircumferenceUpper;
+                std::vector<int> vCamerasFailed = mTrackerManager.startPipelines(camAOI, eyeAOIRatio, cameraSubSamplingFactor, cameraFrameRateDesired, mDetectionParametersEye, mDetectionVariablesInitial);
 
-    double maxChangeThresholdPositionX = mAOI.wdth - mDetectionVariables.predictedWidth;
-    double maxChangeThresholdPositionY = mAOI.hght - mDetectionVariables.predictedHeight;
-    double maxChangeThresholdPosition  = std::max(maxChangeThresholdPositionX, maxChangeThresholdPositionY);
-    double rangeChangeThresholdPosition = maxChangeThresholdPosition - mDetectionParameters.thresholdChangePositionUpper;
-    mDetectionVariables.thresholdChangePositionUpper = rangeChangeThresholdPosition + mDetectionParameters.thresholdChangePositionUpper;
+                if (!vCamerasFailed.empty())
+                {
+                    QString text = "Camera";
+                    for (int iCamera = 0; iCamera < (int) vCamerasFailed.size(); iCamera++) { text += " " + QString::number(vCamerasFailed[iCamera]); }
+                    text += " could not be started. Only the cameras that are running are tracked.";
 
-    mDetectionVariables.thresholdScoreEdge = 0;
-    mDetectionVariables.thresholdScoreFit  = 0;
+                    ConfirmationWindow mConfirmationWindow(text, false);
+                    mConfirmationWindow.setWindowTitle("Warning");
+                    mConfirmationWindow.exec();
+                }
+            }
 
-    mDetectionVariables.certaintyFeatures      = 0;
-    mDetectionVariables.certaintyPosition      = 0;
-    mDetectionVariables.certaintyFeaturesPrime = 0;
-    mDetectionVariables.certaintyPositionPrime = 0;
+            getCameraParameters();
+            emit startTimer(round(1000 / guiUpdateFrequency));
+        }
+    }
+    else { std::this_thread::sleep_for(std::chrono::milliseconds(2000)); }
 }
 
 // General functions
@@ -1534,14 +1742,19 @@ void MainWindow::msWait(int ms)
 
 void MainWindow::onQuitButtonClicked()
 {
-    if (Parameters::CAMERA_RUNNING)
+    if (mCameraSession->CAMERA_RUNNING)
     {
         APP_RUNNING = false;
         std::unique_lock<std::mutex> lck(mutexQuit);
         while (!APP_EXIT) cv.wait(lck);
     }
 
-    mUEyeOpencvCam.exitCamera();
+    mTrackerManager.stopPipelines();
+    mUEyeOpencvCam->exitCamera();
+
+    int trialNumber;
+    mCatchUpTracker.stopTrial(trialNumber); // in case app was closed during trial
+    finishExports(); // session file of last trial
 
     saveSettings(LastUsedSettingsFileName);
 
@@ -1563,15 +1776,15 @@ void MainWindow::onSetOfflineMode(int state)
     OfflineModeWidget  ->setVisible(state);
 
     Parameters::ONLINE_MODE = !state;
-    Parameters::CAMERA_RUNNING    = !state;
-    Parameters::CAMERA_READY      = !state;
+    mCameraSession->CAMERA_RUNNING    = !state;
+    mCameraSession->CAMERA_READY      = !state;
 
     trialIndexOffline = 0;
     imageIndexOffline = 0;
 
     if (!state)
     {
-        if (mUEyeOpencvCam.startVideoCapture())
+        if (mUEyeOpencvCam->startVideoCapture())
         {
             std::thread pupilTrackingThread(&MainWindow::pupilTracking, this);
             pupilTrackingThread.detach();
@@ -1588,13 +1801,13 @@ void MainWindow::onSetOfflineMode(int state)
     else
     {
         { // unlock frame grabbing threads
-            std::unique_lock<std::mutex> frameCaptureMutexLock(Parameters::frameCaptureMutex);
-            Parameters::frameCaptureCV.notify_all(); // unlock getFrame() thread
+            std::unique_lock<std::mutex> frameCaptureMutexLock(mCameraSession->frameCaptureMutex);
+            mCameraSession->frameCaptureCV.notify_all(); // unlock getFrame() thread
         }
 
         { // wait for threads to finish
             std::unique_lock<std::mutex> lck(mutexQuit);
-            while (Parameters::CAMERA_RUNNING) cv.wait(lck);
+            while (mCameraSession->CAMERA_RUNNING) cv.wait(lck);
         }
 
         CamQImage->clearImage();
@@ -1662,9 +1875,9 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 
 void MainWindow::onSetPupilPosition(double xPos, double yPos)
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
 
-    if (xPos > 0 && xPos < Parameters::eyeAOI.wdth && yPos > 0 && yPos < Parameters::eyeAOI.hght)
+    if (xPos > 0 && xPos < mCameraSession->eyeAOI.wdth && yPos > 0 && yPos < mCameraSession->eyeAOI.hght)
     {
         mDetectionVariablesEye.predictedXPos = xPos;
         mDetectionVariablesEye.predictedYPos = yPos;
@@ -1736,55 +1949,62 @@ bool MainWindow::checkFlashAOI(AOIProperties& AOIFlashRelative, const AOIPropert
 
 void MainWindow::startTrialRecording()
 {
-    if (Parameters::CAMERA_RUNNING)
+    if (mCameraSession->CAMERA_RUNNING)
     {
         if (!TRIAL_RECORDING)
         {
             emit stopTimer(); // stop showing camera feed
 
-            // start recording
+            std::stringstream directoryName;
+            directoryName << dataDirectory
+                          << "/"
+                          << currentDate
+                          << "/trial_"
+                          << trialIndex;
 
-            TRIAL_RECORDING = true;
-            mUEyeOpencvCam.startRecording();
+            if (SAVE_EYE_IMAGE) // create directories and start writing threads before first frame arrives
+            {
+                mFrameWriter.start(directoryName.str(), frameWriterThreads, frameWriterQueueSize, SAVE_RAW_CONTAINER, SAVE_RAW_COMPRESSED);
+            }
 
-            // get start times
+            // results are written while trial is recorded, file space is reserved for expected trial length
 
-            absoluteTime = startTime;
-            relativeTime = 0;
+            int resultStreamFlags = 0;
+            if (BINOCULAR_MODE)                   { resultStreamFlags |= RESULT_STREAM_BINOCULAR; }
+            if (mParameterWidgetBead->getState()) { resultStreamFlags |= RESULT_STREAM_BEAD; }
 
-            trialStartTime  = getCurrentTime();
-            trialFrameTotal = ceil((trialTimeLength * cameraFrameRate) / 1000);
+            trialStartTime = getCurrentTime();
 
-            trialTimeLength = (TrialTimeLengthLineEdit->text()).toInt();
+            resultStreamFilenameTrial = directoryName.str() + "/" + resultStreamFilename;
+            mResultStream.open(resultStreamFilenameTrial, trialIndex, trialStartTime, resultStreamFlags, ceil((trialTimeLength * cameraFrameRate) / 1000), resultQueueSize);
 
-            frameCount = 0;
+            if (ONLINE_PROCESSING && CATCH_UP_ENABLED)
+            {   mCatchUpTracker.startTrial(catchUpCapacity, catchUpInterval, catchUpBacklogHigh, catchUpBacklogLow); }
 
-            // preallocate vector space for data
+            mStageProfiler.clear(); // whole-trial statistics are saved with trial
 
-            vDataVariablesEye.resize(trialFrameTotal);
-            vDataVariablesBead.resize(trialFrameTotal);
+            { std::lock_guard<std::mutex> trialWarningLock(trialWarningMutex);
+                trialWarnings.clear();
+            }
+            mTemporalReuseEye    .clearCounters();
+            mTemporalReuseEyeRght.clearCounters();
 
-            vDetectionVariablesEye.resize(trialFrameTotal);
-            vDetectionVariablesBead.resize(trialFrameTotal);
+            // start recording
 
-            // Reset variables
+            TRIAL_RECORDING = true;
+            mUEyeOpencvCam->startRecording();
+            mTrackerManager.startRecording();
 
-            if (SAVE_EYE_IMAGE) // create directories if necessary
-            {
-                std::stringstream directoryName;
-                directoryName << dataDirectory << "/" << currentDate;
+            // get start times
+
+            absoluteTime = startTime;
+            relativeTime = 0;
 
-                if (!boost::filesystem::exists(directoryName.str()))
-                {    boost::filesystem::create_directory(directoryName.str().c_str()); }
+            trialFrameTotal = ceil((trialTimeLength * cameraFrameRate) / 1000);
 
-                directoryName << "/trial_" << trialIndex;
-                if (!boost::filesystem::exists(directoryName.str()))
-                {    boost::filesystem::create_directory(directoryName.str().c_str()); }
+            trialTimeLength = (TrialTimeLengthLineEdit->text()).toInt();
 
-                directoryName << "/raw/";
-                if (!boost::filesystem::exists(directoryName.str()))
-                {    boost::filesystem::create_directory(directoryName.str().c_str()); }
-            }
+            frameCount = 0;
         }
         else
         {
@@ -1800,98 +2020,386 @@ void MainWindow::onStartRecordingManual()
 {
     if (!TRIAL_RECORDING && !PROCESSING_ALL_EXPS && !PROCESSING_ALL_TRIALS && !PROCESSING_ALL_IMAGES)
     {
-        imageInfo mImageInfo = mUEyeOpencvCam.getFrame();
+        imageInfo mImageInfo = mUEyeOpencvCam->getFrame();
         startTime = mImageInfo.time;
+        startTimeHost = mImageInfo.timeHost;
         startTrialRecording();
     }
 }
 
+void MainWindow::addTrialWarning(const std::string& text)
+{
+    std::lock_guard<std::mutex> trialWarningLock(trialWarningMutex);
+    if (!trialWarnings.empty()) { trialWarnings += "\n"; }
+    trialWarnings += text;
+}
+
 void MainWindow::saveTrialData()
 {
-    if (!SAVE_EYE_IMAGE)
+    mResultStream.close(); // results were written during trial, only the last few records are left
+
+    if (mResultStream.getDropCount() > 0)
+    {
+        std::stringstream text;
+        text << "Trial " << trialIndex << ": result queue was full, " << mResultStream.getDropCount() << " samples were not saved";
+        addTrialWarning(text.str());
+    }
+
+    { // latency and lost frames of trial, a trial is flagged if tracking did not keep up with the camera
+        std::stringstream filenameTelemetry;
+        filenameTelemetry << dataDirectory << "/"
+                          << currentDate   << "/"
+                          << "trial_"      << trialIndex
+                          << "/"
+                          << telemetryFilename;
+
+        if (!mCameraSession->mTelemetry.save(filenameTelemetry.str()))
+        {
+            std::stringstream text;
+            text << "Trial " << trialIndex << ": could not save " << filenameTelemetry.str();
+            addTrialWarning(text.str());
+        }
+
+        telemetryStatistics mStatistics = mCameraSession->mTelemetry.getStatistics(true);
+
+        if (mStatistics.OVERLOADED)
+        {
+            std::stringstream text;
+            text << "Trial " << trialIndex << ": tracking could not keep up with camera, see " << filenameTelemetry.str();
+            addTrialWarning(text.str());
+        }
+    }
+
+    if (ONLINE_PROCESSING && profilingEnabled) // stage timing of live tracking
+    {
+        std::stringstream filenameProfile;
+        filenameProfile << dataDirectory << "/"
+                        << currentDate   << "/"
+                        << "trial_"      << trialIndex
+                        << "/"
+                        << stageProfileFilename;
+
+        if (!mStageProfiler.save(filenameProfile.str()))
+        {
+            std::stringstream text;
+            text << "Trial " << trialIndex << ": could not save " << filenameProfile.str();
+            addTrialWarning(text.str());
+        }
+    }
+
+    std::stringstream filename;           // session file with live tracking results
+    std::stringstream filenameTimestamps; // time stamps of saved frames
+
+    if (ONLINE_PROCESSING)
     {
         dataFilename = (DataFilenameLineEdit->text()).toStdString();
 
-        std::stringstream filename;
         filename << dataDirectory
                  << "/"
                  << dataFilename
                  << ".dat";
 
+        if (mTrackerManager.getNumberOfPipelines() > 1) // samples of all cameras, one per line, ordered by host time
+        {
+            std::stringstream filenameMerged;
+            filenameMerged << dataDirectory
+                           << "/"
+                           << dataFilename
+                           << "_cameras.dat";
+
+            mTrackerManager.saveMergedData(filenameMerged.str(), trialIndex, startTimeHost);
+        }
+    }
+
+    if (SAVE_EYE_IMAGE)
+    {
+        filenameTimestamps << dataDirectory << "/"
+                           << currentDate   << "/"
+                           << "trial_"      << trialIndex
+                           << "/"
+                           << "timestamps.dat";
+
+        // save disk throughput, a trial is at risk of losing frames if the queue had no headroom left
+
+        frameWriterStatistics mStatistics = mFrameWriter.getStatistics();
+
+        std::stringstream filenameWriter;
+        filenameWriter << dataDirectory << "/"
+                       << currentDate   << "/"
+                       << "trial_"      << trialIndex
+                       << "/"
+                       << "writer.dat";
+
+        std::ofstream file;
+        file.open(filenameWriter.str(), std::ios::out | std::ios::trunc);
+
+        file << "frames "         << mStatistics.framesWritten      << "\n";
+        file << "megabytes "      << mStatistics.megabytesWritten   << "\n";
+        file << "megabytes_disk " << mStatistics.megabytesStored    << "\n";
+        file << "megabytes/s "    << mStatistics.megabytesPerSecond << "\n";
+        file << "queue_max "      << mStatistics.queueSizeMax       << "\n";
+        file << "queue_capacity " << mStatistics.queueCapacity      << "\n";
+        file << "stalls "         << mStatistics.stallCount         << "\n";
+
+        file.close();
+
+        if (mStatistics.stallCount > 0)
+        {
+            std::stringstream text;
+            text << "Trial " << trialIndex << ": frame writer queue was full " << mStatistics.stallCount << " times (" << mStatistics.megabytesPerSecond << " MB/s)";
+            addTrialWarning(text.str());
+        }
+    }
+
+    // ASCII files are written from result stream in background, so that next trial can start straight away
+
+    int trialNumber;
+    int framesSkipped = mCatchUpTracker.stopTrial(trialNumber);
+
+    if (framesSkipped > 0)
+    {
+        std::stringstream text;
+        text << "Trial " << trialIndex << ": tracking fell behind camera, " << framesSkipped << " frames are detected after trial";
+        addTrialWarning(text.str());
+    }
+
+    if (ONLINE_PROCESSING && REUSE_ENABLED) // save how often detections were re-used, next to the other trial files
+    {
+        std::stringstream filenameReuse;
+        filenameReuse << dataDirectory << "/"
+                      << currentDate   << "/"
+                      << "trial_"      << trialIndex
+                      << "/"
+                      << "reuse.dat";
+
+        std::ofstream file;
+        file.open(filenameReuse.str(), std::ios::out | std::ios::trunc);
+
+        file << "frames "                << mTemporalReuseEye.getFramesTracked()        << "\n";
+        file << "reused "                << mTemporalReuseEye.getFramesReused()         << "\n";
+        file << "verification_failures " << mTemporalReuseEye.getVerificationFailures() << "\n";
+
+        if (BINOCULAR_MODE)
+        {
+            file << "rght_frames "                << mTemporalReuseEyeRght.getFramesTracked()        << "\n";
+            file << "rght_reused "                << mTemporalReuseEyeRght.getFramesReused()         << "\n";
+            file << "rght_verification_failures " << mTemporalReuseEyeRght.getVerificationFailures() << "\n";
+        }
+
+        file.close();
+    }
+
+    // Export gets its own copy of the save options, since these can be changed in the GUI while it runs
+
+    trialExport mExport;
+    mExport.PLOT               = ONLINE_PROCESSING;
+    mExport.SAVE_ASPECT_RATIO  = SAVE_ASPECT_RATIO;
+    mExport.SAVE_CIRCUMFERENCE = SAVE_CIRCUMFERENCE;
+    mExport.SAVE_POSITION      = SAVE_POSITION;
+    mExport.framesSkipped      = framesSkipped;
+    mExport.trialNumber        = trialNumber;
+    mExport.filename           = filename.str();
+    mExport.filenameTimestamps = filenameTimestamps.str();
+    mExport.streamFilename     = resultStreamFilenameTrial;
+
+    { std::lock_guard<std::mutex> exportLock(exportMutex); // tracking thread does not wait for export of previous trial
+        qExports.push_back(mExport);
+    }
+
+    exportCV.notify_one();
+}
+
+void MainWindow::threadExport()
+{
+    EventTracer::setThreadName("export");
+
+    while (true)
+    {
+        trialExport mExport;
+
+        {
+            std::unique_lock<std::mutex> exportLock(exportMutex);
+            while (qExports.empty() && EXPORT_ACTIVE) { exportCV.wait(exportLock); }
+            if (qExports.empty()) { break; } // stopped and all trials exported
+
+            mExport = qExports.front();
+            qExports.pop_front();
+        }
+
+        exportTrialRecording(mExport);
+    }
+}
+
+void MainWindow::finishExports()
+{
+    {
+        std::lock_guard<std::mutex> exportLock(exportMutex);
+        EXPORT_ACTIVE = false;
+    }
+
+    exportCV.notify_one();
+
+    if (exportThread.joinable()) { exportThread.join(); }
+}
+
+void MainWindow::saveTrace()
+{
+    if (!EventTracer::isEnabled()) { return; }
+
+    std::stringstream filename;
+    filename << dataDirectory << "/"
+             << currentDate   << "/"
+             << "trial_"      << trialIndex
+             << "/"
+             << traceFilename;
+
+    if (!EventTracer::save(filename.str()))
+    {
+        std::stringstream text;
+        text << "Trial " << trialIndex << ": could not save " << filename.str();
+        addTrialWarning(text.str());
+    }
+
+    EventTracer::clear(); // next trial starts with empty trace
+}
+
+void MainWindow::onSetTracing(bool state)
+{
+    EventTracer::clear();
+    EventTracer::setEnabled(state);
+}
+
+void MainWindow::onSaveTrace()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save trace"), QString::fromStdString(dataDirectory + "/" + traceFilename), tr("Chrome trace (*.json)"));
+    if (filename.isEmpty()) { return; }
+
+    if (!EventTracer::save(filename.toStdString()))
+    {
+        QString text = "Could not save " + filename;
+        ConfirmationWindow mConfirmationWindow(text, false);
+        mConfirmationWindow.setWindowTitle("Warning");
+        mConfirmationWindow.exec();
+    }
+}
+
+void MainWindow::exportTrialRecording(const trialExport& mExport)
+{
+    TraceSpan mExportSpan("export trial", "writer");
+
+    if (mExport.framesSkipped > 0) // frames that were skipped during trial, detected while live tracking is not behind
+    {
+        std::vector<resultRecord> vRecordsCaughtUp = mCatchUpTracker.getResults(mExport.trialNumber);
+
+        if (!vRecordsCaughtUp.empty() && !updateResultStream(mExport.streamFilename, vRecordsCaughtUp))
+        {   addTrialWarning("Could not update " + mExport.streamFilename + " with frames detected after trial"); }
+    }
+
+    resultStreamHeader mHeader;
+    std::vector<resultRecord> vRecords;
+
+    if (!readResultStream(mExport.streamFilename, mHeader, vRecords)) { return; }
+
+    int sampleTotal = vRecords.size();
+
+    if (!mExport.filename.empty())
+    {
         std::ofstream file;
 
-        if (!boost::filesystem::exists(filename.str()))
-        {   file.open(filename.str(), std::ios::out | std::ios::ate); }
+        if (!boost::filesystem::exists(mExport.filename))
+        {   file.open(mExport.filename, std::ios::out | std::ios::ate); }
         else
         {
-            file.open(filename.str(), std::ios_base::app);
+            file.open(mExport.filename, std::ios_base::app);
             file << "\n";
         }
 
         std::string delimiter = ";";
 
-        file << std::setw(3) << std::setfill('0') << trialIndex << delimiter; // print with leading zeros
-        file << frameCount << delimiter;                                      // data samples
-        file << trialStartTime << delimiter;                                  // system clock time
+        file << std::setw(3) << std::setfill('0') << mHeader.trialIndex << delimiter; // print with leading zeros
+        file << sampleTotal << delimiter;                                             // data samples
+        file << mHeader.systemTime << delimiter;                                      // system clock time
 
         file << std::fixed;
         file << std::setprecision(3);
 
-        for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].DETECTED  << delimiter; }
-        for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].timestamp << delimiter; } // saving ALL timestamps allows for accurate frame-rate calculation during data processing
+        for (int i = 0; i < sampleTotal; i++) { file << (int) vRecords[i].eyeDETECTED << delimiter; }
+        for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].timestamp << delimiter; } // saving ALL timestamps allows for accurate frame-rate calculation during data processing
 
-        if (SAVE_POSITION)
+        if (mExport.SAVE_POSITION)
         {
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].absoluteXPos  << delimiter; }
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].absoluteYPos  << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].eyeXPos << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].eyeYPos << delimiter; }
         }
 
-        if (SAVE_CIRCUMFERENCE)
+        if (mExport.SAVE_CIRCUMFERENCE)
         {
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].exactCircumference << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].eyeCircumference << delimiter; }
         }
 
-        if (SAVE_ASPECT_RATIO)
+        if (mExport.SAVE_ASPECT_RATIO)
         {
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].exactAspectRatio << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].eyeAspectRatio << delimiter; }
         }
 
-        if (mParameterWidgetBead->getState())
+        if (mHeader.flags & RESULT_STREAM_BINOCULAR) // second eye data follows first eye data, sharing the same time stamps
         {
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesBead[i].DETECTED      << delimiter; }
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesBead[i].absoluteXPos  << delimiter; }
-            for (int i = 0; i < frameCount; i++) { file << vDataVariablesBead[i].absoluteYPos  << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << (int) vRecords[i].rghtDETECTED << delimiter; }
+
+            if (mExport.SAVE_POSITION)
+            {
+                for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].rghtXPos << delimiter; }
+                for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].rghtYPos << delimiter; }
+            }
+
+            if (mExport.SAVE_CIRCUMFERENCE)
+            {
+                for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].rghtCircumference << delimiter; }
+            }
+
+            if (mExport.SAVE_ASPECT_RATIO)
+            {
+                for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].rghtAspectRatio << delimiter; }
+            }
+        }
+
+        if (mHeader.flags & RESULT_STREAM_BEAD)
+        {
+            for (int i = 0; i < sampleTotal; i++) { file << (int) vRecords[i].beadDETECTED << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].beadXPos << delimiter; }
+            for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].beadYPos << delimiter; }
         }
 
         file.close();
     }
-    else
-    {
-        // save time stamps
-
-        std::stringstream filename;
-        filename << dataDirectory << "/"
-                 << currentDate   << "/"
-                 << "trial_"      << trialIndex
-                 << "/"
-                 << "timestamps.dat";
 
+    if (!mExport.filenameTimestamps.empty())
+    {
         std::ofstream file;
 
-        file.open(filename.str(), std::ios::out | std::ios::trunc); // open file and remove any existing data
+        file.open(mExport.filenameTimestamps, std::ios::out | std::ios::trunc); // open file and remove any existing data
 
         std::string delimiter = " "; // space delimiter allows for easier reading when combining data
 
-        file << std::setw(3) << std::setfill('0') << trialIndex << delimiter; // print with leading zeros
-        file << trialStartTime << delimiter; // system clock time
+        file << std::setw(3) << std::setfill('0') << mHeader.trialIndex << delimiter; // print with leading zeros
+        file << mHeader.systemTime << delimiter; // system clock time
 
         file << std::fixed;
         file << std::setprecision(3);
 
-        for (int i = 0; i < frameCount; i++) { file << vDataVariablesEye[i].timestamp << delimiter; }
+        for (int i = 0; i < sampleTotal; i++) { file << vRecords[i].timestamp << delimiter; }
 
         file.close();
     }
+
+    if (mExport.PLOT) // plot is drawn from final results, not from file that may still be updated
+    {
+        { std::lock_guard<std::mutex> plotLock(plotMutex);
+            vRecordsPlot.swap(vRecords);
+        }
+
+        emit showPlot();
+    }
 }
 
 void MainWindow::onPlotTrialData()
@@ -1902,13 +2410,19 @@ void MainWindow::onPlotTrialData()
         std::vector<double> y;
         std::vector<double> t;
 
-        for (int i = 0; i < frameCount; i++)
+        std::vector<resultRecord> vRecords; // handed over by export of last trial
+
+        { std::lock_guard<std::mutex> plotLock(plotMutex);
+            vRecords.swap(vRecordsPlot);
+        }
+
+        for (int i = 0; i < (int) vRecords.size(); i++)
         {
-            if (vDataVariablesEye[i].DETECTED)
+            if (vRecords[i].eyeDETECTED)
             {
-                x.push_back(vDataVariablesEye[i].absoluteXPos - Parameters::camAOI.xPos);
-                y.push_back(Parameters::eyeAOI.hght - (vDataVariablesEye[i].absoluteYPos - Parameters::camAOI.yPos));
-                t.push_back(0.001 * vDataVariablesEye[i].timestamp);
+                x.push_back(vRecords[i].eyeXPos - mCameraSession->camAOI.xPos);
+                y.push_back(mCameraSession->eyeAOI.hght - (vRecords[i].eyeYPos - mCameraSession->camAOI.yPos));
+                t.push_back(0.001 * vRecords[i].timestamp);
             }
         }
 
@@ -1919,7 +2433,7 @@ void MainWindow::onPlotTrialData()
 
 void MainWindow::onFlashStandbySlider(int state)
 {
-    if (Parameters::CAMERA_RUNNING && Parameters::ONLINE_MODE && !TRIAL_RECORDING)
+    if (mCameraSession->CAMERA_RUNNING && Parameters::ONLINE_MODE && !TRIAL_RECORDING)
     {
         CamQImage       ->setVisible(!state);
         CamAOIXPosSlider->setVisible(!state);
@@ -1930,9 +2444,9 @@ void MainWindow::onFlashStandbySlider(int state)
         EyeAOIHghtSlider->setVisible(!state);
         mQwtPlotWidget  ->setVisible( state);
 
-        if (CameraHardwareGainAutoCheckBox->isChecked()) { mUEyeOpencvCam.setAutoGain(!state); }
+        if (CameraHardwareGainAutoCheckBox->isChecked()) { mUEyeOpencvCam->setAutoGain(!state); }
 
-        { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+        { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
             FLASH_STANDBY = state;
         }
 
@@ -2005,6 +2519,19 @@ void MainWindow::countNumImages()
 {
     imageTotalOffline = 0;
 
+    std::stringstream containerName;
+    containerName << dataDirectoryOffline.toStdString()
+                  << "/images/trial_"
+                  << trialIndexOffline
+                  << "/"
+                  << frameContainerFilename;
+
+    if (mFrameContainerReader.open(containerName.str())) // all frames of trial in one file
+    {
+        imageTotalOffline = mFrameContainerReader.getFrameCount();
+        return;
+    }
+
     while (1)
     {
         std::stringstream filename;
@@ -2043,15 +2570,6 @@ void MainWindow::setupOfflineSession()
             if (trialIndexOffline != 0) { OfflineTrialSlider->setValue(0); } // start with first trial
             else { onSetTrialOffline(0); }
 
-            std::stringstream directoryName;
-            directoryName << dataDirectoryOffline.toStdString()
-                          << "/images/trial_"
-                          << trialIndexOffline
-                          << "/processed";
-
-            if (!boost::filesystem::exists(directoryName.str()))
-            {    boost::filesystem::create_directory(directoryName.str().c_str()); }
-
             if (timeMatrix.empty()) // Grab time stamps
             {
                 std::stringstream directory;
@@ -2087,69 +2605,117 @@ void MainWindow::onSetTrialOffline(int index)
 
         countNumImages();
 
+        std::stringstream overlayPath;
+        overlayPath << dataDirectoryOffline.toStdString()
+                    << "/images/trial_"
+                    << trialIndexOffline
+                    << "/"
+                    << overlayFilename;
+
+        mOverlayReader.open(overlayPath.str()); // file may not exist yet
+
+        mDiagnosticsArena.clear();
+
         if (imageTotalOffline > 0)
         {
             vDataVariablesEye.resize( imageTotalOffline);
+            mDiagnosticsArena.resize( imageTotalOffline);
+            vDataVariablesEyeRght.resize(imageTotalOffline);
             vDataVariablesBead.resize(imageTotalOffline);
 
             vDetectionVariablesEye.resize( imageTotalOffline + 1);
+            vDetectionVariablesEyeRght.resize(imageTotalOffline + 1);
             vDetectionVariablesBead.resize(imageTotalOffline + 1);
 
-            resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
-            resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), Parameters::beadAOI);
+            resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession->eyeAOI);
+            resetVariablesHard(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), mCameraSession->eyeAOIRght);
+            resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), mCameraSession->beadAOI);
 
             vDetectionVariablesEye [0] = mDetectionVariablesEye;
+            vDetectionVariablesEyeRght[0] = mDetectionVariablesEyeRght;
             vDetectionVariablesBead[0] = mDetectionVariablesBead;
 
             if (imageIndexOffline != 0) { OfflineImageSlider->setValue(0); } // start with first frame
             else { onSetOfflineImage(0); }
 
             OfflineImageSlider->setMaximum(imageTotalOffline - 1);
-
-            // Create folder
-
-            std::stringstream directoryPath;
-            directoryPath << dataDirectoryOffline.toStdString()
-                          << "/images/trial_"
-                          << trialIndexOffline
-                          << "/processed/";
-
-            if (!boost::filesystem::exists(directoryPath.str()))
-            {    boost::filesystem::create_directory(directoryPath.str().c_str()); }
         }
     }
 }
 
-void MainWindow::onUpdateImageRaw(int imgIndex) // for signal from qimageopencv
+cv::Mat MainWindow::loadImageRaw(int imageIndex)
 {
-    if (imgIndex < 0) { imgIndex = imageIndexOffline; }
+    cv::Mat imageRaw;
+
+    if (mFrameContainerReader.isOpen())
+    {
+        cv::Mat imageContainer = mFrameContainerReader.getFrame(imageIndex); // points into mapped file
+
+        if      (imageContainer.empty())         { return imageRaw; }
+        else if (imageContainer.channels() == 1) { cv::cvtColor(imageContainer, imageRaw, cv::COLOR_GRAY2BGR); } // same as loading PNG in color
+        else                                     { imageRaw = imageContainer.clone(); }
+
+        return imageRaw;
+    }
 
     std::stringstream imagePath;
     imagePath << dataDirectoryOffline.toStdString()
               << "/images/trial_"
               << trialIndexOffline
               << "/raw/"
-              << imgIndex
+              << imageIndex
               << ".png";
 
-    if (boost::filesystem::exists(imagePath.str()))
+    if (boost::filesystem::exists(imagePath.str())) { imageRaw = cv::imread(imagePath.str(), CV_LOAD_IMAGE_COLOR); }
+
+    return imageRaw;
+}
+
+void MainWindow::onUpdateImageRaw(int imgIndex) // for signal from qimageopencv
+{
+    if (imgIndex < 0) { imgIndex = imageIndexOffline; }
+
+    cv::Mat eyeImageRaw = loadImageRaw(imgIndex);
+
+    if (!eyeImageRaw.empty())
     {
-        cv::Mat eyeImageRaw = cv::imread(imagePath.str(), CV_LOAD_IMAGE_COLOR);
         CamQImage->loadImage(eyeImageRaw);
-        { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-            Parameters::camAOI.wdth = eyeImageRaw.cols;
-            Parameters::camAOI.hght = eyeImageRaw.rows;
+        { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+            mCameraSession->camAOI.wdth = eyeImageRaw.cols;
+            mCameraSession->camAOI.hght = eyeImageRaw.rows;
         }
         updateAOIx();
         updateAOIy();
-        CamQImage->setAOIEye (Parameters::eyeAOI);
-        CamQImage->setAOIBead(Parameters::beadAOI);
+        CamQImage->setAOIEye (mCameraSession->eyeAOI);
+        CamQImage->setAOIEyeRght(mCameraSession->eyeAOIRght);
+        CamQImage->setAOIBead(mCameraSession->beadAOI);
         CamQImage->setImage();
     } else { CamQImage->clearImage(); }
 }
 
 void MainWindow::onUpdateImageProcessed(int imgIndex)
 {
+    // Detection results are drawn on the raw frame, with the current draw settings
+
+    std::vector<drawVariables> vDrawVariables;
+
+    mOverlayReader.update(); // records of running detection
+
+    if (mOverlayReader.getFrame(imgIndex, vDrawVariables))
+    {
+        cv::Mat eyeImage = loadImageRaw(imgIndex);
+
+        if (!eyeImage.empty())
+        {
+            drawAll(eyeImage, vDrawVariables);
+            CamQImage->loadImage(eyeImage);
+            CamQImage->setImage();
+            return;
+        }
+    }
+
+    // Processed images saved by older versions, or exported
+
     std::stringstream fileName;
     fileName << dataDirectoryOffline.toStdString()
              << "/images/trial_"
@@ -2192,7 +2758,7 @@ void MainWindow::onSetOfflineImage(int imgIndex)
 {
     if (!PROCESSING_ALL_IMAGES) { imageIndexOffline = imgIndex; }
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
         mVariableWidgetEye ->setWidgets(vDataVariablesEye    [imgIndex]);
         mVariableWidgetBead->setWidgets(vDataVariablesBead[imgIndex]);
     }
@@ -2216,60 +2782,109 @@ void MainWindow::onSetOfflineImage(int imgIndex)
 
 void MainWindow::detectCurrentFrame(int imageIndex)
 {
-    // Grab raw images
+    cv::Mat imageRaw = loadImageRaw(imageIndex);
 
-    cv::Mat imageRaw;
+    std::vector<drawVariables> vDrawVariables = detectFrame(imageIndex, imageRaw);
+    if (vDrawVariables.empty()) { return; }
 
-    std::stringstream imagePathRaw;
-    imagePathRaw << dataDirectoryOffline.toStdString()
-                 << "/images/trial_"
-                 << trialIndexOffline
-                 << "/raw/"
-                 << imageIndex
-                 << ".png";
+    std::stringstream trialDirectory;
+    trialDirectory << dataDirectoryOffline.toStdString()
+                   << "/images/trial_"
+                   << trialIndexOffline;
+
+    OverlayWriter mOverlayWriter;
+    mOverlayWriter.open(trialDirectory.str() + "/" + overlayFilename, true);
+    mOverlayWriter.addFrame(imageIndex, vDrawVariables);
+
+    if (SAVE_PROCESSED_IMAGES)
+    {
+        std::stringstream imagePath;
+        imagePath << trialDirectory.str()
+                  << "/processed/"
+                  << imageIndex
+                  << ".png";
+
+        boost::filesystem::create_directories(trialDirectory.str() + "/processed");
+
+        cv::Mat imageProcessed = imageRaw.clone();
+        drawAll(imageProcessed, vDrawVariables);
+        cv::imwrite(imagePath.str(), imageProcessed);
+    }
+}
 
-    if (boost::filesystem::exists(imagePathRaw.str())) { imageRaw = cv::imread(imagePathRaw.str(), CV_LOAD_IMAGE_COLOR); }
-    else                                               { return; }
+std::vector<drawVariables> MainWindow::detectFrame(int imageIndex, const cv::Mat& imageRaw)
+{
+    std::vector<drawVariables> vDrawVariables;
+
+    if (imageRaw.empty()) { return vDrawVariables; }
 
     // Detect pupil
 
     detectionVariables mDetectionVariablesEyeTemp;
+    detectionVariables mDetectionVariablesEyeRghtTemp;
     detectionVariables mDetectionVariablesBeadTemp;
 
     detectionParameters mDetectionParametersEyeTemp;
     detectionParameters mDetectionParametersBeadTemp;
 
     AOIProperties AOIEyeTemp;
+    AOIProperties AOIEyeRghtTemp;
     AOIProperties AOIBeadTemp;
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    bool BINOCULAR_MODE_TEMP;
+
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
 
         mDetectionVariablesEyeTemp  = vDetectionVariablesEye[imageIndex];
         mDetectionParametersEyeTemp = mParameterWidgetEye->getStructure();
 
+        mDetectionVariablesEyeRghtTemp = vDetectionVariablesEyeRght[imageIndex];
+        BINOCULAR_MODE_TEMP = BINOCULAR_MODE;
+
         mDetectionVariablesBeadTemp  = vDetectionVariablesBead[imageIndex];
         mDetectionParametersBeadTemp = mParameterWidgetBead->getStructure();
 
-        Parameters::camAOI.wdth = imageRaw.cols;
-        Parameters::camAOI.hght = imageRaw.rows;
+        mCameraSession->camAOI.wdth = imageRaw.cols;
+        mCameraSession->camAOI.hght = imageRaw.rows;
 
         if (mAdvancedOptions.CURVATURE_MEASUREMENT) { setCurvatureMeasurement(mDetectionParametersEyeTemp, imageRaw.cols); }
 
         updateAOIx();
         updateAOIy();
 
-        AOIEyeTemp  = Parameters::eyeAOI;
-        AOIBeadTemp = Parameters::beadAOI;
+        AOIEyeTemp  = mCameraSession->eyeAOI;
+        AOIBeadTemp = mCameraSession->beadAOI;
+        AOIEyeRghtTemp = mCameraSession->eyeAOIRght;
+    }
+
+    PreprocessedFrame mPreprocessedFrame(imageRaw); // shared by eye and bead tracking
+
+    bool SAVE_DIAGNOSTICS = SAVE_DATA_EDGE || SAVE_DATA_FIT; // per-edge and per-fit data is not kept otherwise
+    diagnosticVariables mDiagnosticVariablesEye;
+
+    // Second eye is tracked in parallel
+
+    detectionVariables mDetectionVariablesEyeRghtNew;
+
+    if (BINOCULAR_MODE_TEMP)
+    {
+        mWorkerEyeRght.run([&] {
+            mDetectionVariablesEyeRghtNew      = eyeStalker(mPreprocessedFrame, AOIEyeRghtTemp, mDetectionVariablesEyeRghtTemp, mDetectionParametersEyeTemp, mDataVariablesEyeRght, mDrawVariablesEyeRght, mAdvancedOptions);
+            mDataVariablesEyeRght.absoluteXPos = mDataVariablesEyeRght.exactXPos;
+            mDataVariablesEyeRght.absoluteYPos = mDataVariablesEyeRght.exactYPos;
+            vDataVariablesEyeRght[imageIndex]  = mDataVariablesEyeRght;
+        });
     }
 
     auto t1 = std::chrono::high_resolution_clock::now();
-    detectionVariables mDetectionVariablesEyeNew = eyeStalker(imageRaw,
+    detectionVariables mDetectionVariablesEyeNew = eyeStalker(mPreprocessedFrame,
                                                               AOIEyeTemp,
                                                               mDetectionVariablesEyeTemp,
                                                               mDetectionParametersEyeTemp,
                                                               mDataVariablesEye,
                                                               mDrawVariablesEye,
-                                                              mAdvancedOptions);
+                                                              mAdvancedOptions,
+                                                              SAVE_DIAGNOSTICS ? &mDiagnosticVariablesEye : NULL);
     auto t2 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> fp_ms = t2 - t1;
 
@@ -2280,42 +2895,41 @@ void MainWindow::detectCurrentFrame(int imageIndex)
     mDataVariablesEye.absoluteYPos     = mDataVariablesEye.exactYPos;
     vDataVariablesEye[imageIndex]   = mDataVariablesEye;
 
-    cv::Mat imageProcessed = imageRaw.clone();
-    drawAll(imageProcessed, mDrawVariablesEye);
+    if (SAVE_DIAGNOSTICS) { mDiagnosticsArena.store(imageIndex, mDiagnosticVariablesEye); }
+
+    if (BINOCULAR_MODE_TEMP) { mWorkerEyeRght.wait(); }
+
+    vDrawVariables.push_back(mDrawVariablesEye);
+    if (BINOCULAR_MODE_TEMP) { vDrawVariables.push_back(mDrawVariablesEyeRght); }
 
     detectionVariables mDetectionVariablesBeadNew;
 
     if (mParameterWidgetBead->getState())
     {
-        mDetectionVariablesBeadNew      = eyeStalker(imageRaw, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBead, mDrawVariablesBead);
+        mDetectionVariablesBeadNew      = eyeStalker(mPreprocessedFrame, AOIBeadTemp, mDetectionVariablesBeadTemp, mDetectionParametersBeadTemp, mDataVariablesBead, mDrawVariablesBead);
         mDataVariablesBead.absoluteXPos = mDataVariablesBead.exactXPos;
         mDataVariablesBead.absoluteYPos = mDataVariablesBead.exactYPos;
         vDataVariablesBead[imageIndex]  = mDataVariablesBead;
-        drawAll(imageProcessed, mDrawVariablesBead);
+        vDrawVariables.push_back(mDrawVariablesBead);
     }
 
-    // Save image
-
-    std::stringstream imagePath;
-    imagePath << dataDirectoryOffline.toStdString()
-              << "/images/trial_"
-              << trialIndexOffline
-              << "/processed/"
-              << imageIndex
-              << ".png";
-
-    cv::imwrite(imagePath.str(), imageProcessed);
-
     // Record variables for next frame(s)
 
-    { std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
         mDetectionVariablesEye = mDetectionVariablesEyeNew;
         vDetectionVariablesEye[imageIndex + 1] = mDetectionVariablesEye;
+        if (BINOCULAR_MODE_TEMP)
+        {
+            mDetectionVariablesEyeRght = mDetectionVariablesEyeRghtNew;
+            vDetectionVariablesEyeRght[imageIndex + 1] = mDetectionVariablesEyeRght;
+        }
         if (mParameterWidgetBead->getState())
         {
             mDetectionVariablesBead = mDetectionVariablesBeadNew;
             vDetectionVariablesBead[imageIndex + 1] = mDetectionVariablesBead; }
     }
+
+    return vDrawVariables;
 }
 
 void MainWindow::onDetectCurrentFrame()
@@ -2362,11 +2976,43 @@ void MainWindow::detectAllFrames()
 {
     int initialIndex = imageIndexOffline; // needed for progressbar
 
+    // Frames are decoded ahead and processed images written behind by separate threads, so that tracking does not wait for the disk
+
+    std::stringstream trialDirectory;
+    trialDirectory << dataDirectoryOffline.toStdString()
+                   << "/images/trial_"
+                   << trialIndexOffline;
+
+    FramePrefetcher mFramePrefetcher;
+    mFramePrefetcher.start([this](int imageIndex) { return loadImageRaw(imageIndex); }, initialIndex, imageTotalOffline, offlineDecoderThreads, offlineQueueSize);
+
+    OverlayWriter mOverlayWriter;
+    mOverlayWriter.open(trialDirectory.str() + "/" + overlayFilename, initialIndex > 0); // detection from first frame replaces previous overlays
+
+    FrameWriter mProcessedWriter;
+    if (SAVE_PROCESSED_IMAGES) { mProcessedWriter.startImages(trialDirectory.str() + "/processed", offlineWriterThreads, offlineQueueSize); }
+
     for (imageIndexOffline = initialIndex; imageIndexOffline < imageTotalOffline && PROCESSING_ALL_IMAGES; imageIndexOffline++)
     {
-        detectCurrentFrame(imageIndexOffline);
+        cv::Mat imageRaw = mFramePrefetcher.getFrame(imageIndexOffline);
+
+        std::vector<drawVariables> vDrawVariables = detectFrame(imageIndexOffline, imageRaw);
+        if (vDrawVariables.empty()) { continue; }
+
+        mOverlayWriter.addFrame(imageIndexOffline, vDrawVariables);
+
+        if (SAVE_PROCESSED_IMAGES)
+        {
+            cv::Mat imageProcessed = imageRaw.clone();
+            drawAll(imageProcessed, vDrawVariables);
+            mProcessedWriter.addFrame(imageIndexOffline, 0, imageProcessed);
+        }
     }
 
+    mFramePrefetcher.stop();
+    mOverlayWriter.close();
+    mProcessedWriter.finish(); // processed images are on disk before they are shown
+
     imageIndexOffline--; // for-loop overshoots value
 
     if (PROCESSING_ALL_IMAGES)
@@ -2392,10 +3038,14 @@ void MainWindow::onDetectAllTrials()
     {
         PROCESSING_ALL_TRIALS = true;
 
-        for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline && PROCESSING_ALL_TRIALS; iTrial++)
+        if (offlineThreads != 1 && !BINOCULAR_MODE && !mParameterWidgetBead->getState()) { detectAllTrialsParallel(); }
+        else
         {
-            OfflineTrialSlider->setValue(iTrial);
-            onDetectAllFrames();
+            for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline && PROCESSING_ALL_TRIALS; iTrial++)
+            {
+                OfflineTrialSlider->setValue(iTrial);
+                onDetectAllFrames();
+            }
         }
     }
 
@@ -2403,6 +3053,45 @@ void MainWindow::onDetectAllTrials()
     PROCESSING_ALL_TRIALS = false;
 }
 
+void MainWindow::detectAllTrialsParallel()
+{
+    trialTrackerSettings mSettings;
+    mSettings.SAVE_ASPECT_RATIO    = SAVE_ASPECT_RATIO;
+    mSettings.SAVE_CIRCUMFERENCE   = SAVE_CIRCUMFERENCE;
+    mSettings.SAVE_POSITION        = SAVE_POSITION;
+    mSettings.SAVE_SAMPLING_RATE   = true;
+    mSettings.SAVE_DATA_ASCII      = SAVE_DATA_ASCII;
+    mSettings.SAVE_DATA_EDGE       = SAVE_DATA_EDGE;
+    mSettings.SAVE_DATA_EXTRA      = SAVE_DATA_EXTRA;
+    mSettings.SAVE_DATA_FIT        = SAVE_DATA_FIT;
+    mSettings.chunkOverlap         = offlineChunkOverlap;
+    mSettings.chunkTotal           = offlineChunks;
+    mSettings.cameraFrameRate      = cameraFrameRate;
+    mSettings.eyeAOIRatio          = mCameraSession->eyeAOIRatio;
+    mSettings.mDetectionParameters = mParameterWidgetEye->getStructure();
+    mSettings.mAdvancedOptions     = mAdvancedOptions;
+
+    TrialPool mTrialPool;
+    for (int iTrial = trialIndexOffline; iTrial < trialTotalOffline; iTrial++) { mTrialPool.addTrial(dataDirectoryOffline.toStdString(), iTrial); }
+    mTrialPool.start(mSettings, offlineThreads);
+
+    while (!mTrialPool.isFinished())
+    {
+        if (!PROCESSING_ALL_TRIALS) { mTrialPool.stop(); } // button was pressed again
+
+        std::stringstream ss;
+        ss << "<b>" << mTrialPool.getTrialsDone() << " / " << mTrialPool.getTrialsTotal() << " trials</b>";
+        QString title = QString::fromStdString(ss.str());
+        OfflineImageFrameTextBox->setText(title);
+
+        msWait(1000 / guiUpdateFrequency);
+    }
+
+    mTrialPool.wait();
+
+    onSetTrialOffline(trialIndexOffline);
+}
+
 void MainWindow::onDetectAllExperiments()
 {
     if (!PROCESSING_ALL_EXPS)
@@ -2435,6 +3124,67 @@ void MainWindow::onDetectAllExperiments()
 
 
 void MainWindow::onSaveTrialData()
+{
+    { // binary data, the ASCII files are an export
+
+        std::vector<double> vTimestamps(imageTotalOffline, 0.0);
+        long long systemTime = 0;
+
+        if (trialIndexOffline < (int) timeMatrix.size())
+        {
+            const std::vector<double>& timestamps = timeMatrix[trialIndexOffline];
+            for (int i = 0; i < imageTotalOffline && i + 2 < (int) timestamps.size(); i++) { vTimestamps[i] = timestamps[i + 2]; }
+            if (timestamps.size() > 1) { systemTime = timestamps[1]; }
+        }
+
+        TrackingDataWriter mWriter;
+        addDataColumns(mWriter, "", vDataVariablesEye, imageTotalOffline);
+        mWriter.addColumn("timestamp", vTimestamps);
+        if (BINOCULAR_MODE)                    { addDataColumns(mWriter, "rght_", vDataVariablesEyeRght, imageTotalOffline); }
+        if (mParameterWidgetBead->getState())  { addDataColumns(mWriter, "bead_", vDataVariablesBead,    imageTotalOffline); }
+        if (SAVE_DATA_EXTRA) { addExtraColumns(mWriter, vDataVariablesEye, vDetectionVariablesEye, imageTotalOffline); }
+        if (SAVE_DATA_EDGE)  { addEdgeColumns (mWriter, mDiagnosticsArena, imageTotalOffline); }
+        if (SAVE_DATA_FIT)   { addFitColumns  (mWriter, mDiagnosticsArena, imageTotalOffline); }
+        addStageColumns(mWriter, vDataVariablesEye, imageTotalOffline);
+
+        std::stringstream filename;
+        filename << dataDirectoryOffline.toStdString()
+                 << "/images/trial_"
+                 << trialIndexOffline
+                 << "/"
+                 << trackingDataFilename;
+
+        if (!mWriter.save(filename.str(), trialIndexOffline, systemTime, cameraFrameRate, imageTotalOffline))
+        {
+            QString text = "Could not save <b>" + QString::fromStdString(filename.str()) + "</b>";
+            ConfirmationWindow mConfirmationWindow(text, false);
+            mConfirmationWindow.setWindowTitle("Warning");
+            mConfirmationWindow.exec();
+        }
+    }
+
+    { // stage timing, only in profiling builds
+
+        std::stringstream filename;
+        filename << dataDirectoryOffline.toStdString()
+                 << "/images/trial_"
+                 << trialIndexOffline
+                 << "/"
+                 << stageProfileFilename;
+
+        if (!saveStageProfile(filename.str(), vDataVariablesEye, imageTotalOffline))
+        {
+            QString text = "Could not save <b>" + QString::fromStdString(filename.str()) + "</b>";
+            ConfirmationWindow mConfirmationWindow(text, false);
+            mConfirmationWindow.setWindowTitle("Warning");
+            mConfirmationWindow.exec();
+        }
+    }
+
+    if (SAVE_DATA_ASCII) { exportTrialData(); }
+}
+
+void MainWindow::exportTrialData()
 {
     std::string delimiter = ";";
 
@@ -2478,6 +3228,27 @@ void MainWindow::onSaveTrialData()
             for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEye[i].exactAspectRatio << delimiter; }
         }
 
+        if (BINOCULAR_MODE)
+        {
+            for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEyeRght[i].DETECTED << delimiter; }
+
+            if (SAVE_POSITION)
+            {
+                for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEyeRght[i].absoluteXPos << delimiter; }
+                for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEyeRght[i].absoluteYPos << delimiter; }
+            }
+
+            if (SAVE_CIRCUMFERENCE)
+            {
+                for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEyeRght[i].exactCircumference << delimiter; }
+            }
+
+            if (SAVE_ASPECT_RATIO)
+            {
+                for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesEyeRght[i].exactAspectRatio << delimiter; }
+            }
+        }
+
         if (mParameterWidgetBead->getState())
         {
             for (int i = 0; i < imageTotalOffline; i++) { file << vDataVariablesBead[i].DETECTED      << delimiter; }
@@ -2515,16 +3286,17 @@ void MainWindow::onSaveTrialData()
 
         for (int i = 0; i < imageTotalOffline; i++)
         {
-            int numEdges = vDataVariablesEye[i].edgeData.size();
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].tag          << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvature    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvatureMax << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].curvatureMin << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].length       << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].radius       << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].radiusVar    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].intensity    << delimiter; }
-            for (int j = 0; j < numEdges; j++) { file << vDataVariablesEye[i].edgeData[j].gradient     << delimiter; }
+            int numEdges;
+            const edgeSummary* edgeData = mDiagnosticsArena.getEdgeData(i, numEdges);
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].tag          << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvature    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMax << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].curvatureMin << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].length       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radius       << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].radiusVar    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].intensity    << delimiter; }
+            for (int j = 0; j < numEdges; j++) { file << edgeData[j].gradient     << delimiter; }
             file << "\n";
         }
 
@@ -2544,16 +3316,17 @@ void MainWindow::onSaveTrialData()
 
         for (int i = 0; i < imageTotalOffline; i++)
         {
-            int numFits = vDataVariablesEye[i].ellipseData.size();
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].tag           << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].xPos          << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].yPos          << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].circumference << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].aspectRatio   << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].fitError      << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].edgeLength    << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].angle         << delimiter; }
-            for (int j = 0; j < numFits; j++) { file << vDataVariablesEye[i].ellipseData[j].edgeScore     << delimiter; }
+            int numFits;
+            const ellipseSummary* ellipseData = mDiagnosticsArena.getEllipseData(i, numFits);
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].tag           << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].xPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].yPos          << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].circumference << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].aspectRatio   << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].fitError      << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeLength    << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].angle         << delimiter; }
+            for (int j = 0; j < numFits; j++) { file << ellipseData[j].edgeScore     << delimiter; }
             file << "\n";
         }
 
@@ -2571,20 +3344,44 @@ void MainWindow::onCombineData()
                     << ".dat";
 
     std::string fileNameWrite = fileNameWriteSS.str();
+    std::string fileNameIndex = dataDirectoryOffline.toStdString() + "/" + dataFilename + ".esi";
+
+    bool ASCII_EXISTS = SAVE_DATA_ASCII && boost::filesystem::exists(fileNameWrite);
+    bool INDEX_EXISTS = boost::filesystem::exists(fileNameIndex);
 
-    if (boost::filesystem::exists(fileNameWrite))
+    if (ASCII_EXISTS || INDEX_EXISTS)
     {
-        QString text = "The file <b>" + QString::fromStdString(dataFilename) + ".dat</b> already exists in <b>" + dataDirectoryOffline + "/</b>. Do you wish to add data to the end of this file?";
+        QString fileNameASCII  = "<b>" + QString::fromStdString(dataFilename) + ".dat</b>";
+        QString fileNameBinary = "<b>" + QString::fromStdString(dataFilename) + ".esi</b>";
+
+        QString fileNames;
+        if      (ASCII_EXISTS && INDEX_EXISTS) { fileNames = fileNameASCII + " and " + fileNameBinary + " already exist"; }
+        else if (ASCII_EXISTS)                 { fileNames = fileNameASCII  + " already exists"; }
+        else                                   { fileNames = fileNameBinary + " already exists"; }
+
+        QString text = "The file " + fileNames + " in <b>" + dataDirectoryOffline + "/</b>. Do you wish to add data to the end?";
         ConfirmationWindow mConfirmationWindow(text);
         mConfirmationWindow.setWindowTitle("Please select option");
 
         if(mConfirmationWindow.exec() == QDialog::Rejected) { return; }
     }
 
+    std::vector<std::string> vDataFilenames; // binary data is combined through an index, without copying
+
     for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
     {
         OfflineTrialSlider->setValue(iTrial);
 
+        std::stringstream dataFilenameTrial;
+        dataFilenameTrial << "images/trial_"
+                          << iTrial
+                          << "/"
+                          << trackingDataFilename;
+
+        if (boost::filesystem::exists(dataDirectoryOffline.toStdString() + "/" + dataFilenameTrial.str())) { vDataFilenames.push_back(dataFilenameTrial.str()); }
+
+        if (!SAVE_DATA_ASCII) { continue; }
+
         std::stringstream fileNameRead;
         fileNameRead << dataDirectoryOffline.toStdString()
                      << "/images/trial_"
@@ -2603,6 +3400,95 @@ void MainWindow::onCombineData()
         file << "\n";
         file.close();
     }
+
+    if (!appendTrackingIndex(fileNameIndex, vDataFilenames))
+    {
+        QString text = "Could not save <b>" + QString::fromStdString(fileNameIndex) + "</b>";
+        ConfirmationWindow mConfirmationWindow(text, false);
+        mConfirmationWindow.setWindowTitle("Warning");
+        mConfirmationWindow.exec();
+    }
+}
+
+void MainWindow::onPackRawImages()
+{
+    QString text = "Do you wish to pack the raw images of all trials into one file per trial? The images themselves are kept.";
+    ConfirmationWindow mConfirmationWindow(text);
+    mConfirmationWindow.setWindowTitle("Please select option");
+
+    if(mConfirmationWindow.exec() == QDialog::Rejected) { return; }
+
+    for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
+    {
+        std::stringstream trialDirectory;
+        trialDirectory << dataDirectoryOffline.toStdString()
+                       << "/images/trial_"
+                       << iTrial;
+
+        std::vector<double> timestamps; // first two entries are trial index and start time
+
+        if (iTrial < (int) timeMatrix.size() && timeMatrix[iTrial].size() > 2)
+        {   timestamps.assign(timeMatrix[iTrial].begin() + 2, timeMatrix[iTrial].end()); }
+
+        if (iTrial == trialIndexOffline) { mFrameContainerReader.close(); } // file is about to be replaced
+
+        convertPNGToContainer(trialDirectory.str(), timestamps);
+    }
+
+    onSetTrialOffline(trialIndexOffline);
+}
+
+void MainWindow::onUnpackRawImages()
+{
+    for (int iTrial = 0; iTrial < trialTotalOffline; iTrial++)
+    {
+        std::stringstream trialDirectory;
+        trialDirectory << dataDirectoryOffline.toStdString()
+                       << "/images/trial_"
+                       << iTrial;
+
+        convertContainerToPNG(trialDirectory.str());
+    }
+}
+
+void MainWindow::onBenchmarkCodec()
+{
+    if (imageTotalOffline <= 0) { return; }
+
+    // Frames spread over current trial
+
+    int numberOfFrames = std::min(imageTotalOffline, 100);
+
+    std::vector<cv::Mat> vImages;
+
+    for (int iFrame = 0; iFrame < numberOfFrames; iFrame++)
+    {
+        cv::Mat imageRaw = loadImageRaw(iFrame * imageTotalOffline / numberOfFrames);
+        if (imageRaw.empty()) { continue; }
+
+        cv::Mat imageGray;
+        cv::cvtColor(imageRaw, imageGray, cv::COLOR_BGR2GRAY); // recordings are saved in grayscale
+        vImages.push_back(imageGray);
+    }
+
+    std::stringstream results;
+    benchmarkFrameCodec(vImages, results);
+
+    std::stringstream filename;
+    filename << dataDirectoryOffline.toStdString()
+             << "/codec_benchmark.dat";
+
+    std::ofstream file;
+    file.open(filename.str(), std::ios::out | std::ios::trunc);
+    file << results.str();
+    file.close();
+
+    QString text = QString::fromStdString(results.str());
+    text.replace("\n", "<br>");
+
+    ConfirmationWindow mConfirmationWindow(text, false);
+    mConfirmationWindow.setWindowTitle("Codec benchmark");
+    mConfirmationWindow.exec();
 }
 
 ///////////////////////////////////////////////////////////////
@@ -2638,52 +3524,87 @@ void MainWindow::loadSettings(QString filename)
                                                        0.60,    // 24. Score difference threshold edge
                                                        0.10,    // 25. Score difference threshold fit
                                                        7,       // 26. Edge window length
-                                                       6};      // 27. Maximum number of fits
+                                                       6,       // 27. Maximum number of fits
+                                                       0,       // 28. Blink contrast threshold
+                                                       0};      // 29. Reduced-scale circumference
 
     QSettings settings(filename, QSettings::IniFormat);
 
-    camAOIRatio.hght                = settings.value("CamAOIHghtFraction",          camAOIRatioLeft.hght).toDouble();
-    camAOIRatio.wdth                = settings.value("CamAOIWdthFraction",          camAOIRatioLeft.wdth).toDouble();
-    camAOIRatio.xPos                = settings.value("CamAOIXPosFraction",          camAOIRatioLeft.xPos).toDouble();
-    camAOIRatio.yPos                = settings.value("CamAOIYPosFraction",          camAOIRatioLeft.yPos).toDouble();
-    cameraFrameRateDesired          = settings.value("CameraFrameRateDesired",      250).toInt();
-    cameraSubSamplingFactor         = settings.value("SubSamplingFactor",             1).toInt();
-    dataDirectory                   = settings.value("DataDirectory",                "").toString().toStdString();
-    dataDirectoryOffline            = settings.value("DataDirectoryOffline",         "").toString();
-    dataFilename                    = settings.value("DataFilename",                "experiment_data").toString().toStdString();
-    Parameters::drawFlags.haar      = settings.value("DrawHaar",                  false).toBool();
-    Parameters::drawFlags.edge      = settings.value("DrawEdge",                  false).toBool();
-    Parameters::drawFlags.elps      = settings.value("DrawElps",                   true).toBool();
-    trialIndexOffline               = settings.value("trialIndexOffline",             0).toInt();
-    imageTotalOffline               = settings.value("imageTotalOffline",             0).toInt();
-    flashThreshold                  = settings.value("FlashThreshold",              230).toInt();
-    Parameters::eyeAOIRatio.xPos    = settings.value("AOIXPosRatio",                0.0).toDouble();
-    Parameters::eyeAOIRatio.yPos    = settings.value("AOIYPosRatio",                0.0).toDouble();
-    Parameters::eyeAOIRatio.hght    = settings.value("AOIHghtRatio",                1.0).toDouble();
-    Parameters::eyeAOIRatio.wdth    = settings.value("AOIWdthRatio",                1.0).toDouble();
-    Parameters::beadAOIRatio.xPos   = settings.value("AOIBeadXPosRatio",            0.2).toDouble();
-    Parameters::beadAOIRatio.yPos   = settings.value("AOIBeadYPosRatio",            0.5).toDouble();
-    Parameters::beadAOIRatio.hght   = settings.value("AOIBeadHghtRatio",            0.6).toDouble();
-    Parameters::beadAOIRatio.wdth   = settings.value("AOIBeadWdthRatio",            0.3).toDouble();
-    flashAOILeft.hght               = settings.value("FlashAOIHghtLeft",            100).toInt();
-    flashAOILeft.wdth               = settings.value("FlashAOIWdthLeft",             60).toInt();
-    flashAOILeft.xPos               = settings.value("FlashAOIXPosLeft",            227).toInt();
-    flashAOILeft.yPos               = settings.value("FlashAOIYPosLeft",            500).toInt();
-    flashAOIRght.hght               = settings.value("FlashAOIHghtRght",            100).toInt();
-    flashAOIRght.wdth               = settings.value("FlashAOIWdthRght",             60).toInt();
-    flashAOIRght.xPos               = settings.value("FlashAOIXPosRght",           1020).toInt();
-    flashAOIRght.yPos               = settings.value("FlashAOIYPosRght",            450).toInt();
-    SAVE_ASPECT_RATIO               = settings.value("SaveAspectRatio",             true).toBool();
-    SAVE_CIRCUMFERENCE              = settings.value("SaveCircumference",           true).toBool();
-    SAVE_POSITION                   = settings.value("SavePosition",                true).toBool();
-    SAVE_EYE_IMAGE                  = settings.value("SaveEyeImage",                false).toBool();
-    trialTimeLength                 = settings.value("TrialTimeLength",             1500).toInt();
+    camAOIRatio.hght                     = settings.value("CamAOIHghtFraction",          camAOIRatioLeft.hght).toDouble();
+    camAOIRatio.wdth                     = settings.value("CamAOIWdthFraction",          camAOIRatioLeft.wdth).toDouble();
+    camAOIRatio.xPos                     = settings.value("CamAOIXPosFraction",          camAOIRatioLeft.xPos).toDouble();
+    camAOIRatio.yPos                     = settings.value("CamAOIYPosFraction",          camAOIRatioLeft.yPos).toDouble();
+    cameraFrameRateDesired               = settings.value("CameraFrameRateDesired",      250).toInt();
+    cameraSubSamplingFactor              = settings.value("SubSamplingFactor",             1).toInt();
+    dataDirectory                        = settings.value("DataDirectory",                "").toString().toStdString();
+    dataDirectoryOffline                 = settings.value("DataDirectoryOffline",         "").toString();
+    dataFilename                         = settings.value("DataFilename",                "experiment_data").toString().toStdString();
+    Parameters::drawFlags.haar           = settings.value("DrawHaar",                  false).toBool();
+    Parameters::drawFlags.edge           = settings.value("DrawEdge",                  false).toBool();
+    Parameters::drawFlags.elps           = settings.value("DrawElps",                   true).toBool();
+    trialIndexOffline                    = settings.value("trialIndexOffline",             0).toInt();
+    imageTotalOffline                    = settings.value("imageTotalOffline",             0).toInt();
+    flashThreshold                       = settings.value("FlashThreshold",              230).toInt();
+    mCameraSession->eyeAOIRatio.xPos     = settings.value("AOIXPosRatio",                0.0).toDouble();
+    mCameraSession->eyeAOIRatio.yPos     = settings.value("AOIYPosRatio",                0.0).toDouble();
+    mCameraSession->eyeAOIRatio.hght     = settings.value("AOIHghtRatio",                1.0).toDouble();
+    mCameraSession->eyeAOIRatio.wdth     = settings.value("AOIWdthRatio",                1.0).toDouble();
+    mCameraSession->eyeAOIRatioRght.xPos = settings.value("AOIRghtXPosRatio",           0.5).toDouble();
+    mCameraSession->eyeAOIRatioRght.yPos = settings.value("AOIRghtYPosRatio",           0.0).toDouble();
+    mCameraSession->eyeAOIRatioRght.hght = settings.value("AOIRghtHghtRatio",           1.0).toDouble();
+    mCameraSession->eyeAOIRatioRght.wdth = settings.value("AOIRghtWdthRatio",           0.5).toDouble();
+    BINOCULAR_MODE                       = settings.value("BinocularMode",               false).toBool();
+    numberOfCameras                      = settings.value("NumberOfCameras",                 1).toInt();
+    frameWriterThreads                   = settings.value("FrameWriterThreads",              2).toInt();
+    frameWriterQueueSize                 = settings.value("FrameWriterQueueSize",         2000).toInt();
+    resultQueueSize                      = settings.value("ResultQueueSize",              4096).toInt();
+    CATCH_UP_ENABLED                     = settings.value("CatchUpEnabled",              false).toBool();
+    catchUpBacklogHigh                   = settings.value("CatchUpBacklogHigh",            100).toInt();
+    catchUpBacklogLow                    = settings.value("CatchUpBacklogLow",              10).toInt();
+    catchUpCapacity                      = settings.value("CatchUpCapacity",              2000).toInt();
+    catchUpInterval                      = settings.value("CatchUpInterval",                 4).toInt();
+    detectionTimeBudget                  = settings.value("DetectionTimeBudget",             0).toDouble();
+    REUSE_ENABLED                        = settings.value("ReuseEnabled",                false).toBool();
+    reuseContrast                        = settings.value("ReuseContrast",                 0.7).toDouble();
+    reuseDifference                      = settings.value("ReuseDifference",               2.0).toDouble();
+    reuseMaximum                         = settings.value("ReuseMaximum",                  100).toInt();
+
+    mTemporalReuseEye    .setParameters(REUSE_ENABLED, reuseDifference, reuseContrast, reuseMaximum);
+    mTemporalReuseEyeRght.setParameters(REUSE_ENABLED, reuseDifference, reuseContrast, reuseMaximum);
+
+    offlineChunkOverlap                  = settings.value("OfflineChunkOverlap",           500).toInt();
+    offlineChunks                        = settings.value("OfflineChunks",                   1).toInt();
+    offlineDecoderThreads                = settings.value("OfflineDecoderThreads",           2).toInt();
+    offlineQueueSize                     = settings.value("OfflineQueueSize",               64).toInt();
+    offlineThreads                       = settings.value("OfflineThreads",                  1).toInt();
+    offlineWriterThreads                 = settings.value("OfflineWriterThreads",            2).toInt();
+    SAVE_DATA_ASCII                      = settings.value("SaveDataASCII",                true).toBool();
+    mCameraSession->beadAOIRatio.xPos    = settings.value("AOIBeadXPosRatio",            0.2).toDouble();
+    mCameraSession->beadAOIRatio.yPos    = settings.value("AOIBeadYPosRatio",            0.5).toDouble();
+    mCameraSession->beadAOIRatio.hght    = settings.value("AOIBeadHghtRatio",            0.6).toDouble();
+    mCameraSession->beadAOIRatio.wdth    = settings.value("AOIBeadWdthRatio",            0.3).toDouble();
+    flashAOILeft.hght                    = settings.value("FlashAOIHghtLeft",            100).toInt();
+    flashAOILeft.wdth                    = settings.value("FlashAOIWdthLeft",             60).toInt();
+    flashAOILeft.xPos                    = settings.value("FlashAOIXPosLeft",            227).toInt();
+    flashAOILeft.yPos                    = settings.value("FlashAOIYPosLeft",            500).toInt();
+    flashAOIRght.hght                    = settings.value("FlashAOIHghtRght",            100).toInt();
+    flashAOIRght.wdth                    = settings.value("FlashAOIWdthRght",             60).toInt();
+    flashAOIRght.xPos                    = settings.value("FlashAOIXPosRght",           1020).toInt();
+    flashAOIRght.yPos                    = settings.value("FlashAOIYPosRght",            450).toInt();
+    SAVE_ASPECT_RATIO                    = settings.value("SaveAspectRatio",             true).toBool();
+    SAVE_CIRCUMFERENCE                   = settings.value("SaveCircumference",           true).toBool();
+    SAVE_POSITION                        = settings.value("SavePosition",                true).toBool();
+    SAVE_EYE_IMAGE                       = settings.value("SaveEyeImage",                false).toBool();
+    ONLINE_PROCESSING                    = settings.value("OnlineProcessing",  !SAVE_EYE_IMAGE).toBool(); // both may be set
+    SAVE_RAW_CONTAINER                   = settings.value("SaveRawContainer",             true).toBool();
+    SAVE_RAW_COMPRESSED                  = settings.value("SaveRawCompressed",            true).toBool();
+    trialTimeLength                      = settings.value("TrialTimeLength",             1500).toInt();
 
     CameraHardwareGainAutoCheckBox ->setChecked(settings.value("GainAuto",   true).toBool());
     CameraHardwareGainBoostCheckBox->setChecked(settings.value("GainBoost", false).toBool());
 
-    cameraAOIWdthMax = Parameters::cameraXResolution / (double) cameraSubSamplingFactor; // maximum possible AOI size
-    cameraAOIHghtMax = Parameters::cameraYResolution / (double) cameraSubSamplingFactor;
+    cameraAOIWdthMax = mCameraSession->cameraXResolution / (double) cameraSubSamplingFactor; // maximum possible AOI size
+    cameraAOIHghtMax = mCameraSession->cameraYResolution / (double) cameraSubSamplingFactor;
 
     updateCamAOIx();
     updateCamAOIy();
@@ -2694,8 +3615,17 @@ void MainWindow::loadSettings(QString filename)
     mParameterWidgetEye ->setStructure(mDetectionParametersEye);
     mParameterWidgetBead->setStructure(mDetectionParametersBead);
 
-    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
-    resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), Parameters::beadAOI);
+    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession->eyeAOI);
+    resetVariablesHard(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), mCameraSession->eyeAOIRght);
+    resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), mCameraSession->beadAOI);
+
+    if (CamQImage != NULL) // not yet created when settings are loaded at start-up
+    {
+        CamQImage->setAOIEye    (mCameraSession->eyeAOI);
+        CamQImage->setAOIEyeRght(mCameraSession->eyeAOIRght);
+        CamQImage->setAOIBead   (mCameraSession->beadAOI);
+        CamQImage->showAOIEyeRght(BINOCULAR_MODE);
+    }
 }
 
 detectionParameters MainWindow::loadParameters(QString filename, QString prefix, std::vector<double> parameters)
@@ -2731,6 +3661,8 @@ detectionParameters MainWindow::loadParameters(QString filename, QString prefix,
     mDetectionParameters.thresholdScoreDiffFit              = settings.value(prefix + "ScoreThresholdDiffFit",          parameters[25]).toDouble();
     mDetectionParameters.windowLengthEdge                   = settings.value(prefix + "WindowLengthEdge",               parameters[26]).toDouble();
     mDetectionParameters.fitMaximum                         = settings.value(prefix + "FitMaximum",                     parameters[27]).toDouble();
+    mDetectionParameters.thresholdBlinkContrast             = settings.value(prefix + "BlinkContrast",                  parameters[28]).toDouble();
+    mDetectionParameters.circumferenceScaled                = settings.value(prefix + "CircumferenceScaled",            parameters[29]).toDouble();
 
     return mDetectionParameters;
 }
@@ -2739,14 +3671,40 @@ void MainWindow::saveSettings(QString filename)
 {
     QSettings settings(filename, QSettings::IniFormat);
 
-    settings.setValue("AOIHghtRatio",           Parameters::eyeAOIRatio.hght);
-    settings.setValue("AOIWdthRatio",           Parameters::eyeAOIRatio.wdth);
-    settings.setValue("AOIXPosRatio",           Parameters::eyeAOIRatio.xPos);
-    settings.setValue("AOIYPosRatio",           Parameters::eyeAOIRatio.yPos);
-    settings.setValue("AOIBeadHghtRatio",       Parameters::beadAOIRatio.hght);
-    settings.setValue("AOIBeadWdthRatio",       Parameters::beadAOIRatio.wdth);
-    settings.setValue("AOIBeadXPosRatio",       Parameters::beadAOIRatio.xPos);
-    settings.setValue("AOIBeadYPosRatio",       Parameters::beadAOIRatio.yPos);
+    settings.setValue("AOIHghtRatio",           mCameraSession->eyeAOIRatio.hght);
+    settings.setValue("AOIWdthRatio",           mCameraSession->eyeAOIRatio.wdth);
+    settings.setValue("AOIXPosRatio",           mCameraSession->eyeAOIRatio.xPos);
+    settings.setValue("AOIYPosRatio",           mCameraSession->eyeAOIRatio.yPos);
+    settings.setValue("AOIRghtHghtRatio",       mCameraSession->eyeAOIRatioRght.hght);
+    settings.setValue("AOIRghtWdthRatio",       mCameraSession->eyeAOIRatioRght.wdth);
+    settings.setValue("AOIRghtXPosRatio",       mCameraSession->eyeAOIRatioRght.xPos);
+    settings.setValue("AOIRghtYPosRatio",       mCameraSession->eyeAOIRatioRght.yPos);
+    settings.setValue("BinocularMode",          BINOCULAR_MODE);
+    settings.setValue("NumberOfCameras",        numberOfCameras);
+    settings.setValue("FrameWriterThreads",     frameWriterThreads);
+    settings.setValue("FrameWriterQueueSize",   frameWriterQueueSize);
+    settings.setValue("ResultQueueSize",        resultQueueSize);
+    settings.setValue("CatchUpEnabled",         CATCH_UP_ENABLED);
+    settings.setValue("CatchUpBacklogHigh",     catchUpBacklogHigh);
+    settings.setValue("CatchUpBacklogLow",      catchUpBacklogLow);
+    settings.setValue("CatchUpCapacity",        catchUpCapacity);
+    settings.setValue("CatchUpInterval",        catchUpInterval);
+    settings.setValue("DetectionTimeBudget",    detectionTimeBudget);
+    settings.setValue("ReuseEnabled",           REUSE_ENABLED);
+    settings.setValue("ReuseContrast",          reuseContrast);
+    settings.setValue("ReuseDifference",        reuseDifference);
+    settings.setValue("ReuseMaximum",           reuseMaximum);
+    settings.setValue("OfflineChunkOverlap",    offlineChunkOverlap);
+    settings.setValue("OfflineChunks",          offlineChunks);
+    settings.setValue("OfflineDecoderThreads",  offlineDecoderThreads);
+    settings.setValue("OfflineQueueSize",       offlineQueueSize);
+    settings.setValue("OfflineThreads",         offlineThreads);
+    settings.setValue("OfflineWriterThreads",   offlineWriterThreads);
+    settings.setValue("SaveDataASCII",          SAVE_DATA_ASCII);
+    settings.setValue("AOIBeadHghtRatio",       mCameraSession->beadAOIRatio.hght);
+    settings.setValue("AOIBeadWdthRatio",       mCameraSession->beadAOIRatio.wdth);
+    settings.setValue("AOIBeadXPosRatio",       mCameraSession->beadAOIRatio.xPos);
+    settings.setValue("AOIBeadYPosRatio",       mCameraSession->beadAOIRatio.yPos);
     settings.setValue("DataDirectory",          QString::fromStdString(dataDirectory));
     settings.setValue("DataDirectoryOffline",   dataDirectoryOffline);
     settings.setValue("DrawHaar",               Parameters::drawFlags.haar);
@@ -2773,6 +3731,9 @@ void MainWindow::saveSettings(QString filename)
     settings.setValue("SaveCircumference",      SAVE_CIRCUMFERENCE);
     settings.setValue("SavePosition",           SAVE_POSITION);
     settings.setValue("SaveEyeImage",           SAVE_EYE_IMAGE);
+    settings.setValue("OnlineProcessing",       ONLINE_PROCESSING);
+    settings.setValue("SaveRawContainer",       SAVE_RAW_CONTAINER);
+    settings.setValue("SaveRawCompressed",      SAVE_RAW_COMPRESSED);
     settings.setValue("SubSamplingFactor",      cameraSubSamplingFactor);
     settings.setValue("TrialTimeLength",        TrialTimeLengthLineEdit->text().toInt());
 
@@ -2802,6 +3763,8 @@ void MainWindow::saveParameters(QString filename, QString prefix, detectionParam
     settings.setValue(prefix + "FitMaximum",                mDetectionParameters.fitMaximum);
     settings.setValue(prefix + "ThresholdFitError",         mDetectionParameters.thresholdFitError);
     settings.setValue(prefix + "AspectRatioMin",            mDetectionParameters.thresholdAspectRatioMin);
+    settings.setValue(prefix + "BlinkContrast",             mDetectionParameters.thresholdBlinkContrast);
+    settings.setValue(prefix + "CircumferenceScaled",       mDetectionParameters.circumferenceScaled);
     settings.setValue(prefix + "GlintSize",                 mDetectionParameters.glintWdth);
     settings.setValue(prefix + "CircumferenceChangeUpper",  mDetectionParameters.thresholdChangeCircumferenceUpper);
     settings.setValue(prefix + "CircumferenceChangeLower",  mDetectionParameters.thresholdChangeCircumferenceLower);
@@ -2830,8 +3793,9 @@ void MainWindow::onResetParameters()
     mParameterWidgetEye ->reset();
     mParameterWidgetBead->reset();
 
-    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), Parameters::eyeAOI);
-    resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), Parameters::beadAOI);
+    resetVariablesHard(mDetectionVariablesEye,  mParameterWidgetEye ->getStructure(), mCameraSession->eyeAOI);
+    resetVariablesHard(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), mCameraSession->eyeAOIRght);
+    resetVariablesHard(mDetectionVariablesBead, mParameterWidgetBead->getStructure(), mCameraSession->beadAOI);
 }
 
 void MainWindow::onSetBeadDetection(int state)
@@ -2854,8 +3818,14 @@ void MainWindow::onSetBeadDetection(int state)
 
 void MainWindow::onSetOnlineProcessing(int state)
 {
-    if (state) { SAVE_EYE_IMAGE = false; }
-    else       { SAVE_EYE_IMAGE = true;  }
+    if (state) { ONLINE_PROCESSING = true;  }
+    else       { ONLINE_PROCESSING = false; }
+}
+
+void MainWindow::onSetSaveEyeImage(int state)
+{
+    if (state) { SAVE_EYE_IMAGE = true;  }
+    else       { SAVE_EYE_IMAGE = false; }
 }
 
 void MainWindow::onResetFlashIntensity()
@@ -2868,12 +3838,12 @@ void MainWindow::onResetFlashIntensity()
 void MainWindow::onSetCameraPixelClock(int value)
 {
     cameraPixelClock = value;
-    mUEyeOpencvCam.setPixelClock(cameraPixelClock);
+    mUEyeOpencvCam->setPixelClock(cameraPixelClock);
     CameraPixelClockLabel->setText(QString::number(cameraPixelClock));
 
     // Set new frame rate
 
-    std::vector<double> frameRateRange = mUEyeOpencvCam.getFrameRateRange();
+    std::vector<double> frameRateRange = mUEyeOpencvCam->getFrameRateRange();
     CameraFrameRateSlider->setDoubleRange(frameRateRange[0], frameRateRange[1]);
     CameraFrameRateSlider->setDoubleValue(frameRateRange[1]);
     onSetCameraFrameRate(frameRateRange[1]); // set frame-rate to maximum
@@ -2881,12 +3851,12 @@ void MainWindow::onSetCameraPixelClock(int value)
 
 void MainWindow::onSetCameraFrameRate(double value)
 {
-    cameraFrameRate = mUEyeOpencvCam.setFrameRate(value);
+    cameraFrameRate = mUEyeOpencvCam->setFrameRate(value);
     CameraFrameRateLabel->setText(QString::number(cameraFrameRate, 'f', 1));
 
     // Set new exposure
 
-    std::vector<double> exposureRange = mUEyeOpencvCam.getExposureRange();
+    std::vector<double> exposureRange = mUEyeOpencvCam->getExposureRange();
     CameraExposureSlider->setDoubleRange(exposureRange[0], exposureRange[1]);
     CameraExposureSlider->setDoubleValue(exposureRange[1]);
     onSetCameraExposure(exposureRange[1]);
@@ -2904,25 +3874,25 @@ void MainWindow::onCalibrateFrameRate()
 
 void MainWindow::onSetCameraExposure(double value)
 {
-    mUEyeOpencvCam.setExposure(value);
+    mUEyeOpencvCam->setExposure(value);
     CameraExposureLabel->setText(QString::number(value, 'f', 2));
 }
 
 void MainWindow::onSetCameraBlackLevelOffset(int value)
 {
-    double blackLevelOffset = mUEyeOpencvCam.setBlackLevelOffset(value);
+    double blackLevelOffset = mUEyeOpencvCam->setBlackLevelOffset(value);
     CameraBlackLevelOffsetLabel->setText(QString::number(blackLevelOffset));
 }
 
-void MainWindow::onSetCameraBlackLevelMode(int state) { mUEyeOpencvCam.setBlackLevelMode(state); }
-void MainWindow::onSetCameraGainBoost     (int state) { mUEyeOpencvCam.setGainBoost(state);      }
-void MainWindow::onSetCameraAutoGain      (int state) { mUEyeOpencvCam.setAutoGain(state);       }
+void MainWindow::onSetCameraBlackLevelMode(int state) { mUEyeOpencvCam->setBlackLevelMode(state); }
+void MainWindow::onSetCameraGainBoost     (int state) { mUEyeOpencvCam->setGainBoost(state);      }
+void MainWindow::onSetCameraAutoGain      (int state) { mUEyeOpencvCam->setAutoGain(state);       }
 
 void MainWindow::onSetCameraHardwareGain(int val)
 {
     if (!CameraHardwareGainAutoCheckBox->checkState())
     {
-        mUEyeOpencvCam.setHardwareGain(val);
+        mUEyeOpencvCam->setHardwareGain(val);
     }
 
     CameraHardwareGainLabel->setText(QString::number(val));
@@ -2949,16 +3919,16 @@ void MainWindow::onSetCameraSubSampling(int state)
     updateCamAOIx();
     updateCamAOIy();
 
-    if (Parameters::CAMERA_RUNNING)
+    if (mCameraSession->CAMERA_RUNNING)
     {
-        if (mUEyeOpencvCam.freeImageMemory())
+        if (mUEyeOpencvCam->freeImageMemory())
         {
-            if (mUEyeOpencvCam.setSubSampling(cameraSubSamplingFactor))
+            if (mUEyeOpencvCam->setSubSampling(cameraSubSamplingFactor))
             {
-                if (mUEyeOpencvCam.allocateMemory(Parameters::camAOI.wdth, Parameters::camAOI.hght))
+                if (mUEyeOpencvCam->allocateMemory(mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght))
                 {
-                    mUEyeOpencvCam.setAOI(Parameters::camAOI.xPos, Parameters::camAOI.yPos, Parameters::camAOI.wdth, Parameters::camAOI.hght);
-                    Parameters::CAMERA_READY = true;
+                    mUEyeOpencvCam->setAOI(mCameraSession->camAOI.xPos, mCameraSession->camAOI.yPos, mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght);
+                    mCameraSession->CAMERA_READY = true;
                 }
             }
         }
@@ -2975,23 +3945,27 @@ void MainWindow::onCropAOI()
     double fracHght;
 
     {
-        std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-        std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
+        std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
 
-        int absXPos = Parameters::eyeAOI.xPos + Parameters::camAOI.xPos;
-        int absYPos = Parameters::eyeAOI.yPos + Parameters::camAOI.yPos;
+        int absXPos = mCameraSession->eyeAOI.xPos + mCameraSession->camAOI.xPos;
+        int absYPos = mCameraSession->eyeAOI.yPos + mCameraSession->camAOI.yPos;
 
         fracXPos = absXPos / (double) cameraAOIWdthMax;
         fracYPos = absYPos / (double) cameraAOIHghtMax;
-        fracWdth = (Parameters::eyeAOI.wdth - cameraAOIWdthMin) / (double) (cameraAOIWdthMax - cameraAOIWdthMin);
-        fracHght = (Parameters::eyeAOI.hght - cameraAOIHghtMin) / (double) (cameraAOIHghtMax - cameraAOIHghtMin);
+        fracWdth = (mCameraSession->eyeAOI.wdth - cameraAOIWdthMin) / (double) (cameraAOIWdthMax - cameraAOIWdthMin);
+        fracHght = (mCameraSession->eyeAOI.hght - cameraAOIHghtMin) / (double) (cameraAOIHghtMax - cameraAOIHghtMin);
+
+        mCameraSession->eyeAOIRatio.xPos = 1.0;
+        mCameraSession->eyeAOIRatio.yPos = 1.0;
+        mCameraSession->eyeAOIRatio.wdth = 1.0;
+        mCameraSession->eyeAOIRatio.hght = 1.0;
 
-        Parameters::eyeAOIRatio.xPos = 1.0;
-        Parameters::eyeAOIRatio.yPos = 1.0;
-        Parameters::eyeAOIRatio.wdth = 1.0;
-        Parameters::eyeAOIRatio.hght = 1.0;
+        BINOCULAR_MODE = false; // cropped AOI only contains first eye
     }
 
+    CamQImage->showAOIEyeRght(false);
+
     CamAOIXPosSlider->setDoubleValue(fracXPos);
     CamAOIYPosSlider->setDoubleValue(fracYPos);
     CamAOIWdthSlider->setDoubleValue(fracWdth);
@@ -3001,53 +3975,63 @@ void MainWindow::onCropAOI()
 
 void MainWindow::updateCamAOIx()
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-    Parameters::camAOI.wdth = floor(((cameraAOIWdthMax - cameraAOIWdthMin) * camAOIRatio.wdth + cameraAOIWdthMin) / (double) cameraAOIWdthStepSize) * cameraAOIWdthStepSize;
-    Parameters::camAOI.xPos = floor((cameraAOIWdthMax * camAOIRatio.xPos) / (double) cameraAOIWdthStepSize) * cameraAOIWdthStepSize;
-    CamAOIXPosSlider->setDoubleMaximum((cameraAOIWdthMax - Parameters::camAOI.wdth) / (double) cameraAOIWdthMax);
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+    mCameraSession->camAOI.wdth = floor(((cameraAOIWdthMax - cameraAOIWdthMin) * camAOIRatio.wdth + cameraAOIWdthMin) / (double) cameraAOIWdthStepSize) * cameraAOIWdthStepSize;
+    mCameraSession->camAOI.xPos = floor((cameraAOIWdthMax * camAOIRatio.xPos) / (double) cameraAOIWdthStepSize) * cameraAOIWdthStepSize;
+    CamAOIXPosSlider->setDoubleMaximum((cameraAOIWdthMax - mCameraSession->camAOI.wdth) / (double) cameraAOIWdthMax);
     updateAOIx();
 }
 
 void MainWindow::updateCamAOIy()
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-    Parameters::camAOI.hght = floor(((cameraAOIHghtMax - cameraAOIHghtMin) * camAOIRatio.hght + cameraAOIHghtMin) / (double) cameraAOIHghtStepSize) * cameraAOIHghtStepSize;
-    Parameters::camAOI.yPos = floor((cameraAOIHghtMax * camAOIRatio.yPos) / (double) cameraAOIHghtStepSize) * cameraAOIHghtStepSize;
-    CamAOIYPosSlider->setDoubleMaximum((cameraAOIHghtMax - Parameters::camAOI.hght) / (double) cameraAOIHghtMax);
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+    mCameraSession->camAOI.hght = floor(((cameraAOIHghtMax - cameraAOIHghtMin) * camAOIRatio.hght + cameraAOIHghtMin) / (double) cameraAOIHghtStepSize) * cameraAOIHghtStepSize;
+    mCameraSession->camAOI.yPos = floor((cameraAOIHghtMax * camAOIRatio.yPos) / (double) cameraAOIHghtStepSize) * cameraAOIHghtStepSize;
+    CamAOIYPosSlider->setDoubleMaximum((cameraAOIHghtMax - mCameraSession->camAOI.hght) / (double) cameraAOIHghtMax);
     updateAOIy();
 }
 
 void MainWindow::updateAOIx()
 {
-    { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-        Parameters::eyeAOI.wdth = round(Parameters::camAOI.wdth * Parameters::eyeAOIRatio.wdth);
-        Parameters::eyeAOI.xPos = round(Parameters::camAOI.wdth * Parameters::eyeAOIRatio.xPos);
-        if (Parameters::eyeAOI.xPos + Parameters::eyeAOI.wdth > Parameters::camAOI.wdth)
-        {   Parameters::eyeAOI.xPos = Parameters::camAOI.wdth - Parameters::eyeAOI.wdth; }
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+        mCameraSession->eyeAOI.wdth = round(mCameraSession->camAOI.wdth * mCameraSession->eyeAOIRatio.wdth);
+        mCameraSession->eyeAOI.xPos = round(mCameraSession->camAOI.wdth * mCameraSession->eyeAOIRatio.xPos);
+        if (mCameraSession->eyeAOI.xPos + mCameraSession->eyeAOI.wdth > mCameraSession->camAOI.wdth)
+        {   mCameraSession->eyeAOI.xPos = mCameraSession->camAOI.wdth - mCameraSession->eyeAOI.wdth; }
+
+        mCameraSession->eyeAOIRght.wdth = round(mCameraSession->camAOI.wdth * mCameraSession->eyeAOIRatioRght.wdth);
+        mCameraSession->eyeAOIRght.xPos = round(mCameraSession->camAOI.wdth * mCameraSession->eyeAOIRatioRght.xPos);
+        if (mCameraSession->eyeAOIRght.xPos + mCameraSession->eyeAOIRght.wdth > mCameraSession->camAOI.wdth)
+        {   mCameraSession->eyeAOIRght.xPos = mCameraSession->camAOI.wdth - mCameraSession->eyeAOIRght.wdth; }
     }
 
-    { std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-        Parameters::beadAOI.wdth = round(Parameters::camAOI.wdth * Parameters::beadAOIRatio.wdth);
-        Parameters::beadAOI.xPos = round(Parameters::camAOI.wdth * Parameters::beadAOIRatio.xPos);
-        if (Parameters::beadAOI.xPos + Parameters::beadAOI.wdth > Parameters::camAOI.wdth)
-        {   Parameters::beadAOI.xPos = Parameters::camAOI.wdth - Parameters::beadAOI.wdth; }
+    { std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+        mCameraSession->beadAOI.wdth = round(mCameraSession->camAOI.wdth * mCameraSession->beadAOIRatio.wdth);
+        mCameraSession->beadAOI.xPos = round(mCameraSession->camAOI.wdth * mCameraSession->beadAOIRatio.xPos);
+        if (mCameraSession->beadAOI.xPos + mCameraSession->beadAOI.wdth > mCameraSession->camAOI.wdth)
+        {   mCameraSession->beadAOI.xPos = mCameraSession->camAOI.wdth - mCameraSession->beadAOI.wdth; }
     }
 }
 
 void MainWindow::updateAOIy()
 {
-    { std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-        Parameters::eyeAOI.hght = round(Parameters::camAOI.hght * Parameters::eyeAOIRatio.hght);
-        Parameters::eyeAOI.yPos = round(Parameters::camAOI.hght * Parameters::eyeAOIRatio.yPos);
-        if (Parameters::eyeAOI.yPos + Parameters::eyeAOI.hght > Parameters::camAOI.hght)
-        {   Parameters::eyeAOI.yPos = Parameters::camAOI.hght - Parameters::eyeAOI.hght; }
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+        mCameraSession->eyeAOI.hght = round(mCameraSession->camAOI.hght * mCameraSession->eyeAOIRatio.hght);
+        mCameraSession->eyeAOI.yPos = round(mCameraSession->camAOI.hght * mCameraSession->eyeAOIRatio.yPos);
+        if (mCameraSession->eyeAOI.yPos + mCameraSession->eyeAOI.hght > mCameraSession->camAOI.hght)
+        {   mCameraSession->eyeAOI.yPos = mCameraSession->camAOI.hght - mCameraSession->eyeAOI.hght; }
+
+        mCameraSession->eyeAOIRght.hght = round(mCameraSession->camAOI.hght * mCameraSession->eyeAOIRatioRght.hght);
+        mCameraSession->eyeAOIRght.yPos = round(mCameraSession->camAOI.hght * mCameraSession->eyeAOIRatioRght.yPos);
+        if (mCameraSession->eyeAOIRght.yPos + mCameraSession->eyeAOIRght.hght > mCameraSession->camAOI.hght)
+        {   mCameraSession->eyeAOIRght.yPos = mCameraSession->camAOI.hght - mCameraSession->eyeAOIRght.hght; }
     }
 
-    { std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-        Parameters::beadAOI.hght = round(Parameters::camAOI.hght * Parameters::beadAOIRatio.hght);
-        Parameters::beadAOI.yPos = round(Parameters::camAOI.hght * Parameters::beadAOIRatio.yPos);
-        if (Parameters::beadAOI.yPos + Parameters::beadAOI.hght > Parameters::camAOI.hght)
-        {   Parameters::beadAOI.yPos = Parameters::camAOI.hght - Parameters::beadAOI.hght; }
+    { std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+        mCameraSession->beadAOI.hght = round(mCameraSession->camAOI.hght * mCameraSession->beadAOIRatio.hght);
+        mCameraSession->beadAOI.yPos = round(mCameraSession->camAOI.hght * mCameraSession->beadAOIRatio.yPos);
+        if (mCameraSession->beadAOI.yPos + mCameraSession->beadAOI.hght > mCameraSession->camAOI.hght)
+        {   mCameraSession->beadAOI.yPos = mCameraSession->camAOI.hght - mCameraSession->beadAOI.hght; }
     }
 }
 
@@ -3056,22 +4040,22 @@ void MainWindow::onSetCamAOI()
     std::lock_guard<std::mutex> AOILock_1(mutexAOI_1);
     std::lock_guard<std::mutex> AOILock_2(mutexAOI_2);
 
-    Parameters::camAOI = camAOITemp;
+    mCameraSession->camAOI = camAOITemp;
 
     updateAOIx();
     updateAOIy();
 
-    if (mUEyeOpencvCam.freeImageMemory())
+    if (mUEyeOpencvCam->freeImageMemory())
     {
-        if (mUEyeOpencvCam.allocateMemory(Parameters::camAOI.wdth, Parameters::camAOI.hght))
+        if (mUEyeOpencvCam->allocateMemory(mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght))
         {
             if
-                    (Parameters::camAOI.xPos + Parameters::camAOI.wdth <= cameraAOIWdthMax &&
-                     Parameters::camAOI.yPos + Parameters::camAOI.hght <= cameraAOIHghtMax)
+                    (mCameraSession->camAOI.xPos + mCameraSession->camAOI.wdth <= cameraAOIWdthMax &&
+                     mCameraSession->camAOI.yPos + mCameraSession->camAOI.hght <= cameraAOIHghtMax)
             {
-                if (mUEyeOpencvCam.setAOI(Parameters::camAOI.xPos, Parameters::camAOI.yPos, Parameters::camAOI.wdth, Parameters::camAOI.hght))
+                if (mUEyeOpencvCam->setAOI(mCameraSession->camAOI.xPos, mCameraSession->camAOI.yPos, mCameraSession->camAOI.wdth, mCameraSession->camAOI.hght))
                 {
-                    Parameters::CAMERA_READY = true;
+                    mCameraSession->CAMERA_READY = true;
                     getCameraParameters();
                 }
             }
@@ -3107,38 +4091,54 @@ void MainWindow::onSetCamAOIYPos(double fraction)
 
 void MainWindow::onSetEyeAOIWdth(double ratio)
 {
-    std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-    Parameters::eyeAOIRatio.wdth = ratio;
-    Parameters::eyeAOI.wdth = round(Parameters::camAOI.wdth * Parameters::eyeAOIRatio.wdth);
-    if (Parameters::eyeAOI.xPos + Parameters::eyeAOI.wdth > Parameters::camAOI.wdth)
-    {   Parameters::eyeAOI.xPos = Parameters::camAOI.wdth - Parameters::eyeAOI.wdth; }
+    std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+    mCameraSession->eyeAOIRatio.wdth = ratio;
+    mCameraSession->eyeAOI.wdth = round(mCameraSession->camAOI.wdth * mCameraSession->eyeAOIRatio.wdth);
+    if (mCameraSession->eyeAOI.xPos + mCameraSession->eyeAOI.wdth > mCameraSession->camAOI.wdth)
+    {   mCameraSession->eyeAOI.xPos = mCameraSession->camAOI.wdth - mCameraSession->eyeAOI.wdth; }
+
+    if (BINOCULAR_MODE) // both eyes have same AOI size
+    {
+        mCameraSession->eyeAOIRatioRght.wdth = ratio;
+        mCameraSession->eyeAOIRght.wdth = mCameraSession->eyeAOI.wdth;
+        if (mCameraSession->eyeAOIRght.xPos + mCameraSession->eyeAOIRght.wdth > mCameraSession->camAOI.wdth)
+        {   mCameraSession->eyeAOIRght.xPos = mCameraSession->camAOI.wdth - mCameraSession->eyeAOIRght.wdth; }
+    }
 }
 
 void MainWindow::onSetEyeAOIHght(double ratio)
 {
-    std::lock_guard<std::mutex> AOIEyeLock(Parameters::AOIEyeMutex);
-    Parameters::eyeAOIRatio.hght = ratio;
-    Parameters::eyeAOI.hght      = round(Parameters::camAOI.hght * Parameters::eyeAOIRatio.hght);
-    if (Parameters::eyeAOI.yPos + Parameters::eyeAOI.hght > Parameters::camAOI.hght)
-    {   Parameters::eyeAOI.yPos = Parameters::camAOI.hght - Parameters::eyeAOI.hght; }
+    std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+    mCameraSession->eyeAOIRatio.hght = ratio;
+    mCameraSession->eyeAOI.hght      = round(mCameraSession->camAOI.hght * mCameraSession->eyeAOIRatio.hght);
+    if (mCameraSession->eyeAOI.yPos + mCameraSession->eyeAOI.hght > mCameraSession->camAOI.hght)
+    {   mCameraSession->eyeAOI.yPos = mCameraSession->camAOI.hght - mCameraSession->eyeAOI.hght; }
+
+    if (BINOCULAR_MODE)
+    {
+        mCameraSession->eyeAOIRatioRght.hght = ratio;
+        mCameraSession->eyeAOIRght.hght = mCameraSession->eyeAOI.hght;
+        if (mCameraSession->eyeAOIRght.yPos + mCameraSession->eyeAOIRght.hght > mCameraSession->camAOI.hght)
+        {   mCameraSession->eyeAOIRght.yPos = mCameraSession->camAOI.hght - mCameraSession->eyeAOIRght.hght; }
+    }
 }
 
 void MainWindow::onSetBeadAOIWdth(double ratio)
 {
-    std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-    Parameters::beadAOIRatio.wdth = ratio;
-    Parameters::beadAOI.wdth      = round(Parameters::camAOI.wdth * Parameters::beadAOIRatio.wdth);
-    if (Parameters::beadAOI.xPos + Parameters::beadAOI.wdth > Parameters::camAOI.wdth)
-    {   Parameters::beadAOI.xPos = Parameters::camAOI.wdth - Parameters::beadAOI.wdth; }
+    std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+    mCameraSession->beadAOIRatio.wdth = ratio;
+    mCameraSession->beadAOI.wdth      = round(mCameraSession->camAOI.wdth * mCameraSession->beadAOIRatio.wdth);
+    if (mCameraSession->beadAOI.xPos + mCameraSession->beadAOI.wdth > mCameraSession->camAOI.wdth)
+    {   mCameraSession->beadAOI.xPos = mCameraSession->camAOI.wdth - mCameraSession->beadAOI.wdth; }
 }
 
 void MainWindow::onSetBeadAOIHght(double ratio)
 {
-    std::lock_guard<std::mutex> AOIBeadLock(Parameters::AOIBeadMutex);
-    Parameters::beadAOIRatio.hght = ratio;
-    Parameters::beadAOI.hght      = round(Parameters::camAOI.hght * Parameters::beadAOIRatio.hght);
-    if (Parameters::beadAOI.yPos + Parameters::beadAOI.hght > Parameters::camAOI.hght)
-    {   Parameters::beadAOI.yPos = Parameters::camAOI.hght  - Parameters::beadAOI.hght; }
+    std::lock_guard<std::mutex> AOIBeadLock(mCameraSession->AOIBeadMutex);
+    mCameraSession->beadAOIRatio.hght = ratio;
+    mCameraSession->beadAOI.hght      = round(mCameraSession->camAOI.hght * mCameraSession->beadAOIRatio.hght);
+    if (mCameraSession->beadAOI.yPos + mCameraSession->beadAOI.hght > mCameraSession->camAOI.hght)
+    {   mCameraSession->beadAOI.yPos = mCameraSession->camAOI.hght  - mCameraSession->beadAOI.hght; }
 }
 
 void MainWindow::onSetFlashAOIXPosLeft(int val) { flashAOILeft.xPos = val; }
@@ -3158,6 +4158,11 @@ void MainWindow::onSetFlashThreshold(int val)
 
 void MainWindow::onSetAOIEyeLeft()
 {
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        BINOCULAR_MODE = false;
+    }
+    CamQImage->showAOIEyeRght(false);
+
     CamAOIXPosSlider->setDoubleValue(camAOIRatioLeft.xPos);
     CamAOIYPosSlider->setDoubleValue(camAOIRatioLeft.yPos);
     CamAOIWdthSlider->setDoubleValue(camAOIRatioLeft.wdth);
@@ -3170,6 +4175,11 @@ void MainWindow::onSetAOIEyeLeft()
 
 void MainWindow::onSetAOIEyeRght()
 {
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        BINOCULAR_MODE = false;
+    }
+    CamQImage->showAOIEyeRght(false);
+
     CamAOIXPosSlider->setDoubleValue(camAOIRatioRght.xPos);
     CamAOIYPosSlider->setDoubleValue(camAOIRatioRght.yPos);
     CamAOIWdthSlider->setDoubleValue(camAOIRatioRght.wdth);
@@ -3180,6 +4190,59 @@ void MainWindow::onSetAOIEyeRght()
     CamQImage->setAOIFlash(flashAOI);
 }
 
+void MainWindow::onSetAOIEyeBoth()
+{
+    // Camera AOI that contains both the left and right eye AOI (in pixels)
+
+    int xPosLeft = cameraAOIWdthMax * camAOIRatioLeft.xPos;
+    int yPosLeft = cameraAOIHghtMax * camAOIRatioLeft.yPos;
+    int wdthLeft = (cameraAOIWdthMax - cameraAOIWdthMin) * camAOIRatioLeft.wdth + cameraAOIWdthMin;
+    int hghtLeft = (cameraAOIHghtMax - cameraAOIHghtMin) * camAOIRatioLeft.hght + cameraAOIHghtMin;
+
+    int xPosRght = cameraAOIWdthMax * camAOIRatioRght.xPos;
+    int yPosRght = cameraAOIHghtMax * camAOIRatioRght.yPos;
+    int wdthRght = (cameraAOIWdthMax - cameraAOIWdthMin) * camAOIRatioRght.wdth + cameraAOIWdthMin;
+    int hghtRght = (cameraAOIHghtMax - cameraAOIHghtMin) * camAOIRatioRght.hght + cameraAOIHghtMin;
+
+    int xPos = std::min(xPosLeft, xPosRght);
+    int yPos = std::min(yPosLeft, yPosRght);
+    int wdth = std::max(xPosLeft + wdthLeft, xPosRght + wdthRght) - xPos;
+    int hght = std::max(yPosLeft + hghtLeft, yPosRght + hghtRght) - yPos;
+
+    if (xPos + wdth > cameraAOIWdthMax) { wdth = cameraAOIWdthMax - xPos; }
+    if (yPos + hght > cameraAOIHghtMax) { hght = cameraAOIHghtMax - yPos; }
+
+    CamAOIXPosSlider->setDoubleValue(xPos / (double) cameraAOIWdthMax);
+    CamAOIYPosSlider->setDoubleValue(yPos / (double) cameraAOIHghtMax);
+    CamAOIWdthSlider->setDoubleValue((wdth - cameraAOIWdthMin) / (double) (cameraAOIWdthMax - cameraAOIWdthMin));
+    CamAOIHghtSlider->setDoubleValue((hght - cameraAOIHghtMin) / (double) (cameraAOIHghtMax - cameraAOIHghtMin));
+
+    // Eye AOIs relative to combined camera AOI
+
+    { std::lock_guard<std::mutex> AOIEyeLock(mCameraSession->AOIEyeMutex);
+        mCameraSession->eyeAOIRatio.xPos     = (xPosLeft - xPos) / (double) wdth;
+        mCameraSession->eyeAOIRatio.yPos     = (yPosLeft - yPos) / (double) hght;
+        mCameraSession->eyeAOIRatio.wdth     = wdthLeft / (double) wdth;
+        mCameraSession->eyeAOIRatio.hght     = hghtLeft / (double) hght;
+        mCameraSession->eyeAOIRatioRght.xPos = (xPosRght - xPos) / (double) wdth;
+        mCameraSession->eyeAOIRatioRght.yPos = (yPosRght - yPos) / (double) hght;
+        mCameraSession->eyeAOIRatioRght.wdth = wdthRght / (double) wdth;
+        mCameraSession->eyeAOIRatioRght.hght = hghtRght / (double) hght;
+    }
+
+    onSetCamAOI();
+
+    { std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+        BINOCULAR_MODE = true;
+        resetVariablesHard(mDetectionVariablesEyeRght, mParameterWidgetEye->getStructure(), mCameraSession->eyeAOIRght);
+    }
+
+    flashAOI = flashAOILeft;
+    CamQImage->setAOIFlash(flashAOI);
+    CamQImage->setAOIEyeRght(mCameraSession->eyeAOIRght);
+    CamQImage->showAOIEyeRght(true);
+}
+
 void MainWindow::onSetTrialIndex           (int val)   { trialIndex                 =   val; }
 void MainWindow::onSetSaveDataAspectRatio  (int state) { SAVE_ASPECT_RATIO          = state; }
 void MainWindow::onSetSaveDataCircumference(int state) { SAVE_CIRCUMFERENCE         = state; }
@@ -3199,12 +4262,16 @@ void MainWindow::setCurvatureMeasurement(detectionParameters& mDetectionParamete
     mDetectionParameters.thresholdScoreDiffEdge     = 1.0;
     mDetectionParameters.curvatureOffset            = 360;
     mDetectionParameters.glintWdth                  = 0.0;
+    mDetectionParameters.thresholdBlinkContrast     = 0.0;
+    mDetectionParameters.circumferenceScaled        = 0.0;
 }
 
 void MainWindow::onSetSaveDataEdge (int state) { SAVE_DATA_EDGE  = state; }
 void MainWindow::onSetSaveDataFit  (int state) { SAVE_DATA_FIT   = state; }
 void MainWindow::onSetSaveDataExtra(int state) { SAVE_DATA_EXTRA = state; }
 
+void MainWindow::onSetSaveProcessedImages(int state) { SAVE_PROCESSED_IMAGES = state; }
+
 double MainWindow::flashDetection(const cv::Mat& imgBGR)
 {
     int imgSize = imgBGR.cols * imgBGR.rows;
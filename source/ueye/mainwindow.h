@@ -23,18 +23,34 @@
 
 // Files
 
+#include "../camerasession.h"
+#include "../catchuptracker.h"
 #include "../confirmationwindow.h"
 #include "../constants.h"
+#include "../diagnosticsarena.h"
 #include "../drawfunctions.h"
+#include "../eventtracer.h"
 #include "../eyestalker.h"
+#include "../framecontainer.h"
+#include "../frameprefetcher.h"
+#include "../framewriter.h"
+#include "../overlayfile.h"
 #include "../parameters.h"
 #include "../parameterwidget.h"
+#include "../preprocessedframe.h"
+#include "../resultstream.h"
+#include "../stageprofiler.h"
 #include "../sliderdouble.h"
 #include "../structures.h"
+#include "../taskworker.h"
+#include "../temporalreuse.h"
+#include "../trackingdata.h"
+#include "../trialpool.h"
 #include "../qimageopencv.h"
 #include "../variablewidget.h"
 
 #include "qwtplotwidget.h"
+#include "trackermanager.h"
 #include "ueyeopencv.h"
 
 // Standard Template
@@ -42,9 +58,11 @@
 #include <chrono>
 #include <condition_variable> // std::condition_variable
 #include <ctime>        // for current date
+#include <deque>
 #include <fstream>      // std::ofstream
 #include <iomanip>
 #include <iostream>     // std::ofstream
+#include <memory>
 #include <thread>
 
 // Directory creation
@@ -105,6 +123,19 @@
 #include <QVBoxLayout>
 #include <QWidget>
 
+struct trialExport // session file of a trial, written in background after trial has ended
+{
+    bool PLOT; // trial results are shown once export is done
+    bool SAVE_ASPECT_RATIO;
+    bool SAVE_CIRCUMFERENCE;
+    bool SAVE_POSITION;
+    int framesSkipped; // detected by catch-up tracker, collected before export
+    int trialNumber;   // of catch-up tracker
+    std::string filename;           // session file, skipped if empty
+    std::string filenameTimestamps; // time stamps of saved frames, skipped if empty
+    std::string streamFilename;     // results written during trial
+};
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -118,6 +149,7 @@ private:
 
     bool APP_EXIT;
     bool APP_RUNNING;
+    bool BINOCULAR_MODE; // track left and right eye simultaneously
     bool TRIAL_RECORDING;
     bool FLASH_STANDBY;
     bool OFFLINE_SAVE_DATA;
@@ -179,6 +211,8 @@ private:
     QLabel *CameraFrameRateLabel;
     QLabel *CameraHardwareGainLabel;
     QLabel *CameraPixelClockLabel;
+    QLabel *CameraTelemetryLabel;
+    QLabel *CameraTrialWarningLabel;
     QLabel *DataAnalysisTitleTextBox;
     QLabel *DataDirectoryTextBox;
     QLabel *FlashStandbyLabel;
@@ -224,6 +258,7 @@ private:
 
     QCheckBox* BeadDetectionCheckBox;
     QCheckBox *OnlineProcessingCheckBox;
+    QCheckBox *SaveEyeImageCheckBox;
 
     // Interface
 
@@ -268,28 +303,38 @@ private:
 
     cv::Mat imageCamera;
 
-    UEyeOpencvCam mUEyeOpencvCam;
+    CameraSession *mCameraSession; // session of main camera, owned by tracker manager
+    TrackerManager mTrackerManager;
+    UEyeOpencvCam *mUEyeOpencvCam;
+
+    int numberOfCameras; // additional cameras are tracked without interface
 
     void findCamera();
     void getCameraParameters();
 
     // Variables and parameters
 
-    void resetVariablesHard(detectionVariables&, const detectionParameters&, const AOIProperties&);
-    void resetVariablesSoft(detectionVariables&, const detectionParameters&, const AOIProperties&);
-
     detectionVariables mDetectionVariablesBead;
     detectionVariables mDetectionVariablesEye;
+    detectionVariables mDetectionVariablesEyeRght;
 
     std::vector<detectionVariables> vDetectionVariablesBead;
     std::vector<detectionVariables> vDetectionVariablesEye;
 
+    std::vector<detectionVariables> vDetectionVariablesEyeRght;
+
     std::vector<dataVariables> vDataVariablesEye;
+    std::vector<dataVariables> vDataVariablesEyeRght;
     std::vector<dataVariables> vDataVariablesBead;
 
+    DiagnosticsArena mDiagnosticsArena; // per-edge and per-fit data of trial (first eye), only kept when it is saved
+
     drawVariables mDrawVariablesEye;
     dataVariables mDataVariablesEye;
 
+    drawVariables mDrawVariablesEyeRght; // second eye in binocular mode, uses eye parameters
+    dataVariables mDataVariablesEyeRght;
+
     drawVariables mDrawVariablesBead;
     dataVariables mDataVariablesBead;
 
@@ -315,13 +360,57 @@ private:
     bool SAVE_ASPECT_RATIO;
     bool SAVE_CIRCUMFERENCE;
     bool SAVE_POSITION;
-    bool SAVE_EYE_IMAGE;
+    bool SAVE_EYE_IMAGE;    // raw frames are saved during trial
+    bool ONLINE_PROCESSING; // frames are tracked during trial, also while raw frames are saved
+    bool SAVE_RAW_COMPRESSED; // lossless compression of frames in container
+    bool SAVE_RAW_CONTAINER;  // one container file per trial instead of one PNG per frame
+
+    FrameWriter mFrameWriter; // writes raw frames in background when saving eye images
+    int frameWriterQueueSize; // in frames
+    int frameWriterThreads;
+
+    ResultStream mResultStream; // writes tracking results to disk while trial is recorded
+    StageProfiler mStageProfiler; // stage timing of live tracking (first eye), only measured in profiling builds
+    int resultQueueSize;        // in frames
+    std::string resultStreamFilenameTrial;
+    bool EXPORT_ACTIVE;
+    std::condition_variable exportCV;
+    std::deque<trialExport> qExports; // trials that have ended, exported in order by export thread
+    std::mutex exportMutex;
+    std::thread exportThread;
+    std::mutex plotMutex;
+    std::vector<resultRecord> vRecordsPlot; // results of last exported trial, handed to GUI for plotting
+    std::mutex trialWarningMutex;
+    std::string trialWarnings;  // problems of last trial, also added by export thread, shown below telemetry
+
+    bool CATCH_UP_ENABLED; // skip detection of frames while tracking is behind camera, and detect them later
+    int catchUpBacklogHigh; // frames waiting in camera ring before frames are skipped
+    int catchUpBacklogLow;
+    int catchUpCapacity;    // skipped frames kept in memory
+    int catchUpInterval;    // every n-th frame is still detected live while skipping
+    CatchUpTracker mCatchUpTracker; // kept for session, results of a trial are collected by export thread
+
+    double detectionTimeBudget; // ms per frame for live detection, frame period if 0, no limit if negative
+
+    bool REUSE_ENABLED;     // re-use last detection while eye image hardly changes (fixations)
+    double reuseContrast;   // fraction of pupil contour contrast of last detection that must remain
+    double reuseDifference; // mean grey level difference per pixel with last detected frame
+    int reuseMaximum;       // frames re-used in a row
+    TemporalReuse mTemporalReuseEye;
+    TemporalReuse mTemporalReuseEyeRght;
+    TaskWorker mWorkerEyeRght; // tracks right eye next to the tracking thread in binocular mode
 
     unsigned long long absoluteTime; // in units of 0.1 microseconds
     unsigned long long startTime;
+    unsigned long long startTimeHost; // host clock, used to merge data of multiple cameras
 
     void startTrialRecording();
+    void saveTrace(); // at end of trial, if trace is recorded
     void saveTrialData();
+    void addTrialWarning(const std::string&);
+    void exportTrialRecording(const trialExport&); // from result stream into session file and time stamps of saved frames, after skipped frames were detected
+    void finishExports(); // exports remaining trials and stops export thread
+    void threadExport();
 
     // Offline interface
 
@@ -331,12 +420,26 @@ private:
 
     void countNumTrials();
     void countNumImages();
+    cv::Mat loadImageRaw(int); // from trial container or PNG file
+
+    FrameContainerReader mFrameContainerReader;
+    OverlayReader mOverlayReader; // detection results of trial, drawn on raw frames
 
     void setupOfflineSession();
     void updateOfflineTrial();
 
+    std::vector<drawVariables> detectFrame(int imageIndex, const cv::Mat& imageRaw); // returns overlays of all tracked objects, empty if frame is missing
     void detectCurrentFrame(int);
     void detectAllFrames();
+    void detectAllTrialsParallel(); // one trial per thread, without saving processed images
+    void exportTrialData(); // semicolon-delimited text files, next to binary tracking data
+
+    int offlineChunkOverlap; // warm-up frames before each chunk
+    int offlineChunks; // each trial is split in chunks that are tracked in parallel
+    int offlineDecoderThreads; // frames decoded ahead of tracking thread
+    int offlineQueueSize; // decoded frames and processed images held in memory
+    int offlineThreads; // number of trials tracked at once, 0 uses all cores, 1 tracks serially and saves processed images
+    int offlineWriterThreads; // exported processed images written behind tracking thread
 
     void setCurvatureMeasurement(detectionParameters&, int);
 
@@ -344,10 +447,13 @@ private:
 
     developmentOptions mAdvancedOptions;
 
+    bool SAVE_DATA_ASCII;
     bool SAVE_DATA_EDGE;
     bool SAVE_DATA_FIT;
     bool SAVE_DATA_EXTRA;
 
+    bool SAVE_PROCESSED_IMAGES; // overlays are always saved, images only on request
+
     // General
 
     void msWait(int ms);
@@ -369,6 +475,7 @@ private slots:
 
     void onCombineData              ();
     void onSetCamAOI                ();
+    void onBenchmarkCodec           ();
     void onCalibrateFrameRate       ();
     void onCropAOI                  ();
     void onDetectAllExperiments     ();
@@ -381,11 +488,14 @@ private slots:
     void onImageNext                ();
     void onImagePrevious            ();
     void onLoadSession              ();
+    void onPackRawImages            ();
     void onPlotTrialData            ();
     void onQuitButtonClicked        ();
     void onResetFlashIntensity      ();
     void onResetParameters          ();
+    void onSaveTrace                ();
     void onSaveTrialData            ();
+    void onSetAOIEyeBoth            ();
     void onSetAOIEyeLeft            ();
     void onSetAOIEyeRght            ();
     void onSetBeadDetection         (int);
@@ -407,6 +517,7 @@ private slots:
     void onSetCameraSubSampling     (int);
     void onSetAdvancedMode          (bool);
     void onSetDrawEdge              (int);
+    void onSetTracing               (bool);
     void onSetDrawElps              (int);
     void onSetDrawHaar              (int);
     void onSetEyeAOIHght            (double);
@@ -424,12 +535,14 @@ private slots:
     void onSetOfflineMode           (int);
     void onSetPupilPosition         (double, double);
     void onSetOnlineProcessing      (int);
+    void onSetSaveEyeImage          (int);
     void onSetSaveDataAspectRatio   (int);
     void onSetSaveDataCircumference (int);
     void onSetSaveDataPosition      (int);
     void onSetTrialIndex            (int);
     void onSetTrialOffline          (int);
     void onStartRecordingManual     ();
+    void onUnpackRawImages          ();
     void onUpdateCameraImage        ();
     void onUpdateImageProcessed     (int);
     void onUpdateImageRaw           (int);
@@ -442,6 +555,8 @@ private slots:
     void onSetSaveDataFit  (int);
     void onSetSaveDataExtra(int);
 
+    void onSetSaveProcessedImages(int);
+
 };
 
 #endif // MAINWINDOW_H
@@ -16,13 +16,15 @@
 
 #include "qwtplotwidget.h"
 
-QwtPlotWidget::QwtPlotWidget(QWidget *parent) : QWidget(parent)
+QwtPlotWidget::QwtPlotWidget(CameraSession *session, QWidget *parent) : QWidget(parent)
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    mCameraSession = session;
+
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
 
     mQwtPlot = new QwtPlot;
-    mQwtPlot->setAxisScale(QwtPlot::xBottom, 0, Parameters::camAOI.wdth, 0);
-    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, Parameters::camAOI.hght, 0);
+    mQwtPlot->setAxisScale(QwtPlot::xBottom, 0, mCameraSession->camAOI.wdth, 0);
+    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, mCameraSession->camAOI.hght, 0);
     mQwtPlot->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
     QVBoxLayout *MainLayout = new QVBoxLayout;
@@ -37,15 +39,15 @@ void QwtPlotWidget::setWidth(int W)
 
 QSize QwtPlotWidget::sizeHint() const
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
-    double aspectRatio = (double) Parameters::camAOI.hght / Parameters::camAOI.wdth;
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
+    double aspectRatio = (double) mCameraSession->camAOI.hght / mCameraSession->camAOI.wdth;
     double height = aspectRatio * widgetWdth;
     return QSize(widgetWdth, height);
 }
 
 void QwtPlotWidget::plotTrajectory(const std::vector<double>& x, const std::vector<double>& y)
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
 
     mQwtPlot->detachItems();
 
@@ -54,15 +56,15 @@ void QwtPlotWidget::plotTrajectory(const std::vector<double>& x, const std::vect
     curve->setPen(* new QPen(Qt::red));
     curve->attach(mQwtPlot);
 
-    mQwtPlot->setAxisScale(QwtPlot::xBottom, 0, Parameters::camAOI.wdth, 0);
-    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, Parameters::camAOI.hght, 0);
+    mQwtPlot->setAxisScale(QwtPlot::xBottom, 0, mCameraSession->camAOI.wdth, 0);
+    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, mCameraSession->camAOI.hght, 0);
 
     mQwtPlot->replot();
 }
 
 void QwtPlotWidget::plotTimeSeries(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& t, double trialLength)
 {
-    std::lock_guard<std::mutex> AOICamLock(Parameters::AOICamMutex);
+    std::lock_guard<std::mutex> AOICamLock(mCameraSession->AOICamMutex);
 
     mQwtPlot->detachItems();
 
@@ -77,7 +79,7 @@ void QwtPlotWidget::plotTimeSeries(const std::vector<double>& x, const std::vect
     yCurve->attach(mQwtPlot);
 
     mQwtPlot->setAxisScale(QwtPlot::xBottom, 0,             trialLength, 0);
-    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, Parameters::camAOI.wdth, 0);
+    mQwtPlot->setAxisScale(QwtPlot::yLeft,   0, mCameraSession->camAOI.wdth, 0);
 
     mQwtPlot->replot();
 }
@@ -17,6 +17,7 @@
 #ifndef QWTPLOTWIDGET_H
 #define QWTPLOTWIDGET_H
 
+#include "../camerasession.h"
 #include "../parameters.h"
 
 // Qt
@@ -36,7 +37,7 @@ class QwtPlotWidget : public QWidget
     Q_OBJECT
 
 public:
-    explicit QwtPlotWidget(QWidget *parent = 0);
+    explicit QwtPlotWidget(CameraSession *session, QWidget *parent = 0);
 
     QSize sizeHint() const;
 
@@ -48,6 +49,7 @@ public:
 
 private:
 
+    CameraSession *mCameraSession;
     QwtPlot* mQwtPlot;
     int widgetWdth;
 
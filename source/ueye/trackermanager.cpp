@@ -0,0 +1,349 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#include "trackermanager.h"
+
+TrackerPipeline::TrackerPipeline(int index) : index(index)
+{
+    TRACKING_ACTIVE = false;
+    TRIAL_RECORDING = false;
+
+    cpuCore = -1;
+
+    mUEyeOpencvCam.setCameraSession(&mCameraSession);
+}
+
+TrackerPipeline::~TrackerPipeline()
+{
+    stopTracking();
+}
+
+int TrackerPipeline::getCPUCore() { return cpuCore; }
+int TrackerPipeline::getIndex()   { return index; }
+
+void TrackerPipeline::setCPUCore(int core)
+{
+    cpuCore = core;
+    mUEyeOpencvCam.setCPUCore(core);
+}
+
+bool TrackerPipeline::startCamera(int subSamplingFactor, double frameRate)
+{
+    // Same start-up sequence as the main camera, but without retrying
+
+    int retInt = mUEyeOpencvCam.initCamera();
+
+    if      (retInt == 0) { return false; }
+    else if (retInt == 2)
+    {
+        mUEyeOpencvCam.exitCamera();
+        if (!mUEyeOpencvCam.initCamera()) { return false; }
+    }
+
+    if (!configureCamera(subSamplingFactor, frameRate))
+    {
+        mCameraSession.CAMERA_RUNNING = false;
+        mCameraSession.CAMERA_READY   = false;
+        mUEyeOpencvCam.exitCamera(); // camera was opened, so its handle must be released
+        return false;
+    }
+
+    return true;
+}
+
+bool TrackerPipeline::configureCamera(int subSamplingFactor, double frameRate)
+{
+    if (!mUEyeOpencvCam.setColorMode())                    { return false; }
+    if (!mUEyeOpencvCam.setSubSampling(subSamplingFactor)) { return false; }
+
+    AOIProperties camAOI = mCameraSession.camAOI;
+
+    if (!mUEyeOpencvCam.allocateMemory(camAOI.wdth, camAOI.hght))                   { return false; }
+    if (!mUEyeOpencvCam.setAOI(camAOI.xPos, camAOI.yPos, camAOI.wdth, camAOI.hght)) { return false; }
+
+    mCameraSession.CAMERA_RUNNING = true; // must be set before capture thread starts
+
+    if (!mUEyeOpencvCam.startVideoCapture()) { return false; }
+
+    mUEyeOpencvCam.setFrameRate(frameRate);
+    mUEyeOpencvCam.setAutoGain(true);
+
+    mCameraSession.CAMERA_READY = true;
+
+    return true;
+}
+
+void TrackerPipeline::startTracking(const detectionParameters& mDetectionParametersNew, const detectionVariables& mDetectionVariablesNew)
+{
+    if (TRACKING_ACTIVE) { return; }
+
+    mDetectionParameters = mDetectionParametersNew;
+    mDetectionVariables  = mDetectionVariablesNew;
+
+    TRACKING_ACTIVE = true;
+    trackingThread  = std::thread(&TrackerPipeline::threadTracking, this);
+}
+
+void TrackerPipeline::stopTracking()
+{
+    if (!TRACKING_ACTIVE) { return; }
+
+    stopRecording();
+    TRACKING_ACTIVE = false;
+
+    { std::lock_guard<std::mutex> frameLock(mCameraSession.frameCaptureMutex); // tracking thread cannot miss the notification
+        mCameraSession.CAMERA_RUNNING = false;
+    }
+
+    mCameraSession.frameCaptureCV.notify_all();
+
+    if (trackingThread.joinable()) { trackingThread.join(); }
+
+    mUEyeOpencvCam.exitCamera();
+}
+
+void TrackerPipeline::threadTracking()
+{
+    setThreadAffinity(cpuCore);
+
+    std::stringstream threadName;
+    threadName << "tracking (camera " << mCameraSession.cameraIndex << ")";
+    EventTracer::setThreadName(threadName.str());
+
+    unsigned long long timeHostPrevious = 0;
+
+    while (TRACKING_ACTIVE && mCameraSession.CAMERA_RUNNING && Parameters::ONLINE_MODE)
+    {
+        imageInfo mImageInfo = mUEyeOpencvCam.getFrame();
+
+        if (mImageInfo.image.empty() || mImageInfo.timeHost == timeHostPrevious) // no new frame
+        {
+            mUEyeOpencvCam.waitForFrame(timeHostPrevious); // woken by capture thread
+            continue;
+        }
+
+        timeHostPrevious = mImageInfo.timeHost;
+
+        AOIProperties AOICameraTemp;
+        AOIProperties AOIEyeTemp;
+
+        { TracedLock AOICamLock(mCameraSession.AOICamMutex, "AOICamMutex");
+            AOICameraTemp = mCameraSession.camAOI;
+        }
+
+        { TracedLock AOIEyeLock(mCameraSession.AOIEyeMutex, "AOIEyeMutex");
+            AOIEyeTemp = mCameraSession.eyeAOI;
+        }
+
+        if (mImageInfo.image.cols < AOIEyeTemp.xPos + AOIEyeTemp.wdth || mImageInfo.image.rows < AOIEyeTemp.yPos + AOIEyeTemp.hght) { continue; }
+
+        PreprocessedFrame mPreprocessedFrame(mImageInfo.image);
+
+        dataVariables mDataVariables;
+        drawVariables mDrawVariables;
+
+        TraceSpan mDetectSpan("detect");
+        mDetectionVariables = eyeStalker(mPreprocessedFrame, AOIEyeTemp, mDetectionVariables, mDetectionParameters, mDataVariables, mDrawVariables);
+        mDetectSpan.end();
+
+        if (TRIAL_RECORDING)
+        {
+            mDataVariables.absoluteXPos = mDataVariables.exactXPos + AOIEyeTemp.xPos + AOICameraTemp.xPos;
+            mDataVariables.absoluteYPos = mDataVariables.exactYPos + AOIEyeTemp.yPos + AOICameraTemp.yPos;
+            addSample(mDataVariables, mImageInfo.timeHost);
+        }
+    }
+}
+
+void TrackerPipeline::startRecording()
+{
+    clearSamples();
+
+    if (TRACKING_ACTIVE) { mUEyeOpencvCam.startRecording(); } // main camera is started by main window
+
+    TRIAL_RECORDING = true;
+}
+
+void TrackerPipeline::stopRecording()
+{
+    TRIAL_RECORDING = false;
+
+    if (TRACKING_ACTIVE)
+    {
+        mUEyeOpencvCam.stopRecording();
+        mCameraSession.frameCaptureCV.notify_all(); // release thread waiting for frames
+    }
+}
+
+void TrackerPipeline::addSample(const dataVariables& mDataVariables, unsigned long long timeHost)
+{
+    trackerSample mSample;
+    mSample.DETECTED      = mDataVariables.DETECTED;
+    mSample.aspectRatio   = mDataVariables.exactAspectRatio;
+    mSample.circumference = mDataVariables.exactCircumference;
+    mSample.xPos          = mDataVariables.absoluteXPos;
+    mSample.yPos          = mDataVariables.absoluteYPos;
+    mSample.cameraIndex   = index;
+    mSample.timeHost      = timeHost;
+
+    std::lock_guard<std::mutex> sampleLock(sampleMutex);
+    vSamples.push_back(mSample);
+}
+
+void TrackerPipeline::clearSamples()
+{
+    std::lock_guard<std::mutex> sampleLock(sampleMutex);
+    vSamples.clear();
+}
+
+std::vector<trackerSample> TrackerPipeline::getSamples()
+{
+    std::lock_guard<std::mutex> sampleLock(sampleMutex);
+    return vSamples;
+}
+
+TrackerManager::TrackerManager()
+{
+    vPipelines.emplace_back(new TrackerPipeline(0)); // main camera always exists
+}
+
+TrackerManager::~TrackerManager()
+{
+    stopPipelines();
+}
+
+TrackerPipeline* TrackerManager::getPipeline(int index) { return vPipelines[index].get(); }
+
+int TrackerManager::getNumberOfPipelines() { return vPipelines.size(); }
+
+void TrackerManager::setNumberOfPipelines(int numberOfPipelines)
+{
+    if (numberOfPipelines < 1) { numberOfPipelines = 1; }
+
+    stopPipelines();
+
+    vPipelines.resize(1); // keep main camera, since main window holds on to its session
+
+    for (int iPipeline = 1; iPipeline < numberOfPipelines; iPipeline++) { vPipelines.emplace_back(new TrackerPipeline(iPipeline)); }
+
+    // With multiple cameras each pipeline opens a fixed device ID, so cameras do not swap between sessions
+
+    for (int iPipeline = 0; iPipeline < numberOfPipelines; iPipeline++)
+    {
+        if (numberOfPipelines > 1) { vPipelines[iPipeline]->mCameraSession.cameraIndex = iPipeline + 1; }
+        else                       { vPipelines[iPipeline]->mCameraSession.cameraIndex = 0; }
+
+        vPipelines[iPipeline]->setCPUCore(iPipeline); // capture and tracking of each camera share one core
+    }
+
+    if (numberOfPipelines == 1) { vPipelines[0]->setCPUCore(-1); } // single camera is left to the scheduler
+}
+
+std::vector<int> TrackerManager::startPipelines(const AOIProperties& camAOI, const AOIPropertiesDouble& eyeAOIRatio, int subSamplingFactor, double frameRate, const detectionParameters& mDetectionParameters, const detectionVariables& mDetectionVariables)
+{
+    std::vector<int> vCamerasFailed;
+
+    for (int iPipeline = 1; iPipeline < (int) vPipelines.size(); iPipeline++)
+    {
+        TrackerPipeline *mPipeline = vPipelines[iPipeline].get();
+        CameraSession& mSession = mPipeline->mCameraSession;
+
+        { std::lock_guard<std::mutex> AOICamLock(mSession.AOICamMutex);
+            mSession.camAOI = camAOI;
+        }
+
+        { std::lock_guard<std::mutex> AOIEyeLock(mSession.AOIEyeMutex);
+            mSession.eyeAOIRatio = eyeAOIRatio;
+            mSession.eyeAOI.xPos = round(camAOI.wdth * eyeAOIRatio.xPos);
+            mSession.eyeAOI.yPos = round(camAOI.hght * eyeAOIRatio.yPos);
+            mSession.eyeAOI.wdth = round(camAOI.wdth * eyeAOIRatio.wdth);
+            mSession.eyeAOI.hght = round(camAOI.hght * eyeAOIRatio.hght);
+        }
+
+        if (mPipeline->startCamera(subSamplingFactor, frameRate)) { mPipeline->startTracking(mDetectionParameters, mDetectionVariables); }
+        else { vCamerasFailed.push_back(mSession.cameraIndex); }
+    }
+
+    return vCamerasFailed;
+}
+
+void TrackerManager::stopPipelines()
+{
+    for (int iPipeline = 1; iPipeline < (int) vPipelines.size(); iPipeline++) { vPipelines[iPipeline]->stopTracking(); }
+}
+
+void TrackerManager::startRecording()
+{
+    for (int iPipeline = 0; iPipeline < (int) vPipelines.size(); iPipeline++) { vPipelines[iPipeline]->startRecording(); }
+}
+
+void TrackerManager::stopRecording()
+{
+    for (int iPipeline = 0; iPipeline < (int) vPipelines.size(); iPipeline++) { vPipelines[iPipeline]->stopRecording(); }
+}
+
+void TrackerManager::saveMergedData(const std::string& filename, int trialIndex, unsigned long long startTimeHost)
+{
+    // Merge samples of all cameras by host time stamp. Each camera is already in chronological order.
+
+    int numberOfPipelines = vPipelines.size();
+
+    std::vector<std::vector<trackerSample>> vSamplesAll(numberOfPipelines);
+    std::vector<int> vSampleIndex(numberOfPipelines, 0);
+
+    for (int iPipeline = 0; iPipeline < numberOfPipelines; iPipeline++) { vSamplesAll[iPipeline] = vPipelines[iPipeline]->getSamples(); }
+
+    std::ofstream file;
+    file.open(filename, std::ios_base::app);
+
+    std::string delimiter = ";";
+
+    file << std::fixed;
+    file << std::setprecision(3);
+
+    while (true)
+    {
+        int iPipelineNext = -1;
+
+        for (int iPipeline = 0; iPipeline < numberOfPipelines; iPipeline++)
+        {
+            if (vSampleIndex[iPipeline] >= (int) vSamplesAll[iPipeline].size()) { continue; }
+
+            if (iPipelineNext < 0 || vSamplesAll[iPipeline][vSampleIndex[iPipeline]].timeHost < vSamplesAll[iPipelineNext][vSampleIndex[iPipelineNext]].timeHost)
+            {
+                iPipelineNext = iPipeline;
+            }
+        }
+
+        if (iPipelineNext < 0) { break; } // all samples written
+
+        const trackerSample& mSample = vSamplesAll[iPipelineNext][vSampleIndex[iPipelineNext]];
+        vSampleIndex[iPipelineNext]++;
+
+        double relativeTimeHost = ((long long) (mSample.timeHost - startTimeHost)) / (double) 10000; // in ms
+
+        file << std::setw(3) << std::setfill('0') << trialIndex << delimiter << std::setfill(' ');
+        file << mSample.cameraIndex   << delimiter;
+        file << relativeTimeHost      << delimiter;
+        file << mSample.DETECTED      << delimiter;
+        file << mSample.xPos          << delimiter;
+        file << mSample.yPos          << delimiter;
+        file << mSample.circumference << delimiter;
+        file << mSample.aspectRatio   << "\n";
+    }
+
+    file.close();
+}
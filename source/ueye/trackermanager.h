@@ -0,0 +1,125 @@
+//  EyeStalker: robust video-based eye tracking
+//  Copyright (C) 2016  Terence Brouns, t.s.n.brouns@gmail.com
+
+//  EyeStalker is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  EyeStalker is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+#ifndef TRACKERMANAGER_H
+#define TRACKERMANAGER_H
+
+// Files
+
+#include "../camerasession.h"
+#include "../eventtracer.h"
+#include "../eyestalker.h"
+#include "../parameters.h"
+#include "../preprocessedframe.h"
+#include "../structures.h"
+
+#include "ueyeopencv.h"
+
+// Standard Template
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Single tracking result of one camera, ordered by host time when cameras are merged
+
+struct trackerSample
+{
+    bool DETECTED;
+    double aspectRatio;
+    double circumference;
+    double xPos;
+    double yPos;
+    int cameraIndex;
+    unsigned long long timeHost;
+};
+
+// One camera with its own session, capture thread, tracking thread and output buffer
+
+class TrackerPipeline
+{
+
+public:
+
+    TrackerPipeline(int index);
+    ~TrackerPipeline();
+
+    CameraSession mCameraSession;
+    UEyeOpencvCam mUEyeOpencvCam;
+
+    bool startCamera(int subSamplingFactor, double frameRate);
+    int  getCPUCore();
+    int  getIndex();
+    void addSample(const dataVariables&, unsigned long long timeHost);
+    void clearSamples();
+    void setCPUCore(int);
+    void startRecording();
+    void startTracking(const detectionParameters&, const detectionVariables&);
+    void stopRecording();
+    void stopTracking();
+    std::vector<trackerSample> getSamples();
+
+private:
+
+    std::atomic<bool> TRACKING_ACTIVE;
+    std::atomic<bool> TRIAL_RECORDING;
+
+    int cpuCore;
+    int index;
+
+    detectionParameters mDetectionParameters;
+    detectionVariables  mDetectionVariables;
+
+    std::mutex sampleMutex;
+    std::thread trackingThread;
+    std::vector<trackerSample> vSamples;
+
+    bool configureCamera(int subSamplingFactor, double frameRate);
+    void threadTracking();
+};
+
+// Owns all camera pipelines. Pipeline 0 is driven by the main window, the others track headless.
+
+class TrackerManager
+{
+
+public:
+
+    TrackerManager();
+    ~TrackerManager();
+
+    TrackerPipeline* getPipeline(int);
+    int  getNumberOfPipelines();
+    void saveMergedData(const std::string& filename, int trialIndex, unsigned long long startTimeHost);
+    void setNumberOfPipelines(int);
+    std::vector<int> startPipelines(const AOIProperties& camAOI, const AOIPropertiesDouble& eyeAOIRatio, int subSamplingFactor, double frameRate, const detectionParameters&, const detectionVariables&); // returns indices of cameras that could not be started
+    void startRecording();
+    void stopPipelines();
+    void stopRecording();
+
+private:
+
+    std::vector<std::unique_ptr<TrackerPipeline>> vPipelines;
+};
+
+#endif // TRACKERMANAGER_H
@@ -22,14 +22,23 @@ UEyeOpencvCam::UEyeOpencvCam()
     vImageInfo.resize(numberOfImageBuffers);
 
     frameIndex = 0;
+    frameBacklog = 0;
     hCam = 0;
+    cpuCore = -1;
+
+    mCameraSession = NULL;
 
     DEVICE_INITIALIZED = false;
     EVENT_ENABLED = true;
+    FRAME_READ = true;
+    RING_WAIT = false;
     TRIAL_RECORDING = false;
     THREAD_ACTIVE = false;
 }
 
+void UEyeOpencvCam::setCameraSession(CameraSession* session) { mCameraSession = session; }
+void UEyeOpencvCam::setCPUCore(int core) { cpuCore = core; }
+
 void UEyeOpencvCam::setDeviceInfo(int idV, int idP)
 {
     idVendor = idV;
@@ -84,6 +93,9 @@ int UEyeOpencvCam::initCamera()
     if (DEVICE_INITIALIZED) { return 2; }
     else
     {
+        hCam = (HIDS) mCameraSession->cameraIndex;
+        if (mCameraSession->cameraIndex > 0) { hCam = (HIDS) (mCameraSession->cameraIndex | IS_USE_DEVICE_ID); }
+
         int retInt = is_InitCamera(&hCam, 0);
         if (retInt != IS_SUCCESS) { return 0; }
     }
@@ -111,14 +123,14 @@ bool UEyeOpencvCam::setSubSampling(int subSamplingFactor)
 
 bool UEyeOpencvCam::freeImageMemory()
 {
-    std::lock_guard<std::mutex> lock(Parameters::frameCaptureMutex);
+    std::lock_guard<std::mutex> lock(mCameraSession->frameCaptureMutex);
 
     if (is_FreeImageMem(hCam, ppcImgMem, pid) != IS_SUCCESS) { return false; }
     else
     {
         vImageInfo.clear();
         frameCount = 0;
-        Parameters::CAMERA_READY = false;
+        mCameraSession->CAMERA_READY = false;
     }
 
     return true;
@@ -126,7 +138,7 @@ bool UEyeOpencvCam::freeImageMemory()
 
 bool UEyeOpencvCam::setAOI(int xAOI, int yAOI, int wAOI, int hAOI)
 {
-    std::lock_guard<std::mutex> lock(Parameters::frameCaptureMutex);
+    std::lock_guard<std::mutex> lock(mCameraSession->frameCaptureMutex);
 
     // Crop to area of interest
 
@@ -145,7 +157,7 @@ bool UEyeOpencvCam::setAOI(int xAOI, int yAOI, int wAOI, int hAOI)
 
 bool UEyeOpencvCam::allocateMemory(int wdth, int hght)
 {
-    std::lock_guard<std::mutex> lock(Parameters::frameCaptureMutex);
+    std::lock_guard<std::mutex> lock(mCameraSession->frameCaptureMutex);
 
     width  = wdth;
     height = hght;
@@ -171,10 +183,14 @@ bool UEyeOpencvCam::startVideoCapture()
 {
     if (is_CaptureVideo(hCam, IS_DONT_WAIT) != IS_SUCCESS)
     {
-        Parameters::CAMERA_RUNNING = false;
+        mCameraSession->CAMERA_RUNNING = false;
         return false;
     }
 
+    FRAME_READ = true;
+    RING_WAIT  = false;
+    mCameraSession->mTelemetry.clear();
+
     std::thread frameCaptureThread(&UEyeOpencvCam::threadFrameCapture, this);
     frameCaptureThread.detach();
 
@@ -200,6 +216,12 @@ void UEyeOpencvCam::threadFrameCapture()
 {
     THREAD_ACTIVE = true;
 
+    setThreadAffinity(cpuCore);
+
+    std::stringstream threadName;
+    threadName << "capture (camera " << mCameraSession->cameraIndex << ")";
+    EventTracer::setThreadName(threadName.str());
+
 #ifdef _WIN32
     HANDLE hEvent = CreateEvent(NULL,FALSE,FALSE,NULL);
     is_InitEvent(hCam,hEvent,IS_SET_EVENT_FRAME);
@@ -207,19 +229,27 @@ void UEyeOpencvCam::threadFrameCapture()
 
     is_EnableEvent(hCam, IS_SET_EVENT_FRAME);
 
-    while(Parameters::CAMERA_RUNNING && Parameters::ONLINE_MODE)
+    while(mCameraSession->CAMERA_RUNNING && Parameters::ONLINE_MODE)
     {
+        TraceSpan mEventSpan("frame event wait", "camera");
 
 #ifdef __linux__
-        if (is_WaitEvent(hCam, IS_SET_EVENT_FRAME, 1000) == IS_SUCCESS)
+        bool FRAME_READY = (is_WaitEvent(hCam, IS_SET_EVENT_FRAME, 1000) == IS_SUCCESS);
 #else
-        if (WaitForSingleObject(hEvent,1000) == WAIT_OBJECT_0)
+        bool FRAME_READY = (WaitForSingleObject(hEvent,1000) == WAIT_OBJECT_0);
 #endif
 
+        mEventSpan.end();
+
+        if (FRAME_READY)
         {
-            std::unique_lock<std::mutex> lck(Parameters::frameCaptureMutex);
+            TraceSpan mLockSpan("frameCaptureMutex", "lock_wait"); // no hold span, since lock is released while buffer is full
+            std::unique_lock<std::mutex> lck(mCameraSession->frameCaptureMutex);
+            mLockSpan.end();
 
-            if (Parameters::CAMERA_READY)
+            TraceSpan mCopySpan("copy frame", "camera");
+
+            if (mCameraSession->CAMERA_READY)
             {
                 VOID* pMem;
 
@@ -228,37 +258,49 @@ void UEyeOpencvCam::threadFrameCapture()
                     UEYEIMAGEINFO mUEYEIMAGEINFO;
                     is_GetImageInfo(hCam, pid, &mUEYEIMAGEINFO, sizeof(mUEYEIMAGEINFO));
                     unsigned long long timeStamp = mUEYEIMAGEINFO.u64TimestampDevice;
+                    unsigned long long timeStampHost = getHostTime(); // clock shared by all cameras
 
                     cv::Mat img = cv::Mat(height, width, CV_8UC3);
                     memcpy(img.ptr(), pMem, width * height * 3);
 
+                    mCameraSession->mTelemetry.addCapturedFrame(timeStamp, RING_WAIT); // gaps in time stamps are counted as lost frames
+                    RING_WAIT = false;
+
                     if (TRIAL_RECORDING)
                     {
                         vImageInfo[frameIndex].image = img;
                         vImageInfo[frameIndex].time = timeStamp;
+                        vImageInfo[frameIndex].timeHost = timeStampHost;
 
                         frameIndex = (frameIndex + 1) % numberOfImageBuffers;
                         frameCount++;
 
                         if (frameCount >= numberOfImageBuffers)
                         {
-                            while (frameCount >= numberOfImageBuffers && Parameters::ONLINE_MODE && TRIAL_RECORDING) { Parameters::frameCaptureCV.wait(lck); } // wait if image buffer is full
+                            mCopySpan.end();
+                            TraceSpan mBufferSpan("buffer full wait", "camera");
+                            RING_WAIT = true;
+                            while (frameCount >= numberOfImageBuffers && Parameters::ONLINE_MODE && TRIAL_RECORDING) { mCameraSession->frameCaptureCV.wait(lck); } // wait if image buffer is full
                             frameCount = frameCount % numberOfImageBuffers;
                         }
                     }
                     else
                     {
+                        if (!FRAME_READ) { mCameraSession->mTelemetry.addFrameLoss(DROP_OVERWRITTEN); }
+                        FRAME_READ = false;
+
                         vImageInfo[0].time = timeStamp;
+                        vImageInfo[0].timeHost = timeStampHost;
                         vImageInfo[0].image = img;
                     }
                 }
             }
 
-            Parameters::frameCaptureCV.notify_one();  // notify waiting thread that new image has arrived
+            mCameraSession->frameCaptureCV.notify_one();  // notify waiting thread that new image has arrived
         }
         else
         {
-            Parameters::CAMERA_RUNNING = false;
+            mCameraSession->CAMERA_RUNNING = false;
         }
     }
 
@@ -280,17 +322,22 @@ imageInfo UEyeOpencvCam::getFrame()
 {
     imageInfo mImageInfoNew;
 
-    if (Parameters::ONLINE_MODE && Parameters::CAMERA_RUNNING)
+    if (Parameters::ONLINE_MODE && mCameraSession->CAMERA_RUNNING)
     {
-        std::unique_lock<std::mutex> lck(Parameters::frameCaptureMutex);
+        TraceSpan mLockSpan("frameCaptureMutex", "lock_wait");
+        std::unique_lock<std::mutex> lck(mCameraSession->frameCaptureMutex);
+        mLockSpan.end();
 
         if (TRIAL_RECORDING)
         {
             if (frameCount <= 0)
             {
-                while (frameCount <= 0 && Parameters::ONLINE_MODE && TRIAL_RECORDING) Parameters::frameCaptureCV.wait(lck); // wait for new images to arrive
+                TraceSpan mWaitSpan("frame wait", "camera");
+                while (frameCount <= 0 && Parameters::ONLINE_MODE && TRIAL_RECORDING) mCameraSession->frameCaptureCV.wait(lck); // wait for new images to arrive
             }
 
+            mCameraSession->mTelemetry.addRingOccupancy(frameCount, numberOfImageBuffers);
+
             int index = frameIndex - frameCount;
 
             if (index < 0)
@@ -302,21 +349,39 @@ imageInfo UEyeOpencvCam::getFrame()
             {
                 mImageInfoNew = vImageInfo[index];
                 frameCount--;
+                frameBacklog = frameCount;
             }
         }
         else
         {
             mImageInfoNew = vImageInfo[0];
+            FRAME_READ = true;
         }
     }
 
     return mImageInfoNew;
 }
 
+bool UEyeOpencvCam::waitForFrame(unsigned long long timeHostPrevious)
+{
+    std::unique_lock<std::mutex> lck(mCameraSession->frameCaptureMutex);
+
+    return mCameraSession->frameCaptureCV.wait_for(lck, std::chrono::milliseconds(1000), [&]
+    {
+        if (!mCameraSession->CAMERA_RUNNING || TRIAL_RECORDING) { return true; } // caller re-checks its state
+        return (!vImageInfo.empty() && vImageInfo[0].timeHost != timeHostPrevious);
+    });
+}
+
+int UEyeOpencvCam::getBacklog() { return frameBacklog; }
+
 void UEyeOpencvCam::startRecording()
 {
+    frameBacklog = 0;
     frameCount = 0;
     frameIndex = 0;
+    RING_WAIT  = false;
+    mCameraSession->mTelemetry.clear(); // statistics of trial only
     TRIAL_RECORDING = true;
 }
 
@@ -362,6 +427,7 @@ double UEyeOpencvCam::setFrameRate(double FPS)
 {
     double newFPS;
     is_SetFrameRate(hCam, FPS, &newFPS);
+    mCameraSession->mTelemetry.setFrameRate(newFPS);
     return newFPS;
 }
 
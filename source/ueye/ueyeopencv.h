@@ -19,7 +19,9 @@
 
 // Files
 
+#include "../camerasession.h"
 #include "../constants.h"
+#include "../eventtracer.h"
 #include "../parameters.h"
 #include "../structures.h"
 
@@ -27,8 +29,10 @@
 
 // Standard Template
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <thread>
 
@@ -63,6 +67,8 @@ public:
     double getExposure();
     double setFrameRate(double FPS);
     imageInfo getFrame(); // returns cv::Mat of camera frame
+    bool waitForFrame(unsigned long long timeHostPrevious); // camera feed: blocks until a frame newer than the given one has arrived, false on time-out or stop
+    int getBacklog(); // frames waiting in ring during recording, as of last call to 'getFrame'
     int getHardwareGain();
     int initCamera();
     int setBlackLevelOffset(int nOffset);
@@ -74,6 +80,8 @@ public:
     void exitCamera();
     void setAutoGain(bool FLAG);
     void setBlackLevelMode(bool FLAG);
+    void setCameraSession(CameraSession*);
+    void setCPUCore(int);
     void setDeviceInfo(int, int);
     void setExposure(double pExp);
     void setGainBoost(bool FLAG);
@@ -88,9 +96,14 @@ private:
 
     bool DEVICE_INITIALIZED;
     bool EVENT_ENABLED;
-    bool TRIAL_RECORDING;
+    bool FRAME_READ; // camera feed: latest frame was taken by tracking thread
+    bool RING_WAIT;  // capture thread waited for a free slot in frame ring
+    std::atomic<bool> TRIAL_RECORDING; // set by tracking thread, read by capture thread
     bool THREAD_ACTIVE;
+    CameraSession *mCameraSession;
     char* ppcImgMem;
+    int cpuCore;
+    int frameBacklog; // frames left in ring after last one taken by tracking thread
     HIDS hCam;
     int frameCount;
     int frameIndex;